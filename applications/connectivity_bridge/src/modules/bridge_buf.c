@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <sys/atomic.h>
+
+#include "bridge_buf.h"
+
+/* Two UART instances, see uart_handler.c */
+#define BUF_COUNT_UART (2 * CONFIG_BRIDGE_UART_BUF_COUNT)
+#if CONFIG_BRIDGE_CDC_ENABLE
+#define BUF_COUNT_CDC (CONFIG_USB_CDC_ACM_DEVICE_COUNT * 3)
+#else
+#define BUF_COUNT_CDC 0
+#endif
+#if CONFIG_BRIDGE_BLE_ENABLE
+#define BUF_COUNT_BLE 2
+#else
+#define BUF_COUNT_BLE 0
+#endif
+
+#define BUF_SLAB_BLOCK_SIZE sizeof(struct bridge_buf)
+#define BUF_SLAB_BLOCK_COUNT (BUF_COUNT_UART + BUF_COUNT_CDC + BUF_COUNT_BLE)
+#define BUF_SLAB_ALIGNMENT 4
+
+struct bridge_buf {
+	atomic_t ref_counter;
+	uint8_t buf[BRIDGE_BUF_SIZE];
+};
+
+BUILD_ASSERT((sizeof(struct bridge_buf) % BUF_SLAB_ALIGNMENT) == 0);
+
+/* Blocks from the same slab are used for all interfaces */
+K_MEM_SLAB_DEFINE(bridge_buf_slab, BUF_SLAB_BLOCK_SIZE, BUF_SLAB_BLOCK_COUNT,
+		  BUF_SLAB_ALIGNMENT);
+
+static inline struct bridge_buf *block_start_get(const void *buf)
+{
+	size_t block_num;
+
+	/* blocks are fixed size units from a continuous memory slab: */
+	/* round down to the closest unit size to find beginning of block. */
+
+	block_num =
+		(((size_t)buf - (size_t)bridge_buf_slab.buffer) / BUF_SLAB_BLOCK_SIZE);
+
+	return (struct bridge_buf *) &bridge_buf_slab.buffer[block_num * BUF_SLAB_BLOCK_SIZE];
+}
+
+uint8_t *bridge_buf_alloc(void)
+{
+	struct bridge_buf *buf;
+	int err;
+
+	/* Async UART driver returns pointers to received data as */
+	/* offsets from beginning of RX buffer block. */
+	/* This code uses a reference counter to keep track of the number of */
+	/* references within a single buffer block */
+
+	err = k_mem_slab_alloc(&bridge_buf_slab, (void **) &buf, K_NO_WAIT);
+	if (err) {
+		return NULL;
+	}
+
+	atomic_set(&buf->ref_counter, 1);
+
+	return buf->buf;
+}
+
+void bridge_buf_ref(const void *buf)
+{
+	__ASSERT_NO_MSG(buf);
+
+	atomic_inc(&(block_start_get(buf)->ref_counter));
+}
+
+void bridge_buf_unref(const void *buf)
+{
+	__ASSERT_NO_MSG(buf);
+
+	struct bridge_buf *bridge_buf = block_start_get(buf);
+	atomic_t ref_counter = atomic_dec(&bridge_buf->ref_counter);
+
+	/* ref_counter is the bridge_buf->ref_counter value prior to decrement */
+	if (ref_counter == 1) {
+		k_mem_slab_free(&bridge_buf_slab, (void **)&bridge_buf);
+	}
+}
+
+uint8_t *bridge_buf_writer_get(struct bridge_buf_writer *writer,
+			       size_t min_space, size_t *space)
+{
+	if (writer->block && BRIDGE_BUF_SIZE - writer->offset < min_space) {
+		bridge_buf_writer_reset(writer);
+	}
+
+	if (!writer->block) {
+		writer->block = bridge_buf_alloc();
+		if (!writer->block) {
+			return NULL;
+		}
+	}
+
+	*space = BRIDGE_BUF_SIZE - writer->offset;
+
+	return &writer->block[writer->offset];
+}
+
+uint8_t *bridge_buf_writer_commit(struct bridge_buf_writer *writer, size_t len)
+{
+	uint8_t *segment = &writer->block[writer->offset];
+
+	__ASSERT_NO_MSG(writer->offset + len <= BRIDGE_BUF_SIZE);
+
+	writer->offset += len;
+	bridge_buf_ref(segment);
+
+	return segment;
+}
+
+void bridge_buf_writer_reset(struct bridge_buf_writer *writer)
+{
+	if (writer->block) {
+		bridge_buf_unref(writer->block);
+	}
+
+	writer->block = NULL;
+	writer->offset = 0;
+}
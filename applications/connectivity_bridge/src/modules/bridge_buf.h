@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _BRIDGE_BUF_H_
+#define _BRIDGE_BUF_H_
+
+/**
+ * @brief Bridge buffers
+ * @defgroup bridge_buf Bridge buffers
+ * @{
+ *
+ * Reference counted buffer blocks shared by the UART and USB CDC modules.
+ * Data passed in UART and CDC data events points into these blocks, and a
+ * module that keeps the data after the event holds a reference to the block
+ * instead of copying it. A reference can be taken and released through any
+ * pointer into the data of the block.
+ */
+
+#include <zephyr/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BRIDGE_BUF_SIZE CONFIG_BRIDGE_BUF_SIZE
+
+/** Fills a block in segments, for data that arrives in small pieces. */
+struct bridge_buf_writer {
+	uint8_t *block;
+	size_t offset;
+};
+
+/**
+ * @brief Allocate a block. Can be called from an ISR.
+ *
+ * @return Data of the block with one reference, or NULL if none is free.
+ */
+uint8_t *bridge_buf_alloc(void);
+
+/** @brief Take a reference to the block that @p buf points into. */
+void bridge_buf_ref(const void *buf);
+
+/**
+ * @brief Release a reference to the block that @p buf points into.
+ *	  The block is freed with the last reference.
+ */
+void bridge_buf_unref(const void *buf);
+
+/**
+ * @brief Get free space in the block of a writer.
+ *
+ * A new block is started if there is less than @p min_space left.
+ *
+ * @param writer Writer.
+ * @param min_space Minimum free space needed.
+ * @param space Free space at the returned pointer.
+ *
+ * @return Where to write the next segment, or NULL if no block is free.
+ */
+uint8_t *bridge_buf_writer_get(struct bridge_buf_writer *writer,
+			       size_t min_space, size_t *space);
+
+/**
+ * @brief Finish a segment written to the pointer from bridge_buf_writer_get().
+ *
+ * @param writer Writer.
+ * @param len Length of the segment.
+ *
+ * @return The segment, with a reference that the caller must release.
+ */
+uint8_t *bridge_buf_writer_commit(struct bridge_buf_writer *writer, size_t len);
+
+/** @brief Release the block of a writer. */
+void bridge_buf_writer_reset(struct bridge_buf_writer *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _BRIDGE_BUF_H_ */
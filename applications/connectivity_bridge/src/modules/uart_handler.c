@@ -4,8 +4,8 @@
  * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
  */
 
+#include <string.h>
 #include <zephyr/types.h>
-#include <sys/ring_buffer.h>
 #include <drivers/uart.h>
 
 #define MODULE uart_handler
@@ -14,16 +14,14 @@
 #include "ble_data_event.h"
 #include "cdc_data_event.h"
 #include "uart_data_event.h"
+#include "bridge_buf.h"
 
 #include <logging/log.h>
 LOG_MODULE_REGISTER(MODULE, CONFIG_BRIDGE_UART_LOG_LEVEL);
 
-#define UART_BUF_SIZE CONFIG_BRIDGE_BUF_SIZE
-
-#define UART_SLAB_BLOCK_SIZE sizeof(struct uart_rx_buf)
-#define UART_SLAB_BLOCK_COUNT (UART_DEVICE_COUNT * CONFIG_BRIDGE_UART_BUF_COUNT)
-#define UART_SLAB_ALIGNMENT 4
 #define UART_RX_TIMEOUT_MS 1
+#define UART_TX_QUEUE_LEN 16
+#define UART_BLE_TX_MIN_SPACE 256
 
 #if defined(CONFIG_PM_DEVICE)
 #define UART_SET_PM_STATE true
@@ -51,31 +49,39 @@ static const char *device_names[UART_DEVICE_COUNT] = {
 #undef X
 };
 
-struct uart_rx_buf {
-	atomic_t ref_counter;
+/* Segment of a bridge buffer. The queue holds a reference to the buffer. */
+struct uart_tx_seg {
+	uint8_t *buf;
 	size_t len;
-	uint8_t buf[UART_BUF_SIZE];
 };
 
-struct uart_tx_buf {
-	struct ring_buf rb;
-	uint32_t buf[UART_BUF_SIZE];
+/* Data is transmitted straight from the buffers it was received in. */
+/* The first segment is being transmitted while uart_tx_started is set. */
+struct uart_tx_queue {
+	struct uart_tx_seg segs[UART_TX_QUEUE_LEN];
+	uint8_t head;
+	uint8_t count;
 };
 
-BUILD_ASSERT((sizeof(struct uart_rx_buf) % UART_SLAB_ALIGNMENT) == 0);
-
-/* Blocks from the same slab is used for RX for all UART instances */
-/* TX has inidividual ringbuffers per UART instance */
+struct uart_stats {
+	uint32_t rx;
+	uint32_t tx;
+	uint32_t tx_dropped;
+};
 
-K_MEM_SLAB_DEFINE(uart_rx_slab, UART_SLAB_BLOCK_SIZE, UART_SLAB_BLOCK_COUNT, UART_SLAB_ALIGNMENT);
+/* RX blocks for all UART instances, and the data sent by the other */
+/* interfaces, are bridge buffers (see bridge_buf.h). */
 
 static const struct device *devices[UART_DEVICE_COUNT];
-static struct uart_tx_buf uart_tx_ringbufs[UART_DEVICE_COUNT];
+static struct uart_tx_queue uart_tx_queues[UART_DEVICE_COUNT];
+static struct uart_stats uart_stats[UART_DEVICE_COUNT];
 static uint32_t uart_default_baudrate[UART_DEVICE_COUNT];
 /* UART RX only enabled when there is one or more subscribers (power saving) */
 static int subscriber_count[UART_DEVICE_COUNT];
 static bool enable_rx_retry[UART_DEVICE_COUNT];
 static atomic_t uart_tx_started[UART_DEVICE_COUNT];
+/* BLE data is not in a bridge buffer, so it is copied into one */
+static struct bridge_buf_writer ble_tx_writer;
 
 static void enable_uart_rx(uint8_t dev_idx);
 static void disable_uart_rx(uint8_t dev_idx);
@@ -83,70 +89,46 @@ static void set_uart_power_state(uint8_t dev_idx, bool active);
 static int uart_tx_start(uint8_t dev_idx);
 static void uart_tx_finish(uint8_t dev_idx, size_t len);
 
-static inline struct uart_rx_buf *block_start_get(uint8_t *buf)
-{
-	size_t block_num;
-
-	/* blocks are fixed size units from a continuous memory slab: */
-	/* round down to the closest unit size to find beginning of block. */
+#if CONFIG_BRIDGE_STATS_INTERVAL > 0
+static void stats_work_handler(struct k_work *work);
 
-	block_num =
-		(((size_t)buf - (size_t)uart_rx_slab.buffer) / UART_SLAB_BLOCK_SIZE);
-
-	return (struct uart_rx_buf *) &uart_rx_slab.buffer[block_num * UART_SLAB_BLOCK_SIZE];
-}
+static K_WORK_DELAYABLE_DEFINE(stats_work, stats_work_handler);
 
-static struct uart_rx_buf *uart_rx_buf_alloc(void)
+static void stats_work_handler(struct k_work *work)
 {
-	struct uart_rx_buf *buf;
-	int err;
-
-	/* Async UART driver returns pointers to received data as */
-	/* offsets from beginning of RX buffer block. */
-	/* This code uses a reference counter to keep track of the number of */
-	/* references within a single RX buffer block */
-
-	err = k_mem_slab_alloc(&uart_rx_slab, (void **) &buf, K_NO_WAIT);
-	if (err) {
-		return NULL;
+	for (int i = 0; i < UART_DEVICE_COUNT; ++i) {
+		struct uart_stats stats;
+		unsigned int key = irq_lock();
+
+		stats = uart_stats[i];
+		memset(&uart_stats[i], 0, sizeof(uart_stats[i]));
+		irq_unlock(key);
+
+		if (stats.rx || stats.tx || stats.tx_dropped) {
+			LOG_INF("UART_%d rx: %u B/s, tx: %u B/s, tx dropped: %u B",
+				i,
+				stats.rx / CONFIG_BRIDGE_STATS_INTERVAL,
+				stats.tx / CONFIG_BRIDGE_STATS_INTERVAL,
+				stats.tx_dropped);
+		}
 	}
 
-	atomic_set(&buf->ref_counter, 1);
-
-	return buf;
-}
-
-static void uart_rx_buf_ref(void *buf)
-{
-	__ASSERT_NO_MSG(buf);
-
-	atomic_inc(&(block_start_get(buf)->ref_counter));
-}
-
-static void uart_rx_buf_unref(void *buf)
-{
-	__ASSERT_NO_MSG(buf);
-
-	struct uart_rx_buf *uart_buf = block_start_get(buf);
-	atomic_t ref_counter = atomic_dec(&uart_buf->ref_counter);
-
-	/* ref_counter is the uart_buf->ref_counter value prior to decrement */
-	if (ref_counter == 1) {
-		k_mem_slab_free(&uart_rx_slab, (void **)&uart_buf);
-	}
+	k_work_reschedule(&stats_work, K_SECONDS(CONFIG_BRIDGE_STATS_INTERVAL));
 }
+#endif
 
 static void uart_callback(const struct device *dev, struct uart_event *evt,
 			  void *user_data)
 {
 	int dev_idx = (int) user_data;
 	struct uart_data_event *event;
-	struct uart_rx_buf *buf;
+	uint8_t *buf;
 	int err;
 
 	switch (evt->type) {
 	case UART_RX_RDY:
-		uart_rx_buf_ref(evt->data.rx.buf);
+		bridge_buf_ref(evt->data.rx.buf);
+		uart_stats[dev_idx].rx += evt->data.rx.len;
 
 		event = new_uart_data_event();
 		event->dev_idx = dev_idx;
@@ -156,20 +138,20 @@ static void uart_callback(const struct device *dev, struct uart_event *evt,
 		break;
 	case UART_RX_BUF_RELEASED:
 		if (evt->data.rx_buf.buf) {
-			uart_rx_buf_unref(evt->data.rx_buf.buf);
+			bridge_buf_unref(evt->data.rx_buf.buf);
 		}
 		break;
 	case UART_RX_BUF_REQUEST:
-		buf = uart_rx_buf_alloc();
+		buf = bridge_buf_alloc();
 		if (buf == NULL) {
 			LOG_WRN("UART_%d RX overflow", dev_idx);
 			break;
 		}
 
-		err = uart_rx_buf_rsp(dev, buf->buf, sizeof(buf->buf));
+		err = uart_rx_buf_rsp(dev, buf, BRIDGE_BUF_SIZE);
 		if (err) {
 			LOG_ERR("uart_rx_buf_rsp: %d", err);
-			uart_rx_buf_unref(buf);
+			bridge_buf_unref(buf);
 		}
 		break;
 	case UART_RX_DISABLED:
@@ -183,10 +165,9 @@ static void uart_callback(const struct device *dev, struct uart_event *evt,
 	case UART_TX_DONE:
 		uart_tx_finish(dev_idx, evt->data.tx.len);
 
-		if (ring_buf_is_empty(&uart_tx_ringbufs[dev_idx].rb)) {
+		if (uart_tx_queues[dev_idx].count == 0 ||
+		    uart_tx_start(dev_idx) != 0) {
 			atomic_set(&uart_tx_started[dev_idx], false);
-		} else {
-			uart_tx_start(dev_idx);
 		}
 		break;
 	case UART_TX_ABORTED:
@@ -270,7 +251,7 @@ static void enable_uart_rx(uint8_t dev_idx)
 {
 	const struct device *dev = devices[dev_idx];
 	int err;
-	struct uart_rx_buf *buf;
+	uint8_t *buf;
 
 	err = uart_callback_set(dev, uart_callback, (void *) (int) dev_idx);
 	if (err) {
@@ -278,15 +259,15 @@ static void enable_uart_rx(uint8_t dev_idx)
 		return;
 	}
 
-	buf = uart_rx_buf_alloc();
+	buf = bridge_buf_alloc();
 	if (!buf) {
-		LOG_ERR("uart_rx_buf_alloc error");
+		LOG_ERR("bridge_buf_alloc error");
 		return;
 	}
 
-	err = uart_rx_enable(dev, buf->buf, sizeof(buf->buf), UART_RX_TIMEOUT_MS);
+	err = uart_rx_enable(dev, buf, BRIDGE_BUF_SIZE, UART_RX_TIMEOUT_MS);
 	if (err) {
-		uart_rx_buf_unref(buf);
+		bridge_buf_unref(buf);
 		LOG_ERR("uart_rx_enable: %d", err);
 		return;
 	}
@@ -306,18 +287,19 @@ static void disable_uart_rx(uint8_t dev_idx)
 
 static int uart_tx_start(uint8_t dev_idx)
 {
-	int len;
+	struct uart_tx_queue *queue = &uart_tx_queues[dev_idx];
+	struct uart_tx_seg seg;
+	unsigned int key;
 	int err;
-	uint8_t *buf;
 
-	len = ring_buf_get_claim(
-			&uart_tx_ringbufs[dev_idx].rb,
-			&buf,
-			sizeof(uart_tx_ringbufs[dev_idx].buf));
+	key = irq_lock();
+	seg = queue->segs[queue->head];
+	irq_unlock(key);
 
-	err = uart_tx(devices[dev_idx], buf, len, 0);
+	err = uart_tx(devices[dev_idx], seg.buf, seg.len, 0);
 	if (err) {
 		LOG_ERR("uart_tx: %d", err);
+		uart_stats[dev_idx].tx_dropped += seg.len;
 		uart_tx_finish(dev_idx, 0);
 		return err;
 	}
@@ -325,27 +307,63 @@ static int uart_tx_start(uint8_t dev_idx)
 	return 0;
 }
 
+/* Release the segment that has been transmitted. */
 static void uart_tx_finish(uint8_t dev_idx, size_t len)
 {
-	int err;
-
-	err = ring_buf_get_finish(&uart_tx_ringbufs[dev_idx].rb, len);
-	if (err) {
-		LOG_ERR("ring_buf_get_finish: %d", err);
-	}
+	struct uart_tx_queue *queue = &uart_tx_queues[dev_idx];
+	struct uart_tx_seg seg;
+	unsigned int key;
+
+	key = irq_lock();
+	__ASSERT_NO_MSG(queue->count > 0);
+	seg = queue->segs[queue->head];
+	queue->head = (queue->head + 1) % UART_TX_QUEUE_LEN;
+	queue->count--;
+	irq_unlock(key);
+
+	uart_stats[dev_idx].tx += len;
+	bridge_buf_unref(seg.buf);
 }
 
+/* Queue a segment of a bridge buffer for TX, without copying it. */
 static int uart_tx_enqueue(uint8_t *data, size_t data_len, uint8_t dev_idx)
 {
+	struct uart_tx_queue *queue = &uart_tx_queues[dev_idx];
+	struct uart_tx_seg *tail;
 	atomic_t started;
-	uint32_t written;
+	unsigned int key;
 	int err;
 
-	written = ring_buf_put(&uart_tx_ringbufs[dev_idx].rb, data, data_len);
-	if (written == 0) {
+	key = irq_lock();
+
+	tail = &queue->segs[(queue->head + queue->count - 1) % UART_TX_QUEUE_LEN];
+
+	/* Data usually arrives in consecutive segments of the same buffer: */
+	/* extend the last segment unless it is being transmitted. */
+	/* Consecutive buffers are never contiguous, the header is between. */
+	if (queue->count > 1 ||
+	    (queue->count == 1 && !atomic_get(&uart_tx_started[dev_idx]))) {
+		if (tail->buf + tail->len == data) {
+			tail->len += data_len;
+			irq_unlock(key);
+			return 0;
+		}
+	}
+
+	if (queue->count == UART_TX_QUEUE_LEN) {
+		irq_unlock(key);
+		uart_stats[dev_idx].tx_dropped += data_len;
 		return -ENOMEM;
 	}
 
+	bridge_buf_ref(data);
+	tail = &queue->segs[(queue->head + queue->count) % UART_TX_QUEUE_LEN];
+	tail->buf = data;
+	tail->len = data_len;
+	queue->count++;
+
+	irq_unlock(key);
+
 	started = atomic_set(&uart_tx_started[dev_idx], true);
 	if (!started) {
 		err = uart_tx_start(dev_idx);
@@ -355,10 +373,41 @@ static int uart_tx_enqueue(uint8_t *data, size_t data_len, uint8_t dev_idx)
 		}
 	}
 
-	if (written == data_len) {
-		return 0;
-	} else {
-		return -ENOMEM;
+	return 0;
+}
+
+/* BLE data is copied into a bridge buffer before it is queued. */
+static int uart_tx_enqueue_copy(const uint8_t *data, size_t data_len,
+				uint8_t dev_idx)
+{
+	uint8_t *buf;
+	uint8_t *seg;
+	size_t space;
+	size_t len;
+	int err;
+
+	while (data_len > 0) {
+		buf = bridge_buf_writer_get(
+			&ble_tx_writer,
+			MIN(data_len, UART_BLE_TX_MIN_SPACE),
+			&space);
+		if (!buf) {
+			uart_stats[dev_idx].tx_dropped += data_len;
+			return -ENOMEM;
+		}
+
+		len = MIN(data_len, space);
+		memcpy(buf, data, len);
+		seg = bridge_buf_writer_commit(&ble_tx_writer, len);
+
+		err = uart_tx_enqueue(seg, len, dev_idx);
+		bridge_buf_unref(seg);
+		if (err) {
+			return err;
+		}
+
+		data += len;
+		data_len -= len;
 	}
 
 	return 0;
@@ -372,8 +421,8 @@ static bool event_handler(const struct event_header *eh)
 		const struct uart_data_event *event =
 			cast_uart_data_event(eh);
 
-		/* All subscribers have gotten a chance to copy data at this point */
-		uart_rx_buf_unref(event->buf);
+		/* All subscribers have gotten a chance to ref data at this point */
+		bridge_buf_unref(event->buf);
 
 		return true;
 	}
@@ -412,7 +461,7 @@ static bool event_handler(const struct event_header *eh)
 			return false;
 		}
 
-		err = uart_tx_enqueue(event->buf, event->len, dev_idx);
+		err = uart_tx_enqueue_copy(event->buf, event->len, dev_idx);
 		if (err == -ENOMEM) {
 			LOG_WRN("BLE->UART_%d overflow", dev_idx);
 		} else if (err) {
@@ -490,15 +539,15 @@ static bool event_handler(const struct event_header *eh)
 
 				atomic_set(&uart_tx_started[i], false);
 
-				ring_buf_init(
-					&uart_tx_ringbufs[i].rb,
-					sizeof(uart_tx_ringbufs[i].buf),
-					uart_tx_ringbufs[i].buf);
-
 				if (UART_SET_PM_STATE) {
 					set_uart_power_state(i, false);
 				}
 			}
+
+#if CONFIG_BRIDGE_STATS_INTERVAL > 0
+			k_work_reschedule(&stats_work,
+					  K_SECONDS(CONFIG_BRIDGE_STATS_INTERVAL));
+#endif
 		}
 
 		return false;
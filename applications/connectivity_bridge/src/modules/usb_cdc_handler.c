@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
  */
 #include <stdio.h>
+#include <string.h>
 #include <zephyr/types.h>
 #include <drivers/uart.h>
 #include <usb/usb_device.h>
@@ -13,6 +14,7 @@
 #include "peer_conn_event.h"
 #include "cdc_data_event.h"
 #include "uart_data_event.h"
+#include "bridge_buf.h"
 
 #include <logging/log.h>
 LOG_MODULE_REGISTER(MODULE, CONFIG_BRIDGE_CDC_LOG_LEVEL);
@@ -21,20 +23,28 @@ LOG_MODULE_REGISTER(MODULE, CONFIG_BRIDGE_CDC_LOG_LEVEL);
 #define CDC_DEVICE_NAME_TEMPLATE CONFIG_USB_CDC_ACM_DEVICE_NAME "_%d"
 
 #define USB_CDC_DTR_POLL_MS 500
-#define USB_CDC_RX_BLOCK_SIZE CONFIG_BRIDGE_BUF_SIZE
-#define USB_CDC_RX_BLOCK_COUNT (CDC_DEVICE_COUNT * 3)
-#define USB_CDC_SLAB_ALIGNMENT 4
+/* Max packet size of a full speed bulk endpoint */
+#define USB_CDC_RX_MIN_SPACE 64
+
+struct cdc_stats {
+	uint32_t rx;
+	uint32_t tx;
+	uint32_t rx_dropped;
+	uint32_t tx_dropped;
+};
 
 static void cdc_dtr_timer_handler(struct k_timer *timer);
 static void cdc_dtr_work_handler(struct k_work *work);
 
 static K_TIMER_DEFINE(cdc_dtr_timer, cdc_dtr_timer_handler, NULL);
 static K_WORK_DEFINE(cdc_dtr_work, cdc_dtr_work_handler);
-/* Incoming data from any CDC instance is copied into a block from this slab */
-K_MEM_SLAB_DEFINE(cdc_rx_slab, USB_CDC_RX_BLOCK_SIZE, USB_CDC_RX_BLOCK_COUNT, USB_CDC_SLAB_ALIGNMENT);
 
 static const struct device *devices[CDC_DEVICE_COUNT];
 static uint32_t cdc_ready[CDC_DEVICE_COUNT];
+/* Incoming data is read into bridge buffers, one segment per FIFO read. */
+/* The UART module transmits the data straight from these buffers. */
+static struct bridge_buf_writer rx_writers[CDC_DEVICE_COUNT];
+static struct cdc_stats cdc_stats[CDC_DEVICE_COUNT];
 
 static uint8_t overflow_buf[64];
 
@@ -43,6 +53,36 @@ static void cdc_dtr_timer_handler(struct k_timer *timer)
 	k_work_submit(&cdc_dtr_work);
 }
 
+#if CONFIG_BRIDGE_STATS_INTERVAL > 0
+static void stats_work_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(stats_work, stats_work_handler);
+
+static void stats_work_handler(struct k_work *work)
+{
+	for (int i = 0; i < CDC_DEVICE_COUNT; ++i) {
+		struct cdc_stats stats;
+		unsigned int key = irq_lock();
+
+		stats = cdc_stats[i];
+		memset(&cdc_stats[i], 0, sizeof(cdc_stats[i]));
+		irq_unlock(key);
+
+		if (stats.rx || stats.tx || stats.rx_dropped || stats.tx_dropped) {
+			LOG_INF("CDC_%d rx: %u B/s, tx: %u B/s, "
+				"rx dropped: %u B, tx dropped: %u B",
+				i,
+				stats.rx / CONFIG_BRIDGE_STATS_INTERVAL,
+				stats.tx / CONFIG_BRIDGE_STATS_INTERVAL,
+				stats.rx_dropped,
+				stats.tx_dropped);
+		}
+	}
+
+	k_work_reschedule(&stats_work, K_SECONDS(CONFIG_BRIDGE_STATS_INTERVAL));
+}
+#endif
+
 static void poll_dtr(void)
 {
 	for (int i = 0; i < CDC_DEVICE_COUNT; ++i) {
@@ -94,8 +134,8 @@ static void cdc_uart_interrupt_handler(const struct device *dev, void *user_data
 	uart_irq_update(dev);
 
 	while (uart_irq_rx_ready(dev)) {
-		void *rx_buf;
-		int err;
+		uint8_t *rx_buf;
+		size_t space;
 		int data_length;
 
 		if (cdc_ready[dev_idx] == 0) {
@@ -103,28 +143,33 @@ static void cdc_uart_interrupt_handler(const struct device *dev, void *user_data
 			poll_dtr();
 		}
 
-		err = k_mem_slab_alloc(&cdc_rx_slab, &rx_buf, K_NO_WAIT);
-		if (err) {
+		rx_buf = bridge_buf_writer_get(&rx_writers[dev_idx],
+					       USB_CDC_RX_MIN_SPACE,
+					       &space);
+		if (!rx_buf) {
 			data_length = uart_fifo_read(
 				dev,
 				overflow_buf,
 				sizeof(overflow_buf));
+			cdc_stats[dev_idx].rx_dropped += data_length;
 			LOG_WRN("CDC_%d RX overflow", dev_idx);
 		} else {
 			data_length = uart_fifo_read(
 				dev,
 				rx_buf,
-				USB_CDC_RX_BLOCK_SIZE);
+				space);
 
 			if (data_length) {
 				struct cdc_data_event *event = new_cdc_data_event();
 
 				event->dev_idx = dev_idx;
-				event->buf = rx_buf;
+				event->buf = bridge_buf_writer_commit(
+					&rx_writers[dev_idx],
+					data_length);
 				event->len = data_length;
 				EVENT_SUBMIT(event);
-			} else {
-				k_mem_slab_free(&cdc_rx_slab, &rx_buf);
+
+				cdc_stats[dev_idx].rx += data_length;
 			}
 		}
 	}
@@ -190,7 +235,10 @@ static bool event_handler(const struct event_header *eh)
 			event->buf,
 			event->len);
 
+		cdc_stats[event->dev_idx].tx += tx_written;
 		if (tx_written != event->len) {
+			cdc_stats[event->dev_idx].tx_dropped +=
+				event->len - tx_written;
 			LOG_DBG("UART_%d->CDC_%d overflow",
 				event->dev_idx,
 				event->dev_idx);
@@ -203,8 +251,8 @@ static bool event_handler(const struct event_header *eh)
 		const struct cdc_data_event *event =
 			cast_cdc_data_event(eh);
 
-		/* All subscribers have gotten a chance to copy data at this point */
-		k_mem_slab_free(&cdc_rx_slab, (void **) &event->buf);
+		/* All subscribers have gotten a chance to ref data at this point */
+		bridge_buf_unref(event->buf);
 
 		return true;
 	}
@@ -256,6 +304,11 @@ static bool event_handler(const struct event_header *eh)
 				&cdc_dtr_timer,
 				K_MSEC(USB_CDC_DTR_POLL_MS),
 				K_MSEC(USB_CDC_DTR_POLL_MS));
+
+#if CONFIG_BRIDGE_STATS_INTERVAL > 0
+			k_work_reschedule(&stats_work,
+					  K_SECONDS(CONFIG_BRIDGE_STATS_INTERVAL));
+#endif
 		}
 
 		return false;
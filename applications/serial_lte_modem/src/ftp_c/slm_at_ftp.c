@@ -62,6 +62,10 @@ static bool ftp_verbose_on;
 static char filepath[FTP_MAX_FILEPATH];
 static int sz_filepath;
 static int (*ftp_data_mode_handler)(const uint8_t *data, int len);
+static bool ftp_mput_streaming;
+
+static void ftp_mput_close(struct k_work *work);
+K_WORK_DEFINE(ftp_mput_close_work, ftp_mput_close);
 
 /** forward declaration of cmd handlers **/
 static int do_ftp_close(void);
@@ -468,6 +472,12 @@ static int ftp_datamode_callback(uint8_t op, const uint8_t *data, int len)
 			LOG_ERR("no datamode send handler");
 		}
 	} else if (op == DATAMODE_EXIT) {
+		if (ftp_mput_streaming) {
+			/* May be called from timer context, close in the same
+			 * work queue that writes the data.
+			 */
+			k_work_submit(&ftp_mput_close_work);
+		}
 		ftp_data_mode_handler = NULL;
 	}
 
@@ -628,16 +638,45 @@ static int do_ftp_uput(void)
 	return ret;
 }
 
-/* FTP UPUT data mode handler */
+static void ftp_mput_close(struct k_work *work)
+{
+	int ret;
+
+	ARG_UNUSED(work);
+
+	ret = ftp_put_stream_close();
+	if (ret != FTP_CODE_226) {
+		LOG_WRN("mput stream close: %d", ret);
+	}
+	ftp_mput_streaming = false;
+}
+
+/* FTP MPUT data mode handler */
 static int ftp_mput_handler(const uint8_t *data, int len)
 {
-	int ret = -1;
+	int ret;
 
-	if (strlen(filepath) > 0 && data != NULL) {
-		ret = ftp_put(filepath, data, len, FTP_PUT_APPEND);
+	if (strlen(filepath) == 0 || data == NULL) {
+		return -1;
 	}
 
-	return (ret == FTP_CODE_226) ? 0 : -1;
+	/* Keep one data connection open for the whole data mode session */
+	if (!ftp_mput_streaming) {
+		ret = ftp_put_stream_open(filepath, FTP_PUT_APPEND, 0);
+		if (ret != FTP_CODE_150) {
+			return -1;
+		}
+		ftp_mput_streaming = true;
+	}
+
+	ret = ftp_put_stream_write(data, len);
+	if (ret) {
+		LOG_ERR("stream write failed: %d", ret);
+		(void)ftp_put_stream_close();
+		ftp_mput_streaming = false;
+	}
+
+	return ret;
 }
 
 /* AT#XFTP="mput",<file>,<datatype>[,<data>] */
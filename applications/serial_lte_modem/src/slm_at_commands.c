@@ -11,6 +11,7 @@
 #include <logging/log.h>
 #include <drivers/uart.h>
 #include <string.h>
+#include <strings.h>
 #include <init.h>
 #include <modem/at_cmd.h>
 #include <modem/at_cmd_parser.h>
@@ -314,6 +315,7 @@ int handle_at_udp_send(enum at_cmd_type cmd_type);
 
 /* Socket-type TCPIP commands */
 int handle_at_socket(enum at_cmd_type cmd_type);
+int handle_at_socket_select(enum at_cmd_type cmd_type);
 int handle_at_socketopt(enum at_cmd_type cmd_type);
 int handle_at_bind(enum at_cmd_type cmd_type);
 int handle_at_connect(enum at_cmd_type cmd_type);
@@ -393,6 +395,7 @@ static struct slm_at_cmd {
 
 	/* Socket-type TCPIP commands */
 	{"AT#XSOCKET", handle_at_socket},
+	{"AT#XSOCKETSELECT", handle_at_socket_select},
 	{"AT#XSOCKETOPT", handle_at_socketopt},
 	{"AT#XBIND", handle_at_bind},
 	{"AT#XCONNECT", handle_at_connect},
@@ -449,6 +452,39 @@ static struct slm_at_cmd {
 #endif
 };
 
+/* Indexes of slm_at_cmd_list, sorted by command name for binary search */
+static uint8_t slm_at_cmd_sorted[ARRAY_SIZE(slm_at_cmd_list)];
+
+BUILD_ASSERT(ARRAY_SIZE(slm_at_cmd_list) <= UINT8_MAX, "Too many SLM AT commands");
+
+static void slm_at_cmd_sort(void)
+{
+	/* Insertion sort, done once at init time */
+	for (int i = 0; i < ARRAY_SIZE(slm_at_cmd_list); i++) {
+		int j = i;
+
+		while (j > 0 && strcasecmp(slm_at_cmd_list[slm_at_cmd_sorted[j - 1]].string,
+					   slm_at_cmd_list[i].string) > 0) {
+			slm_at_cmd_sorted[j] = slm_at_cmd_sorted[j - 1];
+			j--;
+		}
+		slm_at_cmd_sorted[j] = i;
+	}
+}
+
+/* Compare the command name in the first name_len chars of at_cmd */
+static int slm_at_cmd_cmp(const char *at_cmd, size_t name_len, const char *slm_cmd)
+{
+	int ret = strncasecmp(at_cmd, slm_cmd, name_len);
+
+	if (ret == 0 && slm_cmd[name_len] != '\0') {
+		/* at_cmd name is a prefix of slm_cmd */
+		ret = -1;
+	}
+
+	return ret;
+}
+
 int handle_at_clac(enum at_cmd_type cmd_type)
 {
 	int ret = -EINVAL;
@@ -466,26 +502,33 @@ int handle_at_clac(enum at_cmd_type cmd_type)
 	return ret;
 }
 
-int slm_at_parse(const char *at_cmd)
+int slm_at_parse(const char *at_cmd, size_t name_len)
 {
-	int ret = -ENOENT;
-	int total = ARRAY_SIZE(slm_at_cmd_list);
-
-	for (int i = 0; i < total; i++) {
-		if (slm_util_cmd_casecmp(at_cmd, slm_at_cmd_list[i].string)) {
+	int lo = 0;
+	int hi = ARRAY_SIZE(slm_at_cmd_list) - 1;
+
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		const struct slm_at_cmd *cmd = &slm_at_cmd_list[slm_at_cmd_sorted[mid]];
+		int cmp = slm_at_cmd_cmp(at_cmd, name_len, cmd->string);
+
+		if (cmp < 0) {
+			hi = mid - 1;
+		} else if (cmp > 0) {
+			lo = mid + 1;
+		} else {
 			enum at_cmd_type type = at_parser_cmd_type_get(at_cmd);
+			int ret = at_parser_params_from_str(at_cmd, NULL, &at_param_list);
 
-			ret = at_parser_params_from_str(at_cmd, NULL, &at_param_list);
 			if (ret) {
 				LOG_ERR("Failed to parse AT command %d", ret);
 				return -EINVAL;
 			}
-			ret = slm_at_cmd_list[i].handler(type);
-			break;
+			return cmd->handler(type);
 		}
 	}
 
-	return ret;
+	return -ENOENT;
 }
 
 int slm_at_init(void)
@@ -493,6 +536,7 @@ int slm_at_init(void)
 	int err;
 
 	k_work_init_delayable(&slm_work.work, set_uart_wk);
+	slm_at_cmd_sort();
 
 	err = slm_at_tcp_proxy_init();
 	if (err) {
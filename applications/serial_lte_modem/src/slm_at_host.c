@@ -9,7 +9,6 @@
 #include <ctype.h>
 #include <logging/log.h>
 #include <drivers/uart.h>
-#include <sys/ring_buffer.h>
 #include <string.h>
 #include <init.h>
 #include <modem/at_cmd.h>
@@ -31,8 +30,9 @@ LOG_MODULE_REGISTER(at_host, CONFIG_SLM_LOG_LEVEL);
  *  Modem library's NRF_MODEM_AT_MAX_CMD_SIZE */
 #define AT_MAX_CMD_LEN          4096
 
-#define UART_RX_BUF_NUM         2
+#define UART_RX_BUF_NUM         8
 #define UART_RX_LEN             256
+#define UART_RX_POOL_LEN        (UART_RX_BUF_NUM * UART_RX_LEN)
 #define UART_RX_TIMEOUT_MS      1
 #define UART_ERROR_DELAY_MS     500
 #define UART_RX_MARGIN_MS       10
@@ -46,15 +46,43 @@ static const struct device *uart_dev;
 static uint8_t at_buf[AT_MAX_CMD_LEN];
 static uint16_t at_buf_len;
 static bool at_buf_overflow;
-static struct ring_buf data_rb;
 static bool datamode_off_pending;
 static bool datamode_rx_disabled;
 static slm_datamode_handler_t datamode_handler;
 static struct k_work raw_send_work;
 static struct k_work cmd_send_work;
 
-static uint8_t uart_rx_buf[UART_RX_BUF_NUM][UART_RX_LEN];
-static uint8_t *next_buf = uart_rx_buf[1];
+/* UART RX buffers are consecutive parts of one pool, so that data received
+ * into several of them can be passed on without copying. In data mode, a
+ * buffer is handed to UART again only after its data has been sent.
+ */
+static uint8_t uart_rx_pool[UART_RX_POOL_LEN];
+static uint16_t rx_buf_base;  /* Pool offset of the last buffer given to UART */
+static uint16_t rx_end;       /* End of received data in the pool */
+static uint16_t tx_pos;       /* Start of data not yet sent in data mode */
+static bool rx_wrapped;       /* Reception continued at the pool start */
+static uint16_t wrap_end;     /* End of data received before wrapping */
+static uint16_t quit_start;   /* Terminator held until silence is confirmed */
+static uint16_t quit_end;
+static struct k_spinlock rx_lock;
+
+/* AT command grammar check state, see cmd_grammar_step() */
+enum cmd_grammar {
+	GRAMMAR_A,		/* expecting A */
+	GRAMMAR_T,		/* expecting T */
+	GRAMMAR_SEPARATOR,	/* AT, expecting <separator> or <NULL> */
+	GRAMMAR_BODY_START,	/* expecting first char of <body> */
+	GRAMMAR_BODY,		/* inside <body> */
+	GRAMMAR_SET,		/* after =, expecting ? or <parameters> or <NULL> */
+	GRAMMAR_END,		/* after ?, expecting <NULL> */
+	GRAMMAR_PARAMS,		/* inside <parameters>, not checked */
+	GRAMMAR_INVALID,
+	GRAMMAR_RECHECK		/* command edited, check once complete */
+};
+
+static enum cmd_grammar at_grammar;
+static uint16_t at_name_len;	/* length of AT<separator><body> */
+
 static uint8_t *uart_tx_buf;
 static bool uart_recovery_pending;
 static struct k_work_delayable uart_recovery_work;
@@ -62,7 +90,7 @@ static struct k_work_delayable uart_recovery_work;
 static K_SEM_DEFINE(tx_done, 0, 1);
 
 /* global functions defined in different files */
-int slm_at_parse(const char *at_cmd);
+int slm_at_parse(const char *at_cmd, size_t name_len);
 int slm_at_init(void);
 void slm_at_uninit(void);
 int slm_setting_uart_save(void);
@@ -77,20 +105,14 @@ uint16_t datamode_time_limit;               /* Send trigger by time in data mode
 extern bool uart_configured;
 extern struct uart_config slm_uart;
 
-static int uart_send(const uint8_t *str, size_t len)
+/* Transmit a buffer allocated with k_malloc, which is freed when done */
+static int uart_send_buf(uint8_t *buf, size_t len)
 {
 	int ret;
 
 	k_sem_take(&tx_done, K_FOREVER);
 
-	uart_tx_buf = k_malloc(len);
-	if (uart_tx_buf == NULL) {
-		LOG_WRN("No ram buffer");
-		k_sem_give(&tx_done);
-		return -ENOMEM;
-	}
-
-	memcpy(uart_tx_buf, str, len);
+	uart_tx_buf = buf;
 	ret = uart_tx(uart_dev, uart_tx_buf, len, SYS_FOREVER_MS);
 	if (ret) {
 		LOG_WRN("uart_tx failed: %d", ret);
@@ -101,6 +123,19 @@ static int uart_send(const uint8_t *str, size_t len)
 	return ret;
 }
 
+static int uart_send(const uint8_t *str, size_t len)
+{
+	uint8_t *buf = k_malloc(len);
+
+	if (buf == NULL) {
+		LOG_WRN("No ram buffer");
+		return -ENOMEM;
+	}
+
+	memcpy(buf, str, len);
+	return uart_send_buf(buf, len);
+}
+
 void rsp_send(const uint8_t *str, size_t len)
 {
 	if (len == 0) {
@@ -111,11 +146,41 @@ void rsp_send(const uint8_t *str, size_t len)
 	(void)uart_send(str, len);
 }
 
+uint8_t *rsp_buf_alloc(size_t len)
+{
+	uint8_t *buf = k_malloc(len);
+
+	if (buf == NULL) {
+		LOG_WRN("No ram buffer");
+	}
+
+	return buf;
+}
+
+void rsp_send_buf(uint8_t *buf, size_t len)
+{
+	if (len == 0) {
+		k_free(buf);
+		return;
+	}
+
+	LOG_HEXDUMP_DBG(buf, len, "TX");
+	(void)uart_send_buf(buf, len);
+}
+
 static int uart_receive(void)
 {
+	k_spinlock_key_t key = k_spin_lock(&rx_lock);
 	int ret;
 
-	ret = uart_rx_enable(uart_dev, uart_rx_buf[0], sizeof(uart_rx_buf[0]), UART_RX_TIMEOUT_MS);
+	rx_buf_base = 0;
+	rx_end = 0;
+	tx_pos = 0;
+	rx_wrapped = false;
+	k_spin_unlock(&rx_lock, key);
+	at_grammar = GRAMMAR_A;
+
+	ret = uart_rx_enable(uart_dev, uart_rx_pool, UART_RX_LEN, UART_RX_TIMEOUT_MS);
 	if (ret) {
 		LOG_ERR("UART RX failed: %d", ret);
 		rsp_send(FATAL_STR, sizeof(FATAL_STR) - 1);
@@ -138,14 +203,20 @@ static void uart_recovery(struct k_work *work)
 
 int enter_datamode(slm_datamode_handler_t handler)
 {
+	k_spinlock_key_t key;
+
 	if (handler == NULL || datamode_handler != NULL) {
 		LOG_INF("Invalid, not enter datamode");
 		return -EINVAL;
 	}
 
-	ring_buf_init(&data_rb, sizeof(at_buf) / 2, at_buf);
 	datamode_handler = handler;
+	/* Data received from now on is sent, the rest was AT commands */
+	key = k_spin_lock(&rx_lock);
+	tx_pos = rx_end;
+	rx_wrapped = false;
 	slm_operation_mode = SLM_DATA_MODE;
+	k_spin_unlock(&rx_lock, key);
 	LOG_INF("Enter datamode");
 
 	return 0;
@@ -154,13 +225,13 @@ int enter_datamode(slm_datamode_handler_t handler)
 bool exit_datamode(void)
 {
 	if (slm_operation_mode == SLM_DATA_MODE) {
-		ring_buf_reset(&data_rb);
-		/* reset UART to restore command mode */
+		slm_operation_mode = SLM_AT_COMMAND_MODE;
+		datamode_handler = NULL;
+		/* reset UART to restore command mode, dropping unsent data */
 		uart_rx_disable(uart_dev);
 		k_sleep(K_MSEC(10));
+		datamode_rx_disabled = false;
 		(void) uart_receive();
-		slm_operation_mode = SLM_AT_COMMAND_MODE;
-		datamode_handler = NULL;
 		LOG_INF("Exit datamode");
 		return true;
 	}
@@ -263,26 +334,55 @@ static void response_handler(void *context, const char *response)
 	}
 }
 
+static bool datamode_data_pending(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&rx_lock);
+	bool pending = rx_wrapped || (tx_pos != rx_end);
+
+	k_spin_unlock(&rx_lock, key);
+
+	return pending;
+}
+
 static void raw_send(struct k_work *work)
 {
-	ARG_UNUSED(work);
+	k_spinlock_key_t key;
+	uint16_t start, end;
+	bool wrapped;
 
-	const uint32_t tx_buf_size = sizeof(at_buf) / 2;
-	uint32_t size = ring_buf_get(&data_rb, &at_buf[tx_buf_size], tx_buf_size);
+	ARG_UNUSED(work);
 
-	if (size > 0) {
-		LOG_INF("Raw send %d", size);
-		LOG_HEXDUMP_DBG(&at_buf[tx_buf_size], size, "RX");
-		if (datamode_handler) {
-			(void)datamode_handler(DATAMODE_SEND, &at_buf[tx_buf_size], size);
-		} else {
-			LOG_WRN("no handler, data dropped");
+	/* Pass received data straight from the UART RX buffers, in at most
+	 * two parts if reception continued at the start of the pool.
+	 */
+	do {
+		key = k_spin_lock(&rx_lock);
+		wrapped = rx_wrapped;
+		start = tx_pos;
+		end = wrapped ? wrap_end : rx_end;
+		k_spin_unlock(&rx_lock, key);
+
+		if (end > start) {
+			LOG_INF("Raw send %d", end - start);
+			LOG_HEXDUMP_DBG(&uart_rx_pool[start], end - start, "RX");
+			if (datamode_handler) {
+				(void)datamode_handler(DATAMODE_SEND, &uart_rx_pool[start],
+						       end - start);
+			} else {
+				LOG_WRN("no handler, data dropped");
+			}
 		}
-	}
-	/* resume UART RX in case of stopped by buffer full */
-	if (datamode_rx_disabled) {
-		uart_receive();
+
+		key = k_spin_lock(&rx_lock);
+		tx_pos = wrapped ? 0 : end;
+		rx_wrapped = false;
+		k_spin_unlock(&rx_lock, key);
+	} while (wrapped);
+
+	/* resume UART RX in case of stopped by lack of free buffers */
+	if (datamode_rx_disabled && slm_operation_mode == SLM_DATA_MODE) {
 		datamode_rx_disabled = false;
+		uart_receive();
 	}
 }
 
@@ -291,7 +391,7 @@ static void inactivity_timer_handler(struct k_timer *timer)
 	ARG_UNUSED(timer);
 
 	LOG_INF("time limit reached");
-	if (!ring_buf_is_empty(&data_rb)) {
+	if (datamode_data_pending()) {
 		k_work_submit(&raw_send_work);
 	} else {
 		LOG_WRN("data buffer empty");
@@ -323,9 +423,60 @@ static void silence_timer_handler(struct k_timer *timer)
 
 K_TIMER_DEFINE(silence_timer, silence_timer_handler, NULL);
 
+/* Called with rx_lock held */
+static bool rx_buf_overlaps(uint16_t base, uint16_t start, uint16_t end)
+{
+	return (base < end) && (start < base + UART_RX_LEN);
+}
+
+/* Find the next UART RX buffer, if it holds no data still to be sent */
+static uint8_t *rx_buf_next(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&rx_lock);
+	uint16_t base = rx_buf_base + UART_RX_LEN;
+	uint8_t *buf = NULL;
+
+	if (base >= UART_RX_POOL_LEN) {
+		base = 0;
+	}
+
+	if (slm_operation_mode == SLM_DATA_MODE) {
+		if (base == 0 && rx_wrapped) {
+			/* Data is sent in at most two parts, so reception
+			 * wraps only once. It stops at the end of the pool
+			 * and resumes when the data is sent.
+			 */
+			goto out;
+		}
+		if (rx_wrapped ? (rx_buf_overlaps(base, tx_pos, wrap_end) ||
+				  rx_buf_overlaps(base, 0, rx_end)) :
+				 rx_buf_overlaps(base, tx_pos, rx_end)) {
+			goto out;
+		}
+	}
+
+	rx_buf_base = base;
+	buf = &uart_rx_pool[base];
+out:
+	k_spin_unlock(&rx_lock, key);
+	return buf;
+}
+
+/* Called with rx_lock held */
+static void raw_rx_accept(uint16_t start, uint16_t end)
+{
+	if (start < rx_end) {
+		/* Reception continued at the start of the pool */
+		rx_wrapped = true;
+		wrap_end = rx_end;
+	}
+	rx_end = end;
+}
+
 static int raw_rx_handler(const uint8_t *data, int datalen)
 {
-	int ret;
+	k_spinlock_key_t key;
+	uint16_t start = data - uart_rx_pool;
 	const char *quit_str = CONFIG_SLM_DATAMODE_TERMINATOR;
 	int quit_str_len = strlen(quit_str);
 	int64_t silence = CONFIG_SLM_DATAMODE_SILENCE * MSEC_PER_SEC;
@@ -337,13 +488,17 @@ static int raw_rx_handler(const uint8_t *data, int datalen)
 			/* quit procedure aborted */
 			k_timer_stop(&silence_timer);
 			datamode_off_pending = false;
-			(void)ring_buf_put(&data_rb, quit_str, quit_str_len);
+			key = k_spin_lock(&rx_lock);
+			raw_rx_accept(quit_start, quit_end);
+			k_spin_unlock(&rx_lock, key);
 			LOG_INF("datamode off cancelled");
 		}
 	} else {
 		/* leading silence confirmed */
 		if (datalen == quit_str_len && strncmp(data, quit_str, quit_str_len) == 0) {
 			datamode_off_pending = true;
+			quit_start = start;
+			quit_end = start + datalen;
 			/* check subordinate silence */
 			k_timer_start(&silence_timer, K_SECONDS(CONFIG_SLM_DATAMODE_SILENCE),
 				      K_NO_WAIT);
@@ -357,19 +512,10 @@ static int raw_rx_handler(const uint8_t *data, int datalen)
 		k_timer_stop(&inactivity_timer);
 	}
 
-	/* Second, save data to buffer */
-	ret = ring_buf_put(&data_rb, data, datalen);
-	if (ret != datalen) {
-		LOG_ERR("enqueue data error (%d, %d)", datalen, ret);
-		uart_rx_disable(uart_dev);
-		return -1;
-	}
-	ret = ring_buf_space_get(&data_rb);
-	if (ret < UART_RX_LEN) {
-		LOG_WRN("data buffer full (%d)", ret);
-		uart_rx_disable(uart_dev);
-		return -1;
-	}
+	/* Second, mark data in the RX buffer to be sent */
+	key = k_spin_lock(&rx_lock);
+	raw_rx_accept(start, start + datalen);
+	k_spin_unlock(&rx_lock, key);
 
 	/* Third, start/restart inactivity timer, or trigger sending */
 	if (datamode_time_limit > 0) {
@@ -394,81 +540,80 @@ static int raw_rx_handler(const uint8_t *data, int datalen)
  * <separator>: +, %, #
  * <body>: alphanumeric char only, size > 0
  * <parameters>: arbitrary, size > 0
+ *
+ * The check is done one character at a time while the command is received.
  */
-static int cmd_grammar_check(const uint8_t *cmd, uint16_t length)
+static enum cmd_grammar cmd_grammar_step(enum cmd_grammar state, uint8_t ch)
 {
-	const uint8_t *body;
-
-	/* check AT (if not, no check) */
-	if (length < 2 || toupper((int)cmd[0]) != 'A' || toupper((int)cmd[1]) != 'T') {
-		return -EINVAL;
-	}
-
-	/* check AT<NULL> */
-	cmd += 2;
-	if (*cmd == '\0') {
-		return 0;
-	}
-
-	/* check AT<separator> */
-	if ((*cmd != '+') && (*cmd != '%') && (*cmd != '#')) {
-		return -EINVAL;
-	}
-
-	/* check AT<separator><body> */
-	cmd += 1;
-	body = cmd;
-	while (true) {
-		/* check body is alphanumeric */
-		if (!isalpha((int)*cmd) && !isdigit((int)*cmd)) {
-			break;
+	switch (state) {
+	case GRAMMAR_A:
+		return (toupper((int)ch) == 'A') ? GRAMMAR_T : GRAMMAR_INVALID;
+	case GRAMMAR_T:
+		return (toupper((int)ch) == 'T') ? GRAMMAR_SEPARATOR : GRAMMAR_INVALID;
+	case GRAMMAR_SEPARATOR:
+		if ((ch == '+') || (ch == '%') || (ch == '#')) {
+			return GRAMMAR_BODY_START;
 		}
-		cmd++;
-	}
-
-	/* check body size > 0 */
-	if (cmd == body) {
-		return -EINVAL;
-	}
-
-	/* check AT<separator><body><NULL> */
-	if (*cmd == '\0') {
-		return 0;
+		return GRAMMAR_INVALID;
+	case GRAMMAR_BODY_START:
+		return isalnum((int)ch) ? GRAMMAR_BODY : GRAMMAR_INVALID;
+	case GRAMMAR_BODY:
+		if (isalnum((int)ch)) {
+			return GRAMMAR_BODY;
+		} else if (ch == '=') {
+			return GRAMMAR_SET;
+		} else if (ch == '?') {
+			return GRAMMAR_END;
+		}
+		return GRAMMAR_INVALID;
+	case GRAMMAR_SET:
+		return (ch == '?') ? GRAMMAR_END : GRAMMAR_PARAMS;
+	case GRAMMAR_PARAMS:
+		return GRAMMAR_PARAMS;
+	case GRAMMAR_RECHECK:
+		return GRAMMAR_RECHECK;
+	default:
+		return GRAMMAR_INVALID;
 	}
+}
 
-	/* check AT<separator><body>= or check AT<separator><body>? */
-	if (*cmd != '=' && *cmd != '?') {
-		return -EINVAL;
-	}
+/* Feed one received character, noting where the command name ends */
+static inline void cmd_grammar_update(uint8_t ch, uint16_t pos)
+{
+	enum cmd_grammar next = cmd_grammar_step(at_grammar, ch);
 
-	/* check AT<separator><body>?<NULL> */
-	if (*cmd == '?') {
-		cmd += 1;
-		if (*cmd == '\0') {
-			return 0;
-		} else {
-			return -EINVAL;
-		}
+	if (at_grammar == GRAMMAR_BODY && next != GRAMMAR_BODY) {
+		at_name_len = pos;
 	}
+	at_grammar = next;
+}
 
-	/* check AT<separator><body>=<NULL> */
-	cmd += 1;
-	if (*cmd == '\0') {
+static int cmd_grammar_result(uint16_t length)
+{
+	switch (at_grammar) {
+	case GRAMMAR_SEPARATOR:
+	case GRAMMAR_BODY:
+		at_name_len = length;
+		return 0;
+	case GRAMMAR_SET:
+	case GRAMMAR_END:
+	case GRAMMAR_PARAMS:
 		return 0;
+	default:
+		return -EINVAL;
 	}
+}
 
-	/* check AT<separator><body>=?<NULL> */
-	if (*cmd == '?') {
-		cmd += 1;
-		if (*cmd == '\0') {
-			return 0;
-		} else {
-			return -EINVAL;
+static int cmd_grammar_check(const uint8_t *cmd, uint16_t length)
+{
+	if (at_grammar == GRAMMAR_RECHECK) {
+		at_grammar = GRAMMAR_A;
+		for (uint16_t i = 0; i < length; i++) {
+			cmd_grammar_update(cmd[i], i);
 		}
 	}
 
-	/* no need to check AT<separator><body>=<parameters><NULL> */
-	return 0;
+	return cmd_grammar_result(length);
 }
 
 static void cmd_send(struct k_work *work)
@@ -492,7 +637,7 @@ static void cmd_send(struct k_work *work)
 		goto done;
 	}
 
-	err = slm_at_parse(at_buf);
+	err = slm_at_parse(at_buf, at_name_len);
 	if (err == 0) {
 		rsp_send(OK_STR, sizeof(OK_STR) - 1);
 		goto done;
@@ -539,64 +684,89 @@ done:
 	(void)uart_receive();
 }
 
-static int cmd_rx_handler(uint8_t character)
+static int cmd_rx_handler(const uint8_t *buf, size_t len)
 {
 	static bool inside_quotes;
+	static bool cr_pending;
 	static size_t at_cmd_len;
+	uint8_t character;
 
-	/* Handle control characters */
-	switch (character) {
-	case 0x08: /* Backspace. */
-		/* Fall through. */
-	case 0x7F: /* DEL character */
-		if (at_cmd_len > 0) {
-			at_cmd_len--;
-		}
-		return 0;
-	}
+	for (size_t i = 0; i < len; i++) {
+		character = buf[i];
 
-	/* Handle termination characters, if outside quotes. */
-	if (!inside_quotes) {
+		/* Handle control characters */
 		switch (character) {
-		case '\r':
+		case 0x08: /* Backspace. */
+			/* Fall through. */
+		case 0x7F: /* DEL character */
+			if (cr_pending) {
+				cr_pending = false;
+			} else if (at_cmd_len > 0) {
+				at_cmd_len--;
+				at_grammar = GRAMMAR_RECHECK;
+			}
+			continue;
+		}
+
+#if defined(CONFIG_SLM_CR_LF_TERMINATION)
+		if (cr_pending) {
+			cr_pending = false;
+			if (character == '\n') {
+				goto send;
+			}
+			/* Not a termination, keep the CR char */
+			at_buf[at_cmd_len] = '\r';
+			cmd_grammar_update('\r', at_cmd_len);
+			at_cmd_len++;
+			if (at_cmd_len > sizeof(at_buf) - 1) {
+				goto overflow;
+			}
+		}
+#endif
+		/* Handle termination characters, if outside quotes. */
+		if (!inside_quotes) {
+			switch (character) {
+			case '\r':
 #if defined(CONFIG_SLM_CR_TERMINATION)
-			goto send;
+				goto send;
+#elif defined(CONFIG_SLM_CR_LF_TERMINATION)
+				cr_pending = true;
+				continue;
 #else
-			break;
+				break;
 #endif
-		case '\n':
+			case '\n':
 #if defined(CONFIG_SLM_LF_TERMINATION)
-			goto send;
-#elif defined(CONFIG_SLM_CR_LF_TERMINATION)
-			if (at_cmd_len > 0 && at_buf[at_cmd_len - 1] == '\r') {
-				at_cmd_len--; /* trim the CR char */
 				goto send;
-			}
 #endif
-			break;
+				break;
+			}
 		}
-	}
 
-	/* Write character to AT buffer */
-	at_buf[at_cmd_len] = character;
-	at_cmd_len++;
+		/* Write character to AT buffer */
+		at_buf[at_cmd_len] = character;
+		cmd_grammar_update(character, at_cmd_len);
+		at_cmd_len++;
 
-	/* Detect AT command buffer overflow, leaving space for null */
-	if (at_cmd_len > sizeof(at_buf) - 1) {
-		LOG_ERR("Buffer overflow");
-		at_cmd_len--;
-		at_buf_overflow = true;
-		goto send;
-	}
+		/* Detect AT command buffer overflow, leaving space for null */
+		if (at_cmd_len > sizeof(at_buf) - 1) {
+			goto overflow;
+		}
 
-	/* Handle special written character */
-	if (character == '"') {
-		inside_quotes = !inside_quotes;
+		/* Handle special written character */
+		if (character == '"') {
+			inside_quotes = !inside_quotes;
+		}
 	}
 
 	return 0;
 
+overflow:
+	LOG_ERR("Buffer overflow");
+	at_cmd_len--;
+	at_buf_overflow = true;
 send:
+	/* Rest of the chunk is dropped, RX restarts once command is handled */
 	uart_rx_disable(uart_dev);
 
 	at_buf[at_cmd_len] = '\0';
@@ -604,6 +774,7 @@ send:
 	k_work_submit(&cmd_send_work);
 
 	inside_quotes = false;
+	cr_pending = false;
 	at_cmd_len = 0;
 	if (at_buf_overflow) {
 		return -1;
@@ -614,7 +785,7 @@ send:
 static void uart_callback(const struct device *dev, struct uart_event *evt, void *user_data)
 {
 	int err;
-	static uint16_t pos;
+	uint8_t *buf;
 	static bool enable_rx_retry;
 
 	ARG_UNUSED(dev);
@@ -631,32 +802,38 @@ static void uart_callback(const struct device *dev, struct uart_event *evt, void
 		LOG_INF("TX_ABORTED");
 		break;
 	case UART_RX_RDY:
+		buf = &(evt->data.rx.buf[evt->data.rx.offset]);
 		if (slm_operation_mode == SLM_AT_COMMAND_MODE) {
-			for (int i = pos; i < (pos + evt->data.rx.len); i++) {
-				err = cmd_rx_handler(evt->data.rx.buf[i]);
-				if (err) {
-					return;
-				}
-			}
+			/* Data dropped on overflow is consumed as well */
+			(void)cmd_rx_handler(buf, evt->data.rx.len);
+			/* Data is consumed, keep track of it for datamode switch */
+			k_spinlock_key_t key = k_spin_lock(&rx_lock);
+
+			rx_end = buf + evt->data.rx.len - uart_rx_pool;
+			tx_pos = rx_end;
+			k_spin_unlock(&rx_lock, key);
 		} else if (slm_operation_mode == SLM_DATA_MODE) {
-			err = raw_rx_handler(&(evt->data.rx.buf[pos]), evt->data.rx.len);
+			err = raw_rx_handler(buf, evt->data.rx.len);
 			if (err) {
 				return;
 			}
 		} else {
 			LOG_WRN("No handler");
 		}
-		pos += evt->data.rx.len;
 		break;
 	case UART_RX_BUF_REQUEST:
-		pos = 0;
-		err = uart_rx_buf_rsp(uart_dev, next_buf, sizeof(uart_rx_buf[0]));
+		buf = rx_buf_next();
+		if (buf == NULL) {
+			/* RX stops when the current buffer is full */
+			LOG_DBG("No free RX buffer");
+			break;
+		}
+		err = uart_rx_buf_rsp(uart_dev, buf, UART_RX_LEN);
 		if (err) {
 			LOG_WRN("UART RX buf rsp: %d", err);
 		}
 		break;
 	case UART_RX_BUF_RELEASED:
-		next_buf = evt->data.rx_buf.buf;
 		break;
 	case UART_RX_STOPPED:
 		LOG_WRN("RX_STOPPED (%d)", evt->data.rx_stop.reason);
@@ -669,6 +846,10 @@ static void uart_callback(const struct device *dev, struct uart_event *evt, void
 		LOG_DBG("RX_DISABLED");
 		if (slm_operation_mode == SLM_DATA_MODE) {
 			datamode_rx_disabled = true;
+			if (!enable_rx_retry) {
+				/* Send the data to free RX buffers */
+				k_work_submit(&raw_send_work);
+			}
 		}
 		if (enable_rx_retry && !uart_recovery_pending) {
 			k_work_schedule(&uart_recovery_work, K_MSEC(UART_ERROR_DELAY_MS));
@@ -63,6 +63,8 @@ static int nfds;
 
 /* global functions defined in different files */
 void rsp_send(const uint8_t *str, size_t len);
+uint8_t *rsp_buf_alloc(size_t len);
+void rsp_send_buf(uint8_t *buf, size_t len);
 int enter_datamode(slm_datamode_handler_t handler);
 bool exit_datamode(void);
 bool check_uart_flowcontrol(void);
@@ -413,9 +415,7 @@ static void tcp_data_handle(uint8_t *data, uint32_t length)
 {
 	int ret;
 
-	if (proxy.datamode) {
-		rsp_send(data, length);
-	} else if (slm_util_hex_check(data, length)) {
+	if (slm_util_hex_check(data, length)) {
 		uint8_t data_hex[length * 2];
 
 		ret = slm_util_htoa(data, length, data_hex, length * 2);
@@ -440,6 +440,34 @@ static void tcp_data_handle(uint8_t *data, uint32_t length)
 
 }
 
+static int do_tcp_recv(int sock)
+{
+	uint8_t *data = rx_data;
+	int ret;
+
+	if (proxy.datamode) {
+		/* Receive straight into a UART TX buffer */
+		data = rsp_buf_alloc(sizeof(rx_data));
+		if (data == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	ret = recv(sock, (void *)data, sizeof(rx_data), 0);
+	if (ret < 0) {
+		ret = -errno;
+		LOG_WRN("recv() error: %d", ret);
+	}
+
+	if (proxy.datamode) {
+		rsp_send_buf(data, MAX(ret, 0));
+	} else if (ret > 0) {
+		tcp_data_handle(data, ret);
+	}
+
+	return ret;
+}
+
 static void tcp_terminate_connection(int cause)
 {
 	if (proxy.datamode) {
@@ -534,13 +562,7 @@ static int tcpsvr_input(int infd)
 		fds[nfds].events = POLLIN;
 		nfds++;
 	} else {
-		ret = recv(fds[infd].fd, (void *)rx_data, sizeof(rx_data), 0);
-		if (ret > 0) {
-			tcp_data_handle(rx_data, ret);
-		}
-		if (ret < 0) {
-			LOG_WRN("recv() error: %d", -errno);
-		}
+		ret = do_tcp_recv(fds[infd].fd);
 	}
 
 	return ret;
@@ -680,15 +702,7 @@ static void tcpcli_thread_func(void *p1, void *p2, void *p3)
 			goto exit;
 		}
 		if ((fds[0].revents & POLLIN) == POLLIN) {
-			ret = recv(fds[0].fd, (void *)rx_data, sizeof(rx_data), 0);
-			if (ret < 0) {
-				LOG_WRN("recv() error: %d", -errno);
-				continue;
-			}
-			if (ret == 0) {
-				continue;
-			}
-			tcp_data_handle(rx_data, ret);
+			(void)do_tcp_recv(fds[0].fd);
 		}
 	}
 exit:
@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <net/socket.h>
+#include <sys/ring_buffer.h>
 #include <modem/modem_key_mgmt.h>
 #include <net/tls_credentials.h>
 #include "slm_util.h"
@@ -19,7 +20,6 @@ LOG_MODULE_REGISTER(tcpip, CONFIG_SLM_LOG_LEVEL);
 
 /*
  * Known limitation in this version
- * - Multiple concurrent sockets
  * - Socket type other than SOCK_STREAM(1) and SOCK_DGRAM(2)
  * - IP Protocol other than TCP(6) and UDP(17)
  * - TCP server accept one connection only
@@ -28,6 +28,16 @@ LOG_MODULE_REGISTER(tcpip, CONFIG_SLM_LOG_LEVEL);
  * - does not support proxy
  */
 
+#define THREAD_STACK_SIZE	KB(2)
+#define THREAD_PRIORITY		K_LOWEST_APPLICATION_THREAD_PRIO
+
+/* Size of the length header of one datagram stored in a RX ring */
+#define DGRAM_HDR_LEN		sizeof(uint16_t)
+
+BUILD_ASSERT(CONFIG_SLM_SOCKET_RX_RING_SIZE >=
+	     CONFIG_SLM_SOCKET_RX_MAX + DGRAM_HDR_LEN,
+	     "RX ring must hold at least one full datagram");
+
 /**@brief Socket operations. */
 enum slm_socket_operation {
 	AT_SOCKET_CLOSE,
@@ -48,14 +58,36 @@ enum slm_socket_role {
 
 static struct sockaddr_in remote;
 
-static struct tcpip_client {
-	int sock; /* Socket descriptor. */
+static struct slm_socket {
+	int sock; /* Socket descriptor, also the AT socket handle */
 	sec_tag_t sec_tag; /* Security tag of the credential */
 	int role; /* Client or Server role */
 	int sock_peer; /* Socket descriptor for peer. */
 	int ip_proto; /* IP protocol */
 	bool connected; /* TCP connected flag */
-} client;
+	bool rx_ready; /* Polled by the socket engine */
+	bool rx_eof; /* Orderly shutdown by remote */
+	int rx_err; /* Receive error reported by the socket engine */
+	k_timeout_t rx_timeout; /* Time to wait for data in #XRECV */
+	struct k_sem rx_sem; /* Signalled when data is buffered */
+	struct ring_buf rx_ring;
+	uint8_t rx_ring_data[CONFIG_SLM_SOCKET_RX_RING_SIZE];
+	uint32_t rx_bytes; /* Bytes received since open */
+	uint32_t tx_bytes; /* Bytes sent since open */
+	int64_t open_time; /* Uptime when the socket was opened */
+} socks[CONFIG_SLM_SOCKET_COUNT];
+
+/* Socket used by the single-socket AT commands */
+static struct slm_socket *client;
+
+/* Protects the socket table and the RX rings */
+static K_MUTEX_DEFINE(socks_mutex);
+/* Wakes up the socket engine when there is nothing to poll */
+static K_SEM_DEFINE(engine_sem, 0, 1);
+
+static struct k_thread engine_thread;
+static K_THREAD_STACK_DEFINE(engine_thread_stack, THREAD_STACK_SIZE);
+static uint8_t engine_buf[CONFIG_SLM_SOCKET_RX_MAX];
 
 /* global functions defined in different files */
 void rsp_send(const uint8_t *str, size_t len);
@@ -65,6 +97,76 @@ extern struct at_param_list at_param_list;
 extern char rsp_buf[CONFIG_SLM_SOCKET_RX_MAX * 2];
 extern uint8_t rx_data[CONFIG_SLM_SOCKET_RX_MAX];
 
+static void socket_reset(struct slm_socket *s)
+{
+	s->sock = INVALID_SOCKET;
+	s->sec_tag = INVALID_SEC_TAG;
+	s->role = AT_SOCKET_ROLE_CLIENT;
+	s->sock_peer = INVALID_SOCKET;
+	s->connected = false;
+	s->ip_proto = IPPROTO_IP;
+	s->rx_ready = false;
+	s->rx_eof = false;
+	s->rx_err = 0;
+	s->rx_timeout = K_SECONDS(CONFIG_SLM_SOCKET_RX_TIMEOUT);
+	k_sem_reset(&s->rx_sem);
+	ring_buf_init(&s->rx_ring, sizeof(s->rx_ring_data), s->rx_ring_data);
+	s->rx_bytes = 0;
+	s->tx_bytes = 0;
+	s->open_time = 0;
+}
+
+/* Find the socket by handle, INVALID_SOCKET finds a free slot */
+static struct slm_socket *socket_find(int handle)
+{
+	for (int i = 0; i < ARRAY_SIZE(socks); i++) {
+		if (socks[i].sock == handle) {
+			return &socks[i];
+		}
+	}
+
+	return NULL;
+}
+
+static bool socket_is_dgram(const struct slm_socket *s)
+{
+	return s->ip_proto == IPPROTO_UDP || s->ip_proto == IPPROTO_DTLS_1_2;
+}
+
+/* Descriptor the socket engine receives from, or INVALID_SOCKET */
+static int socket_rx_fd(const struct slm_socket *s)
+{
+	if (s->sock == INVALID_SOCKET || !s->rx_ready || s->rx_eof || s->rx_err) {
+		return INVALID_SOCKET;
+	}
+	if (s->role == AT_SOCKET_ROLE_SERVER) {
+		return s->sock_peer;
+	}
+
+	return s->sock;
+}
+
+/* Stop polling once the ring cannot take another full read, the data
+ * then stays queued in the modem until the host drains the ring.
+ */
+static bool socket_rx_space(struct slm_socket *s)
+{
+	uint32_t space = ring_buf_space_get(&s->rx_ring);
+
+	if (socket_is_dgram(s)) {
+		return space >= CONFIG_SLM_SOCKET_RX_MAX + DGRAM_HDR_LEN;
+	}
+
+	return space > 0;
+}
+
+/* Ask the socket engine to rebuild its poll set */
+static void engine_wake(struct slm_socket *s)
+{
+	s->rx_ready = true;
+	k_sem_give(&engine_sem);
+}
+
 /**@brief Resolves host IPv4 address and port
  */
 static int parse_host_by_ipv4(const char *ip, uint16_t port)
@@ -121,47 +223,181 @@ static int parse_host_by_name(const char *name, uint16_t port, int socktype)
 	return 0;
 }
 
+static void engine_rx_notify(int handle, int value)
+{
+	char urc[40];
+
+	sprintf(urc, "\r\n#XSOCKETDATA: %d,%d\r\n", handle, value);
+	rsp_send(urc, strlen(urc));
+}
+
+static void engine_rx(struct slm_socket *s, int fd, short revents)
+{
+	bool dgram;
+	bool notify = false;
+	int handle;
+	size_t len;
+	int ret;
+
+	k_mutex_lock(&socks_mutex, K_FOREVER);
+	if (socket_rx_fd(s) != fd) {
+		/* Closed while polling */
+		k_mutex_unlock(&socks_mutex);
+		return;
+	}
+	dgram = socket_is_dgram(s);
+	len = MIN(ring_buf_space_get(&s->rx_ring), sizeof(engine_buf));
+	k_mutex_unlock(&socks_mutex);
+
+	if ((revents & POLLIN) == 0) {
+		ret = (revents & POLLHUP) ? -ENOTCONN : -EIO;
+	} else {
+		/* A datagram must be read in one go, its space is reserved
+		 * by socket_rx_space()
+		 */
+		ret = recv(fd, engine_buf, dgram ? sizeof(engine_buf) : len,
+			   MSG_DONTWAIT);
+		if (ret < 0) {
+			if (errno == EAGAIN) {
+				return;
+			}
+			ret = -errno;
+		}
+	}
+
+	k_mutex_lock(&socks_mutex, K_FOREVER);
+	if (socket_rx_fd(s) != fd) {
+		k_mutex_unlock(&socks_mutex);
+		return;
+	}
+	handle = s->sock;
+	if (ret == -ENOTCONN || (ret == 0 && !dgram)) {
+		/* An empty datagram is valid, hang-up without data is not */
+		LOG_DBG("Socket %d shut down by remote", handle);
+		s->rx_eof = true;
+		ret = -ENOTCONN;
+		notify = true;
+	} else if (ret < 0) {
+		LOG_WRN("recv() error on %d: %d", handle, ret);
+		s->rx_err = ret;
+		notify = true;
+	} else {
+		/* Notify once per batch, until the host drains the ring */
+		notify = ring_buf_is_empty(&s->rx_ring);
+		if (dgram) {
+			uint16_t dgram_len = ret;
+
+			ring_buf_put(&s->rx_ring, (uint8_t *)&dgram_len,
+				     DGRAM_HDR_LEN);
+		}
+		ring_buf_put(&s->rx_ring, engine_buf, ret);
+		s->rx_bytes += ret;
+	}
+	k_mutex_unlock(&socks_mutex);
+	k_sem_give(&s->rx_sem);
+
+	if (notify) {
+		engine_rx_notify(handle, ret);
+	}
+}
+
+/* Single poll loop receiving for all opened sockets */
+static void engine_thread_func(void *p1, void *p2, void *p3)
+{
+	struct pollfd fds[CONFIG_SLM_SOCKET_COUNT];
+	struct slm_socket *polled[CONFIG_SLM_SOCKET_COUNT];
+	int nfds;
+	int ret;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (true) {
+		nfds = 0;
+		k_mutex_lock(&socks_mutex, K_FOREVER);
+		for (int i = 0; i < ARRAY_SIZE(socks); i++) {
+			int fd = socket_rx_fd(&socks[i]);
+
+			if (fd == INVALID_SOCKET || !socket_rx_space(&socks[i])) {
+				continue;
+			}
+			fds[nfds].fd = fd;
+			fds[nfds].events = POLLIN;
+			fds[nfds].revents = 0;
+			polled[nfds] = &socks[i];
+			nfds++;
+		}
+		k_mutex_unlock(&socks_mutex);
+
+		if (nfds == 0) {
+			(void)k_sem_take(&engine_sem, K_FOREVER);
+			continue;
+		}
+
+		/* Bounded so that newly connected sockets and drained rings
+		 * join the poll set in time
+		 */
+		ret = poll(fds, nfds, CONFIG_SLM_SOCKET_POLL_TIME);
+		if (ret < 0) {
+			LOG_WRN("poll() error: %d", -errno);
+			k_sleep(K_MSEC(CONFIG_SLM_SOCKET_POLL_TIME));
+			continue;
+		}
+		for (int i = 0; i < nfds && ret > 0; i++) {
+			if (fds[i].revents == 0) {
+				continue;
+			}
+			ret--;
+			/* POLLNVAL: closed by the AT command thread */
+			if ((fds[i].revents & POLLNVAL) == 0) {
+				engine_rx(polled[i], fds[i].fd, fds[i].revents);
+			}
+		}
+	}
+}
+
 static int do_socket_open(uint8_t type, uint8_t role, int sec_tag)
 {
 	int ret = 0;
 
-	client.sec_tag = sec_tag;
+	client->sec_tag = sec_tag;
 	if (type == SOCK_STREAM) {
 		if (sec_tag == INVALID_SEC_TAG) {
-			client.sock = socket(AF_INET, SOCK_STREAM,
+			client->sock = socket(AF_INET, SOCK_STREAM,
 					IPPROTO_TCP);
-			client.ip_proto = IPPROTO_TCP;
+			client->ip_proto = IPPROTO_TCP;
 		} else {
-			client.sock = socket(AF_INET, SOCK_STREAM,
+			client->sock = socket(AF_INET, SOCK_STREAM,
 					IPPROTO_TLS_1_2);
-			client.ip_proto = IPPROTO_TLS_1_2;
+			client->ip_proto = IPPROTO_TLS_1_2;
 		}
 	} else if (type == SOCK_DGRAM) {
 		if (sec_tag == INVALID_SEC_TAG) {
-			client.sock = socket(AF_INET, SOCK_DGRAM,
+			client->sock = socket(AF_INET, SOCK_DGRAM,
 					IPPROTO_UDP);
-			client.ip_proto = IPPROTO_UDP;
+			client->ip_proto = IPPROTO_UDP;
 		} else {
-			client.sock = socket(AF_INET, SOCK_DGRAM,
+			client->sock = socket(AF_INET, SOCK_DGRAM,
 					IPPROTO_DTLS_1_2);
-			client.ip_proto = IPPROTO_DTLS_1_2;
+			client->ip_proto = IPPROTO_DTLS_1_2;
 		}
 	} else {
 		LOG_ERR("socket type %d not supported", type);
 		return -ENOTSUP;
 	}
-	if (client.sock < 0) {
+	if (client->sock < 0) {
 		LOG_ERR("socket() failed: %d", -errno);
 		ret = -errno;
 		goto error_exit;
 	}
 
-	if (client.sec_tag != INVALID_SEC_TAG) {
-		sec_tag_t sec_tag_list[1] = { client.sec_tag };
+	if (client->sec_tag != INVALID_SEC_TAG) {
+		sec_tag_t sec_tag_list[1] = { client->sec_tag };
 #if defined(CONFIG_SLM_NATIVE_TLS)
 		int verify;
 
-		ret = slm_tls_loadcrdl(client.sec_tag);
+		ret = slm_tls_loadcrdl(client->sec_tag);
 		if (ret < 0) {
 			LOG_ERR("Fail to load credential: %d", ret);
 			return ret;
@@ -174,7 +410,7 @@ static int do_socket_open(uint8_t type, uint8_t role, int sec_tag)
 			verify = TLS_PEER_VERIFY_REQUIRED;
 		}
 
-		ret = setsockopt(client.sock, SOL_TLS, TLS_PEER_VERIFY,
+		ret = setsockopt(client->sock, SOL_TLS, TLS_PEER_VERIFY,
 				 &verify, sizeof(verify));
 		if (ret) {
 			printk("Failed to setup peer verification, err %d\n",
@@ -190,7 +426,7 @@ static int do_socket_open(uint8_t type, uint8_t role, int sec_tag)
 		}
 #endif
 
-		ret = setsockopt(client.sock, SOL_TLS, TLS_SEC_TAG_LIST,
+		ret = setsockopt(client->sock, SOL_TLS, TLS_SEC_TAG_LIST,
 				sec_tag_list, sizeof(sec_tag_t));
 		if (ret) {
 			LOG_ERR("set (d)tls tag list failed: %d", -errno);
@@ -199,9 +435,10 @@ static int do_socket_open(uint8_t type, uint8_t role, int sec_tag)
 		}
 	}
 
-	client.role = role;
-	sprintf(rsp_buf, "\r\n#XSOCKET: %d,%d,%d,%d\r\n", client.sock,
-		type, role, client.ip_proto);
+	client->role = role;
+	client->open_time = k_uptime_get();
+	sprintf(rsp_buf, "\r\n#XSOCKET: %d,%d,%d,%d\r\n", client->sock,
+		type, role, client->ip_proto);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
 	LOG_DBG("Socket opened");
@@ -209,10 +446,10 @@ static int do_socket_open(uint8_t type, uint8_t role, int sec_tag)
 
 error_exit:
 	LOG_DBG("Socket not opened");
-	if (client.sock >= 0) {
-		close(client.sock);
+	if (client->sock >= 0) {
+		close(client->sock);
 	}
-	slm_at_tcpip_init();
+	socket_reset(client);
 	return ret;
 }
 
@@ -220,25 +457,27 @@ static int do_socket_close(int error)
 {
 	int ret = 0;
 
-	if (client.sock > 0) {
+	if (client->sock > 0) {
 #if defined(CONFIG_SLM_NATIVE_TLS)
-		if (client.sec_tag != INVALID_SEC_TAG) {
-			ret = slm_tls_unloadcrdl(client.sec_tag);
+		if (client->sec_tag != INVALID_SEC_TAG) {
+			ret = slm_tls_unloadcrdl(client->sec_tag);
 			if (ret < 0) {
 				LOG_ERR("Fail to load credential: %d", ret);
 				return ret;
 			}
 		}
 #endif
-		ret = close(client.sock);
+		k_mutex_lock(&socks_mutex, K_FOREVER);
+		ret = close(client->sock);
 		if (ret < 0) {
 			LOG_WRN("close() failed: %d", -errno);
 			ret = -errno;
 		}
-		if (client.sock_peer > 0) {
-			close(client.sock_peer);
+		if (client->sock_peer > 0) {
+			close(client->sock_peer);
 		}
-		slm_at_tcpip_init();
+		socket_reset(client);
+		k_mutex_unlock(&socks_mutex);
 		sprintf(rsp_buf, "\r\n#XSOCKET: %d,\"closed\"\r\n", error);
 		rsp_send(rsp_buf, strlen(rsp_buf));
 		LOG_DBG("Socket closed");
@@ -262,11 +501,14 @@ static int do_socketopt_set(int name, int value)
 	case SO_RCVTIMEO: {
 		struct timeval tmo = { .tv_sec = value };
 
-		ret = setsockopt(client.sock, SOL_SOCKET, SO_RCVTIMEO,
+		ret = setsockopt(client->sock, SOL_SOCKET, SO_RCVTIMEO,
 				&tmo, sizeof(struct timeval));
 		if (ret < 0) {
 			LOG_ERR("setsockopt() error: %d", -errno);
+			break;
 		}
+		/* Data is received by the socket engine, #XRECV waits on the ring */
+		client->rx_timeout = (value > 0) ? K_SECONDS(value) : K_FOREVER;
 	} break;
 
 	case SO_BINDTODEVICE:	/* Not supported by SLM for now */
@@ -297,7 +539,7 @@ static int do_socketopt_get(int name)
 		struct timeval tmo;
 		socklen_t len = sizeof(struct timeval);
 
-		ret = getsockopt(client.sock, SOL_SOCKET, SO_RCVTIMEO,
+		ret = getsockopt(client->sock, SOL_SOCKET, SO_RCVTIMEO,
 				&tmo, &len);
 		if (ret) {
 			LOG_ERR("getsockopt() error: %d", -errno);
@@ -352,7 +594,7 @@ static int do_bind(uint16_t port)
 		return -EINVAL;
 	}
 
-	ret = bind(client.sock, (struct sockaddr *)&local,
+	ret = bind(client->sock, (struct sockaddr *)&local,
 		 sizeof(struct sockaddr_in));
 	if (ret) {
 		LOG_ERR("bind() failed: %d", -errno);
@@ -360,6 +602,7 @@ static int do_bind(uint16_t port)
 		return -errno;
 	}
 
+	engine_wake(client);
 	return 0;
 }
 
@@ -379,8 +622,8 @@ static int do_connect(const char *url, uint16_t port)
 		return ret;
 	}
 
-	if (client.sec_tag != INVALID_SEC_TAG) {
-		ret = setsockopt(client.sock, SOL_TLS, TLS_HOSTNAME, url, strlen(url));
+	if (client->sec_tag != INVALID_SEC_TAG) {
+		ret = setsockopt(client->sock, SOL_TLS, TLS_HOSTNAME, url, strlen(url));
 		if (ret < 0) {
 			LOG_ERR("Failed to set TLS_HOSTNAME\n");
 			do_socket_close(-errno);
@@ -388,14 +631,15 @@ static int do_connect(const char *url, uint16_t port)
 		}
 	}
 
-	ret = connect(client.sock, (struct sockaddr *)&remote, sizeof(struct sockaddr_in));
+	ret = connect(client->sock, (struct sockaddr *)&remote, sizeof(struct sockaddr_in));
 	if (ret < 0) {
 		LOG_ERR("connect() failed: %d", -errno);
 		do_socket_close(-errno);
 		return -errno;
 	}
 
-	client.connected = true;
+	client->connected = true;
+	engine_wake(client);
 	sprintf(rsp_buf, "\r\n#XCONNECT: 1\r\n");
 	rsp_send(rsp_buf, strlen(rsp_buf));
 	return ret;
@@ -406,14 +650,14 @@ static int do_listen(void)
 	int ret;
 
 	/* hardcode backlog to be 1 for now */
-	ret = listen(client.sock, 1);
+	ret = listen(client->sock, 1);
 	if (ret < 0) {
 		LOG_ERR("listen() failed: %d", -errno);
 		do_socket_close(-errno);
 		return -errno;
 	}
 
-	client.sock_peer = INVALID_SOCKET;
+	client->sock_peer = INVALID_SOCKET;
 	return 0;
 }
 
@@ -423,7 +667,7 @@ static int do_accept(void)
 	char peer_addr[INET_ADDRSTRLEN];
 	socklen_t len = sizeof(struct sockaddr_in);
 
-	fd = accept(client.sock, (struct sockaddr *)&remote, &len);
+	fd = accept(client->sock, (struct sockaddr *)&remote, &len);
 	if (fd == -1) {
 		LOG_ERR("accept() failed: %d", -errno);
 		do_socket_close(-errno);
@@ -438,10 +682,11 @@ static int do_accept(void)
 	sprintf(rsp_buf, "\r\n#XACCEPT: \"connected with %s\"\r\n",
 		peer_addr);
 	rsp_send(rsp_buf, strlen(rsp_buf));
-	client.sock_peer = fd;
-	client.connected = true;
+	client->sock_peer = fd;
+	client->connected = true;
+	engine_wake(client);
 
-	sprintf(rsp_buf, "\r\n#XACCEPT: %d\r\n", client.sock_peer);
+	sprintf(rsp_buf, "\r\n#XACCEPT: %d\r\n", client->sock_peer);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
 	return 0;
@@ -451,12 +696,12 @@ static int do_send(const uint8_t *data, int datalen)
 {
 	uint32_t offset = 0;
 	int ret = 0;
-	int sock = client.sock;
+	int sock = client->sock;
 
 	/* For TCP/TLS Server, send to imcoming socket */
-	if (client.role == AT_SOCKET_ROLE_SERVER) {
-		if (client.sock_peer != INVALID_SOCKET) {
-			sock = client.sock_peer;
+	if (client->role == AT_SOCKET_ROLE_SERVER) {
+		if (client->sock_peer != INVALID_SOCKET) {
+			sock = client->sock_peer;
 		} else {
 			LOG_ERR("No remote connection");
 			return -EINVAL;
@@ -479,6 +724,7 @@ static int do_send(const uint8_t *data, int datalen)
 		offset += ret;
 	}
 
+	client->tx_bytes += offset;
 	sprintf(rsp_buf, "\r\n#XSEND: %d\r\n", offset);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
@@ -490,31 +736,92 @@ static int do_send(const uint8_t *data, int datalen)
 	}
 }
 
+/* Wait for data buffered by the socket engine.
+ * Returns with socks_mutex held on success.
+ */
+static int rx_wait(struct slm_socket *s)
+{
+	k_mutex_lock(&socks_mutex, K_FOREVER);
+	while (ring_buf_is_empty(&s->rx_ring)) {
+		int err = s->rx_err;
+
+		if (err == 0 && s->rx_eof) {
+			err = -ENOTCONN;
+		}
+		k_mutex_unlock(&socks_mutex);
+		if (err) {
+			return err;
+		}
+		if (k_sem_take(&s->rx_sem, s->rx_timeout) != 0) {
+			return -EAGAIN;
+		}
+		k_mutex_lock(&socks_mutex, K_FOREVER);
+	}
+
+	return 0;
+}
+
+/* Called with socks_mutex held. Take the data of one read from the ring,
+ * that is a whole datagram or up to length bytes of a stream.
+ */
+static int rx_get(struct slm_socket *s, uint16_t length)
+{
+	uint16_t dgram_len;
+	int ret;
+
+	length = MIN(length, sizeof(rx_data));
+	if (!socket_is_dgram(s)) {
+		return ring_buf_get(&s->rx_ring, rx_data, length);
+	}
+
+	/* Excess bytes of the datagram are discarded, as recvfrom() does */
+	(void)ring_buf_get(&s->rx_ring, (uint8_t *)&dgram_len, DGRAM_HDR_LEN);
+	ret = MIN(dgram_len, length);
+	(void)ring_buf_get(&s->rx_ring, rx_data, ret);
+	(void)ring_buf_get(&s->rx_ring, NULL, dgram_len - ret);
+
+	return ret;
+}
+
+/* Called with socks_mutex held, the ring has room again */
+static void rx_done(void)
+{
+	k_mutex_unlock(&socks_mutex);
+	k_sem_give(&engine_sem);
+}
+
+static int rx_error(int err)
+{
+	LOG_WRN("receive error: %d", err);
+	if (err != -EAGAIN && err != -ETIMEDOUT) {
+		do_socket_close(err);
+	} else {
+		sprintf(rsp_buf, "\r\n#XSOCKET: %d\r\n", err);
+		rsp_send(rsp_buf, strlen(rsp_buf));
+	}
+
+	return err;
+}
+
 static int do_recv(uint16_t length)
 {
 	int ret;
-	int sock = client.sock;
 
 	/* For TCP/TLS Server, receive from imcoming socket */
-	if (client.role == AT_SOCKET_ROLE_SERVER) {
-		if (client.sock_peer != INVALID_SOCKET) {
-			sock = client.sock_peer;
-		} else {
-			LOG_ERR("No remote connection");
-			return -EINVAL;
-		}
+	if (client->role == AT_SOCKET_ROLE_SERVER &&
+	    client->sock_peer == INVALID_SOCKET) {
+		LOG_ERR("No remote connection");
+		return -EINVAL;
 	}
 
-	ret = recv(sock, (void *)rx_data, length, 0);
-	if (ret < 0) {
-		LOG_WRN("recv() error: %d", -errno);
-		if (errno != EAGAIN && errno != ETIMEDOUT) {
-			do_socket_close(-errno);
-		} else {
-			sprintf(rsp_buf, "\r\n#XSOCKET: %d\r\n", -errno);
-			rsp_send(rsp_buf, strlen(rsp_buf));
-		}
-		return -errno;
+	ret = rx_wait(client);
+	if (ret == 0) {
+		ret = rx_get(client, length);
+		rx_done();
+	} else if (ret == -ENOTCONN) {
+		ret = 0;
+	} else {
+		return rx_error(ret);
 	}
 	/**
 	 * When a stream socket peer has performed an orderly shutdown,
@@ -580,7 +887,7 @@ static int do_sendto(const char *url, uint16_t port, const uint8_t *data,
 	}
 
 	while (offset < datalen) {
-		ret = sendto(client.sock, data + offset,
+		ret = sendto(client->sock, data + offset,
 			datalen - offset, 0,
 			(struct sockaddr *)&remote,
 			sizeof(struct sockaddr_in));
@@ -598,6 +905,11 @@ static int do_sendto(const char *url, uint16_t port, const uint8_t *data,
 		offset += ret;
 	}
 
+	client->tx_bytes += offset;
+	if (offset > 0 && !client->rx_ready) {
+		/* Implicitly bound, replies can now be received */
+		engine_wake(client);
+	}
 	sprintf(rsp_buf, "\r\n#XSENDTO: %d\r\n", offset);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
@@ -612,21 +924,13 @@ static int do_sendto(const char *url, uint16_t port, const uint8_t *data,
 static int do_recvfrom(uint16_t length)
 {
 	int ret;
-	/* Below two are not used, just for static code analysis */
-	struct sockaddr src_addr;
-	socklen_t addrlen = sizeof(struct sockaddr);
 
-	ret = recvfrom(client.sock, (void *)rx_data, length, 0, &src_addr, &addrlen);
-	if (ret < 0) {
-		LOG_ERR("recvfrom() error: %d", -errno);
-		if (errno != EAGAIN && errno != ETIMEDOUT) {
-			do_socket_close(-errno);
-		} else {
-			sprintf(rsp_buf, "\r\n#XSOCKET: %d\r\n", -errno);
-			rsp_send(rsp_buf, strlen(rsp_buf));
-		}
-		return -errno;
+	ret = rx_wait(client);
+	if (ret) {
+		return rx_error(ret);
 	}
+	ret = rx_get(client, length);
+	rx_done();
 	/**
 	 * Datagram sockets in various domains permit zero-length
 	 * datagrams. When such a datagram is received, the return
@@ -689,14 +993,20 @@ int handle_at_socket(enum at_cmd_type cmd_type)
 			if (err) {
 				sec_tag = INVALID_SEC_TAG;
 			}
-			if (client.sock > 0) {
-				LOG_WRN("Socket is already opened");
-				return -EINVAL;
-			} else {
-				err = do_socket_open(type, role, sec_tag);
+			if (client->sock > 0) {
+				/* Keep the selected one open, take a free slot */
+				struct slm_socket *free_sock = socket_find(INVALID_SOCKET);
+
+				if (free_sock == NULL) {
+					LOG_WRN("No free socket");
+					return -ENOMEM;
+				}
+				client = free_sock;
 			}
+			socket_reset(client);
+			err = do_socket_open(type, role, sec_tag);
 		} else if (op == AT_SOCKET_CLOSE) {
-			if (client.sock < 0) {
+			if (client->sock < 0) {
 				LOG_WRN("Socket is not opened yet");
 				return -EINVAL;
 			} else {
@@ -705,9 +1015,9 @@ int handle_at_socket(enum at_cmd_type cmd_type)
 		} break;
 
 	case AT_CMD_TYPE_READ_COMMAND:
-		if (client.sock != INVALID_SOCKET) {
+		if (client->sock != INVALID_SOCKET) {
 			sprintf(rsp_buf, "\r\n#XSOCKET: %d,%d,%d\r\n",
-				client.sock, client.ip_proto, client.role);
+				client->sock, client->ip_proto, client->role);
 		} else {
 			sprintf(rsp_buf, "\r\n#XSOCKET: 0\r\n");
 		}
@@ -733,6 +1043,70 @@ int handle_at_socket(enum at_cmd_type cmd_type)
 	return err;
 }
 
+/**@brief handle AT#XSOCKETSELECT commands
+ *  AT#XSOCKETSELECT=<handle>
+ *  AT#XSOCKETSELECT?
+ *  AT#XSOCKETSELECT=? TEST command not supported
+ */
+int handle_at_socket_select(enum at_cmd_type cmd_type)
+{
+	int err = -EINVAL;
+	int handle;
+	struct slm_socket *s;
+
+	switch (cmd_type) {
+	case AT_CMD_TYPE_SET_COMMAND:
+		err = at_params_int_get(&at_param_list, 1, &handle);
+		if (err) {
+			return err;
+		}
+		s = socket_find(handle);
+		if (handle <= 0 || s == NULL) {
+			LOG_ERR("Invalid handle: %d", handle);
+			return -EINVAL;
+		}
+		client = s;
+		sprintf(rsp_buf, "\r\n#XSOCKETSELECT: %d\r\n", client->sock);
+		rsp_send(rsp_buf, strlen(rsp_buf));
+		break;
+
+	case AT_CMD_TYPE_READ_COMMAND:
+		for (int i = 0; i < ARRAY_SIZE(socks); i++) {
+			uint32_t buffered, rx_bytes, tx_bytes;
+			int64_t elapsed;
+
+			s = &socks[i];
+			if (s->sock == INVALID_SOCKET) {
+				continue;
+			}
+			k_mutex_lock(&socks_mutex, K_FOREVER);
+			buffered = sizeof(s->rx_ring_data) -
+				   ring_buf_space_get(&s->rx_ring);
+			rx_bytes = s->rx_bytes;
+			tx_bytes = s->tx_bytes;
+			k_mutex_unlock(&socks_mutex);
+			elapsed = MAX(k_uptime_get() - s->open_time, 1);
+			/* Throughput is averaged since the socket was opened */
+			sprintf(rsp_buf,
+				"\r\n#XSOCKETSELECT: %d,%d,%d,%u,%u,%u,%u,%u\r\n",
+				s->sock, s->ip_proto, s->role, buffered,
+				rx_bytes, tx_bytes,
+				(uint32_t)((uint64_t)rx_bytes * MSEC_PER_SEC / elapsed),
+				(uint32_t)((uint64_t)tx_bytes * MSEC_PER_SEC / elapsed));
+			rsp_send(rsp_buf, strlen(rsp_buf));
+		}
+		sprintf(rsp_buf, "\r\n#XSOCKETSELECT: %d\r\n", client->sock);
+		rsp_send(rsp_buf, strlen(rsp_buf));
+		err = 0;
+		break;
+
+	default:
+		break;
+	}
+
+	return err;
+}
+
 /**@brief handle AT#XSOCKETOPT commands
  *  AT#XSOCKETOPT=<op>,<name>[,<value>]
  *  AT#XSOCKETOPT? READ command not supported
@@ -746,11 +1120,11 @@ int handle_at_socketopt(enum at_cmd_type cmd_type)
 
 	switch (cmd_type) {
 	case AT_CMD_TYPE_SET_COMMAND:
-		if (client.sock < 0) {
+		if (client->sock < 0) {
 			LOG_ERR("Socket not opened yet");
 			return err;
 		}
-		if (client.role != AT_SOCKET_ROLE_CLIENT) {
+		if (client->role != AT_SOCKET_ROLE_CLIENT) {
 			LOG_ERR("Invalid role");
 			return err;
 		}
@@ -798,7 +1172,7 @@ int handle_at_bind(enum at_cmd_type cmd_type)
 	int err = -EINVAL;
 	uint16_t port;
 
-	if (client.sock < 0) {
+	if (client->sock < 0) {
 		LOG_ERR("Socket not opened yet");
 		return err;
 	}
@@ -831,11 +1205,11 @@ int handle_at_connect(enum at_cmd_type cmd_type)
 	int size = TCPIP_MAX_URL;
 	uint16_t port;
 
-	if (client.sock < 0) {
+	if (client->sock < 0) {
 		LOG_ERR("Socket not opened yet");
 		return err;
 	}
-	if (client.role != AT_SOCKET_ROLE_CLIENT) {
+	if (client->role != AT_SOCKET_ROLE_CLIENT) {
 		LOG_ERR("Invalid role");
 		return err;
 	}
@@ -854,7 +1228,7 @@ int handle_at_connect(enum at_cmd_type cmd_type)
 		break;
 
 	case AT_CMD_TYPE_READ_COMMAND:
-		if (client.connected) {
+		if (client->connected) {
 			sprintf(rsp_buf, "\r\n+XCONNECT: 1\r\n");
 		} else {
 			sprintf(rsp_buf, "\r\n+XCONNECT: 0\r\n");
@@ -879,16 +1253,16 @@ int handle_at_listen(enum at_cmd_type cmd_type)
 {
 	int err = -EINVAL;
 
-	if (client.sock < 0) {
+	if (client->sock < 0) {
 		LOG_ERR("Socket not opened yet");
 		return err;
 	}
-	if (client.role != AT_SOCKET_ROLE_SERVER) {
+	if (client->role != AT_SOCKET_ROLE_SERVER) {
 		LOG_ERR("Invalid role");
 		return err;
 	}
-	if (client.ip_proto != IPPROTO_TCP &&
-		client.ip_proto != IPPROTO_TLS_1_2) {
+	if (client->ip_proto != IPPROTO_TCP &&
+		client->ip_proto != IPPROTO_TLS_1_2) {
 		LOG_ERR("Invalid protocol");
 		return err;
 	}
@@ -914,16 +1288,16 @@ int handle_at_accept(enum at_cmd_type cmd_type)
 {
 	int err = -EINVAL;
 
-	if (client.sock < 0) {
+	if (client->sock < 0) {
 		LOG_ERR("Socket not opened yet");
 		return err;
 	}
-	if (client.role != AT_SOCKET_ROLE_SERVER) {
+	if (client->role != AT_SOCKET_ROLE_SERVER) {
 		LOG_ERR("Invalid role");
 		return err;
 	}
-	if (client.ip_proto != IPPROTO_TCP &&
-		client.ip_proto != IPPROTO_TLS_1_2) {
+	if (client->ip_proto != IPPROTO_TCP &&
+		client->ip_proto != IPPROTO_TLS_1_2) {
 		LOG_ERR("Invalid protocol");
 		return err;
 	}
@@ -934,9 +1308,9 @@ int handle_at_accept(enum at_cmd_type cmd_type)
 		break;
 
 	case AT_CMD_TYPE_READ_COMMAND:
-		if (client.sock_peer != INVALID_SOCKET) {
+		if (client->sock_peer != INVALID_SOCKET) {
 			sprintf(rsp_buf, "\r\n#XTCPACCEPT: %d\r\n",
-				client.sock_peer);
+				client->sock_peer);
 		} else {
 			sprintf(rsp_buf, "\r\n#XTCPACCEPT: 0\r\n");
 		}
@@ -963,7 +1337,7 @@ int handle_at_send(enum at_cmd_type cmd_type)
 	char data[NET_IPV4_MTU];
 	int size = NET_IPV4_MTU;
 
-	if (!client.connected) {
+	if (!client->connected) {
 		LOG_ERR("Not connected yet");
 		return err;
 	}
@@ -1007,7 +1381,7 @@ int handle_at_recv(enum at_cmd_type cmd_type)
 	int err = -EINVAL;
 	int16_t length;
 
-	if (!client.connected) {
+	if (!client->connected) {
 		LOG_ERR("Not connected yet");
 		return err;
 	}
@@ -1042,12 +1416,12 @@ int handle_at_sendto(enum at_cmd_type cmd_type)
 	uint16_t datatype;
 	char data[NET_IPV4_MTU];
 
-	if (client.sock < 0) {
+	if (client->sock < 0) {
 		LOG_ERR("Socket not opened yet");
 		return err;
 	}
-	if (client.ip_proto != IPPROTO_UDP &&
-		client.ip_proto != IPPROTO_DTLS_1_2) {
+	if (client->ip_proto != IPPROTO_UDP &&
+		client->ip_proto != IPPROTO_DTLS_1_2) {
 		LOG_ERR("Invalid protocol");
 		return err;
 	}
@@ -1100,12 +1474,12 @@ int handle_at_recvfrom(enum at_cmd_type cmd_type)
 	int err = -EINVAL;
 	uint16_t length;
 
-	if (client.sock < 0) {
+	if (client->sock < 0) {
 		LOG_ERR("Socket not opened yet");
 		return err;
 	}
-	if (client.ip_proto != IPPROTO_UDP &&
-		client.ip_proto != IPPROTO_DTLS_1_2) {
+	if (client->ip_proto != IPPROTO_UDP &&
+		client->ip_proto != IPPROTO_DTLS_1_2) {
 		LOG_ERR("Invalid protocol");
 		return err;
 	}
@@ -1183,12 +1557,16 @@ int handle_at_getaddrinfo(enum at_cmd_type cmd_type)
  */
 int slm_at_tcpip_init(void)
 {
-	client.sock = INVALID_SOCKET;
-	client.sec_tag = INVALID_SEC_TAG;
-	client.role = AT_SOCKET_ROLE_CLIENT;
-	client.sock_peer = INVALID_SOCKET;
-	client.connected = false;
-	client.ip_proto = IPPROTO_IP;
+	for (int i = 0; i < ARRAY_SIZE(socks); i++) {
+		k_sem_init(&socks[i].rx_sem, 0, 1);
+		socket_reset(&socks[i]);
+	}
+	client = &socks[0];
+
+	(void)k_thread_create(&engine_thread, engine_thread_stack,
+			K_THREAD_STACK_SIZEOF(engine_thread_stack),
+			engine_thread_func, NULL, NULL, NULL,
+			THREAD_PRIORITY, K_USER, K_NO_WAIT);
 	return 0;
 }
 
@@ -1196,5 +1574,18 @@ int slm_at_tcpip_init(void)
  */
 int slm_at_tcpip_uninit(void)
 {
-	return do_socket_close(0);
+	int ret = 0;
+
+	/* The socket engine goes idle once all sockets are closed */
+	for (int i = 0; i < ARRAY_SIZE(socks); i++) {
+		int err;
+
+		client = &socks[i];
+		err = do_socket_close(0);
+		if (err) {
+			ret = err;
+		}
+	}
+
+	return ret;
 }
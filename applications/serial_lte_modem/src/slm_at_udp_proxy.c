@@ -47,6 +47,8 @@ static bool udp_datamode;
 
 /* global functions defined in different files */
 void rsp_send(const uint8_t *str, size_t len);
+uint8_t *rsp_buf_alloc(size_t len);
+void rsp_send_buf(uint8_t *buf, size_t len);
 int enter_datamode(slm_datamode_handler_t handler);
 bool check_uart_flowcontrol(void);
 bool exit_datamode(void);
@@ -326,6 +328,7 @@ static void udp_thread_func(void *p1, void *p2, void *p3)
 	int ret;
 	int size = sizeof(struct sockaddr_in);
 	struct pollfd fds;
+	uint8_t *data;
 
 	ARG_UNUSED(p1);
 	ARG_UNUSED(p2);
@@ -354,24 +357,33 @@ static void udp_thread_func(void *p1, void *p2, void *p3)
 		}
 		if ((fds.revents & POLLIN) != POLLIN) {
 			continue;
-		} else {
-			if (udp_server_role) {
-				ret = recvfrom(udp_sock, (void *)rx_data, sizeof(rx_data), 0,
-					(struct sockaddr *)&remote, &size);
-			} else {
-				ret = recv(udp_sock, (void *)rx_data, sizeof(rx_data), 0);
+		}
+		if (udp_datamode) {
+			/* Receive straight into a UART TX buffer */
+			data = rsp_buf_alloc(sizeof(rx_data));
+			if (data == NULL) {
+				continue;
 			}
+		} else {
+			data = rx_data;
+		}
+		if (udp_server_role) {
+			ret = recvfrom(udp_sock, (void *)data, sizeof(rx_data), 0,
+				(struct sockaddr *)&remote, &size);
+		} else {
+			ret = recv(udp_sock, (void *)data, sizeof(rx_data), 0);
 		}
 		if (ret < 0) {
 			LOG_WRN("recv() error: %d", -errno);
+		}
+		if (udp_datamode) {
+			rsp_send_buf(data, MAX(ret, 0));
 			continue;
 		}
-		if (ret == 0) {
+		if (ret <= 0) {
 			continue;
 		}
-		if (udp_datamode) {
-			rsp_send(rx_data, ret);
-		} else if (slm_util_hex_check(rx_data, ret)) {
+		if (slm_util_hex_check(rx_data, ret)) {
 			uint8_t data_hex[ret * 2];
 
 			ret = slm_util_htoa(rx_data, ret, data_hex, ret * 2);
@@ -44,6 +44,18 @@ LOG_MODULE_REGISTER(nrf9160_gps, CONFIG_NRF9160_GPS_LOG_LEVEL);
 
 #define GPS_BLOCKED_TIMEOUT CONFIG_NRF9160_GPS_PRIORITY_WINDOW_TIMEOUT_SEC
 
+#ifdef CONFIG_NRF9160_GPS_FIX_BATCH
+#define FIX_BATCH_SIZE		CONFIG_NRF9160_GPS_FIX_BATCH_SIZE
+#define FIX_MAX_AGE_MS		(CONFIG_NRF9160_GPS_FIX_BATCH_MAX_AGE * MSEC_PER_SEC)
+#define FIX_MIN_INTERVAL_MS	(CONFIG_NRF9160_GPS_FIX_BATCH_MIN_INTERVAL * MSEC_PER_SEC)
+#define FIX_MIN_DISTANCE	CONFIG_NRF9160_GPS_FIX_BATCH_MIN_DISTANCE
+#define FIX_HEADING_CHANGE	CONFIG_NRF9160_GPS_FIX_BATCH_HEADING_CHANGE
+/* Heading is not reliable below this speed, in m/s */
+#define FIX_HEADING_MIN_SPEED	1.0f
+#define EARTH_RADIUS		6371000.0
+#define DEG_TO_RAD		(3.14159265358979323846 / 180.0)
+#endif
+
 struct gps_drv_data {
 	const struct device *dev;
 	gps_event_handler_t handler;
@@ -62,6 +74,21 @@ struct gps_drv_data {
 	struct k_work_delayable timeout_work;
 	struct k_work_delayable blocked_work;
 	struct k_work_sync work_sync;
+#ifdef CONFIG_NRF9160_GPS_FIX_BATCH
+	/* Fixes are stored in place and delivered from here. New fixes are
+	 * stored in one buffer while the other one is being delivered.
+	 */
+	struct gps_fix fix_batch[2][FIX_BATCH_SIZE];
+	size_t fix_buf;
+	size_t fix_count;
+	int64_t fix_batch_start;
+	/* Last stored fix, for decimation */
+	struct gps_fix last_fix;
+	int64_t last_fix_time;
+	bool has_last_fix;
+	struct k_mutex fix_lock;
+	struct k_mutex flush_lock;
+#endif
 };
 
 struct nrf9160_gps_config {
@@ -93,6 +120,18 @@ static nrf_gnss_agps_data_type_t type_lookup_gps2socket[] = {
 	[GPS_AGPS_INTEGRITY]		= NRF_GNSS_AGPS_INTEGRITY,
 };
 
+static void copy_datetime(struct gps_datetime *dest,
+			  const nrf_gnss_datetime_t *src)
+{
+	dest->year = src->year;
+	dest->month = src->month;
+	dest->day = src->day;
+	dest->hour = src->hour;
+	dest->minute = src->minute;
+	dest->seconds = src->seconds;
+	dest->ms = src->ms;
+}
+
 static void copy_pvt(struct gps_pvt *dest, nrf_gnss_pvt_data_frame_t *src)
 {
 	dest->latitude = src->latitude;
@@ -101,13 +140,7 @@ static void copy_pvt(struct gps_pvt *dest, nrf_gnss_pvt_data_frame_t *src)
 	dest->accuracy = src->accuracy;
 	dest->speed = src->speed;
 	dest->heading = src->heading;
-	dest->datetime.year = src->datetime.year;
-	dest->datetime.month = src->datetime.month;
-	dest->datetime.day = src->datetime.day;
-	dest->datetime.hour = src->datetime.hour;
-	dest->datetime.minute = src->datetime.minute;
-	dest->datetime.seconds = src->datetime.seconds;
-	dest->datetime.ms = src->datetime.ms;
+	copy_datetime(&dest->datetime, &src->datetime);
 	dest->pdop = src->pdop;
 	dest->hdop = src->hdop;
 	dest->vdop = src->vdop;
@@ -204,6 +237,163 @@ static void notify_event(const struct device *dev, struct gps_event *evt)
 	}
 }
 
+#ifdef CONFIG_NRF9160_GPS_FIX_BATCH
+/* Taylor series of cos(), accurate to 0.1 % up to 90 degrees. Avoids
+ * depending on libm for decimation.
+ */
+static double cos_approx(double rad)
+{
+	double x2 = rad * rad;
+
+	return MAX(1.0 - x2 / 2.0 + x2 * x2 / 24.0 - x2 * x2 * x2 / 720.0, 0.0);
+}
+
+/* Squared distance in square meters, equirectangular approximation */
+static double distance_sq(const struct gps_fix *a, const struct gps_fix *b)
+{
+	double lat = (a->latitude + b->latitude) / 2.0 * DEG_TO_RAD;
+	double dlon = b->longitude - a->longitude;
+	double x, y;
+
+	if (dlon > 180.0) {
+		dlon -= 360.0;
+	} else if (dlon < -180.0) {
+		dlon += 360.0;
+	}
+
+	x = dlon * DEG_TO_RAD * cos_approx(lat) * EARTH_RADIUS;
+	y = (b->latitude - a->latitude) * DEG_TO_RAD * EARTH_RADIUS;
+
+	return x * x + y * y;
+}
+
+static float heading_change(float a, float b)
+{
+	float diff = b - a;
+
+	if (diff > 180.0f) {
+		diff -= 360.0f;
+	} else if (diff < -180.0f) {
+		diff += 360.0f;
+	}
+
+	return (diff < 0.0f) ? -diff : diff;
+}
+
+static bool fix_keep(struct gps_drv_data *drv_data, const struct gps_fix *fix,
+		     int64_t now)
+{
+	const struct gps_fix *last = &drv_data->last_fix;
+
+	if (!drv_data->has_last_fix) {
+		return true;
+	}
+
+	if ((now - drv_data->last_fix_time) < FIX_MIN_INTERVAL_MS) {
+		return false;
+	}
+
+	if ((FIX_MIN_DISTANCE == 0) ||
+	    (distance_sq(last, fix) >=
+	     (double)FIX_MIN_DISTANCE * FIX_MIN_DISTANCE)) {
+		return true;
+	}
+
+	return (FIX_HEADING_CHANGE > 0) &&
+	       (fix->speed >= FIX_HEADING_MIN_SPEED) &&
+	       (last->speed >= FIX_HEADING_MIN_SPEED) &&
+	       (heading_change(last->heading, fix->heading) >=
+		FIX_HEADING_CHANGE);
+}
+
+/* Deliver the stored fixes. The handler is called without fix_lock held,
+ * so that new fixes can be stored in the other buffer meanwhile. The event
+ * refers to the delivered buffer, which is released when the handler returns.
+ */
+static void fix_batch_flush(const struct device *dev)
+{
+	struct gps_drv_data *drv_data = dev->data;
+	struct gps_event evt = {
+		.type = GPS_EVT_PVT_FIX_BATCH,
+	};
+
+	/* One batch at a time, so that the other buffer is never in use */
+	k_mutex_lock(&drv_data->flush_lock, K_FOREVER);
+	k_mutex_lock(&drv_data->fix_lock, K_FOREVER);
+
+	evt.batch.fixes = drv_data->fix_batch[drv_data->fix_buf];
+	evt.batch.count = drv_data->fix_count;
+
+	if (drv_data->fix_count > 0) {
+		drv_data->fix_buf ^= 1;
+		drv_data->fix_count = 0;
+	}
+
+	k_mutex_unlock(&drv_data->fix_lock);
+
+	if (evt.batch.count > 0) {
+		LOG_DBG("Delivering %d fixes", evt.batch.count);
+		notify_event(dev, &evt);
+	}
+
+	k_mutex_unlock(&drv_data->flush_lock);
+}
+
+/* Deliver the batch if it is full or if the oldest fix is too old */
+static void fix_batch_check(const struct device *dev, int64_t now)
+{
+	struct gps_drv_data *drv_data = dev->data;
+	bool due;
+
+	k_mutex_lock(&drv_data->fix_lock, K_FOREVER);
+	due = (drv_data->fix_count == FIX_BATCH_SIZE) ||
+	      ((FIX_MAX_AGE_MS > 0) && (drv_data->fix_count > 0) &&
+	       ((now - drv_data->fix_batch_start) >= FIX_MAX_AGE_MS));
+	k_mutex_unlock(&drv_data->fix_lock);
+
+	if (due) {
+		fix_batch_flush(dev);
+	}
+}
+
+static void fix_batch_put(const struct device *dev,
+			  const nrf_gnss_pvt_data_frame_t *pvt)
+{
+	struct gps_drv_data *drv_data = dev->data;
+	struct gps_fix *fix;
+	int64_t now = k_uptime_get();
+
+	k_mutex_lock(&drv_data->fix_lock, K_FOREVER);
+
+	/* The batch is never full here, the fix is written to the next slot
+	 * and only kept if it passes decimation.
+	 */
+	fix = &drv_data->fix_batch[drv_data->fix_buf][drv_data->fix_count];
+	fix->latitude = pvt->latitude;
+	fix->longitude = pvt->longitude;
+	fix->altitude = pvt->altitude;
+	fix->accuracy = pvt->accuracy;
+	fix->speed = pvt->speed;
+	fix->heading = pvt->heading;
+	copy_datetime(&fix->datetime, &pvt->datetime);
+
+	if (fix_keep(drv_data, fix, now)) {
+		if (drv_data->fix_count == 0) {
+			drv_data->fix_batch_start = now;
+		}
+
+		drv_data->fix_count++;
+		drv_data->last_fix = *fix;
+		drv_data->last_fix_time = now;
+		drv_data->has_last_fix = true;
+	}
+
+	k_mutex_unlock(&drv_data->fix_lock);
+
+	fix_batch_check(dev, now);
+}
+#endif /* CONFIG_NRF9160_GPS_FIX_BATCH */
+
 static int open_socket(struct gps_drv_data *drv_data)
 {
 	drv_data->socket = nrf_socket(NRF_AF_LOCAL, NRF_SOCK_DGRAM,
@@ -294,7 +484,8 @@ wait:
 	notify_event(dev, &evt);
 
 	while (true) {
-		nrf_gnss_data_frame_t raw_gps_data = {0};
+		/* Not cleared, nrf_recv() fills in the received frame */
+		nrf_gnss_data_frame_t raw_gps_data;
 		struct gps_event evt = {0};
 
 		/* There is no way of knowing if nrf_recv() blocks because the
@@ -330,6 +521,12 @@ wait:
 
 			if (errno == EHOSTDOWN) {
 				LOG_DBG("GPS host is going down, sleeping");
+#ifdef CONFIG_NRF9160_GPS_FIX_BATCH
+				/* Deliver what has been stored before the
+				 * search ends.
+				 */
+				fix_batch_flush(dev);
+#endif
 				cancel_works(drv_data, true);
 				atomic_clear(&drv_data->is_active);
 				atomic_set(&drv_data->is_shutdown, 1);
@@ -355,6 +552,12 @@ wait:
 
 		switch (raw_gps_data.data_id) {
 		case NRF_GNSS_PVT_DATA_ID:
+#ifdef CONFIG_NRF9160_GPS_FIX_BATCH
+			/* PVT frames come every second, also without a fix
+			 * and when blocked, so the age is checked here.
+			 */
+			fix_batch_check(dev, k_uptime_get());
+#endif
 			if (atomic_get(&drv_data->timeout_occurred) ||
 			    ((drv_data->current_cfg.nav_mode != GPS_NAV_MODE_CONTINUOUS) &&
 			    has_fix)) {
@@ -414,8 +617,6 @@ wait:
 					&drv_data->work_sync);
 			}
 
-			copy_pvt(&evt.pvt, &raw_gps_data.pvt);
-
 			if (is_fix(&raw_gps_data.pvt)) {
 				LOG_DBG("PVT: Position fix");
 
@@ -426,6 +627,20 @@ wait:
 				evt.type = GPS_EVT_PVT;
 			}
 
+#ifdef CONFIG_NRF9160_GPS_FIX_BATCH
+			if ((evt.type == GPS_EVT_PVT_FIX) &&
+			    (drv_data->current_cfg.nav_mode ==
+			     GPS_NAV_MODE_CONTINUOUS)) {
+				/* Stored in compact form, without the copy
+				 * to a PVT event.
+				 */
+				fix_batch_put(dev, &raw_gps_data.pvt);
+				print_satellite_stats(&raw_gps_data);
+				break;
+			}
+#endif
+
+			copy_pvt(&evt.pvt, &raw_gps_data.pvt);
 			notify_event(dev, &evt);
 			print_satellite_stats(&raw_gps_data);
 
@@ -768,6 +983,13 @@ set_configuration:
 		}
 	}
 
+#ifdef CONFIG_NRF9160_GPS_FIX_BATCH
+	/* Decimate relative to fixes from this search only */
+	k_mutex_lock(&drv_data->fix_lock, K_FOREVER);
+	drv_data->has_last_fix = false;
+	k_mutex_unlock(&drv_data->fix_lock);
+#endif
+
 	atomic_set(&drv_data->is_active, 1);
 	atomic_set(&drv_data->timeout_occurred, 0);
 	k_sem_give(&drv_data->thread_run_sem);
@@ -898,6 +1120,11 @@ static void stop_work_fn(struct k_work *work)
 		.type = GPS_EVT_SEARCH_STOPPED
 	};
 
+#ifdef CONFIG_NRF9160_GPS_FIX_BATCH
+	/* Deliver what has been stored before the search is reported stopped */
+	fix_batch_flush(dev);
+#endif
+
 	notify_event(dev, &evt);
 }
 
@@ -979,6 +1206,10 @@ static int init(const struct device *dev, gps_event_handler_t handler)
 	k_work_init_delayable(&drv_data->timeout_work, timeout_work_fn);
 	k_work_init_delayable(&drv_data->blocked_work, blocked_work_fn);
 	k_sem_init(&drv_data->thread_run_sem, 0, 1);
+#ifdef CONFIG_NRF9160_GPS_FIX_BATCH
+	k_mutex_init(&drv_data->fix_lock);
+	k_mutex_init(&drv_data->flush_lock);
+#endif
 
 	err = init_thread(dev);
 	if (err) {
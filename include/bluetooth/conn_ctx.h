@@ -16,7 +16,9 @@
 
 #include <zephyr.h>
 #include <sys/__assert.h>
+#include <sys/atomic.h>
 #include <bluetooth/conn.h>
+#include <bluetooth/gatt.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,39 +31,57 @@ extern "C" {
  * @param  _ctx_sz	Context size in bytes for a single connection.
  */
 #define BT_CONN_CTX_DEF(_name, _max_clients, _ctx_sz)                          \
+	BUILD_ASSERT((_max_clients) <= CONFIG_BT_MAX_CONN,                     \
+		     "More clients than Bluetooth connections");               \
 	K_MEM_SLAB_DEFINE(_name##_mem_slab,                                    \
 			  ROUND_UP(_ctx_sz, CONFIG_BT_CONN_CTX_MEM_BUF_ALIGN), \
 			  (_max_clients),                                      \
 			  CONFIG_BT_CONN_CTX_MEM_BUF_ALIGN);                   \
-	K_MUTEX_DEFINE(_name##_mutex);                                         \
 	static struct bt_conn_ctx_lib CONCAT(_name, _ctx_lib) =                \
 	{                                                                      \
 		.mem_slab = &CONCAT(_name, _mem_slab),                         \
-		.mutex = &_name##_mutex                                        \
 	}
 
-/** @brief Context data for a connection. */
+/** @brief Context data for a connection.
+ *
+ * The library only protects the lifetime of the context data, not the
+ * data itself. If the data is accessed from more than one thread, for
+ * example from the application and from Bluetooth callbacks, the user of
+ * the library must synchronize the access.
+ */
 struct bt_conn_ctx {
 	/** Any kind of data associated with a specific connection. */
 	void *data;
 
 	 /** The connection that the data is associated with. */
 	struct bt_conn *conn;
+
+	/** Reference counter and state of the context. Only for internal
+	  * use by the library. */
+	atomic_t ref;
 };
 
 /** @brief Bluetooth connection context library structure. */
 struct bt_conn_ctx_lib {
-	/** Connection contexts. */
+	/** Connection contexts, indexed by the connection index. */
 	struct bt_conn_ctx ctx[CONFIG_BT_MAX_CONN];
 
-	/** Context data mutex that ensures that only one connection context is
-	  * manipulated at a time. */
-	struct k_mutex * const mutex;
+	/** Index of the connection context that uses each memory block. */
+	uint8_t block_ctx[CONFIG_BT_MAX_CONN];
 
 	/** Memory slab instance where the memory is allocated. */
 	struct k_mem_slab * const mem_slab;
 };
 
+/**
+ * @brief Callback for iterating over connection contexts.
+ *
+ * @param ctx		Connection context.
+ * @param user_data	Data passed to the iterating function.
+ */
+typedef void (*bt_conn_ctx_foreach_cb)(const struct bt_conn_ctx *ctx,
+				       void *user_data);
+
 /**
  * @brief Get the block size.
  *
@@ -90,6 +110,8 @@ static inline size_t bt_conn_ctx_count(struct bt_conn_ctx_lib *ctx_lib)
  * @brief Allocate memory for the connection context data.
  *
  * This function can set the pointer to the allocated memory.
+ * The context of the connection is the one at the index of the connection,
+ * see bt_conn_index().
  *
  * This function should be used in conjunction with
  * @ref bt_conn_ctx_release to ensure proper operation.
@@ -105,6 +127,9 @@ void *bt_conn_ctx_alloc(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn);
 /**
  * @brief Free the allocated memory for a connection.
  *
+ * The context cannot be retrieved after this function returns. Its memory
+ * is freed when the last reference taken before is released.
+ *
  * @param ctx_lib	Bluetooth connection context library instance.
  * @param conn		Bluetooth connection.
  *
@@ -126,6 +151,10 @@ void bt_conn_ctx_free_all(struct bt_conn_ctx_lib *ctx_lib);
  * This function finds a connection's context data in the memory pool.
  * The link to find is identified by the connection object.
  *
+ * The function takes a reference to the context without any locking,
+ * so the contexts can be used by many threads at the same time.
+ * The reference only keeps the data allocated, access to the data
+ * must be synchronized by the caller, see @ref bt_conn_ctx.
  * This function should be used in conjunction with
  * @ref bt_conn_ctx_release to ensure proper operation.
  *
@@ -158,8 +187,8 @@ const struct bt_conn_ctx *bt_conn_ctx_get_by_id(struct bt_conn_ctx_lib *ctx_lib,
 /**
  * @brief Release a connection context from the memory pool.
  *
- * This function finds and releases a connection context in the memory pool.
- * The link to find is identified by its context data.
+ * This function finds a connection context in the memory pool and releases
+ * the reference to it. The link to find is identified by its context data.
  *
  * This function should be used in conjunction with @ref bt_conn_ctx_alloc,
  * @ref bt_conn_ctx_get, or @ref bt_conn_ctx_get_by_id to ensure proper
@@ -170,6 +199,44 @@ const struct bt_conn_ctx *bt_conn_ctx_get_by_id(struct bt_conn_ctx_lib *ctx_lib,
  */
 void bt_conn_ctx_release(struct bt_conn_ctx_lib *ctx_lib, void *data);
 
+/**
+ * @brief Call a function for each allocated connection context.
+ *
+ * References to all the contexts are taken before the first call and
+ * released after the last one, so all calls see the same set of contexts.
+ * The function must not release the contexts it is called with.
+ *
+ * @param ctx_lib	Bluetooth connection context library instance.
+ * @param func		Function to call.
+ * @param user_data	Data to pass to the function.
+ *
+ * @return Number of contexts for which the function was called.
+ */
+size_t bt_conn_ctx_foreach(struct bt_conn_ctx_lib *ctx_lib,
+			   bt_conn_ctx_foreach_cb func, void *user_data);
+
+/**
+ * @brief Call a function for each connection context whose connection is
+ *        subscribed to an attribute.
+ *
+ * This function works like @ref bt_conn_ctx_foreach, but skips the contexts
+ * of connections that are not subscribed to the attribute.
+ *
+ * @param ctx_lib	Bluetooth connection context library instance.
+ * @param attr		Characteristic value attribute or its CCC descriptor.
+ * @param ccc_type	The subscription type, @ref BT_GATT_CCC_NOTIFY or
+ *			@ref BT_GATT_CCC_INDICATE.
+ * @param func		Function to call.
+ * @param user_data	Data to pass to the function.
+ *
+ * @return Number of contexts for which the function was called.
+ */
+size_t bt_conn_ctx_foreach_subscribed(struct bt_conn_ctx_lib *ctx_lib,
+				      const struct bt_gatt_attr *attr,
+				      uint16_t ccc_type,
+				      bt_conn_ctx_foreach_cb func,
+				      void *user_data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -44,6 +44,11 @@ extern "C" {
 /** Length of encoded HID Information. */
 #define BT_HIDS_INFORMATION_LEN	4
 
+/** Maximum number of reports in a batch, one for each Input Report
+ *  and one for each boot Input Report.
+ */
+#define BT_HIDS_BATCH_REP_MAX (CONFIG_BT_HIDS_INPUT_REP_MAX + 2)
+
 /**
  * @brief Declare a HIDS instance.
  *
@@ -486,6 +491,36 @@ struct bt_hids_conn_data {
 	uint8_t *feat_rep_ctx;
 };
 
+/** Types of reports in a batch. */
+enum bt_hids_batch_rep_type {
+	/** Input Report. */
+	BT_HIDS_BATCH_REP_INPUT,
+	/** Boot Mouse Input Report. */
+	BT_HIDS_BATCH_REP_BOOT_MOUSE,
+	/** Boot Keyboard Input Report. */
+	BT_HIDS_BATCH_REP_BOOT_KB,
+};
+
+/** @brief Report in a batch sent with @ref bt_hids_inp_rep_send_batch.
+ */
+struct bt_hids_batch_rep {
+	/** Report type. */
+	enum bt_hids_batch_rep_type type;
+
+	/** Index of report descriptor, used only for Input Reports. */
+	uint8_t rep_index;
+
+	/** Pointer to the report data.
+	 *
+	 * For the Boot Mouse Input Report the data is the state of the
+	 * mouse buttons, the horizontal movement and the vertical movement.
+	 */
+	uint8_t const *data;
+
+	/** Length of report data. */
+	uint8_t len;
+};
+
 
 /** @brief Initialize the HIDS instance.
  *
@@ -590,6 +625,35 @@ int bt_hids_boot_kb_inp_rep_send(struct bt_hids *hids_obj, struct bt_conn *conn,
 				 uint8_t const *rep, uint16_t len,
 				 bt_gatt_complete_func_t cb);
 
+/** @brief Send a batch of Input Reports to a set of connections.
+ *
+ *  All the reports for a connection are submitted to the Bluetooth stack
+ *  together using bt_gatt_notify_multiple, so that the stack can send
+ *  them in one PDU if CONFIG_BT_GATT_NOTIFY_MULTIPLE is enabled and the
+ *  peer supports it. A report is sent only to connections that have
+ *  enabled notifications for it.
+ *
+ *  @warning The function is not thread safe.
+ *	     It can not be called from multiple threads at the same time.
+ *
+ *  @param hids_obj Pointer to HIDS instance.
+ *  @param conns Array of Connection Objects, or NULL for all connections.
+ *  @param conn_cnt Number of Connection Objects in @p conns.
+ *  @param reps Array of reports.
+ *  @param rep_cnt Number of reports, at most @ref BT_HIDS_BATCH_REP_MAX.
+ *  @param cb Notification complete callback (can be NULL). Called for the
+ *	      last report sent to each connection.
+ *
+ *  @retval 0 If at least one report was sent and no errors occurred.
+ *  @retval -ENODATA If no connection has enabled notifications for
+ *		     any of the reports.
+ *  @return Otherwise, a (negative) error code is returned.
+ */
+int bt_hids_inp_rep_send_batch(struct bt_hids *hids_obj,
+			       struct bt_conn **conns, size_t conn_cnt,
+			       const struct bt_hids_batch_rep *reps,
+			       size_t rep_cnt, bt_gatt_complete_func_t cb);
+
 
 #ifdef __cplusplus
 }
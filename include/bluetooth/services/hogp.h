@@ -25,6 +25,16 @@ extern "C" {
 
 struct bt_hogp;
 struct bt_hogp_rep_info;
+struct bt_hogp_cache;
+
+/** Maximum number of values read with one Read Multiple request
+ *  during the HIDS client preparation. This many handles fit in a request
+ *  with the default ATT MTU.
+ */
+#define BT_HOGP_READ_MULTIPLE_MAX 11
+
+/** Size of the Database Hash of the server. */
+#define BT_HOGP_DB_HASH_SIZE 16
 
 /**
  * @brief Callback function that is called when a notification or read response
@@ -142,6 +152,20 @@ struct bt_hogp_init_params {
  */
 struct bt_hogp_rep_info;
 
+/**
+ * @brief Statistics of the HIDS client preparation.
+ */
+struct bt_hogp_prep_stats {
+	/** Time from the handles assignment until the client was ready,
+	 *  in milliseconds.
+	 */
+	uint32_t latency_ms;
+	/** Number of read requests sent to the server. */
+	uint8_t reads;
+	/** The server data was restored from the cache. */
+	bool cached;
+};
+
 /**
  * @brief HOGP object.
  *
@@ -209,6 +233,40 @@ struct bt_hogp {
 		uint8_t rep_idx;
 	} init_repref;
 
+#if defined(CONFIG_BT_HOGP_READ_MULTIPLE)
+	struct {
+		/** Handles of the values read with one Read Multiple request.
+		 *  The values are the HID Information, the report references
+		 *  and the protocol mode, in this order.
+		 */
+		uint16_t handles[BT_HOGP_READ_MULTIPLE_MAX];
+		/** Index of the first value read with the request. */
+		uint16_t first;
+		/** Number of values read with the request. */
+		uint8_t cnt;
+		/** The response data was received. */
+		bool received;
+		/** Result of the response data processing. */
+		int err;
+	} init_multi;
+#endif
+
+	/** Preparation start time. */
+	uint32_t prep_start;
+	/** Preparation statistics. */
+	struct bt_hogp_prep_stats prep_stats;
+
+#if defined(CONFIG_BT_HOGP_CACHE)
+	/** Cached data of the server, if it is bonded. */
+	struct bt_hogp_cache *cache;
+	/** Database Hash of the server, read when it is bonded. */
+	uint8_t db_hash[BT_HOGP_DB_HASH_SIZE];
+	/** The server provided its Database Hash. */
+	bool db_hash_valid;
+	/** Work used to pass the cached report map to the callback. */
+	struct k_work map_work;
+#endif
+
 	struct {
 		/** Keyboard input boot report. Input and Output keyboard
 		 *  reports come in pairs.
@@ -330,6 +388,19 @@ bool bt_hogp_assign_check(const struct bt_hogp *hogp);
  */
 bool bt_hogp_ready_check(const struct bt_hogp *hogp);
 
+/**
+ * @brief Get statistics of the HIDS client preparation.
+ *
+ * The statistics are valid after the @ref bt_hogp_ready_cb function
+ * is called.
+ *
+ * @param hogp HOGP object.
+ *
+ * @return Preparation statistics.
+ */
+const struct bt_hogp_prep_stats *bt_hogp_prep_stats_get(
+	const struct bt_hogp *hogp);
+
 /**
  * @brief Send a read request addressing the report value descriptor.
  *
@@ -426,6 +497,11 @@ int bt_hogp_rep_unsubscribe(struct bt_hogp *hogp,
  * To read the whole map, call this function repeatedly with a different
  * offset.
  *
+ * If @option{CONFIG_BT_HOGP_CACHE} is enabled and the whole report map
+ * of a bonded server was read before, the data is taken from the cache.
+ * The callback is then called from the system workqueue, with chunks of
+ * the same size as read from the server.
+ *
  * @note
  * This function uses the common read parameters structure inside the HIDS
  * client object. This object may be used by other functions and is
@@ -41,6 +41,7 @@ struct dfu_target {
 	int (*offset_get)(size_t *offset);
 	int (*write)(const void *const buf, size_t len);
 	int (*done)(bool successful);
+	int (*reset)(void);
 };
 
 /**
@@ -115,6 +116,9 @@ int dfu_target_done(bool successful);
  * @brief Deinitialize the resources that were needed for the current DFU
  *	  target if any and resets the current dfu target.
  *
+ * The data written to the target is discarded, so that the next
+ * initialization of the target starts from offset 0.
+ *
  * @return 0 for an successful deinitialization and reset or a negative error
  *	   code identicating reason of failure.
  **/
@@ -94,6 +94,14 @@ int dfu_target_mcuboot_write(const void *const buf, size_t len);
  */
 int dfu_target_mcuboot_done(bool successful);
 
+/**
+ * @brief Discard the data written so far, so that the next upgrade starts
+ * from offset 0.
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int dfu_target_mcuboot_reset(void);
+
 #endif /* DFU_TARGET_MCUBOOT_H__ */
 
 /**@} */
@@ -67,6 +67,14 @@ int dfu_target_modem_delta_write(const void *const buf, size_t len);
  */
 int dfu_target_modem_delta_done(bool successful);
 
+/**
+ * @brief Delete the banked modem firmware, so that the next upgrade starts
+ * from offset 0.
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int dfu_target_modem_delta_reset(void);
+
 #endif /* DFU_TARGET_MODEM_H__ */
 
 /**@} */
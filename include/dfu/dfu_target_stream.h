@@ -99,6 +99,14 @@ int dfu_target_stream_write(const uint8_t *buf, size_t len);
  */
 int dfu_target_stream_done(bool successful);
 
+/**
+ * @brief Discard the data written so far, so that the next initialization
+ * starts from offset 0.
+ *
+ * @return Non-negative value on success, negative errno otherwise.
+ */
+int dfu_target_stream_reset(void);
+
 #endif /* DFU_TARGET_STREAM_H__ */
 
 /**@} */
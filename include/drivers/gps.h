@@ -83,6 +83,25 @@ struct gps_pvt {
 	struct gps_sv sv[GPS_PVT_MAX_SV_COUNT];
 };
 
+/** Compact position fix, as stored in a fix batch. */
+struct gps_fix {
+	double latitude;
+	double longitude;
+	float altitude;
+	float accuracy;
+	float speed;
+	float heading;
+	struct gps_datetime datetime;
+};
+
+/** Batch of position fixes, oldest first. The fixes are only valid for the
+ *  duration of the event handler call.
+ */
+struct gps_fix_batch {
+	const struct gps_fix *fixes;
+	size_t count;
+};
+
 enum gps_nav_mode {
 	/** Search will be stopped after first fix. */
 	GPS_NAV_MODE_SINGLE_FIX,
@@ -241,6 +260,10 @@ enum gps_event_type {
 	GPS_EVT_OPERATION_UNBLOCKED,
 	GPS_EVT_AGPS_DATA_NEEDED,
 	GPS_EVT_ERROR,
+	/** Batch of position fixes, sent instead of GPS_EVT_PVT_FIX in
+	 *  continuous navigation mode if the driver batches fixes.
+	 */
+	GPS_EVT_PVT_FIX_BATCH,
 };
 
 /**
@@ -257,6 +280,7 @@ struct gps_event {
 		struct gps_nmea nmea;
 		struct gps_agps_request agps_request;
 		enum gps_error error;
+		struct gps_fix_batch batch;
 	};
 };
 
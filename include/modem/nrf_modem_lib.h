@@ -83,6 +83,25 @@ void nrf_modem_lib_shm_tx_diagnose(void);
  */
 void nrf_modem_lib_heap_diagnose(void);
 
+/**
+ * @brief Print diagnostic information for thread wakeups.
+ *
+ * Every RPC event from the modem wakes up all threads sleeping in the
+ * library, because the event does not identify the socket or request
+ * it completes. Reports the number of RPC events, the threads they woke
+ * up and the most threads woken up by a single event.
+ */
+void nrf_modem_lib_wakeup_diagnose(void);
+
+/**
+ * @brief Print diagnostic information for modem traces.
+ *
+ * Reports the traces received, the traces dropped because the trace
+ * buffer was full, the bytes the sink failed to write and how many
+ * times the sink was full.
+ */
+void nrf_modem_lib_trace_diagnose(void);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -40,6 +40,18 @@ enum sms_type {
  */
 #define SMS_MAX_PAYLOAD_LEN_CHARS 160
 
+/**
+ * @brief Size of the payload buffer in struct sms_data excluding NUL-termination.
+ *
+ * @details When concatenated SMS reassembly is enabled, the buffer must hold all
+ * parts of a reassembled message.
+ */
+#if defined(CONFIG_SMS_REASSEMBLY)
+#define SMS_MAX_PAYLOAD_BUF_LEN (SMS_MAX_PAYLOAD_LEN_CHARS * CONFIG_SMS_REASSEMBLY_MAX_PARTS)
+#else
+#define SMS_MAX_PAYLOAD_BUF_LEN SMS_MAX_PAYLOAD_LEN_CHARS
+#endif
+
 /**
  * @brief Maximum length of SMS address, i.e., phone number, in characters
  * as specified in 3GPP TS 23.040 Section 9.1.2.3.
@@ -78,6 +90,10 @@ struct sms_address {
  * @brief SMS concatenated short message information.
  *
  * @details This is specified in 3GPP TS 23.040 Section 9.2.3.24.1 and 9.2.3.24.8.
+ *
+ * If CONFIG_SMS_REASSEMBLY is enabled, subscribers receive concatenated messages only
+ * once all parts have been reassembled. In that case, @c seq_number is set to zero and
+ * the payload contains the text of all parts.
  */
 struct sms_udh_concat {
 	/** @brief Indicates whether this field is present in the SMS message. */
@@ -144,13 +160,15 @@ struct sms_data {
 	 *
 	 * @details Reserving enough bytes for maximum number of characters
 	 * but the length of the received payload is in payload_len variable.
+	 * If CONFIG_SMS_REASSEMBLY is enabled, the buffer is large enough to hold
+	 * a reassembled concatenated message.
 	 *
 	 * Generally the message is of text type in which case you can treat it as string.
 	 * However, header may contain information that determines it for specific purpose,
 	 * e.g., via application port information, in which case it should be treated as
 	 * specified for that purpose.
 	 */
-	uint8_t payload[SMS_MAX_PAYLOAD_LEN_CHARS + 1];
+	uint8_t payload[SMS_MAX_PAYLOAD_BUF_LEN + 1];
 };
 
 /** @brief SMS listener callback function. */
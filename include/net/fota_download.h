@@ -42,7 +42,9 @@ enum fota_download_evt_id {
 	/** FOTA download error. */
 	FOTA_DOWNLOAD_EVT_ERROR,
 	/** FOTA download cancelled. */
-	FOTA_DOWNLOAD_EVT_CANCELLED
+	FOTA_DOWNLOAD_EVT_CANCELLED,
+	/** FOTA download throughput report. */
+	FOTA_DOWNLOAD_EVT_THROUGHPUT,
 };
 
 /**
@@ -59,6 +61,20 @@ enum fota_download_error_cause {
 	FOTA_DOWNLOAD_ERROR_CAUSE_TYPE_MISMATCH,
 };
 
+/**
+ * @brief FOTA download throughput, per stage.
+ */
+struct fota_download_throughput {
+	/** Bytes per second received, not counting time spent waiting for
+	 *  writes.
+	 */
+	uint32_t download;
+	/** Bytes per second written to the DFU target, while writing. */
+	uint32_t write;
+	/** Milliseconds the download has waited for writes. */
+	uint32_t stalled;
+};
+
 /**
  * @brief FOTA download event data.
  */
@@ -70,6 +86,8 @@ struct fota_download_evt {
 		enum fota_download_error_cause cause;
 		/** Download progress %. */
 		int progress;
+		/** Throughput, for FOTA_DOWNLOAD_EVT_THROUGHPUT. */
+		struct fota_download_throughput throughput;
 	};
 };
 
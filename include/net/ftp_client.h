@@ -317,7 +317,8 @@ int ftp_pwd(void);
  * @param options List options, refer to Linux "man ls"
  * @param target file or diretory to list. If not specified, list current folder
  *
- * @retval ftp_reply_code or negative if error
+ * @retval ftp_reply_code or negative if error,
+ *         -EBUSY if a streaming transfer is in progress
  */
 int ftp_list(const char *options, const char *target);
 
@@ -366,7 +367,8 @@ int ftp_delete(const char *file);
  *
  * @param file Target file name
  *
- * @retval ftp_reply_code or negative if error
+ * @retval ftp_reply_code or negative if error,
+ *         -EBUSY if a streaming transfer is in progress
  */
 int ftp_get(const char *file);
 
@@ -378,10 +380,85 @@ int ftp_get(const char *file);
  * @param length Length of data to be stored
  * @param type specify FTP put types, see enum ftp_reply_code
  *
- * @retval ftp_reply_code or negative if error
+ * @retval ftp_reply_code or negative if error,
+ *         -EBUSY if a streaming transfer is in progress
  */
 int ftp_put(const char *file, const uint8_t *data, uint16_t length, int type);
 
+/**@brief Open a streaming upload
+ * The data connection stays open until ftp_put_stream_close() is called,
+ * so data can be written in any number of chunks of any size.
+ * To resume an interrupted transfer, reopen the stream with the size of
+ * the file stored by the server. ftp_stream_offset() is only an upper
+ * bound for it, as data accepted by the network stack can be lost with
+ * the connection.
+ *
+ * @param file Target file name, ignored for FTP_PUT_UNIQUE
+ * @param type specify FTP put types, see enum ftp_put_type
+ * @param offset File offset to restart the transfer from (REST), or 0
+ *
+ * @retval FTP_CODE_150 if the stream is open, other ftp_reply_code or
+ *         negative if error
+ */
+int ftp_put_stream_open(const char *file, int type, uint32_t offset);
+
+/**@brief Write data to an open streaming upload
+ * Blocks until all data is accepted by the network stack.
+ *
+ * @param data Data to be stored
+ * @param length Length of data to be stored
+ *
+ * @retval 0 If all data was sent, negative if error
+ */
+int ftp_put_stream_write(const uint8_t *data, size_t length);
+
+/**@brief Close a streaming upload and wait for the transfer result
+ *
+ * @retval ftp_reply_code or negative if error
+ */
+int ftp_put_stream_close(void);
+
+/**@brief Open a streaming download
+ * Data is not delivered through the data callback, but read by the caller
+ * with ftp_get_stream_read(). The server is throttled by the TCP window
+ * while the caller is not reading.
+ *
+ * @param file Target file name
+ * @param offset File offset to restart the transfer from (REST), or 0
+ *
+ * @retval FTP_CODE_150 if the stream is open, other ftp_reply_code or
+ *         negative if error
+ */
+int ftp_get_stream_open(const char *file, uint32_t offset);
+
+/**@brief Read data from an open streaming download
+ *
+ * @param buf Buffer for the received data
+ * @param length Size of the buffer
+ *
+ * @retval Number of bytes read, 0 at the end of file, when the server has
+ *         closed the data connection in order, -ETIMEDOUT if no data
+ *         was received within CONFIG_FTP_CLIENT_LISTEN_TIME,
+ *         -ECONNRESET or -EIO if the data connection was lost, or other
+ *         negative value if error
+ */
+int ftp_get_stream_read(uint8_t *buf, size_t length);
+
+/**@brief Close a streaming download and wait for the transfer result
+ *
+ * @retval ftp_reply_code or negative if error
+ */
+int ftp_get_stream_close(void);
+
+/**@brief Get the file offset of the current or last streaming transfer
+ * This is the restart offset plus the number of bytes transferred.
+ * For an upload, the bytes are counted when the network stack accepts
+ * them, so the value is an upper bound for the data stored by the server.
+ *
+ * @retval File offset
+ */
+uint32_t ftp_stream_offset(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -102,14 +102,28 @@ typedef int (*icalendar_parser_callback_t)(
 
 /**
  * @brief iCalendar parser instance.
+ *
+ * @details The parser keeps only the content line being unfolded and the
+ * component being parsed, so its memory usage does not depend on the size
+ * of the calendar.
  */
 struct icalendar_parser {
-	/** Internal Buffer for parsing incoming data stream */
-	char buf[CONFIG_ICAL_PARSER_BUFFER_SIZE + 1];
-	/** Offset of unparsed data in buf. */
-	size_t offset;
+	/** Unfolded content line being received. */
+	char line[CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE + 1];
+	/** Length of the content line. */
+	size_t line_len;
+	/** Content line did not fit in the line buffer. */
+	bool line_overflow;
+	/** Line break and folding state between data fragments. */
+	uint8_t line_state;
 	/** begin of iCalendar object delimiter pair */
 	bool icalobject_begin;
+	/** A calendar component is being parsed. */
+	bool com_active;
+	/** Nesting level of subcomponents in the current component. */
+	uint8_t com_depth;
+	/** Calendar component being parsed. */
+	struct ical_parser_evt evt;
 	/** Event handler. */
 	icalendar_parser_callback_t callback;
 };
@@ -128,11 +142,16 @@ int ical_parser_init(struct icalendar_parser *ical,
 /**
  * @brief Parse the iCalendar data stream. Return the parsed bytes.
  *
+ * The data can be split into fragments at any position, for example as
+ * received from the download client. Each calendar component is reported
+ * through the callback as soon as its END delimiter has been parsed.
+ *
  * @param[in,out] ical iCalendar parser instance.
  * @param[in] data Input data to be parsed.
  * @param[in] len  Length of input data stream.
  *
- * @retval size_t  Parsed bytes.
+ * @retval size_t  Parsed bytes. This is less than @p len only if the
+ *                 callback returned non-zero to stop the parsing.
  */
 size_t ical_parser_parse(struct icalendar_parser *ical,
 			const char *data, size_t len);
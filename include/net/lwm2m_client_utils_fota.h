@@ -31,6 +31,15 @@ enum counter_type {
 	COUNTER_UPDATE /**< Update image's counter */
 };
 
+/**
+ * @brief State of an interrupted firmware download
+ */
+struct lwm2m_client_utils_download_state {
+	int image_type; /**< DFU target image type */
+	uint32_t total_size; /**< Image size given by the server, or 0 */
+	uint32_t offset; /**< Bytes written to the DFU target */
+};
+
 /**
  * @brief Read the update counter
  */
@@ -41,6 +50,25 @@ int fota_update_counter_read(struct update_counter *update_counter);
  */
 int fota_update_counter_update(enum counter_type type, uint32_t new_value);
 
+/**
+ * @brief Read the state of an interrupted firmware download
+ *
+ * @return 0 on success, -ENOENT if there is no download in progress.
+ */
+int lwm2m_client_utils_download_state_read(
+	struct lwm2m_client_utils_download_state *state);
+
+/**
+ * @brief Store the state of a firmware download in progress
+ */
+int lwm2m_client_utils_download_state_save(
+	const struct lwm2m_client_utils_download_state *state);
+
+/**
+ * @brief Forget the firmware download in progress
+ */
+int lwm2m_client_utils_download_state_clear(void);
+
 /**
  * @brief Initialize FOTA settings
  */
@@ -26,6 +26,9 @@ struct multicell_location {
 
 /* @brief Send a request for location based on cell measurements to the
  *        selected location service.
+ *        If CONFIG_MULTICELL_LOCATION_CELL_DB is enabled, the location is
+ *        resolved from the local cell database if the serving cell is
+ *        found there.
  *
  * @note This function will block until a response
  *       is received from the location service.
@@ -55,10 +58,40 @@ int multicell_location_get(const struct lte_lc_cells_info *cell_data,
  *		    provisioned to CONFIG_MULTICELL_LOCATION_TLS_SEC_TAG is
  *		    overwritten.
  *
- * @return 0 on success, or negative error code on failure.
+ * @return 0 on success, -ENOTSUP if no location service is enabled, or
+ *	   negative error code on failure.
  */
 int multicell_location_provision_certificate(bool overwrite);
 
+/* @brief Write part of a delta update to the local cell database.
+ *	  The delta is written in consecutive parts. The first part, at
+ *	  offset 0, erases the previous delta, which is not used again until
+ *	  @ref multicell_location_db_delta_apply is called.
+ *
+ * @note Requires CONFIG_MULTICELL_LOCATION_CELL_DB. The length of each part
+ *	 must be a multiple of the flash write block size, except for the
+ *	 last part.
+ *
+ * @param offset Offset of the part in the delta.
+ * @param data Pointer to the part.
+ * @param len Length of the part.
+ *
+ * @return 0 on success, or negative error code on failure.
+ */
+int multicell_location_db_delta_write(size_t offset, const void *data,
+				      size_t len);
+
+/* @brief Validate the delta written with
+ *	  @ref multicell_location_db_delta_write and use it for subsequent
+ *	  location requests.
+ *
+ * @note Requires CONFIG_MULTICELL_LOCATION_CELL_DB.
+ *
+ * @return 0 on success, -ESTALE if the delta is for another version of the
+ *	   cell database, or negative error code on failure.
+ */
+int multicell_location_db_delta_apply(void);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ *  @defgroup zb_rx_stats Zigbee receive queue statistics
+ *  @{
+ */
+
+/**
+ * @file
+ * @brief This file defines the statistics of the 802.15.4 receive queue.
+ */
+
+#ifndef ZIGBEE_RX_STATS_H__
+#define ZIGBEE_RX_STATS_H__
+
+#include <zephyr/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief Statistics of the 802.15.4 receive queue. */
+struct zigbee_rx_stats {
+	/** Number of frames queued for ZBOSS. */
+	uint32_t received;
+	/** Number of frames dropped because the queue was full. The frames
+	 *  were acknowledged by the radio before they were dropped.
+	 */
+	uint32_t dropped;
+	/** Number of frames currently waiting in the queue. */
+	uint32_t queue_len;
+	/** Highest number of frames waiting in the queue. */
+	uint32_t queue_max;
+};
+
+/**@brief Function for reading the 802.15.4 receive queue statistics.
+ *
+ * @param[out] stats  Current statistics.
+ */
+void zigbee_rx_stats_get(struct zigbee_rx_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZIGBEE_RX_STATS_H__ */
+
+/**@} */
@@ -0,0 +1,526 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+#include <stdlib.h>
+#include <storage/flash_map.h>
+#include <sys/crc.h>
+#include <pm_config.h>
+#include <modem/lte_lc.h>
+#include <net/multicell_location.h>
+
+#include "cell_db.h"
+
+#include <logging/log.h>
+
+LOG_MODULE_DECLARE(multicell_location, CONFIG_MULTICELL_LOCATION_LOG_LEVEL);
+
+#define CELL_DB_MAGIC		0x42444c43 /* "CLDB" */
+#define CELL_DB_VERSION		1
+#define CELL_DB_FLAG_DELTA	BIT(0)
+
+#define ECI_MASK		0x0fffffff
+
+/* The base database fills the partition, except for the delta at the end */
+#define DELTA_SIZE		CONFIG_MULTICELL_LOCATION_CELL_DB_DELTA_SIZE
+#define DELTA_OFFSET		(PM_CELL_DB_SIZE - DELTA_SIZE)
+#define BASE_SIZE		DELTA_OFFSET
+
+/* Approximately, one meter is 90 units of 1e-7 degrees */
+#define UNITS_PER_METER		90
+#define NEIGHBOR_DISTANCE_MAX	\
+	((uint64_t)CONFIG_MULTICELL_LOCATION_CELL_DB_NEIGHBOR_DISTANCE * UNITS_PER_METER)
+
+#define SCAN_CHUNK		8
+
+BUILD_ASSERT(PM_CELL_DB_SIZE > DELTA_SIZE,
+	     "The cell database partition must be larger than the delta");
+
+/* The format is shared with scripts/cell_db/cell_db.py, little endian. */
+struct cell_db_header {
+	uint32_t magic;
+	uint8_t version;
+	uint8_t flags;
+	uint16_t record_size;
+	uint32_t count;
+	/* Sequence number of the database, or of the base a delta applies to */
+	uint32_t seq;
+	uint32_t base_seq;
+	/* CRC32 (IEEE) of the records */
+	uint32_t crc;
+	uint32_t reserved[2];
+} __packed;
+
+/* Records are sorted by MCC, MNC, TAC and ECI. In a delta, a record with
+ * range 0 removes the cell from the base.
+ */
+struct cell_db_record {
+	uint16_t mcc;
+	uint16_t mnc;
+	uint16_t tac;
+	uint16_t range; /* Meters */
+	uint32_t eci;
+	int32_t lat; /* 1e-7 degrees */
+	int32_t lon; /* 1e-7 degrees */
+	uint16_t pci; /* Physical cell ID, 0xffff if unknown */
+	uint16_t reserved;
+} __packed;
+
+BUILD_ASSERT(sizeof(struct cell_db_header) == 32);
+BUILD_ASSERT(sizeof(struct cell_db_record) == 24);
+
+struct cell_db_image {
+	off_t offset;
+	uint32_t count; /* 0 if the image is not valid */
+	uint32_t seq;
+};
+
+static const struct flash_area *fa;
+static struct cell_db_image base = { .offset = 0 };
+static struct cell_db_image delta = { .offset = DELTA_OFFSET };
+static uint8_t crc_buf[256];
+static bool loaded;
+
+static K_MUTEX_DEFINE(db_lock);
+
+static uint64_t key_make(uint32_t mcc, uint32_t mnc, uint32_t tac, uint32_t eci)
+{
+	return ((uint64_t)(mcc & 0x3ff) << 54) | ((uint64_t)(mnc & 0x3ff) << 44) |
+	       ((uint64_t)(tac & 0xffff) << 28) | (eci & ECI_MASK);
+}
+
+static uint64_t record_key(const struct cell_db_record *rec)
+{
+	return key_make(rec->mcc, rec->mnc, rec->tac, rec->eci);
+}
+
+static int records_read(const struct cell_db_image *img, uint32_t idx,
+			struct cell_db_record *recs, size_t count)
+{
+	return flash_area_read(fa, img->offset + sizeof(struct cell_db_header) +
+				   idx * sizeof(struct cell_db_record),
+			       recs, count * sizeof(struct cell_db_record));
+}
+
+/* Index of the first record with a key that is not less than the given key */
+static int lower_bound(const struct cell_db_image *img, uint64_t key,
+		       uint32_t *idx)
+{
+	struct cell_db_record rec;
+	uint32_t lo = 0;
+	uint32_t hi = img->count;
+	uint32_t mid;
+	int err;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+
+		err = records_read(img, mid, &rec, 1);
+		if (err) {
+			return err;
+		}
+
+		if (record_key(&rec) < key) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	*idx = lo;
+
+	return 0;
+}
+
+static int image_find(const struct cell_db_image *img, uint64_t key,
+		      struct cell_db_record *rec)
+{
+	uint32_t idx;
+	int err;
+
+	err = lower_bound(img, key, &idx);
+	if (err) {
+		return err;
+	}
+
+	if (idx == img->count) {
+		return -ENOENT;
+	}
+
+	err = records_read(img, idx, rec, 1);
+	if (err) {
+		return err;
+	}
+
+	return (record_key(rec) == key) ? 0 : -ENOENT;
+}
+
+/* Look up a cell. The delta takes precedence over the base. */
+static int cell_find(uint64_t key, struct cell_db_record *rec)
+{
+	int err;
+
+	err = image_find(&delta, key, rec);
+	if (err == -ENOENT) {
+		err = image_find(&base, key, rec);
+	}
+
+	if (err) {
+		return err;
+	}
+
+	return (rec->range == 0) ? -ENOENT : 0;
+}
+
+static uint64_t distance(const struct cell_db_record *a,
+			 const struct cell_db_record *b)
+{
+	return llabs((int64_t)a->lat - b->lat) + llabs((int64_t)a->lon - b->lon);
+}
+
+/* Physical cell IDs are reused, so the neighbor cell is taken to be the
+ * cell with the physical cell ID in the serving cell's tracking area that
+ * is nearest the serving cell.
+ */
+static int tac_scan(const struct cell_db_image *img,
+		    const struct cell_db_record *serving, uint16_t pci,
+		    struct cell_db_record *found, uint64_t *best)
+{
+	struct cell_db_record recs[SCAN_CHUNK];
+	struct cell_db_record tmp;
+	uint64_t first = key_make(serving->mcc, serving->mnc, serving->tac, 0);
+	uint64_t last = first | ECI_MASK;
+	uint64_t dist;
+	uint32_t scanned = 0;
+	uint32_t idx;
+	size_t n;
+	int err;
+
+	err = lower_bound(img, first, &idx);
+	if (err) {
+		return err;
+	}
+
+	while ((idx < img->count) &&
+	       (scanned < CONFIG_MULTICELL_LOCATION_CELL_DB_SCAN_MAX)) {
+		n = MIN(ARRAY_SIZE(recs), img->count - idx);
+
+		err = records_read(img, idx, recs, n);
+		if (err) {
+			return err;
+		}
+
+		for (size_t i = 0; i < n; i++) {
+			if (record_key(&recs[i]) > last) {
+				return 0;
+			}
+
+			if ((recs[i].pci != pci) || (recs[i].range == 0) ||
+			    (recs[i].eci == serving->eci)) {
+				continue;
+			}
+
+			dist = distance(serving, &recs[i]);
+			if (dist >= *best) {
+				continue;
+			}
+
+			/* Cells in the base that the delta changes or removes */
+			if ((img == &base) &&
+			    (image_find(&delta, record_key(&recs[i]), &tmp) == 0)) {
+				continue;
+			}
+
+			*best = dist;
+			*found = recs[i];
+		}
+
+		idx += n;
+		scanned += n;
+	}
+
+	return 0;
+}
+
+static int neighbor_find(const struct cell_db_record *serving, uint16_t pci,
+			 struct cell_db_record *found)
+{
+	uint64_t best = NEIGHBOR_DISTANCE_MAX;
+	int err;
+
+	err = tac_scan(&delta, serving, pci, found, &best);
+	if (err) {
+		return err;
+	}
+
+	err = tac_scan(&base, serving, pci, found, &best);
+	if (err) {
+		return err;
+	}
+
+	return (best < NEIGHBOR_DISTANCE_MAX) ? 0 : -ENOENT;
+}
+
+/* The weight halves for every 6 dB that a cell is weaker than the strongest
+ * cell, and is inversely proportional to the range of the cell.
+ */
+static uint32_t weight(int16_t rsrp, int16_t best_rsrp, uint16_t range)
+{
+	uint32_t shift = MIN((best_rsrp - rsrp) / 6, 16);
+
+	return MAX((BIT(24) >> shift) / range, 1);
+}
+
+static int image_load(struct cell_db_image *img, size_t size, bool is_delta)
+{
+	struct cell_db_header hdr;
+	uint32_t crc = 0;
+	size_t len;
+	size_t chunk;
+	int err;
+
+	img->count = 0;
+
+	err = flash_area_read(fa, img->offset, &hdr, sizeof(hdr));
+	if (err) {
+		return err;
+	}
+
+	if (hdr.magic != CELL_DB_MAGIC) {
+		return -ENOENT;
+	}
+
+	if ((hdr.version != CELL_DB_VERSION) ||
+	    (hdr.record_size != sizeof(struct cell_db_record)) ||
+	    (!!(hdr.flags & CELL_DB_FLAG_DELTA) != is_delta) ||
+	    (hdr.count > (size - sizeof(hdr)) / sizeof(struct cell_db_record))) {
+		return -EINVAL;
+	}
+
+	if (is_delta && (hdr.base_seq != base.seq)) {
+		LOG_WRN("Delta is for database %u, not %u", hdr.base_seq,
+			base.seq);
+		return -ESTALE;
+	}
+
+	len = hdr.count * sizeof(struct cell_db_record);
+
+	for (size_t offset = 0; offset < len; offset += chunk) {
+		chunk = MIN(sizeof(crc_buf), len - offset);
+
+		err = flash_area_read(fa, img->offset + sizeof(hdr) + offset,
+				      crc_buf, chunk);
+		if (err) {
+			return err;
+		}
+
+		crc = crc32_ieee_update(crc, crc_buf, chunk);
+	}
+
+	if (crc != hdr.crc) {
+		return -EBADMSG;
+	}
+
+	img->count = hdr.count;
+	img->seq = hdr.seq;
+
+	return 0;
+}
+
+/* Errors of image_load() that are caused by the content of the flash. Other
+ * errors are failed flash reads, after which the database is loaded again.
+ */
+static bool is_content_error(int err)
+{
+	return (err == -ENOENT) || (err == -EINVAL) || (err == -ESTALE) ||
+	       (err == -EBADMSG);
+}
+
+static int db_init(void)
+{
+	int err;
+
+	if (loaded) {
+		return 0;
+	}
+
+	if (fa == NULL) {
+		err = flash_area_open(PM_CELL_DB_ID, &fa);
+		if (err) {
+			LOG_ERR("Failed to open cell database partition, err %d",
+				err);
+			fa = NULL;
+			return err;
+		}
+	}
+
+	err = image_load(&base, BASE_SIZE, false);
+	if (err == 0) {
+		LOG_INF("Cell database %u, %u cells", base.seq, base.count);
+	} else if (is_content_error(err)) {
+		LOG_WRN("No valid cell database, err %d", err);
+		loaded = true;
+		return 0;
+	} else {
+		LOG_ERR("Failed to read cell database, err %d", err);
+		return err;
+	}
+
+	err = image_load(&delta, DELTA_SIZE, true);
+	if (err == 0) {
+		LOG_INF("Cell database delta %u, %u cells", delta.seq,
+			delta.count);
+	} else if (!is_content_error(err)) {
+		LOG_ERR("Failed to read cell database delta, err %d", err);
+		base.count = 0;
+		return err;
+	} else if (err != -ENOENT) {
+		LOG_WRN("Ignoring cell database delta, err %d", err);
+	}
+
+	loaded = true;
+
+	return 0;
+}
+
+int cell_db_location_get(const struct lte_lc_cells_info *cell_data,
+			 struct multicell_location *location)
+{
+	const struct lte_lc_cell *cell = &cell_data->current_cell;
+	size_t ncells_count = MIN(cell_data->ncells_count,
+				  CONFIG_MULTICELL_LOCATION_MAX_NEIGHBORS);
+	struct cell_db_record serving;
+	struct cell_db_record rec;
+	int16_t best_rsrp = cell->rsrp;
+	int64_t lat_sum, lon_sum;
+	uint64_t range_sum, weight_sum;
+	uint32_t w;
+	size_t used = 1;
+	int err;
+
+	if (cell->id == 0) {
+		return -ENOENT;
+	}
+
+	k_mutex_lock(&db_lock, K_FOREVER);
+
+	err = db_init();
+	if (err) {
+		goto unlock;
+	}
+
+	err = cell_find(key_make(cell->mcc, cell->mnc, cell->tac, cell->id),
+			&serving);
+	if (err) {
+		LOG_DBG("Serving cell not in cell database, err %d", err);
+		goto unlock;
+	}
+
+	for (size_t i = 0; i < ncells_count; i++) {
+		best_rsrp = MAX(best_rsrp, cell_data->neighbor_cells[i].rsrp);
+	}
+
+	w = weight(cell->rsrp, best_rsrp, serving.range);
+	lat_sum = (int64_t)w * serving.lat;
+	lon_sum = (int64_t)w * serving.lon;
+	range_sum = (uint64_t)w * serving.range;
+	weight_sum = w;
+
+	for (size_t i = 0; i < ncells_count; i++) {
+		const struct lte_lc_ncell *ncell = &cell_data->neighbor_cells[i];
+
+		err = neighbor_find(&serving, ncell->phys_cell_id, &rec);
+		if (err == -ENOENT) {
+			continue;
+		} else if (err) {
+			goto unlock;
+		}
+
+		w = weight(ncell->rsrp, best_rsrp, rec.range);
+		lat_sum += (int64_t)w * rec.lat;
+		lon_sum += (int64_t)w * rec.lon;
+		range_sum += (uint64_t)w * rec.range;
+		weight_sum += w;
+		used++;
+	}
+
+	err = 0;
+
+	location->latitude = (int32_t)(lat_sum / (int64_t)weight_sum) / 1e7f;
+	location->longitude = (int32_t)(lon_sum / (int64_t)weight_sum) / 1e7f;
+	location->accuracy = (float)(range_sum / weight_sum);
+
+	LOG_DBG("Location from %u of %u cells in the cell database", used,
+		ncells_count + 1);
+
+unlock:
+	k_mutex_unlock(&db_lock);
+
+	return err;
+}
+
+int multicell_location_db_delta_write(size_t offset, const void *data,
+				      size_t len)
+{
+	int err;
+
+	if ((data == NULL) || (offset + len > DELTA_SIZE)) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&db_lock, K_FOREVER);
+
+	err = db_init();
+	if (err) {
+		goto unlock;
+	}
+
+	if (offset == 0) {
+		/* The delta is not used again until it has been applied */
+		delta.count = 0;
+
+		err = flash_area_erase(fa, DELTA_OFFSET, DELTA_SIZE);
+		if (err) {
+			LOG_ERR("Failed to erase cell database delta, err %d",
+				err);
+			goto unlock;
+		}
+	}
+
+	err = flash_area_write(fa, DELTA_OFFSET + offset, data, len);
+	if (err) {
+		LOG_ERR("Failed to write cell database delta, err %d", err);
+	}
+
+unlock:
+	k_mutex_unlock(&db_lock);
+
+	return err;
+}
+
+int multicell_location_db_delta_apply(void)
+{
+	int err;
+
+	k_mutex_lock(&db_lock, K_FOREVER);
+
+	err = db_init();
+	if (err == 0) {
+		err = image_load(&delta, DELTA_SIZE, true);
+	}
+
+	k_mutex_unlock(&db_lock);
+
+	if (err) {
+		LOG_ERR("Invalid cell database delta, err %d", err);
+		return err;
+	}
+
+	LOG_INF("Cell database delta %u applied, %u cells", delta.seq,
+		delta.count);
+
+	return 0;
+}
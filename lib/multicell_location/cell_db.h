@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef CELL_DB_H_
+#define CELL_DB_H_
+
+#include <modem/lte_lc.h>
+#include <net/multicell_location.h>
+
+/* @brief Resolve the location from the local cell database.
+ *
+ * @param cell_data Pointer to neighbor cell data.
+ * @param location Pointer to location.
+ *
+ * @return 0 on success, -ENOENT if the serving cell is not in the database,
+ *	   or another negative error code on failure.
+ */
+int cell_db_location_get(const struct lte_lc_cells_info *cell_data,
+			 struct multicell_location *location);
+
+#endif /* CELL_DB_H_ */
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "http_response.h"
+
+/* Find a header field in the response head, case insensitively.
+ * Returns a pointer to the field value, or NULL if not found.
+ */
+static const char *header_find(const char *head, const char *head_end,
+			       const char *name)
+{
+	size_t name_len = strlen(name);
+	const char *line = head;
+
+	while ((line != NULL) && (line < head_end)) {
+		if (strncasecmp(line, name, name_len) == 0) {
+			line += name_len;
+			while (*line == ' ') {
+				line++;
+			}
+			return line;
+		}
+
+		line = strstr(line, "\r\n");
+		if (line != NULL) {
+			line += 2;
+		}
+	}
+
+	return NULL;
+}
+
+/* Walk the chunks of a chunked body. Returns true if the last chunk and the
+ * end of the trailer have been received. If decode is set, the chunk data is
+ * moved together in place and terminated, removing the chunk size lines.
+ */
+static bool chunks_walk(char *body, const char *end, bool decode)
+{
+	char *pos = body;
+	char *out = body;
+
+	while (true) {
+		char *line;
+		unsigned long size = strtoul(pos, &line, 16);
+
+		if (line == pos) {
+			return false;
+		}
+
+		/* Skip chunk extensions, if any */
+		line = strstr(line, "\r\n");
+		if ((line == NULL) || (line >= end)) {
+			return false;
+		}
+
+		if (size == 0) {
+			/* Optional trailer fields end with an empty line */
+			if (strstr(line, "\r\n\r\n") == NULL) {
+				return false;
+			}
+
+			if (decode) {
+				*out = '\0';
+			}
+
+			return true;
+		}
+
+		pos = line + 2;
+		if ((size_t)(end - pos) < (size + 2)) {
+			return false;
+		}
+
+		if (decode) {
+			memmove(out, pos, size);
+			out += size;
+		}
+
+		pos += size + 2;
+	}
+}
+
+bool http_response_complete(char *response, size_t len, bool *keep)
+{
+	char *body = strstr(response, "\r\n\r\n");
+	const char *end = response + len;
+	const char *value;
+	long content_len;
+
+	if (body == NULL) {
+		return false;
+	}
+
+	body += 4;
+
+	value = header_find(response, body, "content-length:");
+	if (value != NULL) {
+		content_len = strtol(value, NULL, 10);
+		if ((end - body) < content_len) {
+			return false;
+		}
+	} else {
+		value = header_find(response, body, "transfer-encoding:");
+		if ((value == NULL) || (strncasecmp(value, "chunked", 7) != 0)) {
+			return false;
+		}
+
+		if (!chunks_walk(body, end, false)) {
+			return false;
+		}
+
+		(void)chunks_walk(body, end, true);
+	}
+
+	value = header_find(response, body, "connection:");
+	*keep = (value == NULL) || (strncasecmp(value, "close", 5) != 0);
+
+	return true;
+}
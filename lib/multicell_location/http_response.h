@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef HTTP_RESPONSE_H_
+#define HTTP_RESPONSE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* @brief Check whether a whole HTTP response has been received.
+ *
+ * The connection can only be kept if the response is framed by
+ * Content-Length or chunked transfer encoding, otherwise the end of the
+ * response is signalled by the server closing it. A complete chunked body
+ * is decoded in place.
+ *
+ * @param response Null-terminated response received so far.
+ * @param len Length of the response.
+ * @param keep Set to true if the server allows the connection to be kept.
+ *	       Only valid when the response is complete.
+ *
+ * @return true if the response is complete.
+ */
+bool http_response_complete(char *response, size_t len, bool *keep);
+
+#endif /* HTTP_RESPONSE_H_ */
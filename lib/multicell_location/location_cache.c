@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr.h>
+
+#include "location_cache.h"
+
+struct cache_entry {
+	uint32_t key;
+	bool valid;
+	int64_t stored; /* Uptime when stored */
+	int64_t used; /* Uptime when last returned, for LRU replacement */
+	struct multicell_location location;
+};
+
+static struct cache_entry cache[CONFIG_MULTICELL_LOCATION_CACHE_SIZE];
+
+static uint32_t fnv1a(uint32_t hash, const void *data, size_t len)
+{
+	const uint8_t *bytes = data;
+
+	for (size_t i = 0; i < len; i++) {
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+uint32_t location_cache_key(const struct lte_lc_cells_info *cell_data)
+{
+	const struct lte_lc_cell *cell = &cell_data->current_cell;
+	uint32_t ncells[CONFIG_MULTICELL_LOCATION_CACHE_NEIGHBORS];
+	/* Only the neighbors that are used in the request */
+	size_t ncells_count = MIN(cell_data->ncells_count,
+				  CONFIG_MULTICELL_LOCATION_MAX_NEIGHBORS);
+	size_t count = MIN(ncells_count, ARRAY_SIZE(ncells));
+	uint32_t taken = 0;
+	uint32_t hash = 2166136261u;
+
+	hash = fnv1a(hash, &cell->mcc, sizeof(cell->mcc));
+	hash = fnv1a(hash, &cell->mnc, sizeof(cell->mnc));
+	hash = fnv1a(hash, &cell->tac, sizeof(cell->tac));
+	hash = fnv1a(hash, &cell->id, sizeof(cell->id));
+
+	for (size_t i = 0; i < count; i++) {
+		size_t best = 0;
+		int16_t best_rsrp = INT16_MIN;
+
+		for (size_t j = 0; j < ncells_count; j++) {
+			if (!(taken & BIT(j)) &&
+			    cell_data->neighbor_cells[j].rsrp >= best_rsrp) {
+				best = j;
+				best_rsrp = cell_data->neighbor_cells[j].rsrp;
+			}
+		}
+
+		taken |= BIT(best);
+		ncells[i] = (cell_data->neighbor_cells[best].earfcn << 9) |
+			    cell_data->neighbor_cells[best].phys_cell_id;
+
+		/* Insertion sort */
+		for (size_t j = i; j > 0 && ncells[j - 1] > ncells[j]; j--) {
+			uint32_t tmp = ncells[j];
+
+			ncells[j] = ncells[j - 1];
+			ncells[j - 1] = tmp;
+		}
+	}
+
+	return fnv1a(hash, ncells, count * sizeof(ncells[0]));
+}
+
+bool location_cache_get(uint32_t key, struct multicell_location *location)
+{
+	int64_t now = k_uptime_get();
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (!cache[i].valid || cache[i].key != key) {
+			continue;
+		}
+
+		if ((now - cache[i].stored) >=
+		    CONFIG_MULTICELL_LOCATION_CACHE_TTL * MSEC_PER_SEC) {
+			cache[i].valid = false;
+			return false;
+		}
+
+		cache[i].used = now;
+		*location = cache[i].location;
+		return true;
+	}
+
+	return false;
+}
+
+void location_cache_put(uint32_t key, const struct multicell_location *location)
+{
+	struct cache_entry *entry = &cache[0];
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache[i].valid && cache[i].key == key) {
+			entry = &cache[i];
+			break;
+		}
+
+		if (entry->valid &&
+		    (!cache[i].valid || cache[i].used < entry->used)) {
+			entry = &cache[i];
+		}
+	}
+
+	entry->key = key;
+	entry->valid = true;
+	entry->stored = k_uptime_get();
+	entry->used = entry->stored;
+	entry->location = *location;
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef LOCATION_CACHE_H_
+#define LOCATION_CACHE_H_
+
+#include <stdbool.h>
+#include <modem/lte_lc.h>
+#include <net/multicell_location.h>
+
+/* @brief Compute the cache key of cell measurements.
+ *
+ * The key covers the serving cell and its strongest neighbor cells.
+ * Neighbors are hashed in a fixed order, so that a change in their
+ * ranking alone does not change the key.
+ *
+ * @param cell_data Pointer to neighbor cell data.
+ *
+ * @return Cache key.
+ */
+uint32_t location_cache_key(const struct lte_lc_cells_info *cell_data);
+
+/* @brief Get a cached location.
+ *
+ * Expired entries are removed.
+ *
+ * @param key Cache key.
+ * @param location Pointer to location, set if found.
+ *
+ * @return true if a location that has not expired was found.
+ */
+bool location_cache_get(uint32_t key, struct multicell_location *location);
+
+/* @brief Store a location in the cache.
+ *
+ * Replaces the entry with the same key, else a free one, else the least
+ * recently used one.
+ *
+ * @param key Cache key.
+ * @param location Pointer to location.
+ */
+void location_cache_put(uint32_t key, const struct multicell_location *location);
+
+#endif /* LOCATION_CACHE_H_ */
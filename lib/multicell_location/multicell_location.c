@@ -6,6 +6,7 @@
 
 #include <zephyr.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <net/socket.h>
 #include <modem/lte_lc.h>
 #include <net/tls_credentials.h>
@@ -13,6 +14,9 @@
 #include <net/multicell_location.h>
 
 #include "location_service.h"
+#include "cell_db.h"
+#include "http_response.h"
+#include "location_cache.h"
 
 #include <logging/log.h>
 
@@ -22,8 +26,9 @@
 
 LOG_MODULE_REGISTER(multicell_location, CONFIG_MULTICELL_LOCATION_LOG_LEVEL);
 
-BUILD_ASSERT(!IS_ENABLED(CONFIG_MULTICELL_LOCATION_SERVICE_NONE),
-	     "A location service must be enabled");
+BUILD_ASSERT(!IS_ENABLED(CONFIG_MULTICELL_LOCATION_SERVICE_NONE) ||
+	     IS_ENABLED(CONFIG_MULTICELL_LOCATION_CELL_DB),
+	     "A location service or the cell database must be enabled");
 
 static char http_request[CONFIG_MULTICELL_LOCATION_SEND_BUF_SIZE];
 static char recv_buf[CONFIG_MULTICELL_LOCATION_RECV_BUF_SIZE];
@@ -62,10 +67,9 @@ static int tls_setup(int fd)
 	return 0;
 }
 
-static int execute_http_request(const char *request, size_t request_len)
+static int connection_open(void)
 {
-	int err, fd, bytes;
-	size_t offset = 0;
+	int err, fd;
 	struct addrinfo *res;
 	struct addrinfo hints = {
 		.ai_family = AF_INET,
@@ -142,12 +146,55 @@ static int execute_http_request(const char *request, size_t request_len)
 		goto clean_up;
 	}
 
+clean_up:
+	freeaddrinfo(res);
+
+	if (err) {
+		if (fd >= 0) {
+			(void)close(fd);
+		}
+		return err;
+	}
+
+	return fd;
+}
+
+#if defined(CONFIG_MULTICELL_LOCATION_KEEPALIVE)
+#define IDLE_TIMEOUT_MS \
+	(CONFIG_MULTICELL_LOCATION_KEEPALIVE_IDLE_TIMEOUT * MSEC_PER_SEC)
+/* Retry interval when a request is in progress */
+#define IDLE_RETRY_MS 1000
+
+static int http_fd = -1;
+/* Uptime when the kept connection was last used */
+static int64_t http_fd_used;
+
+static void idle_work_fn(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(idle_work, idle_work_fn);
+#endif /* CONFIG_MULTICELL_LOCATION_KEEPALIVE */
+
+static K_MUTEX_DEFINE(http_lock);
+
+/* Send the request and receive the response into recv_buf.
+ * With keep-alive, returns -ECONNRESET if the server closed the connection
+ * before responding.
+ */
+static int http_exchange(int fd, const char *request, size_t request_len,
+			 bool *keep)
+{
+	int err = 0;
+	int bytes;
+	size_t offset = 0;
+
+	*keep = false;
+
 	do {
 		bytes = send(fd, &request[offset], request_len - offset, 0);
 		if (bytes < 0) {
 			LOG_ERR("send() failed, errno: %d", errno);
-			err = -errno;
-			goto clean_up;
+			return (IS_ENABLED(CONFIG_MULTICELL_LOCATION_KEEPALIVE) &&
+				(errno == EPIPE || errno == ENOTCONN)) ?
+				-ECONNRESET : -errno;
 		}
 
 		offset += bytes;
@@ -175,50 +222,150 @@ static int execute_http_request(const char *request, size_t request_len)
 
 			LOG_ERR("recv() failed, errno: %d", errno);
 
-			err = -errno;
-			goto clean_up;
+			return (errno == ECONNRESET && offset == 0) ?
+				-ECONNRESET : -errno;
 		} else {
 			LOG_DBG("Received HTTP response chunk of %d bytes", bytes);
 		}
 
 		offset += bytes;
+		recv_buf[offset] = '\0';
+
+#if defined(CONFIG_MULTICELL_LOCATION_KEEPALIVE)
+		if (http_response_complete(recv_buf, offset, keep)) {
+			break;
+		}
+#endif
 	} while (bytes != 0);
 
 	recv_buf[offset] = '\0';
 
 	LOG_DBG("Received %d bytes", offset);
 
-	if (offset > 0) {
-		LOG_DBG("HTTP response:\n%s\n", log_strdup(recv_buf));
+	/* An empty response on a kept connection means the server closed it */
+	if (IS_ENABLED(CONFIG_MULTICELL_LOCATION_KEEPALIVE) &&
+	    (offset == 0) && (err == 0)) {
+		return -ECONNRESET;
 	}
 
-	LOG_DBG("Closing socket");
+	LOG_DBG("HTTP response:\n%s\n", log_strdup(recv_buf));
 
-	/* Propagate timeout information */
-	if (err != -ETIMEDOUT) {
-		err = 0;
+	return err;
+}
+
+#if defined(CONFIG_MULTICELL_LOCATION_KEEPALIVE)
+static void idle_work_fn(struct k_work *work)
+{
+	int64_t idle;
+
+	ARG_UNUSED(work);
+
+	/* Do not block the system work queue for a whole request */
+	if (k_mutex_lock(&http_lock, K_NO_WAIT)) {
+		k_work_reschedule(&idle_work, K_MSEC(IDLE_RETRY_MS));
+		return;
 	}
 
-clean_up:
-	freeaddrinfo(res);
-	(void)close(fd);
+	if (http_fd >= 0) {
+		idle = k_uptime_get() - http_fd_used;
+		if (idle < IDLE_TIMEOUT_MS) {
+			/* A request used the connection in the meantime */
+			k_work_reschedule(&idle_work,
+					  K_MSEC(IDLE_TIMEOUT_MS - idle));
+		} else {
+			LOG_DBG("Closing idle connection");
+			(void)close(http_fd);
+			http_fd = -1;
+		}
+	}
+
+	k_mutex_unlock(&http_lock);
+}
+#endif
+
+static int execute_http_request(const char *request, size_t request_len)
+{
+	int err, fd = -1;
+	bool reused = false;
+	bool keep;
+
+#if defined(CONFIG_MULTICELL_LOCATION_KEEPALIVE)
+	(void)k_work_cancel_delayable(&idle_work);
+
+	if (http_fd >= 0) {
+		LOG_DBG("Reusing connection");
+		fd = http_fd;
+		http_fd = -1;
+		reused = true;
+	}
+#endif
+
+	while (true) {
+		if (fd < 0) {
+			fd = connection_open();
+			if (fd < 0) {
+				err = fd;
+				break;
+			}
+		}
+
+		err = http_exchange(fd, request, request_len, &keep);
+		if (err == -ECONNRESET && reused) {
+			/* The server closed the idle connection, reconnect */
+			LOG_DBG("Connection closed by server, reconnecting");
+			(void)close(fd);
+			fd = -1;
+			reused = false;
+			continue;
+		}
+
+		break;
+	}
+
+	if (fd >= 0) {
+#if defined(CONFIG_MULTICELL_LOCATION_KEEPALIVE)
+		if (err == 0 && keep) {
+			http_fd = fd;
+			http_fd_used = k_uptime_get();
+			k_work_reschedule(&idle_work, K_MSEC(IDLE_TIMEOUT_MS));
+			fd = -1;
+		}
+#endif
+		if (fd >= 0) {
+			LOG_DBG("Closing socket");
+			(void)close(fd);
+		}
+	}
 
 	return err;
 }
 
-int multicell_location_get(const struct lte_lc_cells_info *cell_data,
-			   struct multicell_location *location)
+static int location_get(const struct lte_lc_cells_info *cell_data,
+			struct multicell_location *location)
 {
 	int err;
+#if defined(CONFIG_MULTICELL_LOCATION_CACHE)
+	uint32_t key = location_cache_key(cell_data);
 
-	if ((cell_data == NULL) || (location == NULL)) {
-		return -EINVAL;
+	if (location_cache_get(key, location)) {
+		LOG_DBG("Location found in cache");
+		return 0;
 	}
+#endif
 
-	if (cell_data->ncells_count > CONFIG_MULTICELL_LOCATION_MAX_NEIGHBORS) {
-		LOG_WRN("Found %d neighbor cells, but %d cells will be used in location request",
-			cell_data->ncells_count, CONFIG_MULTICELL_LOCATION_MAX_NEIGHBORS);
-		LOG_WRN("Increase CONFIG_MULTICELL_LOCATION_MAX_NEIGHBORS to use more cells");
+#if defined(CONFIG_MULTICELL_LOCATION_CELL_DB)
+	err = cell_db_location_get(cell_data, location);
+	if (err == 0) {
+		LOG_DBG("Location found in cell database");
+		return 0;
+	} else if (err != -ENOENT) {
+		LOG_WRN("Cell database lookup failed, error: %d", err);
+	}
+#endif
+
+	/* Without a location service, the code below is optimized away */
+	if (IS_ENABLED(CONFIG_MULTICELL_LOCATION_SERVICE_NONE)) {
+		return -ENOENT;
 	}
 
 	err = location_service_generate_request(cell_data, http_request,
@@ -244,16 +391,48 @@ int multicell_location_get(const struct lte_lc_cells_info *cell_data,
 		return -ENOMSG;
 	}
 
+#if defined(CONFIG_MULTICELL_LOCATION_CACHE)
+	location_cache_put(key, location);
+#endif
+
 	return 0;
 }
 
+int multicell_location_get(const struct lte_lc_cells_info *cell_data,
+			   struct multicell_location *location)
+{
+	int err;
+
+	if ((cell_data == NULL) || (location == NULL)) {
+		return -EINVAL;
+	}
+
+	if (cell_data->ncells_count > CONFIG_MULTICELL_LOCATION_MAX_NEIGHBORS) {
+		LOG_WRN("Found %d neighbor cells, but %d cells will be used in location request",
+			cell_data->ncells_count, CONFIG_MULTICELL_LOCATION_MAX_NEIGHBORS);
+		LOG_WRN("Increase CONFIG_MULTICELL_LOCATION_MAX_NEIGHBORS to use more cells");
+	}
+
+	/* The cache, the buffers and the kept connection are shared */
+	k_mutex_lock(&http_lock, K_FOREVER);
+	err = location_get(cell_data, location);
+	k_mutex_unlock(&http_lock);
+
+	return err;
+}
+
 int multicell_location_provision_certificate(bool overwrite)
 {
 	int err;
 	bool exists;
 	uint8_t unused;
-	const char *certificate = location_service_get_certificate();
+	const char *certificate;
+
+	if (IS_ENABLED(CONFIG_MULTICELL_LOCATION_SERVICE_NONE)) {
+		return -ENOTSUP;
+	}
 
+	certificate = location_service_get_certificate();
 	if (certificate == NULL) {
 		LOG_ERR("No certificate was provided by the location service");
 		return -EFAULT;
@@ -49,7 +49,7 @@ BUILD_ASSERT(sizeof(API_APP_ID) > 1, "App ID must be configured");
 	"POST "PATH"?"AUTHENTICATION" HTTP/1.1\r\n"			\
 	"Host: "HOSTNAME"\r\n"					        \
 	"Content-Type: application/json\r\n"				\
-	"Connection: close\r\n"						\
+	HTTP_CONNECTION_HEADER						\
 	"Content-Length: %d\r\n\r\n"
 
 #define HTTP_REQUEST_BODY						\
@@ -15,6 +15,13 @@
 extern "C" {
 #endif
 
+/* Connection header to use in HTTP requests. */
+#if defined(CONFIG_MULTICELL_LOCATION_KEEPALIVE)
+#define HTTP_CONNECTION_HEADER "Connection: keep-alive\r\n"
+#else
+#define HTTP_CONNECTION_HEADER "Connection: close\r\n"
+#endif
+
 /* @brief Generate an HTTPS request in the format the location service expects.
  *
  * @param cell_data Pointer to neighbor cell data.
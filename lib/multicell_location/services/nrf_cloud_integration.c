@@ -37,7 +37,7 @@ BUILD_ASSERT(sizeof(CONFIG_MULTICELL_LOCATION_NRF_CLOUD_API_KEY) > 1,
 	"GET /v1/location/single-cell" REQUEST_PARAMETERS " HTTP/1.1\r\n"	\
 	"Host: "HOSTNAME"\r\n"							\
 	"Authorization: Bearer "API_KEY"\r\n"					\
-	"Connection: close\r\n"							\
+	HTTP_CONNECTION_HEADER							\
 	"Content-Type: application/json\r\n\r\n"
 
 BUILD_ASSERT(sizeof(HOSTNAME) > 1, "Hostname must be configured");
@@ -37,7 +37,7 @@ LOG_MODULE_REGISTER(multicell_location_skyhook, CONFIG_MULTICELL_LOCATION_LOG_LE
 	"POST /wps2/json/location?key="API_KEY"&user=%s HTTP/1.1\r\n"	\
 	"Host: "HOSTNAME"\r\n"					        \
 	"Content-Type: application/json\r\n"				\
-	"Connection: close\r\n"						\
+	HTTP_CONNECTION_HEADER						\
 	"Content-Length: %d\r\n\r\n"
 
 #define HTTP_REQUEST_BODY                                               \
@@ -43,6 +43,9 @@
 static struct nrf_sock_ctx {
 	int nrf_fd; /* nRF socket descriptior. */
 	struct k_mutex *lock; /* Mutex associated with the socket. */
+	bool stream; /* Stream socket, data can be sent in several parts. */
+	/* Used by sendmsg to repack data, protected by the socket mutex. */
+	uint8_t sendmsg_buf[CONFIG_NRF_MODEM_LIB_SENDMSG_BUF_SIZE];
 } offload_ctx[NRF_MODEM_MAX_SOCKET_COUNT];
 
 static K_MUTEX_DEFINE(ctx_lock);
@@ -641,6 +644,7 @@ static int nrf91_socket_offload_accept(void *obj, struct sockaddr *addr,
 		errno = ENOMEM;
 		goto error;
 	}
+	ctx->stream = true;
 
 	if ((addr != NULL) && (addrlen != NULL)) {
 		if (nrf_addr_ptr->sa_family == NRF_AF_INET) {
@@ -917,88 +921,114 @@ error:
 	return retval;
 }
 
+/* Send a whole block, sending the rest after a short write.
+ * Returns false when the block could not be sent completely.
+ */
+static bool sendmsg_block(void *obj, const uint8_t *buf, size_t len,
+			  int flags, const struct msghdr *msg, size_t *sent)
+{
+	size_t offset = 0;
+	ssize_t ret;
+
+	while (offset < len) {
+		ret = nrf91_socket_offload_sendto(obj, buf + offset,
+			len - offset, flags, msg->msg_name, msg->msg_namelen);
+		if (ret < 0) {
+			return false;
+		}
+		offset += ret;
+		*sent += ret;
+	}
+
+	return true;
+}
+
 static ssize_t nrf91_socket_offload_sendmsg(void *obj, const struct msghdr *msg,
 					    int flags)
 {
-	ssize_t len = 0;
-	ssize_t ret;
-	ssize_t offset;
+	struct nrf_sock_ctx *ctx = OBJ_TO_CTX(obj);
+	uint8_t *buf = ctx->sendmsg_buf;
+	size_t buf_size = sizeof(ctx->sendmsg_buf);
+	size_t len = 0;
+	size_t staged = 0;
+	size_t sent = 0;
+	bool ok = true;
 	int i;
-	static K_MUTEX_DEFINE(sendmsg_lock);
-	static uint8_t buf[CONFIG_NRF_MODEM_LIB_SENDMSG_BUF_SIZE];
 
 	if (msg == NULL) {
 		errno = EINVAL;
 		return -1;
 	}
 
-	/* The standard POSIX definition of sendmsg says it should return
-	 * EWOULDBLOCK if the socket is in NONBLOCK mode and handed too much data.
-	 * This implementation doesn't meet that requirement and will always
-	 * block, even in NONBLOCK mode.  See POSIX.1-2017:
-	 * <http://pubs.opengroup.org/onlinepubs/9699919799/functions/sendmsg.html>
-	 */
-
-	/* Try to reduce number of `sendto` calls - copy data if they fit into
-	 * a single buffer
-	 */
-
 	for (i = 0; i < msg->msg_iovlen; i++) {
 		len += msg->msg_iov[i].iov_len;
 	}
 
-	if (len <= sizeof(buf)) {
-		/* Protect `buf` access with a mutex. */
-		k_mutex_lock(&sendmsg_lock, K_FOREVER);
-		len = 0;
-
-		for (i = 0; i < msg->msg_iovlen; i++) {
-			memcpy(buf + len, msg->msg_iov[i].iov_base,
-			       msg->msg_iov[i].iov_len);
-			len += msg->msg_iov[i].iov_len;
-		}
+	if (len == 0) {
+		return nrf91_socket_offload_sendto(obj, buf, 0, flags,
+			msg->msg_name, msg->msg_namelen);
+	}
 
-		offset = 0;
-		ret = 0;
-		while ((offset < len) && (ret >= 0)) {
-			ret = nrf91_socket_offload_sendto(obj,
-				(buf + offset), (len - offset), flags,
-				msg->msg_name, msg->msg_namelen);
-			if (ret > 0) {
-				offset += ret;
-			}
+	if (!ctx->stream && len > buf_size) {
+		/* A datagram has to be sent in one piece, gather it in the
+		 * TX region instead.
+		 */
+		buf = nrf_modem_os_shm_tx_alloc(len);
+		if (buf == NULL) {
+			errno = ENOMEM;
+			return -1;
 		}
-
-		k_mutex_unlock(&sendmsg_lock);
-		return ret;
+		buf_size = len;
 	}
 
-	/* If the data won't fit into intermediate buffer, send the buffers
-	 * separately
+	/* Gather the parts into as few `sendto` calls as possible. Parts that
+	 * do not fit into the buffer are sent in place, without copying.
+	 *
+	 * When not everything can be sent, as in NONBLOCK mode, the number of
+	 * bytes sent so far is returned. The error is only returned if nothing
+	 * was sent. Data that was staged but not sent is not counted.
 	 */
-
-	len = 0;
-
-	for (i = 0; i < msg->msg_iovlen; i++) {
-		if (msg->msg_iov[i].iov_len == 0) {
+	for (i = 0; i < msg->msg_iovlen && ok; i++) {
+		const uint8_t *data = msg->msg_iov[i].iov_base;
+		size_t data_len = msg->msg_iov[i].iov_len;
+
+		if (data_len >= buf_size) {
+			ok = sendmsg_block(obj, buf, staged, flags, msg, &sent) &&
+			     sendmsg_block(obj, data, data_len, flags, msg, &sent);
+			staged = 0;
 			continue;
 		}
 
-		offset = 0;
-		while (offset < msg->msg_iov[i].iov_len) {
-			ret = nrf91_socket_offload_sendto(obj,
-				(((uint8_t *) msg->msg_iov[i].iov_base) + offset),
-				(msg->msg_iov[i].iov_len - offset), flags,
-				msg->msg_name, msg->msg_namelen);
-			if (ret < 0) {
-				return ret;
+		while (data_len > 0 && ok) {
+			size_t copy_len = MIN(data_len, buf_size - staged);
+
+			memcpy(buf + staged, data, copy_len);
+			staged += copy_len;
+			data += copy_len;
+			data_len -= copy_len;
+
+			if (staged == buf_size) {
+				ok = sendmsg_block(obj, buf, staged, flags, msg,
+						   &sent);
+				staged = 0;
 			}
-			offset += ret;
-			len += ret;
 		}
 	}
 
-	return len;
+	if (ok && staged > 0) {
+		ok = sendmsg_block(obj, buf, staged, flags, msg, &sent);
+	}
+
+	if (buf != ctx->sendmsg_buf) {
+		nrf_modem_os_shm_tx_free(buf);
+	}
+
+	if (!ok && sent == 0) {
+		/* errno set by sendto */
+		return -1;
+	}
+
+	return sent;
 }
 
 static inline int nrf91_socket_offload_poll(struct pollfd *fds, int nfds,
@@ -1340,6 +1370,7 @@ static int nrf91_socket_create(int family, int type, int proto)
 		z_free_fd(fd);
 		return -1;
 	}
+	ctx->stream = (type == SOCK_STREAM);
 
 	z_finalize_fd(fd, ctx,
 		      (const struct fd_op_vtable *)&nrf91_socket_fd_op_vtable);
@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <zephyr.h>
+#include <sys/atomic.h>
+#include <logging/log.h>
+#include "nrf_modem_lib_trace.h"
+
+#ifdef CONFIG_NRF_MODEM_LIB_TRACE_SINK_UART
+#include <nrfx_uarte.h>
+#endif
+#ifdef CONFIG_NRF_MODEM_LIB_TRACE_SINK_RTT
+#include <SEGGER_RTT.h>
+#endif
+
+LOG_MODULE_DECLARE(nrf_modem_lib, CONFIG_NRF_MODEM_LIB_LOG_LEVEL);
+
+#define TRACE_BUF_SIZE CONFIG_NRF_MODEM_LIB_TRACE_BUF_SIZE
+#define TRACE_THREAD_STACK_SIZE 512
+#define TRACE_THREAD_PRIORITY K_LOWEST_APPLICATION_THREAD_PRIO
+/* Time to wait before retrying when the sink cannot take more data. */
+#define TRACE_SINK_RETRY_MS 10
+
+BUILD_ASSERT((TRACE_BUF_SIZE & (TRACE_BUF_SIZE - 1)) == 0,
+	     "Trace buffer size must be a power of two");
+
+/* Updated from both the trace IRQ and the trace thread. */
+struct trace_diagnostic_info {
+	atomic_t bytes; /* Bytes received from the modem. */
+	atomic_t dropped_chunks; /* Chunks dropped because the buffer was full. */
+	atomic_t dropped_bytes;
+	atomic_t sink_errors; /* Bytes the sink failed to write. */
+	atomic_t sink_full; /* Times the sink was full. */
+	atomic_t max_used; /* Buffer high watermark. */
+};
+
+/* Single producer, single consumer ring buffer. The indexes run freely
+ * and are only written by their owner: wr_idx by nrf_modem_lib_trace_put(),
+ * rd_idx by the trace thread. The data is sent to the sink from the buffer
+ * directly. The indexes are never reset, so the trace thread can be in
+ * the middle of a write when the library is initialized again.
+ */
+static uint8_t trace_buf[TRACE_BUF_SIZE];
+static atomic_t wr_idx;
+static atomic_t rd_idx;
+
+static struct trace_diagnostic_info trace_diag;
+
+static K_SEM_DEFINE(trace_sem, 0, 1);
+
+#ifdef CONFIG_NRF_MODEM_LIB_TRACE_SINK_UART
+/* Max DMA transfers are 255 bytes. */
+#define UART_TX_MAX UINT8_MAX
+
+/* Use UARTE1 as a dedicated peripheral to print traces. */
+static const nrfx_uarte_t uarte_inst = NRFX_UARTE_INSTANCE(1);
+static K_SEM_DEFINE(uart_tx_sem, 0, 1);
+static bool uart_tx_error;
+
+static void uart_event_handler(nrfx_uarte_event_t const *event, void *context)
+{
+	ARG_UNUSED(context);
+
+	if (event->type == NRFX_UARTE_EVT_TX_DONE ||
+	    event->type == NRFX_UARTE_EVT_ERROR) {
+		uart_tx_error = (event->type == NRFX_UARTE_EVT_ERROR);
+		k_sem_give(&uart_tx_sem);
+	}
+}
+
+static int sink_init(void)
+{
+	nrfx_err_t err;
+	/* UART pins are defined in "nrf9160dk_nrf9160.dts". */
+	const nrfx_uarte_config_t config = {
+		/* Use UARTE1 pins routed on VCOM2. */
+		.pseltxd = DT_PROP(DT_NODELABEL(uart1), tx_pin),
+		.pselrxd = DT_PROP(DT_NODELABEL(uart1), rx_pin),
+		.pselcts = NRF_UARTE_PSEL_DISCONNECTED,
+		.pselrts = NRF_UARTE_PSEL_DISCONNECTED,
+
+		.hal_cfg.hwfc = NRF_UARTE_HWFC_DISABLED,
+		.hal_cfg.parity = NRF_UARTE_PARITY_EXCLUDED,
+		.baudrate = NRF_UARTE_BAUDRATE_1000000,
+
+		.interrupt_priority = NRFX_UARTE_DEFAULT_CONFIG_IRQ_PRIORITY,
+		.p_context = NULL,
+	};
+
+	IRQ_CONNECT(DT_IRQN(DT_NODELABEL(uart1)),
+		    NRFX_UARTE_DEFAULT_CONFIG_IRQ_PRIORITY,
+		    nrfx_isr, nrfx_uarte_1_irq_handler, 0);
+
+	/* Non-blocking mode, the trace thread waits for each transfer.
+	 * Already initialized if the modem library is re-initialized.
+	 */
+	err = nrfx_uarte_init(&uarte_inst, &config, uart_event_handler);
+	if (err != NRFX_SUCCESS && err != NRFX_ERROR_INVALID_STATE) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/* Returns the number of bytes written, -EAGAIN if the sink is full
+ * or -EIO if the data cannot be written.
+ */
+static int sink_write(const uint8_t *data, size_t len)
+{
+	len = MIN(len, UART_TX_MAX);
+
+	if (nrfx_uarte_tx(&uarte_inst, data, len) != NRFX_SUCCESS) {
+		return -EIO;
+	}
+	(void)k_sem_take(&uart_tx_sem, K_FOREVER);
+
+	return uart_tx_error ? -EIO : len;
+}
+#endif /* CONFIG_NRF_MODEM_LIB_TRACE_SINK_UART */
+
+#ifdef CONFIG_NRF_MODEM_LIB_TRACE_SINK_RTT
+BUILD_ASSERT(CONFIG_NRF_MODEM_LIB_TRACE_RTT_CHANNEL <
+	     SEGGER_RTT_MAX_NUM_UP_BUFFERS,
+	     "RTT channel number used for modem traces "
+	     "must be lower than SEGGER_RTT_MAX_NUM_UP_BUFFERS");
+
+static uint8_t rtt_up_buffer[CONFIG_NRF_MODEM_LIB_TRACE_RTT_BUF_SIZE];
+
+static int sink_init(void)
+{
+	int ret;
+
+	/* Do not block in RTT when the debugger is not reading,
+	 * the trace thread retries instead.
+	 */
+	ret = SEGGER_RTT_ConfigUpBuffer(CONFIG_NRF_MODEM_LIB_TRACE_RTT_CHANNEL,
+					"modem_trace", rtt_up_buffer,
+					sizeof(rtt_up_buffer),
+					SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+
+	return ret < 0 ? -EIO : 0;
+}
+
+static int sink_write(const uint8_t *data, size_t len)
+{
+	/* One byte of the RTT buffer is always left free. */
+	len = MIN(len, sizeof(rtt_up_buffer) - 1);
+
+	/* Nothing is written if all the data does not fit. */
+	if (SEGGER_RTT_Write(CONFIG_NRF_MODEM_LIB_TRACE_RTT_CHANNEL,
+			     data, len) == 0) {
+		return -EAGAIN;
+	}
+
+	return len;
+}
+#endif /* CONFIG_NRF_MODEM_LIB_TRACE_SINK_RTT */
+
+int nrf_modem_lib_trace_init(void)
+{
+	int err;
+
+	/* Traces still buffered from before a re-initialization are
+	 * written to the sink, the buffer indexes are left as they are.
+	 */
+	atomic_clear(&trace_diag.bytes);
+	atomic_clear(&trace_diag.dropped_chunks);
+	atomic_clear(&trace_diag.dropped_bytes);
+	atomic_clear(&trace_diag.sink_errors);
+	atomic_clear(&trace_diag.sink_full);
+	atomic_clear(&trace_diag.max_used);
+
+	err = sink_init();
+	if (err) {
+		LOG_ERR("Failed to initialize trace sink, err %d", err);
+	}
+
+	return err;
+}
+
+int nrf_modem_lib_trace_put(const uint8_t *data, uint32_t len)
+{
+	uint32_t wr = atomic_get(&wr_idx);
+	uint32_t used = wr - (uint32_t)atomic_get(&rd_idx);
+	uint32_t offset = wr & (TRACE_BUF_SIZE - 1);
+	uint32_t part;
+
+	atomic_add(&trace_diag.bytes, len);
+
+	/* The modem cannot be held back, so a chunk that does not fit is
+	 * dropped as a whole rather than truncated. What is in the buffer
+	 * stays intact and the sink catches up.
+	 */
+	if (len > TRACE_BUF_SIZE - used) {
+		atomic_inc(&trace_diag.dropped_chunks);
+		atomic_add(&trace_diag.dropped_bytes, len);
+		return 0;
+	}
+
+	part = MIN(len, TRACE_BUF_SIZE - offset);
+	memcpy(&trace_buf[offset], data, part);
+	memcpy(trace_buf, data + part, len - part);
+
+	/* Publish the data after it has been written. */
+	atomic_set(&wr_idx, wr + len);
+
+	/* Only written here, no other writer to race with. */
+	if (used + len > (uint32_t)atomic_get(&trace_diag.max_used)) {
+		atomic_set(&trace_diag.max_used, used + len);
+	}
+	k_sem_give(&trace_sem);
+
+	return 0;
+}
+
+static void trace_thread_func(void *p1, void *p2, void *p3)
+{
+	uint32_t rd;
+	uint32_t used;
+	uint32_t offset;
+	size_t len;
+	int written;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (true) {
+		(void)k_sem_take(&trace_sem, K_FOREVER);
+
+		rd = atomic_get(&rd_idx);
+		while ((used = (uint32_t)atomic_get(&wr_idx) - rd) > 0) {
+			offset = rd & (TRACE_BUF_SIZE - 1);
+			len = MIN(used, TRACE_BUF_SIZE - offset);
+
+			written = sink_write(&trace_buf[offset], len);
+			if (written == -EAGAIN) {
+				/* Wait for the sink to be drained. New traces
+				 * are dropped if the buffer fills up meanwhile.
+				 */
+				atomic_inc(&trace_diag.sink_full);
+				k_sleep(K_MSEC(TRACE_SINK_RETRY_MS));
+				continue;
+			}
+			if (written < 0) {
+				/* Skip what the sink cannot write */
+				written = len;
+				atomic_add(&trace_diag.sink_errors, len);
+			}
+
+			rd += written;
+			atomic_set(&rd_idx, rd);
+		}
+	}
+}
+
+K_THREAD_DEFINE(trace_thread, TRACE_THREAD_STACK_SIZE, trace_thread_func,
+		NULL, NULL, NULL, TRACE_THREAD_PRIORITY, 0, 0);
+
+void nrf_modem_lib_trace_diagnose(void)
+{
+	printk("\ntraces:\n");
+	printk("Bytes: %u\n", (uint32_t)atomic_get(&trace_diag.bytes));
+	printk("Dropped chunks: %u, bytes: %u\n",
+	       (uint32_t)atomic_get(&trace_diag.dropped_chunks),
+	       (uint32_t)atomic_get(&trace_diag.dropped_bytes));
+	printk("Sink errors (bytes): %u\n",
+	       (uint32_t)atomic_get(&trace_diag.sink_errors));
+	printk("Sink full: %u\n", (uint32_t)atomic_get(&trace_diag.sink_full));
+	printk("Buffer high watermark: %u/%u\n",
+	       (uint32_t)atomic_get(&trace_diag.max_used), TRACE_BUF_SIZE);
+}
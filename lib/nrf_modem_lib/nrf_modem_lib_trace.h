@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef NRF_MODEM_LIB_TRACE_H__
+#define NRF_MODEM_LIB_TRACE_H__
+
+#include <stdint.h>
+
+/**
+ * @brief Initialize the modem trace buffer and its sink.
+ *
+ * @return 0 on success, a negative error code otherwise.
+ */
+int nrf_modem_lib_trace_init(void);
+
+/**
+ * @brief Queue modem trace data for the trace thread.
+ *
+ * Called from the trace IRQ, the data is copied into the trace buffer.
+ * Data that does not fit is dropped and accounted for.
+ *
+ * @param data Trace data.
+ * @param len Length of the trace data.
+ *
+ * @return 0.
+ */
+int nrf_modem_lib_trace_put(const uint8_t *data, uint32_t len);
+
+#endif /* NRF_MODEM_LIB_TRACE_H__ */
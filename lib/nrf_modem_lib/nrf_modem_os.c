@@ -17,7 +17,7 @@
 #include <logging/log.h>
 
 #ifdef CONFIG_NRF_MODEM_LIB_TRACE_ENABLED
-#include <nrfx_uarte.h>
+#include "nrf_modem_lib_trace.h"
 #endif
 
 #ifndef ENOKEY
@@ -42,11 +42,6 @@
 #define TRACE_IRQ EGU2_IRQn
 #define TRACE_IRQ_PRIORITY 6
 
-#ifdef CONFIG_NRF_MODEM_LIB_TRACE_ENABLED
-/* Use UARTE1 as a dedicated peripheral to print traces. */
-static const nrfx_uarte_t uarte_inst = NRFX_UARTE_INSTANCE(1);
-#endif
-
 #define THREAD_MONITOR_ENTRIES 10
 
 LOG_MODULE_REGISTER(nrf_modem_lib, CONFIG_NRF_MODEM_LIB_LOG_LEVEL);
@@ -60,6 +55,12 @@ struct sleeping_thread {
 	struct k_sem sem;
 };
 
+struct wakeup_diagnostic_info {
+	uint32_t events; /* RPC events. */
+	uint32_t wakeups; /* Sleeping threads woken up by RPC events. */
+	uint32_t wakeups_max; /* Most threads woken up by one RPC event. */
+};
+
 /* Shared memory heap
  * This heap is not initialized with the K_HEAP macro because
  * it should be initialized in the shared memory area reserved by
@@ -74,6 +75,9 @@ static K_HEAP_DEFINE(library_heap, CONFIG_NRF_MODEM_LIB_HEAP_SIZE);
 static struct mem_diagnostic_info shmem_diag;
 static struct mem_diagnostic_info heap_diag;
 
+/* Store information about thread wakeups, updated from the RPC interrupt */
+static struct wakeup_diagnostic_info wakeup_diag;
+
 /* An array of thread ID and RPC counter pairs, used to avoid race conditions.
  * It allows to identify whether it is safe to put the thread to sleep or not.
  */
@@ -382,12 +386,20 @@ ISR_DIRECT_DECLARE(rpc_proxy_irq_handler)
 	nrf_modem_os_application_irq_handler();
 
 	struct sleeping_thread *thread;
+	uint32_t woken = 0;
 
-	/* Wake up all sleeping threads. */
+	/* Wake up all sleeping threads. The RPC event does not tell which
+	 * context it completes, so every thread has to re-check its own.
+	 */
 	SYS_SLIST_FOR_EACH_CONTAINER(&sleeping_threads, thread, node) {
 		k_sem_give(&thread->sem);
+		woken++;
 	}
 
+	wakeup_diag.events++;
+	wakeup_diag.wakeups += woken;
+	wakeup_diag.wakeups_max = MAX(wakeup_diag.wakeups_max, woken);
+
 	ISR_DIRECT_PM(); /* PM done after servicing interrupt for best latency
 			  */
 	return 1; /* We should check if scheduling decision should be made */
@@ -420,32 +432,6 @@ void read_task_create(void)
 	irq_enable(NRF_MODEM_APPLICATION_IRQ);
 }
 
-void trace_uart_init(void)
-{
-#ifdef CONFIG_NRF_MODEM_LIB_TRACE_ENABLED
-	/* UART pins are defined in "nrf9160dk_nrf9160.dts". */
-	const nrfx_uarte_config_t config = {
-		/* Use UARTE1 pins routed on VCOM2. */
-		.pseltxd = DT_PROP(DT_NODELABEL(uart1), tx_pin),
-		.pselrxd = DT_PROP(DT_NODELABEL(uart1), rx_pin),
-		.pselcts = NRF_UARTE_PSEL_DISCONNECTED,
-		.pselrts = NRF_UARTE_PSEL_DISCONNECTED,
-
-		.hal_cfg.hwfc = NRF_UARTE_HWFC_DISABLED,
-		.hal_cfg.parity = NRF_UARTE_PARITY_EXCLUDED,
-		.baudrate = NRF_UARTE_BAUDRATE_1000000,
-
-		/* IRQ handler not used. Blocking mode.*/
-		.interrupt_priority = NRFX_UARTE_DEFAULT_CONFIG_IRQ_PRIORITY,
-		.p_context = NULL,
-	};
-
-	/* Initialize nrfx UARTE driver in blocking mode. */
-	/* TODO: use UARTE in non-blocking mode with IRQ handler. */
-	nrfx_uarte_init(&uarte_inst, &config, NULL);
-#endif
-}
-
 void *nrf_modem_os_alloc(size_t bytes)
 {
 	void *addr = k_heap_alloc(&library_heap, bytes, K_NO_WAIT);
@@ -504,6 +490,15 @@ void nrf_modem_lib_shm_tx_diagnose(void)
 	printk("Failed allocations: %u\n", shmem_diag.failed_allocs);
 }
 
+void nrf_modem_lib_wakeup_diagnose(void)
+{
+	printk("nrf_modem wakeups:\n");
+	printk("RPC events: %u\n", wakeup_diag.events);
+	printk("Threads woken: %u\n", wakeup_diag.wakeups);
+	printk("Most threads woken by one event: %u\n",
+	       wakeup_diag.wakeups_max);
+}
+
 #if defined(CONFIG_NRF_MODEM_LIB_SHM_TX_DUMP_PERIODIC) || \
 	defined(CONFIG_NRF_MODEM_LIB_HEAP_DUMP_PERIODIC)
 
@@ -557,12 +552,15 @@ void nrf_modem_os_init(void)
 
 	read_task_create();
 
-	/* Configure and enable modem tracing over UART. */
-	trace_uart_init();
+	/* Configure and enable modem tracing. */
+#ifdef CONFIG_NRF_MODEM_LIB_TRACE_ENABLED
+	(void)nrf_modem_lib_trace_init();
+#endif
 	trace_task_create();
 
 	memset(&heap_diag, 0x00, sizeof(heap_diag));
 	memset(&shmem_diag, 0x00, sizeof(shmem_diag));
+	memset(&wakeup_diag, 0x00, sizeof(wakeup_diag));
 
 	/* Initialize TX heap */
 	k_heap_init(&shmem_heap,
@@ -592,20 +590,9 @@ void nrf_modem_os_init(void)
 int32_t nrf_modem_os_trace_put(const uint8_t * const data, uint32_t len)
 {
 #ifdef CONFIG_NRF_MODEM_LIB_TRACE_ENABLED
-	/* Max DMA transfers are 255 bytes.
-	 * Split RAM buffer into smaller chunks
-	 * to be transferred using DMA.
-	 */
-	uint32_t remaining_bytes = len;
-
-	while (remaining_bytes) {
-		uint8_t transfer_len = MIN(remaining_bytes, UINT8_MAX);
-		uint32_t idx = len - remaining_bytes;
-
-		nrfx_uarte_tx(&uarte_inst, &data[idx], transfer_len);
-		remaining_bytes -= transfer_len;
-	}
-#endif
-
+	/* Buffered here, written to the sink by the trace thread. */
+	return nrf_modem_lib_trace_put(data, len);
+#else
 	return 0;
+#endif
 }
@@ -18,6 +18,7 @@
 #include "sms_deliver.h"
 #include "sms_at.h"
 #include "sms_internal.h"
+#include "sms_reassembly.h"
 
 LOG_MODULE_REGISTER(sms, CONFIG_SMS_LOG_LEVEL);
 
@@ -106,6 +107,20 @@ void sms_at_handler(void *context, const char *at_notif)
 		return;
 	}
 
+	/* Concatenated messages are delivered only when all parts have been received.
+	 * Parts that don't complete a message are still acknowledged towards network.
+	 * Messages with too many parts to be reassembled are delivered part by part.
+	 */
+	if (IS_ENABLED(CONFIG_SMS_REASSEMBLY) &&
+	    sms_data_info.type == SMS_TYPE_DELIVER &&
+	    sms_data_info.header.deliver.concatenated.present) {
+		err = sms_reassembly_add(&sms_data_info);
+		if (err && err != -EMSGSIZE) {
+			k_work_submit(&sms_ack_work);
+			return;
+		}
+	}
+
 	/* Notify all subscribers. */
 	LOG_DBG("Valid SMS notification decoded");
 	for (size_t i = 0; i < ARRAY_SIZE(subscribers); i++) {
@@ -277,6 +292,10 @@ static void sms_uninit(void)
 			subscribers[i].ctx = NULL;
 			subscribers[i].listener = NULL;
 		}
+
+		if (IS_ENABLED(CONFIG_SMS_REASSEMBLY)) {
+			sms_reassembly_reset();
+		}
 	}
 
 	/* Cleanup resources. */
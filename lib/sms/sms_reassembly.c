@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <zephyr.h>
+#include <modem/sms.h>
+#include <logging/log.h>
+
+#include "sms_reassembly.h"
+
+LOG_MODULE_DECLARE(sms, CONFIG_SMS_LOG_LEVEL);
+
+/** @brief Reassembly timeout in milliseconds. */
+#define REASSEMBLY_TIMEOUT_MS (CONFIG_SMS_REASSEMBLY_TIMEOUT * MSEC_PER_SEC)
+
+/** @brief Size of the text buffer of one reassembly slot. */
+#define REASSEMBLY_BUF_LEN \
+	(CONFIG_SMS_REASSEMBLY_MAX_PARTS * SMS_MAX_PAYLOAD_LEN_CHARS)
+
+/**
+ * @brief Reassembly slot for one concatenated message.
+ *
+ * @details Parts are stored into the text buffer in the order they are received.
+ * Offset and length of each part are recorded so that the parts can be put into
+ * sequence order once the message is complete.
+ */
+struct sms_reassembly_slot {
+	/** Indicates whether the slot is in use. */
+	bool in_use;
+	/** Uptime of the first received part. */
+	int64_t start_time;
+	/** Uptime of the latest received part, used for LRU eviction. */
+	int64_t update_time;
+	/** Header of the first part in sequence order, or the first received part. */
+	struct sms_deliver_header header;
+	/** Number of parts received so far. */
+	uint8_t parts_received;
+	/** Number of bytes used in the text buffer. */
+	uint16_t buf_used;
+	/** Offset of each part in the text buffer. */
+	uint16_t part_offset[CONFIG_SMS_REASSEMBLY_MAX_PARTS];
+	/** Length of each part. */
+	uint8_t part_len[CONFIG_SMS_REASSEMBLY_MAX_PARTS];
+	/** Indicates which parts have been received. */
+	bool part_received[CONFIG_SMS_REASSEMBLY_MAX_PARTS];
+	/** Received text in reception order. */
+	uint8_t buf[REASSEMBLY_BUF_LEN];
+};
+
+/** @brief Reassembly slots. */
+static struct sms_reassembly_slot slots[CONFIG_SMS_REASSEMBLY_SLOTS];
+
+static void slot_free(struct sms_reassembly_slot *slot)
+{
+	slot->in_use = false;
+	slot->parts_received = 0;
+	slot->buf_used = 0;
+	memset(slot->part_received, 0, sizeof(slot->part_received));
+}
+
+/**
+ * @brief Drop reassemblies that have not completed within the timeout.
+ *
+ * @param[in] now Current uptime.
+ */
+static void slots_expire(int64_t now)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(slots); i++) {
+		if (slots[i].in_use &&
+		    (now - slots[i].start_time) > REASSEMBLY_TIMEOUT_MS) {
+			LOG_WRN("Concatenated message reassembly timed out, ref_number=%d, "
+				"%d/%d parts received",
+				slots[i].header.concatenated.ref_number,
+				slots[i].parts_received,
+				slots[i].header.concatenated.total_msgs);
+			slot_free(&slots[i]);
+		}
+	}
+}
+
+/**
+ * @brief Find reassembly slot for the given message.
+ *
+ * @param[in] header Header of the received part.
+ *
+ * @return Slot or NULL if the message has no ongoing reassembly.
+ */
+static struct sms_reassembly_slot *slot_find(const struct sms_deliver_header *header)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(slots); i++) {
+		struct sms_reassembly_slot *slot = &slots[i];
+
+		if (slot->in_use &&
+		    slot->header.concatenated.ref_number == header->concatenated.ref_number &&
+		    slot->header.concatenated.total_msgs == header->concatenated.total_msgs &&
+		    strcmp(slot->header.originating_address.address_str,
+			   header->originating_address.address_str) == 0) {
+			return slot;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Allocate a new reassembly slot. Least recently updated slot is evicted if
+ * all slots are in use.
+ *
+ * @return Allocated slot.
+ */
+static struct sms_reassembly_slot *slot_alloc(void)
+{
+	struct sms_reassembly_slot *lru = &slots[0];
+
+	for (size_t i = 0; i < ARRAY_SIZE(slots); i++) {
+		if (!slots[i].in_use) {
+			return &slots[i];
+		}
+		if (slots[i].update_time < lru->update_time) {
+			lru = &slots[i];
+		}
+	}
+
+	LOG_WRN("No free reassembly slots, dropping message with ref_number=%d, "
+		"%d/%d parts received",
+		lru->header.concatenated.ref_number,
+		lru->parts_received,
+		lru->header.concatenated.total_msgs);
+	slot_free(lru);
+
+	return lru;
+}
+
+int sms_reassembly_add(struct sms_data *data)
+{
+	struct sms_deliver_header *header = &data->header.deliver;
+	struct sms_reassembly_slot *slot;
+	int64_t now = k_uptime_get();
+	uint8_t total_msgs = header->concatenated.total_msgs;
+	uint8_t index = header->concatenated.seq_number - 1;
+	uint16_t len;
+
+	__ASSERT(header->concatenated.present, "Message is not concatenated");
+	__ASSERT(data->payload_len <= SMS_MAX_PAYLOAD_LEN_CHARS,
+		"Part longer than maximum SMS payload");
+
+	if (total_msgs > CONFIG_SMS_REASSEMBLY_MAX_PARTS) {
+		LOG_ERR("Concatenated message has %d parts, maximum is %d",
+			total_msgs, CONFIG_SMS_REASSEMBLY_MAX_PARTS);
+		return -EMSGSIZE;
+	}
+
+	slots_expire(now);
+
+	slot = slot_find(header);
+	if (slot == NULL) {
+		slot = slot_alloc();
+		slot->in_use = true;
+		slot->start_time = now;
+		slot->header = *header;
+	} else if (slot->part_received[index]) {
+		LOG_WRN("Duplicate part %d of concatenated message ref_number=%d ignored",
+			header->concatenated.seq_number, header->concatenated.ref_number);
+		return -EALREADY;
+	}
+
+	/* Header of the first part is delivered to the subscribers */
+	if (index == 0) {
+		slot->header = *header;
+	}
+
+	slot->update_time = now;
+	slot->part_offset[index] = slot->buf_used;
+	slot->part_len[index] = data->payload_len;
+	slot->part_received[index] = true;
+	slot->parts_received++;
+	memcpy(slot->buf + slot->buf_used, data->payload, data->payload_len);
+	slot->buf_used += data->payload_len;
+
+	LOG_DBG("Concatenated message ref_number=%d: %d/%d parts received",
+		header->concatenated.ref_number, slot->parts_received, total_msgs);
+
+	if (slot->parts_received < total_msgs) {
+		return -EAGAIN;
+	}
+
+	/* Write parts into the output buffer in sequence order */
+	len = 0;
+	for (size_t i = 0; i < total_msgs; i++) {
+		memcpy(data->payload + len, slot->buf + slot->part_offset[i], slot->part_len[i]);
+		len += slot->part_len[i];
+	}
+	data->payload[len] = '\0';
+	data->payload_len = len;
+
+	*header = slot->header;
+	header->concatenated.seq_number = 0;
+
+	slot_free(slot);
+
+	return 0;
+}
+
+void sms_reassembly_reset(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(slots); i++) {
+		slot_free(&slots[i]);
+	}
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _SMS_REASSEMBLY_INCLUDE_H_
+#define _SMS_REASSEMBLY_INCLUDE_H_
+
+/* Forward declaration */
+struct sms_data;
+
+/**
+ * @brief Add a part of a concatenated SMS message to the reassembly.
+ *
+ * @details The part is stored into a reassembly slot identified by the originating
+ * address and the concatenated message reference number. When the last missing part
+ * is received, the whole message is written into @p data, which can then be delivered
+ * to the subscribers.
+ *
+ * @param[in,out] data Decoded SMS-DELIVER message containing concatenation information.
+ *                     Contains the reassembled message if zero is returned.
+ *
+ * @retval -EAGAIN Part was stored but the message is not yet complete.
+ * @retval -EALREADY Part has already been received and was ignored.
+ * @retval -EMSGSIZE Message has too many parts to be reassembled. The part should be
+ *                   delivered as is.
+ * @return Zero when the message is complete, otherwise negative error code.
+ */
+int sms_reassembly_add(struct sms_data *data);
+
+/**
+ * @brief Drop all ongoing reassemblies.
+ */
+void sms_reassembly_reset(void);
+
+#endif
@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2021 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+
+"""
+Build the cell database used by the Multicell location library, or a delta
+update between two versions of the database.
+
+The input is a CSV file in the OpenCelliD format, with the columns
+radio, mcc, net, area, cell, unit, lon, lat and range. Only LTE and NB-IoT
+cells are used. The format must match lib/multicell_location/cell_db.c.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+import zlib
+
+MAGIC = 0x42444c43
+VERSION = 1
+FLAG_DELTA = 0x01
+
+HEADER = struct.Struct('<IBBHIIII8x')
+RECORD = struct.Struct('<HHHHIiiH2x')
+
+PCI_UNKNOWN = 0xffff
+RANGE_MIN = 1
+RANGE_MAX = 0xffff
+RADIOS = ('LTE', 'NBIOT')
+
+
+def key(rec):
+    mcc, mnc, tac, _, eci = rec[:5]
+    return (mcc, mnc, tac, eci)
+
+
+def read_csv(path, mccs):
+    cells = {}
+
+    with open(path, newline='') as f:
+        for row in csv.DictReader(f):
+            if row['radio'].upper() not in RADIOS:
+                continue
+
+            mcc = int(row['mcc'])
+            if mccs and mcc not in mccs:
+                continue
+
+            pci = int(row['unit']) if row.get('unit') else PCI_UNKNOWN
+            if not 0 <= pci <= 503:
+                pci = PCI_UNKNOWN
+
+            rng = min(max(int(float(row['range'])), RANGE_MIN), RANGE_MAX)
+            rec = (mcc, int(row['net']), int(row['area']) & 0xffff, rng,
+                   int(row['cell']) & 0x0fffffff,
+                   round(float(row['lat']) * 1e7),
+                   round(float(row['lon']) * 1e7), pci)
+
+            # Later rows replace earlier rows for the same cell
+            cells[key(rec)] = rec
+
+    return cells
+
+
+def pack(records, seq, base_seq=0, flags=0):
+    data = b''.join(RECORD.pack(*rec) for rec in records)
+    header = HEADER.pack(MAGIC, VERSION, flags, RECORD.size, len(records),
+                         seq, base_seq, zlib.crc32(data) & 0xffffffff)
+    return header + data
+
+
+def unpack(data):
+    magic, version, flags, record_size, count, seq, base_seq, crc = \
+        HEADER.unpack_from(data)
+
+    if magic != MAGIC or version != VERSION or record_size != RECORD.size:
+        sys.exit('Not a cell database')
+    if flags & FLAG_DELTA:
+        sys.exit('Expected a cell database, not a delta')
+
+    records = data[HEADER.size:HEADER.size + count * RECORD.size]
+    if zlib.crc32(records) & 0xffffffff != crc:
+        sys.exit('Cell database CRC mismatch')
+
+    cells = {}
+    for rec in RECORD.iter_unpack(records):
+        cells[key(rec)] = rec
+
+    return cells, seq
+
+
+def write(path, data, address):
+    if address is None:
+        with open(path, 'wb') as f:
+            f.write(data)
+    else:
+        from intelhex import IntelHex
+
+        ih = IntelHex()
+        ih.frombytes(data, offset=address)
+        ih.write_hex_file(path)
+
+    print(f'Wrote {len(data)} bytes to {path}')
+
+
+def cmd_build(args):
+    cells = read_csv(args.csv, args.mcc)
+    records = [cells[k] for k in sorted(cells)]
+
+    print(f'{len(records)} cells')
+    write(args.output, pack(records, args.seq), args.address)
+
+
+def cmd_delta(args):
+    with open(args.base, 'rb') as f:
+        old, old_seq = unpack(f.read())
+    with open(args.new, 'rb') as f:
+        new, new_seq = unpack(f.read())
+
+    changed = {k: rec for k, rec in new.items() if old.get(k) != rec}
+    # Removed cells are kept in the delta with range 0
+    removed = {k: rec[:3] + (0,) + rec[4:] for k, rec in old.items()
+               if k not in new}
+    updates = {**changed, **removed}
+    records = [updates[k] for k in sorted(updates)]
+
+    print(f'{len(changed)} cells added or changed, {len(removed)} removed')
+    write(args.output, pack(records, new_seq, old_seq, FLAG_DELTA),
+          args.address)
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    subparsers = parser.add_subparsers(dest='command', required=True)
+
+    build = subparsers.add_parser('build', help='Build a cell database from CSV.')
+    build.add_argument('csv', help='Cells in the OpenCelliD CSV format.')
+    build.add_argument('--seq', type=int, required=True,
+                       help='Sequence number of the database.')
+    build.add_argument('--mcc', type=int, action='append',
+                       help='Only include cells with this MCC. Can be given multiple times.')
+    build.set_defaults(func=cmd_build)
+
+    delta = subparsers.add_parser('delta', help='Build a delta between two cell databases.')
+    delta.add_argument('base', help='The database on the device.')
+    delta.add_argument('new', help='The database to update to.')
+    delta.set_defaults(func=cmd_delta)
+
+    for p in (build, delta):
+        p.add_argument('--output', '-o', required=True, help='Output file.')
+        p.add_argument('--address', type=lambda x: int(x, 0),
+                       help='Write an Intel HEX file with the data at this address, '
+                            'for example that of the cell_db partition.')
+
+    return parser.parse_args()
+
+
+if __name__ == '__main__':
+    args = parse_args()
+    args.func(args)
@@ -9,99 +9,143 @@
 
 LOG_MODULE_REGISTER(bt_conn_ctx, CONFIG_BT_CONN_CTX_LOG_LEVEL);
 
-static void bt_conn_ctx_mem_free(struct k_mem_slab *mem_slab, void **data)
+/* Set in the reference counter from the allocation until the context is
+ * freed. New references can be taken only while it is set.
+ */
+#define CTX_ALLOCATED BIT(30)
+
+static struct bt_conn_ctx *ctx_by_conn(struct bt_conn_ctx_lib *ctx_lib,
+				       struct bt_conn *conn)
 {
-	k_mem_slab_free(mem_slab, data);
-	*data = NULL;
+	uint8_t index = bt_conn_index(conn);
+
+	__ASSERT_NO_MSG(index < ARRAY_SIZE(ctx_lib->ctx));
+
+	return &ctx_lib->ctx[index];
 }
 
-void *bt_conn_ctx_alloc(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
+static size_t block_index(const struct bt_conn_ctx_lib *ctx_lib,
+			  const void *data)
 {
-	__ASSERT_NO_MSG(conn != NULL);
-	__ASSERT_NO_MSG(ctx_lib != NULL);
+	const struct k_mem_slab *mem_slab = ctx_lib->mem_slab;
+
+	return ((const char *)data - mem_slab->buffer) / mem_slab->block_size;
+}
 
-	int err = -ENOMEM;
-	struct bt_conn_ctx *ctx;
+static bool ctx_ref_get(struct bt_conn_ctx *ctx)
+{
+	atomic_val_t ref;
 
-	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
+	do {
+		ref = atomic_get(&ctx->ref);
+		if (!(ref & CTX_ALLOCATED)) {
+			return false;
+		}
+	} while (!atomic_cas(&ctx->ref, ref, ref + 1));
 
-	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
-		ctx = &ctx_lib->ctx[i];
+	return true;
+}
 
-		if (!ctx->conn && !ctx->data) {
-			err = k_mem_slab_alloc(ctx_lib->mem_slab,
-					       &ctx->data,
-					       K_NO_WAIT);
-			if (!err) {
-				ctx->conn = conn;
+static void ctx_ref_put(struct bt_conn_ctx_lib *ctx_lib,
+			struct bt_conn_ctx *ctx)
+{
+	atomic_val_t ref;
 
-				LOG_DBG("The memory for the connection context "
-					"has been allocated, conn %p, index: %u",
-					(void *)conn, i);
+	do {
+		ref = atomic_get(&ctx->ref);
+		__ASSERT_NO_MSG((ref & ~CTX_ALLOCATED) > 0);
 
-				return ctx->data;
+		if (ref == 1) {
+			/* The last reference to a freed context. No new
+			 * reference can be taken, so the counter is cleared
+			 * only when the context can be allocated again.
+			 */
+			void *data = ctx->data;
 
-			} else {
-				break;
-			}
+			ctx->conn = NULL;
+			ctx->data = NULL;
+			k_mem_slab_free(ctx_lib->mem_slab, &data);
+			atomic_clear(&ctx->ref);
 
+			LOG_DBG("The context memory for the connection "
+				"has been released, index %u",
+				(unsigned int)(ctx - ctx_lib->ctx));
+			return;
 		}
+	} while (!atomic_cas(&ctx->ref, ref, ref - 1));
+}
+
+static int ctx_free(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn_ctx *ctx)
+{
+	atomic_val_t ref = atomic_and(&ctx->ref, ~CTX_ALLOCATED);
+
+	if (!(ref & CTX_ALLOCATED)) {
+		return -EINVAL;
 	}
 
-	LOG_WRN("Memory can not be allocated");
-	k_mutex_unlock(ctx_lib->mutex);
+	/* Drop the reference held since the allocation. */
+	ctx_ref_put(ctx_lib, ctx);
 
-	return NULL;
+	return 0;
 }
 
-int bt_conn_ctx_free(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
+void *bt_conn_ctx_alloc(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
 {
 	__ASSERT_NO_MSG(conn != NULL);
 	__ASSERT_NO_MSG(ctx_lib != NULL);
 
-	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
+	struct bt_conn_ctx *ctx = ctx_by_conn(ctx_lib, conn);
+	void *data;
+	int err;
 
-	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
-		struct bt_conn_ctx *ctx = &ctx_lib->ctx[i];
-
-		if (ctx->conn == conn) {
-			bt_conn_ctx_mem_free(ctx_lib->mem_slab, &ctx->data);
-			ctx->conn = NULL;
-			ctx->data = NULL;
+	if (atomic_get(&ctx->ref) != 0) {
+		LOG_WRN("The context of this connection is still in use");
+		return NULL;
+	}
 
-			LOG_DBG("The context memory for the connection "
-				"has been released, conn %p index %u",
-				(void *)conn, i);
+	err = k_mem_slab_alloc(ctx_lib->mem_slab, &data, K_NO_WAIT);
+	if (err) {
+		LOG_WRN("Memory can not be allocated");
+		return NULL;
+	}
 
-			k_mutex_unlock(ctx_lib->mutex);
+	ctx_lib->block_ctx[block_index(ctx_lib, data)] = ctx - ctx_lib->ctx;
+	ctx->data = data;
+	ctx->conn = conn;
 
-			return 0;
-		}
-	}
+	/* The reference held until the context is freed, and the one
+	 * released by the caller.
+	 */
+	atomic_set(&ctx->ref, CTX_ALLOCATED | 2);
 
-	LOG_WRN("There is no allocated memory for this connection");
-	k_mutex_unlock(ctx_lib->mutex);
+	LOG_DBG("The memory for the connection context "
+		"has been allocated, conn %p, index: %u",
+		(void *)conn, (unsigned int)(ctx - ctx_lib->ctx));
 
-	return  -EINVAL;
+	return data;
 }
 
-void bt_conn_ctx_free_all(struct bt_conn_ctx_lib *ctx_lib)
+int bt_conn_ctx_free(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
 {
+	__ASSERT_NO_MSG(conn != NULL);
 	__ASSERT_NO_MSG(ctx_lib != NULL);
 
-	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
+	int err = ctx_free(ctx_lib, ctx_by_conn(ctx_lib, conn));
 
-	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
-		struct bt_conn_ctx *ctx = &ctx_lib->ctx[i];
-
-		if (ctx->data != NULL) {
-			k_mem_slab_free(ctx_lib->mem_slab, &ctx->data);
-			ctx->conn = NULL;
-			ctx->data = NULL;
-		}
+	if (err) {
+		LOG_WRN("There is no allocated memory for this connection");
 	}
 
-	k_mutex_unlock(ctx_lib->mutex);
+	return err;
+}
+
+void bt_conn_ctx_free_all(struct bt_conn_ctx_lib *ctx_lib)
+{
+	__ASSERT_NO_MSG(ctx_lib != NULL);
+
+	for (size_t i = 0; i < ARRAY_SIZE(ctx_lib->ctx); i++) {
+		(void)ctx_free(ctx_lib, &ctx_lib->ctx[i]);
+	}
 
 	LOG_DBG("All allocated memory has been released");
 }
@@ -111,23 +155,16 @@ void *bt_conn_ctx_get(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
 	__ASSERT_NO_MSG(conn != NULL);
 	__ASSERT_NO_MSG(ctx_lib != NULL);
 
-	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
+	struct bt_conn_ctx *ctx = ctx_by_conn(ctx_lib, conn);
 
-	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
-		struct bt_conn_ctx *ctx = &ctx_lib->ctx[i];
-
-		if (ctx->conn == conn) {
-			LOG_DBG("Memory block found for the connection");
-
-			return ctx->data;
-		}
+	if (!ctx_ref_get(ctx)) {
+		LOG_WRN("No memory block for connection");
+		return NULL;
 	}
 
-	LOG_WRN("No memory block for connection");
+	__ASSERT_NO_MSG(ctx->conn == conn);
 
-	k_mutex_unlock(ctx_lib->mutex);
-
-	return NULL;
+	return ctx->data;
 }
 
 const struct bt_conn_ctx *bt_conn_ctx_get_by_id(struct bt_conn_ctx_lib *ctx_lib, uint8_t id)
@@ -135,17 +172,9 @@ const struct bt_conn_ctx *bt_conn_ctx_get_by_id(struct bt_conn_ctx_lib *ctx_lib,
 	__ASSERT_NO_MSG(ctx_lib != NULL);
 	__ASSERT_NO_MSG(id < bt_conn_ctx_count(ctx_lib));
 
-	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
-
 	struct bt_conn_ctx *ctx = &ctx_lib->ctx[id];
 
-	if (ctx_lib->ctx[id].conn != NULL) {
-		return ctx;
-	}
-
-	k_mutex_unlock(ctx_lib->mutex);
-
-	return NULL;
+	return ctx_ref_get(ctx) ? ctx : NULL;
 }
 
 void bt_conn_ctx_release(struct bt_conn_ctx_lib *ctx_lib, void *ctx_data)
@@ -153,15 +182,60 @@ void bt_conn_ctx_release(struct bt_conn_ctx_lib *ctx_lib, void *ctx_data)
 	__ASSERT_NO_MSG(ctx_lib != NULL);
 	__ASSERT_NO_MSG(ctx_data != NULL);
 
-	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
-		struct bt_conn_ctx *ctx = &ctx_lib->ctx[i];
+	struct bt_conn_ctx *ctx =
+		&ctx_lib->ctx[ctx_lib->block_ctx[block_index(ctx_lib,
+							     ctx_data)]];
 
-		if (ctx->data == ctx_data) {
-			k_mutex_unlock(ctx_lib->mutex);
+	__ASSERT_NO_MSG(ctx->data == ctx_data);
 
-			return;
+	ctx_ref_put(ctx_lib, ctx);
+}
+
+static size_t ctx_foreach(struct bt_conn_ctx_lib *ctx_lib,
+			  const struct bt_gatt_attr *attr, uint16_t ccc_type,
+			  bt_conn_ctx_foreach_cb func, void *user_data)
+{
+	struct bt_conn_ctx *ctxs[ARRAY_SIZE(ctx_lib->ctx)];
+	size_t ctx_cnt = 0;
+	size_t cnt = 0;
+
+	__ASSERT_NO_MSG(ctx_lib != NULL);
+	__ASSERT_NO_MSG(func != NULL);
+
+	for (size_t i = 0; i < ARRAY_SIZE(ctx_lib->ctx); i++) {
+		if (ctx_ref_get(&ctx_lib->ctx[i])) {
+			ctxs[ctx_cnt++] = &ctx_lib->ctx[i];
+		}
+	}
+
+	for (size_t i = 0; i < ctx_cnt; i++) {
+		if (!attr ||
+		    bt_gatt_is_subscribed(ctxs[i]->conn, attr, ccc_type)) {
+			func(ctxs[i], user_data);
+			cnt++;
 		}
 	}
 
-	__ASSERT_NO_MSG(false);
+	for (size_t i = 0; i < ctx_cnt; i++) {
+		ctx_ref_put(ctx_lib, ctxs[i]);
+	}
+
+	return cnt;
+}
+
+size_t bt_conn_ctx_foreach(struct bt_conn_ctx_lib *ctx_lib,
+			   bt_conn_ctx_foreach_cb func, void *user_data)
+{
+	return ctx_foreach(ctx_lib, NULL, 0, func, user_data);
+}
+
+size_t bt_conn_ctx_foreach_subscribed(struct bt_conn_ctx_lib *ctx_lib,
+				      const struct bt_gatt_attr *attr,
+				      uint16_t ccc_type,
+				      bt_conn_ctx_foreach_cb func,
+				      void *user_data)
+{
+	__ASSERT_NO_MSG(attr != NULL);
+
+	return ctx_foreach(ctx_lib, attr, ccc_type, func, user_data);
 }
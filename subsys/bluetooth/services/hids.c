@@ -52,6 +52,13 @@
 
 LOG_MODULE_REGISTER(bt_hids, CONFIG_BT_HIDS_LOG_LEVEL);
 
+/* Serializes access to the report data in the connection contexts. Input
+ * reports are written by the application threads that send them and read
+ * by the Bluetooth RX thread, output and feature reports are written by
+ * the RX thread and passed to the application.
+ */
+static K_MUTEX_DEFINE(rep_ctx_lock);
+
 int bt_hids_connected(struct bt_hids *hids_obj, struct bt_conn *conn)
 {
 	__ASSERT_NO_MSG(conn != NULL);
@@ -126,6 +133,10 @@ static ssize_t hids_protocol_mode_write(struct bt_conn *conn,
 	struct bt_hids *hids = CONTAINER_OF(pm, struct bt_hids, pm);
 	uint8_t const *new_pm = (uint8_t const *)buf;
 
+	if (offset + len > sizeof(uint8_t)) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+	}
+
 	struct bt_hids_conn_data *conn_data =
 		bt_conn_ctx_get(hids->conn_ctx, conn);
 
@@ -136,10 +147,6 @@ static ssize_t hids_protocol_mode_write(struct bt_conn *conn,
 
 	uint8_t *cur_pm = &conn_data->pm_ctx_value;
 
-	if (offset + len > sizeof(uint8_t)) {
-		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
-	}
-
 	switch (*new_pm) {
 	case BT_HIDS_PM_BOOT:
 		if (pm->evt_handler) {
@@ -154,6 +161,7 @@ static ssize_t hids_protocol_mode_write(struct bt_conn *conn,
 		}
 		break;
 	default:
+		bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
 		return BT_GATT_ERR(BT_ATT_ERR_NOT_SUPPORTED);
 	}
 
@@ -228,8 +236,10 @@ static ssize_t hids_inp_rep_read(struct bt_conn *conn,
 
 	rep_data = conn_data->inp_rep_ctx + rep->offset;
 
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
 	ret_len = bt_gatt_attr_read(conn, attr, buf, len, offset, rep_data,
 				    rep->size);
+	k_mutex_unlock(&rep_ctx_lock);
 
 	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
 
@@ -275,8 +285,10 @@ static ssize_t hids_outp_rep_read(struct bt_conn *conn,
 
 	rep_data = conn_data->outp_rep_ctx + rep->offset;
 
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
 	ret_len = bt_gatt_attr_read(conn, attr, buf, len, offset, rep_data,
 				    rep->size);
+	k_mutex_unlock(&rep_ctx_lock);
 
 	if (rep->handler) {
 		struct bt_hids_rep report = {
@@ -305,6 +317,10 @@ static ssize_t hids_outp_rep_write(struct bt_conn *conn,
 						 outp_rep_group.reports);
 	uint8_t *rep_data;
 
+	if (offset + len > rep->size) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+	}
+
 	struct bt_hids_conn_data *conn_data =
 		bt_conn_ctx_get(hids->conn_ctx, conn);
 
@@ -315,9 +331,8 @@ static ssize_t hids_outp_rep_write(struct bt_conn *conn,
 
 	rep_data = conn_data->outp_rep_ctx + rep->offset;
 
-	if (offset + len > rep->size) {
-		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
-	}
+	/* The handler gets the report data in the context */
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
 	memcpy(rep_data + offset, buf, len);
 
 	if (rep->handler) {
@@ -327,6 +342,7 @@ static ssize_t hids_outp_rep_write(struct bt_conn *conn,
 		};
 		rep->handler(&report, conn, true);
 	}
+	k_mutex_unlock(&rep_ctx_lock);
 
 	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
 
@@ -372,8 +388,10 @@ static ssize_t hids_feat_rep_read(struct bt_conn *conn,
 
 	rep_data = conn_data->feat_rep_ctx + rep->offset;
 
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
 	ret_len = bt_gatt_attr_read(conn, attr, buf, len, offset, rep_data,
 				    rep->size);
+	k_mutex_unlock(&rep_ctx_lock);
 
 	if (rep->handler) {
 		struct bt_hids_rep report = {
@@ -408,6 +426,10 @@ static ssize_t hids_feat_rep_write(struct bt_conn *conn,
 						 feat_rep_group.reports);
 	uint8_t *rep_data;
 
+	if (offset + len > rep->size) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+	}
+
 	struct bt_hids_conn_data *conn_data =
 		bt_conn_ctx_get(hids->conn_ctx, conn);
 
@@ -418,9 +440,8 @@ static ssize_t hids_feat_rep_write(struct bt_conn *conn,
 
 	rep_data = conn_data->feat_rep_ctx + rep->offset;
 
-	if (offset + len > rep->size) {
-		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
-	}
+	/* The handler gets the report data in the context */
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
 	memcpy(rep_data + offset, buf, len);
 
 	if (rep->handler) {
@@ -430,6 +451,7 @@ static ssize_t hids_feat_rep_write(struct bt_conn *conn,
 		};
 		rep->handler(&report, conn, true);
 	}
+	k_mutex_unlock(&rep_ctx_lock);
 
 	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
 
@@ -497,9 +519,11 @@ static ssize_t hids_boot_mouse_inp_report_read(struct bt_conn *conn,
 
 	rep_data = conn_data->hids_boot_mouse_inp_rep_ctx;
 
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
 	ret_len =
 	    bt_gatt_attr_read(conn, attr, buf, len, offset, rep_data,
 			      sizeof(conn_data->hids_boot_mouse_inp_rep_ctx));
+	k_mutex_unlock(&rep_ctx_lock);
 	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
 
 	return ret_len;
@@ -552,9 +576,11 @@ static ssize_t hids_boot_kb_inp_report_read(struct bt_conn *conn,
 
 	rep_data = conn_data->hids_boot_kb_inp_rep_ctx;
 
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
 	ret_len =
 	    bt_gatt_attr_read(conn, attr, buf, len, offset, rep_data,
 			      sizeof(conn_data->hids_boot_kb_inp_rep_ctx));
+	k_mutex_unlock(&rep_ctx_lock);
 	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
 
 	return ret_len;
@@ -609,9 +635,11 @@ static ssize_t hids_boot_kb_outp_report_read(struct bt_conn *conn,
 
 	rep_data = conn_data->hids_boot_kb_outp_rep_ctx;
 
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
 	ret_len =
 	    bt_gatt_attr_read(conn, attr, buf, len, offset, rep_data,
 			      sizeof(conn_data->hids_boot_kb_outp_rep_ctx));
+	k_mutex_unlock(&rep_ctx_lock);
 
 	if (rep->handler) {
 		struct bt_hids_rep report = {
@@ -637,6 +665,10 @@ static ssize_t hids_boot_kb_outp_report_write(struct bt_conn *conn,
 						 boot_kb_outp_rep);
 	uint8_t *rep_data;
 
+	if (offset + len > sizeof(uint8_t)) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+	}
+
 	struct bt_hids_conn_data *conn_data =
 		bt_conn_ctx_get(hids->conn_ctx, conn);
 
@@ -647,9 +679,7 @@ static ssize_t hids_boot_kb_outp_report_write(struct bt_conn *conn,
 
 	rep_data = conn_data->hids_boot_kb_outp_rep_ctx;
 
-	if (offset + len > sizeof(uint8_t)) {
-		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
-	}
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
 	memcpy(rep_data + offset, buf, len);
 
 	if (rep->handler) {
@@ -660,6 +690,7 @@ static ssize_t hids_boot_kb_outp_report_write(struct bt_conn *conn,
 
 		rep->handler(&report, conn, true);
 	}
+	k_mutex_unlock(&rep_ctx_lock);
 
 	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
 
@@ -1031,42 +1062,43 @@ static void store_input_report(struct bt_hids_inp_rep *hids_inp_rep,
 	}
 }
 
+struct inp_rep_store_data {
+	struct bt_hids_inp_rep *hids_inp_rep;
+	uint8_t const *rep;
+	uint8_t len;
+};
+
+static void inp_rep_store(const struct bt_conn_ctx *ctx, void *user_data)
+{
+	const struct inp_rep_store_data *store = user_data;
+	struct bt_hids_conn_data *conn_data = ctx->data;
+	uint8_t *rep_data = conn_data->inp_rep_ctx +
+			    store->hids_inp_rep->offset;
+
+	store_input_report(store->hids_inp_rep, rep_data, store->rep,
+			   store->len);
+}
+
 static int inp_rep_notify_all(struct bt_hids *hids_obj,
 			      struct bt_hids_inp_rep *hids_inp_rep,
 			      uint8_t const *rep, uint8_t len,
 			      bt_gatt_complete_func_t cb)
 {
-	struct bt_hids_conn_data *conn_data;
-	uint8_t *rep_data = NULL;
 	struct bt_gatt_attr *rep_attr =
 		&hids_obj->gp.svc.attrs[hids_inp_rep->att_ind];
-
-	const size_t contexts =
-	    bt_conn_ctx_count(hids_obj->conn_ctx);
-
-	for (size_t i = 0; i < contexts; i++) {
-		const struct bt_conn_ctx *ctx =
-			bt_conn_ctx_get_by_id(hids_obj->conn_ctx, i);
-
-		if (ctx) {
-			bool notification_enabled = bt_gatt_is_subscribed(
-				ctx->conn, rep_attr, BT_GATT_CCC_NOTIFY);
-
-			if (notification_enabled) {
-				conn_data = ctx->data;
-				rep_data = conn_data->inp_rep_ctx +
-					   hids_inp_rep->offset;
-
-				store_input_report(hids_inp_rep, rep_data, rep,
-						   len);
-			}
-
-			bt_conn_ctx_release(hids_obj->conn_ctx,
-					    (void *)ctx->data);
-		}
-	}
-
-	if (rep_data != NULL) {
+	struct inp_rep_store_data store = {
+		.hids_inp_rep = hids_inp_rep,
+		.rep = rep,
+		.len = len,
+	};
+
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
+	size_t subscribed = bt_conn_ctx_foreach_subscribed(
+		hids_obj->conn_ctx, rep_attr, BT_GATT_CCC_NOTIFY,
+		inp_rep_store, &store);
+	k_mutex_unlock(&rep_ctx_lock);
+
+	if (subscribed) {
 		struct bt_gatt_notify_params params = {0};
 
 		params.attr = rep_attr;
@@ -1113,7 +1145,9 @@ int bt_hids_inp_rep_send(struct bt_hids *hids_obj,
 
 	rep_data = conn_data->inp_rep_ctx + hids_inp_rep->offset;
 
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
 	store_input_report(hids_inp_rep, rep_data, rep, len);
+	k_mutex_unlock(&rep_ctx_lock);
 
 	struct bt_gatt_notify_params params = {0};
 
@@ -1129,56 +1163,54 @@ int bt_hids_inp_rep_send(struct bt_hids *hids_obj,
 	return err;
 }
 
+struct boot_mouse_store_data {
+	const uint8_t *buttons;
+	uint8_t *rep_buff;
+};
+
+static void boot_mouse_inp_rep_store(const struct bt_conn_ctx *ctx,
+				     void *user_data)
+{
+	const struct boot_mouse_store_data *store = user_data;
+	struct bt_hids_conn_data *conn_data = ctx->data;
+	uint8_t *rep_data = conn_data->hids_boot_mouse_inp_rep_ctx;
+
+	if (store->buttons) {
+		/* If buttons data is not given use old values. */
+		rep_data[0] = *store->buttons;
+	}
+
+	store->rep_buff[0] = rep_data[0];
+}
+
 static int boot_mouse_inp_report_notify_all(
 	struct bt_hids *hids_obj, const uint8_t *buttons,
 	struct bt_hids_boot_mouse_inp_rep *boot_mouse_inp_rep,
 	int8_t x_delta, int8_t y_delta, bt_gatt_complete_func_t cb)
 {
-	struct bt_hids_conn_data *conn_data;
 	uint8_t rep_ind = hids_obj->boot_mouse_inp_rep.att_ind;
 	struct bt_gatt_attr *rep_attr = &hids_obj->gp.svc.attrs[rep_ind];
-	uint8_t *rep_data = NULL;
 	uint8_t rep_buff[BT_HIDS_BOOT_MOUSE_REP_LEN] = {0};
+	struct boot_mouse_store_data store = {
+		.buttons = buttons,
+		.rep_buff = rep_buff,
+	};
 
 	rep_buff[1] = (uint8_t)x_delta;
 	rep_buff[2] = (uint8_t)y_delta;
 
-	const size_t contexts = bt_conn_ctx_count(hids_obj->conn_ctx);
-
-	for (size_t i = 0; i < contexts; i++) {
-		const struct bt_conn_ctx *ctx =
-			bt_conn_ctx_get_by_id(hids_obj->conn_ctx, i);
-
-		if (ctx) {
-			bool notification_enabled = bt_gatt_is_subscribed(
-				ctx->conn, rep_attr, BT_GATT_CCC_NOTIFY);
-
-			if (notification_enabled) {
-				conn_data = ctx->data;
-				rep_data =
-				    conn_data->hids_boot_mouse_inp_rep_ctx;
-
-				if (buttons) {
-					/* If buttons data is not given
-					 * use old values.
-					 */
-					rep_data[0] = *buttons;
-				}
-
-				rep_buff[0] = rep_data[0];
-			}
-
-			bt_conn_ctx_release(hids_obj->conn_ctx,
-					    (void *)ctx->data);
-		}
-	}
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
+	size_t subscribed = bt_conn_ctx_foreach_subscribed(
+		hids_obj->conn_ctx, rep_attr, BT_GATT_CCC_NOTIFY,
+		boot_mouse_inp_rep_store, &store);
+	k_mutex_unlock(&rep_ctx_lock);
 
-	if (rep_data != NULL) {
+	if (subscribed) {
 		struct bt_gatt_notify_params params = {0};
 
 		params.attr = rep_attr;
 		params.data = rep_buff;
-		params.len = sizeof(conn_data->hids_boot_mouse_inp_rep_ctx);
+		params.len = sizeof(rep_buff);
 		params.func = cb;
 
 		return bt_gatt_notify_cb(NULL, &params);
@@ -1197,6 +1229,7 @@ int bt_hids_boot_mouse_inp_rep_send(struct bt_hids *hids_obj,
 	struct bt_hids_boot_mouse_inp_rep *boot_mouse_inp_rep =
 	    &hids_obj->boot_mouse_inp_rep;
 	struct bt_gatt_attr *rep_attr = &hids_obj->gp.svc.attrs[rep_ind];
+	uint8_t rep_buff[BT_HIDS_BOOT_MOUSE_REP_LEN];
 	uint8_t *rep_data;
 
 	if (!conn) {
@@ -1222,71 +1255,67 @@ int bt_hids_boot_mouse_inp_rep_send(struct bt_hids *hids_obj,
 
 	rep_data = conn_data->hids_boot_mouse_inp_rep_ctx;
 
+	/* Movement is relative, only the buttons state is kept. The report
+	 * is sent from a copy, so the lock is not held while it is sent.
+	 */
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
 	if (buttons) {
 		/* If buttons data is not given use old values. */
 		rep_data[0] = *buttons;
 	}
-	rep_data[1] = (uint8_t)x_delta;
-	rep_data[2] = (uint8_t)y_delta;
+	memcpy(rep_buff, rep_data, sizeof(rep_buff));
+	k_mutex_unlock(&rep_ctx_lock);
+
+	rep_buff[1] = (uint8_t)x_delta;
+	rep_buff[2] = (uint8_t)y_delta;
 
 	struct bt_gatt_notify_params params = {0};
 
 	params.attr = &hids_obj->gp.svc.attrs[rep_ind];
-	params.data = rep_data;
-	params.len = sizeof(conn_data->hids_boot_mouse_inp_rep_ctx);
+	params.data = rep_buff;
+	params.len = sizeof(rep_buff);
 	params.func = cb;
 
 	int err = bt_gatt_notify_cb(conn, &params);
 
-	rep_data[1] = 0;
-	rep_data[2] = 0;
-
 	bt_conn_ctx_release(hids_obj->conn_ctx, (void *)conn_data);
 
 	return err;
 }
 
+static void boot_kb_inp_rep_store(const struct bt_conn_ctx *ctx,
+				  void *user_data)
+{
+	struct bt_hids_conn_data *conn_data = ctx->data;
+
+	memcpy(conn_data->hids_boot_kb_inp_rep_ctx, user_data,
+	       sizeof(conn_data->hids_boot_kb_inp_rep_ctx));
+}
+
 static int
 boot_kb_inp_notify_all(struct bt_hids *hids_obj, uint8_t const *rep,
 		       uint16_t len,
 		       struct bt_hids_boot_kb_inp_rep *boot_kb_inp_rep,
 		       bt_gatt_complete_func_t cb)
 {
-	struct bt_hids_conn_data *conn_data;
 	uint8_t rep_ind = hids_obj->boot_kb_inp_rep.att_ind;
 	struct bt_gatt_attr *rep_attr = &hids_obj->gp.svc.attrs[rep_ind];
-	uint8_t *rep_data = NULL;
-
-	const size_t contexts = bt_conn_ctx_count(hids_obj->conn_ctx);
-
-	for (size_t i = 0; i < contexts; i++) {
-		const struct bt_conn_ctx *ctx =
-		    bt_conn_ctx_get_by_id(hids_obj->conn_ctx, i);
+	uint8_t rep_buff[BT_HIDS_BOOT_KB_INPUT_REP_LEN] = {0};
 
-		if (ctx) {
-			bool notification_enabled = bt_gatt_is_subscribed(
-				ctx->conn, rep_attr, BT_GATT_CCC_NOTIFY);
+	memcpy(rep_buff, rep, len);
 
-			if (notification_enabled) {
-				conn_data = ctx->data;
-				rep_data = conn_data->hids_boot_kb_inp_rep_ctx;
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
+	size_t subscribed = bt_conn_ctx_foreach_subscribed(
+		hids_obj->conn_ctx, rep_attr, BT_GATT_CCC_NOTIFY,
+		boot_kb_inp_rep_store, rep_buff);
+	k_mutex_unlock(&rep_ctx_lock);
 
-				memcpy(rep_data, rep, len);
-				memset(&rep_data[len], 0,
-				       (BT_HIDS_BOOT_KB_INPUT_REP_LEN - len));
-			}
-
-			bt_conn_ctx_release(hids_obj->conn_ctx,
-					    (void *)ctx->data);
-		}
-	}
-
-	if (rep_data != NULL) {
+	if (subscribed) {
 		struct bt_gatt_notify_params params = {0};
 
 		params.attr = rep_attr;
-		params.data = rep_data;
-		params.len = sizeof(conn_data->hids_boot_kb_inp_rep_ctx);
+		params.data = rep_buff;
+		params.len = sizeof(rep_buff);
 		params.func = cb;
 
 		return bt_gatt_notify_cb(NULL, &params);
@@ -1303,8 +1332,13 @@ int bt_hids_boot_kb_inp_rep_send(struct bt_hids *hids_obj,
 	struct bt_hids_boot_kb_inp_rep *boot_kb_input_report =
 		&hids_obj->boot_kb_inp_rep;
 	struct bt_gatt_attr *rep_attr = &hids_obj->gp.svc.attrs[rep_ind];
+	uint8_t rep_buff[BT_HIDS_BOOT_KB_INPUT_REP_LEN] = {0};
 	uint8_t *rep_data = NULL;
 
+	if (len > BT_HIDS_BOOT_KB_INPUT_REP_LEN) {
+		return -EINVAL;
+	}
+
 	if (!conn) {
 		return boot_kb_inp_notify_all(hids_obj, rep, len,
 					      boot_kb_input_report, cb);
@@ -1317,10 +1351,6 @@ int bt_hids_boot_kb_inp_rep_send(struct bt_hids *hids_obj,
 	struct bt_hids_conn_data *conn_data =
 		bt_conn_ctx_get(hids_obj->conn_ctx, conn);
 
-	if (len > sizeof(conn_data->hids_boot_kb_inp_rep_ctx)) {
-		return -EINVAL;
-	}
-
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
 		return -EINVAL;
@@ -1328,15 +1358,17 @@ int bt_hids_boot_kb_inp_rep_send(struct bt_hids *hids_obj,
 
 	rep_data = conn_data->hids_boot_kb_inp_rep_ctx;
 
-	memcpy(rep_data, rep, len);
-	memset(&rep_data[len], 0,
-	       (sizeof(conn_data->hids_boot_kb_inp_rep_ctx) - len));
+	memcpy(rep_buff, rep, len);
+
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
+	memcpy(rep_data, rep_buff, sizeof(rep_buff));
+	k_mutex_unlock(&rep_ctx_lock);
 
 	struct bt_gatt_notify_params params = {0};
 
 	params.attr = rep_attr;
-	params.data = rep_data;
-	params.len = sizeof(conn_data->hids_boot_kb_inp_rep_ctx);
+	params.data = rep_buff;
+	params.len = sizeof(rep_buff);
 	params.func = cb;
 
 	int err = bt_gatt_notify_cb(conn, &params);
@@ -1345,3 +1377,235 @@ int bt_hids_boot_kb_inp_rep_send(struct bt_hids *hids_obj,
 
 	return err;
 }
+
+static int batch_rep_check(struct bt_hids *hids_obj,
+			   const struct bt_hids_batch_rep *rep)
+{
+	switch (rep->type) {
+	case BT_HIDS_BATCH_REP_INPUT:
+		if ((rep->rep_index >= hids_obj->inp_rep_group.cnt) ||
+		    (hids_obj->inp_rep_group.reports[rep->rep_index].size !=
+		     rep->len)) {
+			return -EINVAL;
+		}
+		return 0;
+	case BT_HIDS_BATCH_REP_BOOT_MOUSE:
+		if (!hids_obj->is_mouse ||
+		    (rep->len != BOOT_MOUSE_INPUT_REPORT_MIN_SIZE)) {
+			return -EINVAL;
+		}
+		return 0;
+	case BT_HIDS_BATCH_REP_BOOT_KB:
+		if (!hids_obj->is_kb ||
+		    (rep->len > BT_HIDS_BOOT_KB_INPUT_REP_LEN)) {
+			return -EINVAL;
+		}
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+static struct bt_gatt_attr *batch_rep_attr(struct bt_hids *hids_obj,
+					   const struct bt_hids_batch_rep *rep)
+{
+	uint8_t att_ind;
+
+	switch (rep->type) {
+	case BT_HIDS_BATCH_REP_INPUT:
+		att_ind = hids_obj->inp_rep_group.reports[rep->rep_index].att_ind;
+		break;
+	case BT_HIDS_BATCH_REP_BOOT_MOUSE:
+		att_ind = hids_obj->boot_mouse_inp_rep.att_ind;
+		break;
+	default:
+		att_ind = hids_obj->boot_kb_inp_rep.att_ind;
+		break;
+	}
+
+	return &hids_obj->gp.svc.attrs[att_ind];
+}
+
+static int batch_notify(struct bt_hids *hids_obj, struct bt_conn *conn,
+			struct bt_hids_conn_data *conn_data,
+			const struct bt_hids_batch_rep *reps, size_t rep_cnt,
+			bt_gatt_complete_func_t cb)
+{
+	struct bt_gatt_notify_params params[BT_HIDS_BATCH_REP_MAX];
+	/* Boot reports are sent from copies, see batch_rep_check() */
+	uint8_t mouse_rep_buff[BT_HIDS_BOOT_MOUSE_REP_LEN];
+	uint8_t kb_rep_buff[BT_HIDS_BOOT_KB_INPUT_REP_LEN] = {0};
+	uint16_t cnt = 0;
+
+	k_mutex_lock(&rep_ctx_lock, K_FOREVER);
+
+	for (size_t i = 0; i < rep_cnt; i++) {
+		const struct bt_hids_batch_rep *rep = &reps[i];
+		struct bt_gatt_attr *rep_attr = batch_rep_attr(hids_obj, rep);
+		struct bt_gatt_notify_params *p = &params[cnt];
+		uint8_t *rep_data;
+
+		if (!bt_gatt_is_subscribed(conn, rep_attr,
+					   BT_GATT_CCC_NOTIFY)) {
+			continue;
+		}
+
+		memset(p, 0, sizeof(*p));
+		p->attr = rep_attr;
+
+		switch (rep->type) {
+		case BT_HIDS_BATCH_REP_INPUT: {
+			struct bt_hids_inp_rep *hids_inp_rep =
+			    &hids_obj->inp_rep_group.reports[rep->rep_index];
+
+			rep_data = conn_data->inp_rep_ctx +
+				   hids_inp_rep->offset;
+			store_input_report(hids_inp_rep, rep_data, rep->data,
+					   rep->len);
+
+			p->data = rep->data;
+			p->len = hids_inp_rep->size;
+			break;
+		}
+		case BT_HIDS_BATCH_REP_BOOT_MOUSE:
+			rep_data = conn_data->hids_boot_mouse_inp_rep_ctx;
+			memcpy(rep_data, rep->data, rep->len);
+			memcpy(mouse_rep_buff, rep_data, sizeof(mouse_rep_buff));
+
+			/* Movement is relative, only the buttons state
+			 * is kept.
+			 */
+			rep_data[1] = 0;
+			rep_data[2] = 0;
+
+			p->data = mouse_rep_buff;
+			p->len = sizeof(mouse_rep_buff);
+			break;
+		default:
+			memcpy(kb_rep_buff, rep->data, rep->len);
+			memcpy(conn_data->hids_boot_kb_inp_rep_ctx, kb_rep_buff,
+			       sizeof(kb_rep_buff));
+
+			p->data = kb_rep_buff;
+			p->len = sizeof(kb_rep_buff);
+			break;
+		}
+
+		cnt++;
+	}
+
+	k_mutex_unlock(&rep_ctx_lock);
+
+	if (cnt == 0) {
+		return -ENODATA;
+	}
+
+	/* Notifications on a connection are sent in order, so the callback
+	 * of the last one tells that the whole batch is sent.
+	 */
+	params[cnt - 1].func = cb;
+
+	return bt_gatt_notify_multiple(conn, cnt, params);
+}
+
+struct batch_notify_data {
+	struct bt_hids *hids_obj;
+	const struct bt_hids_batch_rep *reps;
+	size_t rep_cnt;
+	bt_gatt_complete_func_t cb;
+	bool sent;
+	int err;
+};
+
+static void batch_result_update(struct batch_notify_data *batch, int err)
+{
+	if (!err) {
+		batch->sent = true;
+	} else if ((err != -ENODATA) && !batch->err) {
+		batch->err = err;
+	}
+}
+
+static void batch_notify_ctx(const struct bt_conn_ctx *ctx, void *user_data)
+{
+	struct batch_notify_data *batch = user_data;
+
+	batch_result_update(batch, batch_notify(batch->hids_obj, ctx->conn,
+						ctx->data, batch->reps,
+						batch->rep_cnt, batch->cb));
+}
+
+int bt_hids_inp_rep_send_batch(struct bt_hids *hids_obj,
+			       struct bt_conn **conns, size_t conn_cnt,
+			       const struct bt_hids_batch_rep *reps,
+			       size_t rep_cnt, bt_gatt_complete_func_t cb)
+{
+	bool boot_mouse = false;
+	bool boot_kb = false;
+	int err;
+
+	if (!reps || (rep_cnt == 0) || (rep_cnt > BT_HIDS_BATCH_REP_MAX)) {
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < rep_cnt; i++) {
+		err = batch_rep_check(hids_obj, &reps[i]);
+		if (err) {
+			return err;
+		}
+
+		/* Boot reports are notified from the connection context,
+		 * so each of them can be sent only once in a batch.
+		 */
+		if (reps[i].type == BT_HIDS_BATCH_REP_BOOT_MOUSE) {
+			if (boot_mouse) {
+				return -EINVAL;
+			}
+			boot_mouse = true;
+		} else if (reps[i].type == BT_HIDS_BATCH_REP_BOOT_KB) {
+			if (boot_kb) {
+				return -EINVAL;
+			}
+			boot_kb = true;
+		}
+	}
+
+	struct batch_notify_data batch = {
+		.hids_obj = hids_obj,
+		.reps = reps,
+		.rep_cnt = rep_cnt,
+		.cb = cb,
+	};
+
+	if (!conns) {
+		(void)bt_conn_ctx_foreach(hids_obj->conn_ctx, batch_notify_ctx,
+					  &batch);
+	} else {
+		for (size_t i = 0; i < conn_cnt; i++) {
+			struct bt_hids_conn_data *conn_data =
+				bt_conn_ctx_get(hids_obj->conn_ctx, conns[i]);
+
+			if (!conn_data) {
+				LOG_WRN("The context was not found");
+				if (!batch.err) {
+					batch.err = -EINVAL;
+				}
+				continue;
+			}
+
+			batch_result_update(&batch,
+					    batch_notify(hids_obj, conns[i],
+							 conn_data, reps,
+							 rep_cnt, cb));
+
+			bt_conn_ctx_release(hids_obj->conn_ctx,
+					    (void *)conn_data);
+		}
+	}
+
+	if (batch.err) {
+		return batch.err;
+	}
+
+	return batch.sent ? 0 : -ENODATA;
+}
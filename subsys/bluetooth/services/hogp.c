@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
  */
 #include <kernel.h>
+#include <bluetooth/bluetooth.h>
 #include <bluetooth/conn.h>
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt.h>
@@ -13,6 +14,11 @@
 #include <logging/log.h>
 #include <sys/byteorder.h>
 
+#if defined(CONFIG_BT_HOGP_CACHE)
+#include <stdlib.h>
+#include <settings/settings.h>
+#endif
+
 LOG_MODULE_REGISTER(hogp, CONFIG_BT_HOGP_LOG_LEVEL);
 
 /* Real report structure definition */
@@ -239,6 +245,309 @@ static uint16_t chrc_value_handle_by_uuid(struct bt_gatt_dm *dm,
 	return gatt_desc->handle;
 }
 
+#if defined(CONFIG_BT_HOGP_CACHE)
+/* Cached data of a bonded server. Stored persistently as it is. */
+struct cache_data {
+	bt_addr_le_t addr;
+	uint8_t db_hash[BT_HOGP_DB_HASH_SIZE];
+	struct bt_hids_info info_val;
+	uint16_t info_handle;
+	uint16_t rep_map_handle;
+	uint8_t rep_count;
+	struct {
+		uint16_t ref_handle;
+		uint8_t id;
+	} reps[CONFIG_BT_HOGP_REPORTS_MAX];
+	bool map_complete;
+	uint16_t map_len;
+	uint8_t map[CONFIG_BT_HOGP_CACHE_MAP_SIZE];
+};
+
+struct bt_hogp_cache {
+	struct cache_data data;
+	/** HOGP object using the entry. */
+	struct bt_hogp *hogp;
+	bool valid;
+};
+
+static struct bt_hogp_cache cache[CONFIG_BT_HOGP_CACHE_PEERS];
+
+static bool peer_bonded(struct bt_conn *conn)
+{
+	struct bt_conn_info info;
+
+	if (bt_conn_get_info(conn, &info)) {
+		return false;
+	}
+
+	return bt_addr_le_is_bonded(info.id, bt_conn_get_dst(conn));
+}
+
+static struct bt_hogp_cache *cache_find(const bt_addr_le_t *addr)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache[i].valid && !cache[i].hogp &&
+		    !bt_addr_le_cmp(&cache[i].data.addr, addr)) {
+			return &cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+static struct bt_hogp_cache *cache_alloc(const bt_addr_le_t *addr)
+{
+	struct bt_hogp_cache *entry = cache_find(addr);
+
+	for (size_t i = 0; !entry && (i < ARRAY_SIZE(cache)); i++) {
+		if (!cache[i].valid) {
+			entry = &cache[i];
+		}
+	}
+	/* Replace the data of a peer that is not connected */
+	for (size_t i = 0; !entry && (i < ARRAY_SIZE(cache)); i++) {
+		if (!cache[i].hogp) {
+			entry = &cache[i];
+		}
+	}
+
+	if (entry) {
+		memset(entry, 0, sizeof(*entry));
+		bt_addr_le_copy(&entry->data.addr, addr);
+	}
+
+	return entry;
+}
+
+static void cache_store(struct bt_hogp_cache *entry)
+{
+	if (!IS_ENABLED(CONFIG_BT_HOGP_CACHE_STORE)) {
+		return;
+	}
+
+	char key[] = "bt/hogp/xxx";
+	int err;
+
+	snprintk(key, sizeof(key), "bt/hogp/%u",
+		 (unsigned int)(entry - &cache[0]));
+	err = settings_save_one(key, &entry->data, sizeof(entry->data));
+	if (err) {
+		LOG_ERR("Cannot store cached data (err: %d)", err);
+	}
+}
+
+/**
+ * @brief Restore the server data from the cache
+ *
+ * The data is used only if the peer is bonded, its Database Hash did not
+ * change and the handles found during the discovery match the cached ones.
+ *
+ * @param hogp HOGP object.
+ *
+ * @return True if the data was restored.
+ */
+static bool cache_restore(struct bt_hogp *hogp)
+{
+	struct bt_hogp_cache *entry = cache_find(bt_conn_get_dst(hogp->conn));
+	struct cache_data *data;
+
+	if (!entry || !peer_bonded(hogp->conn)) {
+		return false;
+	}
+
+	entry->hogp = hogp;
+	hogp->cache = entry;
+	data = &entry->data;
+
+	bool match = hogp->db_hash_valid &&
+		     !memcmp(data->db_hash, hogp->db_hash,
+			     sizeof(data->db_hash)) &&
+		     (data->info_handle == hogp->handlers.info) &&
+		     (data->rep_map_handle == hogp->handlers.rep_map) &&
+		     (data->rep_count == hogp->rep_count);
+
+	for (size_t i = 0; match && (i < hogp->rep_count); i++) {
+		match = (data->reps[i].ref_handle ==
+			 hogp->rep_info[i]->handlers.ref);
+	}
+
+	if (!match) {
+		LOG_DBG("Cached data does not match the server");
+		entry->valid = false;
+		entry->data.map_complete = false;
+		return false;
+	}
+
+	hogp->info_val = data->info_val;
+	for (size_t i = 0; i < hogp->rep_count; i++) {
+		hogp->rep_info[i]->ref.id = data->reps[i].id;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Update the cache when the client is ready
+ *
+ * @param hogp HOGP object.
+ */
+static void cache_update(struct bt_hogp *hogp)
+{
+	struct bt_hogp_cache *entry = hogp->cache;
+	struct cache_data *data;
+
+	if (!entry) {
+		/* Without the Database Hash, the data could not be validated
+		 * on the next connection.
+		 */
+		if (!peer_bonded(hogp->conn) || !hogp->db_hash_valid) {
+			return;
+		}
+		entry = cache_alloc(bt_conn_get_dst(hogp->conn));
+		if (!entry) {
+			LOG_WRN("No free cache entry");
+			return;
+		}
+		entry->hogp = hogp;
+		hogp->cache = entry;
+	}
+
+	if (entry->valid) {
+		/* Restored from the cache */
+		return;
+	}
+
+	if (!hogp->db_hash_valid) {
+		return;
+	}
+
+	data = &entry->data;
+	memcpy(data->db_hash, hogp->db_hash, sizeof(data->db_hash));
+	data->info_val = hogp->info_val;
+	data->info_handle = hogp->handlers.info;
+	data->rep_map_handle = hogp->handlers.rep_map;
+	data->rep_count = hogp->rep_count;
+	for (size_t i = 0; i < hogp->rep_count; i++) {
+		data->reps[i].ref_handle = hogp->rep_info[i]->handlers.ref;
+		data->reps[i].id = hogp->rep_info[i]->ref.id;
+	}
+	data->map_complete = false;
+	data->map_len = 0;
+	entry->valid = true;
+
+	cache_store(entry);
+}
+
+/**
+ * @brief Add a chunk of the report map read from the server to the cache
+ *
+ * Only a map read from the beginning in consecutive chunks is cached.
+ * The map is complete when a chunk shorter than the maximum is received.
+ *
+ * @param hogp   HOGP object.
+ * @param data   Chunk data.
+ * @param length Chunk size.
+ * @param offset Chunk offset.
+ */
+static void cache_map_append(struct bt_hogp *hogp, const uint8_t *data,
+			     uint16_t length, size_t offset)
+{
+	struct bt_hogp_cache *entry = hogp->cache;
+	struct cache_data *cdata;
+
+	if (!entry || !entry->valid || entry->data.map_complete) {
+		return;
+	}
+
+	cdata = &entry->data;
+	if ((offset != cdata->map_len) ||
+	    (length > sizeof(cdata->map) - offset)) {
+		return;
+	}
+
+	memcpy(&cdata->map[offset], data, length);
+	cdata->map_len += length;
+
+	if (length < bt_gatt_get_mtu(hogp->conn) - 1) {
+		LOG_DBG("Report map cached (size: %u)", cdata->map_len);
+		cdata->map_complete = true;
+		cache_store(entry);
+	}
+}
+
+static void cache_release(struct bt_hogp *hogp)
+{
+	/* A map read waiting for the work holds the read parameters. */
+	if ((k_work_busy_get(&hogp->map_work) & K_WORK_QUEUED) &&
+	    (k_work_cancel(&hogp->map_work) == 0)) {
+		k_sem_give(&hogp->read_params_sem);
+	}
+
+	if (hogp->cache) {
+		hogp->cache->hogp = NULL;
+		hogp->cache = NULL;
+	}
+	hogp->db_hash_valid = false;
+}
+
+static void map_work_handler(struct k_work *work)
+{
+	struct bt_hogp *hogp = CONTAINER_OF(work, struct bt_hogp, map_work);
+	size_t offset = hogp->read_params.single.offset;
+	bt_hogp_map_cb map_cb = hogp->map_cb;
+	const struct cache_data *cdata;
+	const uint8_t *data = NULL;
+	size_t size = 0;
+
+	if (!hogp->cache || !map_cb) {
+		return;
+	}
+
+	cdata = &hogp->cache->data;
+	if (offset < cdata->map_len) {
+		data = &cdata->map[offset];
+		size = MIN(cdata->map_len - offset,
+			   bt_gatt_get_mtu(hogp->conn) - 1);
+	}
+
+	k_sem_give(&hogp->read_params_sem);
+	map_cb(hogp, 0, data, size, offset);
+}
+
+#if defined(CONFIG_BT_HOGP_CACHE_STORE)
+static int cache_settings_set(const char *key, size_t len,
+			      settings_read_cb read_cb, void *cb_arg)
+{
+	struct bt_hogp_cache *entry;
+	ssize_t size;
+	uint32_t index = atoi(key);
+
+	if (index >= ARRAY_SIZE(cache)) {
+		return -ENOMEM;
+	}
+
+	entry = &cache[index];
+	if (len != sizeof(entry->data)) {
+		/* Deleted entry, or stored with a different configuration */
+		entry->valid = false;
+		return 0;
+	}
+
+	size = read_cb(cb_arg, &entry->data, sizeof(entry->data));
+	if (size < (ssize_t)sizeof(entry->data)) {
+		return -EINVAL;
+	}
+
+	entry->valid = true;
+
+	return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(bt_hogp, "bt/hogp", NULL, cache_settings_set,
+			       NULL, NULL);
+#endif /* defined(CONFIG_BT_HOGP_CACHE_STORE) */
+#endif /* defined(CONFIG_BT_HOGP_CACHE) */
+
 /**
  * @brief Mark hids ready to work
  *
@@ -249,6 +558,14 @@ static uint16_t chrc_value_handle_by_uuid(struct bt_gatt_dm *dm,
  */
 static void hids_mark_ready(struct bt_hogp *hogp)
 {
+	hogp->prep_stats.latency_ms = k_uptime_get_32() - hogp->prep_start;
+	LOG_DBG("Ready in %u ms, %u read(s)", hogp->prep_stats.latency_ms,
+		hogp->prep_stats.reads);
+
+#if defined(CONFIG_BT_HOGP_CACHE)
+	cache_update(hogp);
+#endif
+
 	k_sem_give(&hogp->read_params_sem);
 	hogp->ready = true;
 	if (hogp->ready_cb) {
@@ -273,6 +590,109 @@ static void hids_prep_error(struct bt_hogp *hogp, int err)
 	}
 }
 
+/**
+ * @brief Read a value during the preparation
+ *
+ * @param hogp   HOGP object.
+ * @param func   Read callback.
+ * @param handle Handle of the value.
+ *
+ * @return 0 or negative error value.
+ */
+static int prep_read(struct bt_hogp *hogp, bt_gatt_read_func_t func,
+		     uint16_t handle)
+{
+	hogp->read_params.func = func;
+	hogp->read_params.handle_count  = 1;
+	hogp->read_params.single.handle = handle;
+	hogp->read_params.single.offset = 0;
+	hogp->prep_stats.reads++;
+	return bt_gatt_read(hogp->conn, &(hogp->read_params));
+}
+
+/**
+ * @brief Process the protocol mode value
+ *
+ * @param hogp   HOGP object.
+ * @param data   Pointer to the data buffer.
+ * @param length The size of the data.
+ *
+ * @return 0 or negative error value.
+ */
+static int pm_parse(struct bt_hogp *hogp, const uint8_t *data,
+		    uint16_t length)
+{
+	if (length != 1 || !data) {
+		LOG_ERR("Unexpected PM size");
+		return -ENOTSUP;
+	}
+
+	hogp->pm = (enum bt_hids_pm)data[0];
+	LOG_DBG("Read PM success: %d", (int)hogp->pm);
+	return 0;
+}
+
+/**
+ * @brief Process the report reference value
+ *
+ * @param hogp    HOGP object.
+ * @param rep_idx Index in the report array.
+ * @param data    Pointer to the data buffer.
+ * @param length  The size of the data.
+ *
+ * @return 0 or negative error value.
+ */
+static int repref_parse(struct bt_hogp *hogp, size_t rep_idx,
+			const uint8_t *data, uint16_t length)
+{
+	struct bt_hogp_rep_info *rep;
+
+	if (length != 2 || !data) {
+		LOG_ERR("Report (idx: %u) reference unexpected size (%u)",
+			rep_idx, length);
+		return -ENOTSUP;
+	}
+
+	rep = hogp->rep_info[rep_idx];
+	if ((uint8_t)rep->ref.type != data[1]) {
+		LOG_ERR("Unexpected report type (%u while expecting %u)",
+			data[1], rep->ref.type);
+		return -EINVAL;
+	}
+	rep->ref.id = data[0];
+	LOG_DBG("Report reference read (idx: %u, id: %u)",
+		rep_idx, rep->ref.id);
+	return 0;
+}
+
+/**
+ * @brief Process the HID information value
+ *
+ * @param hogp   HOGP object.
+ * @param data   Pointer to the data buffer.
+ * @param length The size of the data.
+ *
+ * @return 0 or negative error value.
+ */
+static int hid_info_parse(struct bt_hogp *hogp, const uint8_t *data,
+			  uint16_t length)
+{
+	if (length != 4 || !data) {
+		LOG_ERR("Unexpected HID information size: %u", length);
+		return -ENOTSUP;
+	}
+
+	hogp->info_val.bcd_hid = sys_get_le16(&data[0]);
+	hogp->info_val.b_country_code = data[2];
+	hogp->info_val.flags = data[3];
+
+	LOG_DBG("HID information success:");
+	LOG_DBG("  bcdHID: %x", hogp->info_val.bcd_hid);
+	LOG_DBG("  bCountryCode: 0x%x", hogp->info_val.b_country_code);
+	LOG_DBG("  Flags: 0x%x", hogp->info_val.flags);
+	return 0;
+}
+
 /**
  * @brief Process protocol mode read
  *
@@ -315,11 +735,7 @@ static int pm_read_start(struct bt_hogp *hogp)
 		return 0;
 	}
 	LOG_DBG("PM read start");
-	hogp->read_params.func = pm_read_process;
-	hogp->read_params.handle_count  = 1;
-	hogp->read_params.single.handle = hogp->handlers.pm;
-	hogp->read_params.single.offset = 0;
-	err = bt_gatt_read(hogp->conn, &(hogp->read_params));
+	err = prep_read(hogp, pm_read_process, hogp->handlers.pm);
 	if (err) {
 		LOG_ERR("PM read error (err: %d)", err);
 		return err;
@@ -332,6 +748,7 @@ static uint8_t pm_read_process(struct bt_conn *conn, uint8_t err,
 			    const void *data, uint16_t length)
 {
 	struct bt_hogp *hogp;
+	int ret;
 
 	hogp = CONTAINER_OF(params, struct bt_hogp, read_params);
 
@@ -340,14 +757,13 @@ static uint8_t pm_read_process(struct bt_conn *conn, uint8_t err,
 		hids_prep_error(hogp, err);
 		return BT_GATT_ITER_STOP;
 	}
-	if (length != 1 || !data) {
-		LOG_ERR("Unexpected PM size");
-		hids_prep_error(hogp, -ENOTSUP);
+
+	ret = pm_parse(hogp, data, length);
+	if (ret) {
+		hids_prep_error(hogp, ret);
 		return BT_GATT_ITER_STOP;
 	}
 
-	hogp->pm = (enum bt_hids_pm)((uint8_t *)data)[0];
-	LOG_DBG("Read PM success: %d", (int)hogp->pm);
 	hids_mark_ready(hogp);
 	return BT_GATT_ITER_STOP;
 }
@@ -398,11 +814,7 @@ static int repref_read_start(struct bt_hogp *hogp, size_t rep_idx)
 	LOG_DBG("Report (id: %u) reference read start", rep_idx);
 	rep = hogp->rep_info[rep_idx];
 	hogp->init_repref.rep_idx = rep_idx;
-	hogp->read_params.func = repref_read_process;
-	hogp->read_params.handle_count  = 1;
-	hogp->read_params.single.handle = rep->handlers.ref;
-	hogp->read_params.single.offset = 0;
-	err = bt_gatt_read(hogp->conn, &(hogp->read_params));
+	err = prep_read(hogp, repref_read_process, rep->handlers.ref);
 	if (err) {
 		LOG_ERR("Report reference read error (err: %d)", err);
 		return err;
@@ -416,9 +828,7 @@ static uint8_t repref_read_process(struct bt_conn *conn, uint8_t err,
 {
 	int ret;
 	struct bt_hogp *hogp;
-	struct bt_hogp_rep_info *rep;
 	size_t rep_idx;
-	const uint8_t *bdata = data;
 
 	hogp = CONTAINER_OF(params, struct bt_hogp, read_params);
 
@@ -431,24 +841,12 @@ static uint8_t repref_read_process(struct bt_conn *conn, uint8_t err,
 		hids_prep_error(hogp, err);
 		return BT_GATT_ITER_STOP;
 	}
-	if (length != 2 || !data) {
-		LOG_ERR("Report (idx: %u) reference unexpected size (%u)",
-			rep_idx, length);
-		hids_prep_error(hogp, -ENOTSUP);
-		return BT_GATT_ITER_STOP;
-	}
 
-	rep = hogp->rep_info[rep_idx];
-	if ((uint8_t)rep->ref.type != bdata[1]) {
-		LOG_ERR("Unexpected report type (%u while expecting %u)",
-			bdata[1], rep->ref.type);
-		hids_prep_error(hogp, -EINVAL);
+	ret = repref_parse(hogp, rep_idx, data, length);
+	if (ret) {
+		hids_prep_error(hogp, ret);
 		return BT_GATT_ITER_STOP;
 	}
-	rep->ref.id = bdata[0];
-	LOG_DBG("Report reference read (idx: %u, id: %u)",
-		rep_idx, rep->ref.id);
-
 
 	/* Next */
 	ret = repref_read_start(hogp, rep_idx + 1);
@@ -489,11 +887,7 @@ static int hid_info_read_start(struct bt_hogp *hogp)
 		return -EINVAL;
 	}
 	LOG_DBG("HID information read start");
-	hogp->read_params.func = hid_info_read_process;
-	hogp->read_params.handle_count  = 1;
-	hogp->read_params.single.handle = hogp->handlers.info;
-	hogp->read_params.single.offset = 0;
-	err = bt_gatt_read(hogp->conn, &(hogp->read_params));
+	err = prep_read(hogp, hid_info_read_process, hogp->handlers.info);
 	if (err) {
 		LOG_ERR("HID information read error (err: %d)", err);
 		return err;
@@ -506,7 +900,7 @@ static uint8_t hid_info_read_process(struct bt_conn *conn, uint8_t err,
 				   const void *data, uint16_t length)
 {
 	struct bt_hogp *hogp;
-	const uint8_t *bdata = data;
+	int ret;
 
 	hogp = CONTAINER_OF(params, struct bt_hogp, read_params);
 
@@ -515,28 +909,333 @@ static uint8_t hid_info_read_process(struct bt_conn *conn, uint8_t err,
 		hids_prep_error(hogp, err);
 		return BT_GATT_ITER_STOP;
 	}
-	if (length != 4 || !data) {
-		LOG_ERR("Unexpected HID information size: %u", length);
-		hids_prep_error(hogp, -ENOTSUP);
+
+	ret = hid_info_parse(hogp, data, length);
+	if (ret) {
+		hids_prep_error(hogp, ret);
 		return BT_GATT_ITER_STOP;
 	}
 
-	hogp->info_val.bcd_hid = sys_get_le16(&bdata[0]);
-	hogp->info_val.b_country_code = bdata[2];
-	hogp->info_val.flags = bdata[3];
+	ret = repref_read_start(hogp, 0);
+	if (ret) {
+		hids_prep_error(hogp, ret);
+	}
 
-	LOG_DBG("HID information success:");
-	LOG_DBG("  bcdHID: %x", hogp->info_val.bcd_hid);
-	LOG_DBG("  bCountryCode: 0x%x", hogp->info_val.b_country_code);
-	LOG_DBG("  Flags: 0x%x", hogp->info_val.flags);
+	return BT_GATT_ITER_STOP;
+}
+
+#if defined(CONFIG_BT_HOGP_READ_MULTIPLE)
+/**
+ * @brief Get a value read during the preparation
+ *
+ * The values are the HID information, the report references and
+ * the protocol mode, in this order.
+ *
+ * @param hogp   HOGP object.
+ * @param idx    Index of the value.
+ * @param size   The size of the value.
+ *
+ * @return Handle of the value.
+ */
+static uint16_t prep_value_get(const struct bt_hogp *hogp, size_t idx,
+			       uint8_t *size)
+{
+	if (idx == 0) {
+		*size = BT_HIDS_INFORMATION_LEN;
+		return hogp->handlers.info;
+	}
+	if (idx <= hogp->rep_count) {
+		*size = 2;
+		return hogp->rep_info[idx - 1]->handlers.ref;
+	}
+	*size = 1;
+	return hogp->handlers.pm;
+}
+
+static size_t prep_value_count(const struct bt_hogp *hogp)
+{
+	return 1 + hogp->rep_count + ((hogp->handlers.pm != 0) ? 1 : 0);
+}
+
+/**
+ * @brief Process Read Multiple during the preparation
+ *
+ * The function is called with the response data first, and then
+ * without data when the read is complete.
+ *
+ * @param conn   Connection handler.
+ * @param err    Read ATT error code.
+ * @param params Notification parameters structure - the pointer
+ *               to the structure provided to read function.
+ * @param data   Pointer to the data buffer.
+ * @param length The size of the received data.
+ *
+ * @retval BT_GATT_ITER_STOP     Stop notification
+ * @retval BT_GATT_ITER_CONTINUE Continue notification
+ */
+static uint8_t multi_read_process(struct bt_conn *conn, uint8_t err,
+				  struct bt_gatt_read_params *params,
+				  const void *data, uint16_t length);
 
-	err = repref_read_start(hogp, 0);
+/**
+ * @brief Start Read Multiple of the preparation values
+ *
+ * Reads as many values, starting from the given one, as fit into one
+ * request and response. A single value is read with a normal read,
+ * continuing with the read chain from that value.
+ *
+ * @param hogp  See @ref bt_hogp_handles_assign.
+ * @param first Index of the first value to read.
+ *
+ * @return 0 or negative error value.
+ */
+static int multi_read_start(struct bt_hogp *hogp, size_t first)
+{
+	const size_t count = prep_value_count(hogp);
+	const uint16_t mtu = bt_gatt_get_mtu(hogp->conn);
+	size_t rsp_len = 0;
+	uint8_t cnt = 0;
+	uint8_t size;
+	int err;
+
+	if (first >= count) {
+		hids_mark_ready(hogp);
+		return 0;
+	}
+
+	/* Request: opcode and handles, response: opcode and values */
+	while ((first + cnt < count) &&
+	       (cnt < ARRAY_SIZE(hogp->init_multi.handles)) &&
+	       (1 + 2 * (cnt + 1) <= mtu)) {
+		uint16_t handle = prep_value_get(hogp, first + cnt, &size);
+
+		if (rsp_len + size > mtu - 1) {
+			break;
+		}
+		hogp->init_multi.handles[cnt++] = handle;
+		rsp_len += size;
+	}
+
+	if (cnt < 2) {
+		if (first == 0) {
+			return hid_info_read_start(hogp);
+		} else if (first <= hogp->rep_count) {
+			return repref_read_start(hogp, first - 1);
+		} else {
+			return pm_read_start(hogp);
+		}
+	}
+
+	LOG_DBG("Read Multiple start (values: %u..%u)", first,
+		first + cnt - 1);
+	hogp->init_multi.first = first;
+	hogp->init_multi.cnt = cnt;
+	hogp->init_multi.received = false;
+	hogp->init_multi.err = 0;
+	hogp->read_params.func = multi_read_process;
+	hogp->read_params.handle_count = cnt;
+	hogp->read_params.multiple.handles = hogp->init_multi.handles;
+	hogp->read_params.multiple.variable = false;
+	hogp->prep_stats.reads++;
+	err = bt_gatt_read(hogp->conn, &(hogp->read_params));
 	if (err) {
+		LOG_ERR("Read Multiple error (err: %d)", err);
+		return err;
+	}
+	return 0;
+}
+
+static int multi_read_parse(struct bt_hogp *hogp, const uint8_t *data,
+			    uint16_t length)
+{
+	const size_t first = hogp->init_multi.first;
+	size_t expected = 0;
+	uint8_t size;
+	int err = 0;
+
+	for (size_t i = 0; i < hogp->init_multi.cnt; i++) {
+		(void)prep_value_get(hogp, first + i, &size);
+		expected += size;
+	}
+
+	/* Read Multiple Response has the values without their lengths */
+	if (length != expected) {
+		LOG_ERR("Unexpected Read Multiple size (%u while expecting %u)",
+			length, expected);
+		return -ENOTSUP;
+	}
+
+	for (size_t i = 0; !err && (i < hogp->init_multi.cnt); i++) {
+		size_t idx = first + i;
+
+		(void)prep_value_get(hogp, idx, &size);
+		if (idx == 0) {
+			err = hid_info_parse(hogp, data, size);
+		} else if (idx <= hogp->rep_count) {
+			err = repref_parse(hogp, idx - 1, data, size);
+		} else {
+			err = pm_parse(hogp, data, size);
+		}
+		data += size;
+	}
+
+	return err;
+}
+
+static uint8_t multi_read_process(struct bt_conn *conn, uint8_t err,
+				  struct bt_gatt_read_params *params,
+				  const void *data, uint16_t length)
+{
+	struct bt_hogp *hogp;
+	int ret;
+
+	hogp = CONTAINER_OF(params, struct bt_hogp, read_params);
+
+	if (err) {
+		if ((err == BT_ATT_ERR_NOT_SUPPORTED) &&
+		    (hogp->init_multi.first == 0)) {
+			LOG_DBG("Read Multiple not supported by the server");
+			ret = hid_info_read_start(hogp);
+			if (ret) {
+				hids_prep_error(hogp, ret);
+			}
+			return BT_GATT_ITER_STOP;
+		}
+		LOG_ERR("Read Multiple error (err: %d)", err);
 		hids_prep_error(hogp, err);
+		return BT_GATT_ITER_STOP;
+	}
+
+	if (data) {
+		/* The next call, without data, ends the read. The parameters
+		 * must not be reused before that.
+		 */
+		hogp->init_multi.received = true;
+		hogp->init_multi.err = multi_read_parse(hogp, data, length);
+		return BT_GATT_ITER_CONTINUE;
+	}
+
+	ret = hogp->init_multi.received ? hogp->init_multi.err : -ENOTSUP;
+	if (!ret) {
+		ret = multi_read_start(hogp, hogp->init_multi.first +
+					     hogp->init_multi.cnt);
+	}
+	if (ret) {
+		hids_prep_error(hogp, ret);
 	}
 
 	return BT_GATT_ITER_STOP;
 }
+#endif /* defined(CONFIG_BT_HOGP_READ_MULTIPLE) */
+
+/**
+ * @brief Start reading the data required for HIDS client from the server
+ *
+ * The HID information and report references are read together with the
+ * protocol mode using Read Multiple if it is enabled, or one by one.
+ *
+ * @param hogp  See @ref bt_hogp_handles_assign.
+ *
+ * @return 0 or negative error value.
+ */
+static int server_read_start(struct bt_hogp *hogp)
+{
+#if defined(CONFIG_BT_HOGP_READ_MULTIPLE)
+	return multi_read_start(hogp, 0);
+#else
+	return hid_info_read_start(hogp);
+#endif
+}
+
+#if defined(CONFIG_BT_HOGP_CACHE)
+/**
+ * @brief Process the Database Hash read
+ *
+ * The cached data is restored if the hash matches. Otherwise, the data
+ * is read from the server. A server without the Database Hash is handled
+ * as a changed one.
+ *
+ * @param conn   Connection handler.
+ * @param err    Read ATT error code.
+ * @param params Notification parameters structure - the pointer
+ *               to the structure provided to read function.
+ * @param data   Pointer to the data buffer.
+ * @param length The size of the received data.
+ *
+ * @retval BT_GATT_ITER_STOP     Stop notification
+ * @retval BT_GATT_ITER_CONTINUE Continue notification
+ */
+static uint8_t db_hash_read_process(struct bt_conn *conn, uint8_t err,
+				    struct bt_gatt_read_params *params,
+				    const void *data, uint16_t length)
+{
+	struct bt_hogp *hogp;
+	int ret;
+
+	hogp = CONTAINER_OF(params, struct bt_hogp, read_params);
+
+	if (!err && data && (length == sizeof(hogp->db_hash))) {
+		memcpy(hogp->db_hash, data, length);
+		hogp->db_hash_valid = true;
+	} else {
+		LOG_DBG("No Database Hash (err: %u)", err);
+	}
+
+	if (cache_restore(hogp)) {
+		LOG_DBG("Server data restored from the cache");
+		hogp->prep_stats.cached = true;
+		ret = pm_read_start(hogp);
+	} else {
+		ret = server_read_start(hogp);
+	}
+	if (ret) {
+		hids_prep_error(hogp, ret);
+	}
+
+	return BT_GATT_ITER_STOP;
+}
+
+/**
+ * @brief Start the Database Hash read
+ *
+ * @param hogp  See @ref bt_hogp_handles_assign.
+ *
+ * @return 0 or negative error value.
+ */
+static int db_hash_read_start(struct bt_hogp *hogp)
+{
+	LOG_DBG("Database Hash read start");
+	hogp->db_hash_valid = false;
+	hogp->read_params.func = db_hash_read_process;
+	hogp->read_params.handle_count = 0;
+	hogp->read_params.by_uuid.start_handle = BT_ATT_FIRST_ATTTRIBUTE_HANDLE;
+	hogp->read_params.by_uuid.end_handle = BT_ATT_LAST_ATTTRIBUTE_HANDLE;
+	hogp->read_params.by_uuid.uuid = BT_UUID_GATT_DB_HASH;
+	hogp->prep_stats.reads++;
+	return bt_gatt_read(hogp->conn, &(hogp->read_params));
+}
+#endif /* defined(CONFIG_BT_HOGP_CACHE) */
+
+/**
+ * @brief Start reading the data required for HIDS client to work
+ *
+ * For a bonded server, the Database Hash is read first, to check if
+ * the cached data can be used.
+ *
+ * @param hogp  See @ref bt_hogp_handles_assign.
+ *
+ * @return 0 or negative error value.
+ */
+static int prep_read_start(struct bt_hogp *hogp)
+{
+#if defined(CONFIG_BT_HOGP_CACHE)
+	if (peer_bonded(hogp->conn)) {
+		return db_hash_read_start(hogp);
+	}
+#endif
+
+	return server_read_start(hogp);
+}
 
 /**
  * @brief Start anything that should be started after discovery
@@ -559,7 +1258,10 @@ static int post_discovery_start(struct bt_hogp *hogp)
 		return err;
 	}
 
-	err = hid_info_read_start(hogp);
+	hogp->prep_start = k_uptime_get_32();
+	memset(&hogp->prep_stats, 0, sizeof(hogp->prep_stats));
+
+	err = prep_read_start(hogp);
 	if (err) {
 		k_sem_give(&hogp->read_params_sem);
 		return err;
@@ -762,6 +1464,9 @@ void bt_hogp_init(struct bt_hogp *hogp,
 	hogp->prep_error_cb = params->prep_error_cb;
 	hogp->pm_update_cb  = params->pm_update_cb;
 	k_sem_init(&hogp->read_params_sem, 1, 1);
+#if defined(CONFIG_BT_HOGP_CACHE)
+	k_work_init(&hogp->map_work, map_work_handler);
+#endif
 }
 
 int bt_hogp_handles_assign(struct bt_gatt_dm *dm,
@@ -800,6 +1505,10 @@ void bt_hogp_release(struct bt_hogp *hogp)
 	LOG_DBG("Report memory released, entities used: %u",
 		k_mem_slab_num_used_get(&bt_hogp_reports_mem));
 
+#if defined(CONFIG_BT_HOGP_CACHE)
+	cache_release(hogp);
+#endif
+
 	memset(&hogp->info_val, 0, sizeof(hogp->info_val));
 	memset(&hogp->handlers, 0, sizeof(hogp->handlers));
 	hogp->map_cb  = NULL;
@@ -823,6 +1532,12 @@ bool bt_hogp_ready_check(const struct bt_hogp *hogp)
 	return hogp->ready;
 }
 
+const struct bt_hogp_prep_stats *bt_hogp_prep_stats_get(
+	const struct bt_hogp *hogp)
+{
+	return &hogp->prep_stats;
+}
+
 /**
  * @brief Process report read
  *
@@ -1108,6 +1823,11 @@ static uint8_t map_read_process(struct bt_conn *conn, uint8_t err,
 	}
 
 	offset = hogp->read_params.single.offset;
+#if defined(CONFIG_BT_HOGP_CACHE)
+	if (!err) {
+		cache_map_append(hogp, data, length, offset);
+	}
+#endif
 	k_sem_give(&hogp->read_params_sem);
 	hogp->map_cb(hogp, err, data, length, offset);
 	return BT_GATT_ITER_STOP;
@@ -1129,6 +1849,14 @@ int bt_hogp_map_read(struct bt_hogp *hogp,
 		return err;
 	}
 	hogp->map_cb = func;
+#if defined(CONFIG_BT_HOGP_CACHE)
+	if (hogp->cache && hogp->cache->valid &&
+	    hogp->cache->data.map_complete) {
+		hogp->read_params.single.offset = offset;
+		k_work_submit(&hogp->map_work);
+		return 0;
+	}
+#endif
 	hogp->read_params.func = map_read_process;
 	hogp->read_params.handle_count  = 1;
 	hogp->read_params.single.handle = hogp->handlers.rep_map;
@@ -23,15 +23,22 @@
 #define MODULE buttons
 #include <caf/events/module_state_event.h>
 
+#include "buttons_debounce.h"
+
 #include <logging/log.h>
 LOG_MODULE_REGISTER(MODULE, CONFIG_CAF_BUTTONS_LOG_LEVEL);
 
 #define SCAN_INTERVAL CONFIG_CAF_BUTTONS_SCAN_INTERVAL
+#define SCAN_INTERVAL_MAX CONFIG_CAF_BUTTONS_SCAN_INTERVAL_MAX
 #define DEBOUNCE_INTERVAL CONFIG_CAF_BUTTONS_DEBOUNCE_INTERVAL
 
 /* For directly connected GPIO, scan rows once. */
 #define COLUMNS MAX(ARRAY_SIZE(col), 1)
 
+BUILD_ASSERT(ARRAY_SIZE(row) <= 32, "Too many rows");
+BUILD_ASSERT(SCAN_INTERVAL_MAX >= SCAN_INTERVAL,
+	     "Maximum scan interval shorter than scan interval");
+
 enum state {
 	STATE_IDLE,
 	STATE_ACTIVE,
@@ -39,39 +46,104 @@ enum state {
 	STATE_SUSPENDING
 };
 
+enum col_state {
+	COL_UNKNOWN,
+	COL_INPUT,
+	COL_ACTIVE,
+	COL_INACTIVE
+};
+
 static const struct device *gpio_devs[ARRAY_SIZE(port_map)];
 static struct gpio_callback gpio_cb[ARRAY_SIZE(port_map)];
+static uint32_t row_pin_mask[ARRAY_SIZE(port_map)];
+static enum col_state col_state[MAX(ARRAY_SIZE(col), 1)];
 static struct k_work_delayable matrix_scan;
 static struct k_work_delayable button_pressed;
 static enum state state;
+static uint32_t scan_interval = SCAN_INTERVAL;
+static uint32_t last_scan_time;
+
+static const struct buttons_debounce_config debounce_config = {
+	.press_ms = CONFIG_CAF_BUTTONS_DEBOUNCE_PRESS,
+	.release_ms = CONFIG_CAF_BUTTONS_DEBOUNCE_RELEASE,
+	.event_limit = CONFIG_CAF_BUTTONS_EVENT_LIMIT,
+};
+
+BUTTONS_DEBOUNCE_DEFINE(debounce, &debounce_config, COLUMNS, ARRAY_SIZE(row));
 
 
 static void scan_fn(struct k_work *work);
 
 
+static int set_col(size_t i, enum col_state new_state, bool configure)
+{
+	const struct device *dev = gpio_devs[col[i].port];
+	int err;
+
+	if (new_state == COL_INPUT) {
+		err = gpio_pin_configure(dev, col[i].pin, GPIO_INPUT);
+	} else {
+		uint32_t val = (new_state == COL_ACTIVE) ? (1) : (0);
+
+		if (IS_ENABLED(CONFIG_CAF_BUTTONS_POLARITY_INVERSED)) {
+			val = !val;
+		}
+
+		err = 0;
+		if (configure) {
+			err = gpio_pin_configure(dev, col[i].pin, GPIO_OUTPUT);
+		}
+		if (!err) {
+			err = gpio_pin_set_raw(dev, col[i].pin, val);
+		}
+	}
+
+	return err;
+}
+
 static int set_cols(uint32_t mask)
 {
 	for (size_t i = 0; i < ARRAY_SIZE(col); i++) {
-		uint32_t val = (mask & BIT(i)) ? (1) : (0);
-		int err;
-
-		if (val || !mask) {
-			if (IS_ENABLED(CONFIG_CAF_BUTTONS_POLARITY_INVERSED)) {
-				val = !val;
-			}
+		enum col_state new_state;
 
-			err = gpio_pin_configure(gpio_devs[col[i].port],
-						 col[i].pin, GPIO_OUTPUT);
-			if (!err) {
-				err = gpio_pin_set_raw(gpio_devs[col[i].port],
-						       col[i].pin, val);
-			}
+		if (mask & BIT(i)) {
+			new_state = COL_ACTIVE;
+		} else if (!mask) {
+			new_state = COL_INACTIVE;
 		} else {
-			err = gpio_pin_configure(gpio_devs[col[i].port],
-						 col[i].pin, GPIO_INPUT);
+			new_state = COL_INPUT;
 		}
 
-		if (err) {
+		/* Only touch the pins that change, a matrix scan switches
+		 * two columns at a time.
+		 */
+		if (new_state == col_state[i]) {
+			continue;
+		}
+
+		bool configure = (col_state[i] != COL_ACTIVE) &&
+				 (col_state[i] != COL_INACTIVE);
+
+		if (set_col(i, new_state, configure)) {
+			LOG_ERR("Cannot set pin");
+			col_state[i] = COL_UNKNOWN;
+			return -EFAULT;
+		}
+
+		col_state[i] = new_state;
+	}
+
+	return 0;
+}
+
+static int reset_cols_isr(void)
+{
+	/* Called from the interrupt that may preempt set_cols. The pins are
+	 * reconfigured without the cache, which is invalidated when callbacks
+	 * are disabled in the workqueue.
+	 */
+	for (size_t i = 0; i < ARRAY_SIZE(col); i++) {
+		if (set_col(i, COL_INACTIVE, true)) {
 			LOG_ERR("Cannot set pin");
 			return -EFAULT;
 		}
@@ -82,19 +154,28 @@ static int set_cols(uint32_t mask)
 
 static int get_rows(uint32_t *mask)
 {
-	for (size_t i = 0; i < ARRAY_SIZE(row); i++) {
-		int val = gpio_pin_get_raw(gpio_devs[row[i].port], row[i].pin);
+	gpio_port_value_t port_val[ARRAY_SIZE(port_map)] = {0};
+
+	/* Read all rows of a port at once. */
+	for (size_t i = 0; i < ARRAY_SIZE(port_map); i++) {
+		if (!row_pin_mask[i]) {
+			continue;
+		}
 
-		if (val < 0) {
-			LOG_ERR("Cannot get pin");
+		if (gpio_port_get_raw(gpio_devs[i], &port_val[i])) {
+			LOG_ERR("Cannot get port");
 			return -EFAULT;
 		}
 
 		if (IS_ENABLED(CONFIG_CAF_BUTTONS_POLARITY_INVERSED)) {
-			val = !val;
+			port_val[i] = ~port_val[i];
 		}
+	}
 
-		*mask |= (val << i);
+	for (size_t i = 0; i < ARRAY_SIZE(row); i++) {
+		if (port_val[row[i].port] & BIT(row[i].pin)) {
+			*mask |= BIT(i);
+		}
 	}
 
 	return 0;
@@ -157,6 +238,11 @@ static int callback_ctrl(bool enable)
 		 * Make sure pending work is canceled.
 		 */
 		k_work_cancel_delayable(&button_pressed);
+
+		/* The callback could have changed the column pins. */
+		for (size_t i = 0; i < ARRAY_SIZE(col_state); i++) {
+			col_state[i] = COL_UNKNOWN;
+		}
 	}
 
 	return err;
@@ -215,6 +301,29 @@ static void resume(void)
 	}
 }
 
+static void key_changed(size_t col, size_t row, bool pressed, void *user_data)
+{
+	struct button_event *event = new_button_event();
+
+	event->key_id = KEY_ID(col, row);
+	event->pressed = pressed;
+	EVENT_SUBMIT(event);
+
+	(*(size_t *)user_data)++;
+}
+
+static uint32_t next_scan_delay(bool activity, uint32_t pending_ms)
+{
+	/* Slow down scanning while the keys are held without changes. */
+	if (activity) {
+		scan_interval = SCAN_INTERVAL;
+	} else {
+		scan_interval = MIN(2 * scan_interval, SCAN_INTERVAL_MAX);
+	}
+
+	return pending_ms ? MIN(scan_interval, pending_ms) : scan_interval;
+}
+
 static void scan_fn(struct k_work *work)
 {
 	/* Validate state */
@@ -244,74 +353,35 @@ static void scan_fn(struct k_work *work)
 		goto error;
 	}
 
-	static uint32_t settled_state[COLUMNS];
-
-	/* Prevent bouncing */
-	static uint32_t prev_state[COLUMNS];
-	for (size_t i = 0; i < COLUMNS; i++) {
-		uint32_t bounce_mask = prev_state[i] ^ raw_state[i];
-		prev_state[i] = raw_state[i];
-		raw_state[i] &= ~bounce_mask;
-		raw_state[i] |= settled_state[i] & bounce_mask;
-	}
-
-	/* Prevent ghosting */
-	uint32_t cur_state[COLUMNS];
-	for (size_t i = 0; i < COLUMNS; i++) {
-		uint32_t blocking_mask = 0;
-		for (size_t j = 0; j < COLUMNS; j++) {
-			if (i == j) {
-				continue;
-			}
-			blocking_mask |= raw_state[j];
-		}
-		blocking_mask ^= raw_state[i];
-		cur_state[i] = raw_state[i];
-		if (!is_power_of_two(raw_state[i])) {
-			/* Power of two means only one bit is set */
-			cur_state[i] &= blocking_mask;
-		}
-	}
-
-	/* Emit event for any key state change */
-	bool any_pressed = false;
-	size_t evt_limit = 0;
+	/* Debounce and prevent ghosting, emit event for any key state change */
+	uint32_t now = k_uptime_get_32();
+	size_t evt_cnt = 0;
+	uint32_t pending_ms = buttons_debounce_process(&debounce, raw_state,
+							now - last_scan_time,
+							key_changed, &evt_cnt);
+	bool any_pressed = (pending_ms > 0) ||
+			   buttons_debounce_any_pressed(&debounce);
 
-	for (size_t i = 0; i < COLUMNS; i++) {
-		for (size_t j = 0; j < ARRAY_SIZE(row); j++) {
-			bool is_raw_pressed = raw_state[i] & BIT(j);
-			bool is_pressed = cur_state[i] & BIT(j);
-			bool was_pressed = settled_state[i] & BIT(j);
-
-			if ((is_pressed != was_pressed) &&
-			    (is_pressed == is_raw_pressed) &&
-			    (evt_limit < CONFIG_CAF_BUTTONS_EVENT_LIMIT)) {
-				struct button_event *event = new_button_event();
-
-				event->key_id = KEY_ID(i, j);
-				event->pressed = is_pressed;
-				EVENT_SUBMIT(event);
+	last_scan_time = now;
 
-				evt_limit++;
-
-				WRITE_BIT(settled_state[i], j, is_pressed);
-			}
-		}
-
-		any_pressed = any_pressed ||
-			      (prev_state[i] != 0) ||
-			      (settled_state[i] != 0) ||
-			      (cur_state[i] != 0);
+	for (size_t i = 0; (i < COLUMNS) && !any_pressed; i++) {
+		any_pressed = (raw_state[i] != 0);
 	}
 
 	if (any_pressed) {
 		/* Schedule next scan */
-		k_work_reschedule(&matrix_scan, K_MSEC(SCAN_INTERVAL));
+		uint32_t delay = next_scan_delay((evt_cnt > 0) ||
+						 (pending_ms > 0),
+						 pending_ms);
+
+		k_work_reschedule(&matrix_scan, K_MSEC(delay));
 	} else {
 		/* If no button is pressed module can switch to callbacks */
 
 		int err = 0;
 
+		scan_interval = SCAN_INTERVAL;
+
 		/* Enable callbacks and switch state, then set pins */
 		switch (state) {
 		case STATE_SCANNING:
@@ -358,7 +428,7 @@ static void button_pressed_isr(const struct device *gpio_dev,
 	int err = 0;
 
 	/* Scanning will be scheduled, switch off pins */
-	if (set_cols(0x00000000)) {
+	if (reset_cols_isr()) {
 		LOG_ERR("Cannot control pins");
 		err = -EFAULT;
 	}
@@ -449,6 +519,8 @@ static void init_fn(void)
 			LOG_ERR("Cannot configure cols");
 			goto error;
 		}
+
+		col_state[i] = COL_INPUT;
 	}
 
 	int err = set_trig_mode();
@@ -457,7 +529,6 @@ static void init_fn(void)
 		goto error;
 	}
 
-	uint32_t pin_mask[ARRAY_SIZE(port_map)] = {0};
 	for (size_t i = 0; i < ARRAY_SIZE(row); i++) {
 		/* Module starts in scanning mode and will switch to
 		 * callback mode if no button is pressed.
@@ -470,7 +541,7 @@ static void init_fn(void)
 			goto error;
 		}
 
-		pin_mask[row[i].port] |= BIT(row[i].pin);
+		row_pin_mask[row[i].port] |= BIT(row[i].pin);
 	}
 
 	for (size_t i = 0; i < ARRAY_SIZE(port_map); i++) {
@@ -478,7 +549,8 @@ static void init_fn(void)
 			/* Skip non-existing ports */
 			continue;
 		}
-		gpio_init_callback(&gpio_cb[i], button_pressed_isr, pin_mask[i]);
+		gpio_init_callback(&gpio_cb[i], button_pressed_isr,
+				   row_pin_mask[i]);
 		err = gpio_add_callback(gpio_devs[i], &gpio_cb[i]);
 		if (err) {
 			LOG_ERR("Cannot add callback");
@@ -490,6 +562,7 @@ static void init_fn(void)
 
 	/* Perform initial scan */
 	state = STATE_SCANNING;
+	last_scan_time = k_uptime_get_32();
 
 	scan_fn(NULL);
 
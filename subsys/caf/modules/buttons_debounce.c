@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <sys/__assert.h>
+#include <sys/util.h>
+
+#include "buttons_debounce.h"
+
+
+static uint32_t ghost_filter(const struct buttons_debounce *db,
+			     const uint32_t *raw, size_t col, uint32_t multi)
+{
+	/* Power of two means only one bit is set */
+	if ((raw[col] == 0) || is_power_of_two(raw[col])) {
+		return raw[col];
+	}
+
+	/* Keys sharing both the row and the column with other pressed keys
+	 * may be ghosts. Keep them in the debounced state.
+	 */
+	uint32_t blocked = raw[col] & multi;
+
+	return (raw[col] & ~blocked) | (db->settled[col] & blocked);
+}
+
+uint32_t buttons_debounce_process(struct buttons_debounce *db,
+				  const uint32_t *raw, uint32_t elapsed_ms,
+				  buttons_debounce_cb cb, void *user_data)
+{
+	__ASSERT_NO_MSG(db->rows <= 32);
+
+	/* Rows that are pressed in more than one column. */
+	uint32_t once = 0;
+	uint32_t multi = 0;
+
+	for (size_t i = 0; i < db->cols; i++) {
+		multi |= once & raw[i];
+		once |= raw[i];
+	}
+
+	uint32_t next_ms = 0;
+	size_t evt_cnt = 0;
+
+	for (size_t i = 0; i < db->cols; i++) {
+		uint32_t target = ghost_filter(db, raw, i, multi);
+		uint32_t changed = (target ^ db->settled[i]) | db->pending[i];
+
+		while (changed) {
+			size_t j = __builtin_ctz(changed);
+			uint32_t bit = BIT(j);
+			uint8_t *timer = &db->timers[i * db->rows + j];
+			bool pressed = (target & bit) != 0;
+
+			changed &= ~bit;
+
+			if (pressed == ((db->settled[i] & bit) != 0)) {
+				/* Bounced back before the debounce time. */
+				db->pending[i] &= ~bit;
+				continue;
+			}
+
+			if (!(db->pending[i] & bit)) {
+				db->pending[i] |= bit;
+				*timer = pressed ? db->cfg->press_ms :
+						   db->cfg->release_ms;
+			} else {
+				*timer -= MIN(*timer, elapsed_ms);
+			}
+
+			if (*timer > 0) {
+				next_ms = next_ms ? MIN(next_ms, *timer) : *timer;
+				continue;
+			}
+
+			if (evt_cnt >= db->cfg->event_limit) {
+				/* Report in the next scan. */
+				next_ms = 1;
+				continue;
+			}
+
+			cb(i, j, pressed, user_data);
+			evt_cnt++;
+
+			db->pending[i] &= ~bit;
+			WRITE_BIT(db->settled[i], j, pressed);
+		}
+	}
+
+	return next_ms;
+}
+
+bool buttons_debounce_any_pressed(const struct buttons_debounce *db)
+{
+	for (size_t i = 0; i < db->cols; i++) {
+		if (db->settled[i] != 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+#if defined(CONFIG_ZTEST)
+void buttons_debounce_reset(struct buttons_debounce *db)
+{
+	memset(db->settled, 0, db->cols * sizeof(db->settled[0]));
+	memset(db->pending, 0, db->cols * sizeof(db->pending[0]));
+}
+#endif
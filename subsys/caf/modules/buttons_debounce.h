@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _BUTTONS_DEBOUNCE_H_
+#define _BUTTONS_DEBOUNCE_H_
+
+/**
+ * @brief Key matrix debouncer
+ * @defgroup buttons_debounce Key matrix debouncer
+ * @{
+ *
+ * Debounces the raw key matrix state read by the buttons module. Every key
+ * has its own debounce timer, with separate times for press and release.
+ * A key changes its state when the new raw state is kept for the whole
+ * debounce time. Keys that cannot be told apart from a ghost key are kept
+ * in their current state.
+ */
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Debouncer configuration. */
+struct buttons_debounce_config {
+	/** Time in ms that a key must stay pressed to report the press. */
+	uint8_t press_ms;
+
+	/** Time in ms that a key must stay released to report the release. */
+	uint8_t release_ms;
+
+	/** Maximum number of key state changes reported in one scan. */
+	uint8_t event_limit;
+};
+
+/** Debouncer state. The arrays are provided by the user. */
+struct buttons_debounce {
+	const struct buttons_debounce_config *cfg;
+	size_t cols;
+	size_t rows;
+
+	/** Debounced state of each column, one bit for each row. */
+	uint32_t *settled;
+
+	/** Keys with a running debounce timer, one bit for each row. */
+	uint32_t *pending;
+
+	/** Remaining debounce time in ms of each key, cols x rows. */
+	uint8_t *timers;
+};
+
+/**
+ * @brief Callback reporting a debounced key state change.
+ *
+ * @param col		Column of the key.
+ * @param row		Row of the key.
+ * @param pressed	New state of the key.
+ * @param user_data	User data given to @ref buttons_debounce_process.
+ */
+typedef void (*buttons_debounce_cb)(size_t col, size_t row, bool pressed,
+				    void *user_data);
+
+/**
+ * @brief Define the debouncer state.
+ *
+ * @param _name	Name of the debouncer.
+ * @param _cfg	Pointer to the configuration.
+ * @param _cols	Number of columns.
+ * @param _rows	Number of rows, at most 32.
+ */
+#define BUTTONS_DEBOUNCE_DEFINE(_name, _cfg, _cols, _rows)		\
+	static uint32_t _name##_settled[_cols];				\
+	static uint32_t _name##_pending[_cols];				\
+	static uint8_t _name##_timers[(_cols) * (_rows)];		\
+	static struct buttons_debounce _name = {			\
+		.cfg = _cfg,						\
+		.cols = _cols,						\
+		.rows = _rows,						\
+		.settled = _name##_settled,				\
+		.pending = _name##_pending,				\
+		.timers = _name##_timers,				\
+	}
+
+/**
+ * @brief Process the raw state of the key matrix.
+ *
+ * @param db		Debouncer.
+ * @param raw		Raw state of each column, one bit for each row.
+ * @param elapsed_ms	Time since the previous call.
+ * @param cb		Callback called for each key that changed its state.
+ * @param user_data	Data passed to the callback.
+ *
+ * @return Time in ms after which the matrix must be processed again to
+ *	   finish debouncing, or 0 if no key is debounced.
+ */
+uint32_t buttons_debounce_process(struct buttons_debounce *db,
+				  const uint32_t *raw, uint32_t elapsed_ms,
+				  buttons_debounce_cb cb, void *user_data);
+
+/**
+ * @brief Check if any key is pressed after debouncing.
+ *
+ * @param db	Debouncer.
+ *
+ * @return True if a key is pressed.
+ */
+bool buttons_debounce_any_pressed(const struct buttons_debounce *db);
+
+#if defined(CONFIG_ZTEST)
+/**
+ * @brief Reset the debouncer, releasing all keys without reporting it.
+ *
+ * Used by the tests only.
+ *
+ * @param db	Debouncer.
+ */
+void buttons_debounce_reset(struct buttons_debounce *db);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _BUTTONS_DEBOUNCE_H_ */
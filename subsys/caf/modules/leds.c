@@ -14,6 +14,8 @@
 #define MODULE leds
 #include <caf/events/module_state_event.h>
 
+#include "leds_engine.h"
+
 #include <logging/log.h>
 LOG_MODULE_REGISTER(MODULE, CONFIG_CAF_LEDS_LOG_LEVEL);
 
@@ -24,12 +26,9 @@ struct led {
 	const struct device *dev;
 	uint8_t color_count;
 
+	/* Color set in the LED driver. */
 	struct led_color color;
 	const struct led_effect *effect;
-	uint16_t effect_step;
-	uint16_t effect_substep;
-
-	struct k_work_delayable work;
 };
 
 #ifdef CONFIG_CAF_LEDS_PWM
@@ -62,119 +61,137 @@ static struct led leds[] = {
 	DT_INST_FOREACH_STATUS_OKAY(_LED_INSTANCE_DEF)
 };
 
+static void engine_color_set(size_t id, const struct led_color *color);
+static void engine_effect_done(size_t id, const struct led_effect *effect);
+
+static const struct leds_engine_cb engine_cb = {
+	.color_set = engine_color_set,
+	.effect_done = engine_effect_done,
+};
+
+LEDS_ENGINE_DEFINE(engine, &engine_cb, ARRAY_SIZE(leds));
+
+/* A single work advances the effects of all LEDs. */
+static struct k_work_delayable engine_work;
 
-static int set_color_one_channel(struct led *led, struct led_color *color)
+
+static int set_color_one_channel(struct led *led, const struct led_color *color,
+				 bool force)
 {
 	/* For a single color LED convert color to brightness. */
 	unsigned int brightness = 0;
+	unsigned int prev_brightness = 0;
 
 	for (size_t i = 0; i < ARRAY_SIZE(color->c); i++) {
 		brightness += color->c[i];
+		prev_brightness += led->color.c[i];
 	}
 	brightness /= ARRAY_SIZE(color->c);
+	prev_brightness /= ARRAY_SIZE(color->c);
+
+	if (!force && (brightness == prev_brightness)) {
+		return 0;
+	}
 
 	return led_set_brightness(led->dev, 0, brightness);
 }
 
-static int set_color_all_channels(struct led *led, struct led_color *color)
+static int set_color_all_channels(struct led *led, const struct led_color *color,
+				  bool force)
 {
 	int err = 0;
 
 	for (size_t i = 0; (i < ARRAY_SIZE(color->c)) && !err; i++) {
-		err = led_set_brightness(led->dev, i, color->c[i]);
+		/* Skip the channels that keep their brightness. */
+		if (force || (color->c[i] != led->color.c[i])) {
+			err = led_set_brightness(led->dev, i, color->c[i]);
+		}
 	}
 
 	return err;
 }
 
-static void set_color(struct led *led, struct led_color *color)
+static void set_color(struct led *led, const struct led_color *color,
+		      bool force)
 {
 	int err;
 
 	if (led->color_count == ARRAY_SIZE(color->c)) {
-		err = set_color_all_channels(led, color);
+		err = set_color_all_channels(led, color, force);
 	} else {
-		err = set_color_one_channel(led, color);
+		err = set_color_one_channel(led, color, force);
 	}
 
 	if (err) {
 		LOG_ERR("Cannot set LED brightness (err: %d)", err);
 	}
+
+	led->color = *color;
 }
 
 static void set_off(struct led *led)
 {
 	struct led_color nocolor = {0};
 
-	set_color(led, &nocolor);
+	set_color(led, &nocolor, true);
 }
 
-static void work_handler(struct k_work *work)
+static void engine_color_set(size_t id, const struct led_color *color)
 {
-	struct led *led = CONTAINER_OF(work, struct led, work);
-
-	const struct led_effect_step *effect_step =
-		&led->effect->steps[led->effect_step];
-
-	__ASSERT_NO_MSG(effect_step->substep_count > 0);
-	int substeps_left = effect_step->substep_count - led->effect_substep;
+	set_color(&leds[id], color, false);
+}
 
-	for (size_t i = 0; i < ARRAY_SIZE(led->color.c); i++) {
-		int diff = (effect_step->color.c[i] - led->color.c[i]) /
-			substeps_left;
-		led->color.c[i] += diff;
-	}
-	set_color(led, &led->color);
+static void engine_effect_done(size_t id, const struct led_effect *effect)
+{
+	struct led_ready_event *ready_event = new_led_ready_event();
 
-	led->effect_substep++;
-	if (led->effect_substep == effect_step->substep_count) {
-		led->effect_substep = 0;
-		led->effect_step++;
+	ready_event->led_id = id;
+	ready_event->led_effect = effect;
 
-		if (led->effect_step == led->effect->step_count) {
-			if (led->effect->loop_forever) {
-				led->effect_step = 0;
-			} else {
-				struct led_ready_event *ready_event = new_led_ready_event();
+	EVENT_SUBMIT(ready_event);
+}
 
-				ready_event->led_id = LED_ID(led);
-				ready_event->led_effect = led->effect;
+static void work_handler(struct k_work *work)
+{
+	uint32_t delay;
 
-				EVENT_SUBMIT(ready_event);
-			}
-		}
+	if (leds_engine_process(&engine, k_uptime_get_32(), &delay)) {
+		k_work_reschedule(&engine_work, K_MSEC(delay));
 	}
+}
 
-	if (led->effect_step < led->effect->step_count) {
-		int32_t next_delay =
-			led->effect->steps[led->effect_step].substep_time;
+static void engine_reschedule(void)
+{
+	uint32_t delay;
 
-		k_work_reschedule(&led->work, K_MSEC(next_delay));
+	if (leds_engine_next_delay(&engine, k_uptime_get_32(), &delay)) {
+		k_work_reschedule(&engine_work, K_MSEC(delay));
+	} else {
+		k_work_cancel_delayable(&engine_work);
 	}
 }
 
-static void led_update(struct led *led)
+static void led_start(struct led *led, uint32_t now)
 {
-	k_work_cancel_delayable(&led->work);
-
-	led->effect_step = 0;
-	led->effect_substep = 0;
-
 	if (!led->effect) {
 		LOG_WRN("No effect set");
+		leds_engine_stop(&engine, LED_ID(led));
 		return;
 	}
 
 	__ASSERT_NO_MSG(led->effect->steps);
 
-	if (led->effect->step_count > 0) {
-		int32_t next_delay =
-			led->effect->steps[led->effect_step].substep_time;
-
-		k_work_reschedule(&led->work, K_MSEC(next_delay));
-	} else {
+	if (led->effect->step_count == 0) {
 		LOG_WRN("LED effect with no effect");
 	}
+
+	leds_engine_start(&engine, LED_ID(led), led->effect, now);
+}
+
+static void led_update(struct led *led)
+{
+	led_start(led, k_uptime_get_32());
+	engine_reschedule();
 }
 
 static void verify_labels(void)
@@ -205,6 +222,10 @@ static int leds_init(void)
 
 	verify_labels();
 
+	k_work_init_delayable(&engine_work, work_handler);
+
+	uint32_t now = k_uptime_get_32();
+
 	for (size_t i = 0; (i < ARRAY_SIZE(leds)) && !err; i++) {
 		struct led *led = &leds[i];
 
@@ -216,16 +237,19 @@ static int leds_init(void)
 			LOG_ERR("Cannot bind %s", led->label);
 			err = -ENXIO;
 		} else {
-			k_work_init_delayable(&led->work, work_handler);
-			led_update(led);
+			led_start(led, now);
 		}
 	}
 
+	engine_reschedule();
+
 	return err;
 }
 
 static void leds_start(void)
 {
+	uint32_t now = k_uptime_get_32();
+
 	for (size_t i = 0; i < ARRAY_SIZE(leds); i++) {
 #ifdef CONFIG_PM_DEVICE
 		int err = pm_device_state_set(leds[i].dev,
@@ -235,14 +259,18 @@ static void leds_start(void)
 			LOG_ERR("PWM enable failed");
 		}
 #endif
-		led_update(&leds[i]);
+		led_start(&leds[i], now);
 	}
+
+	engine_reschedule();
 }
 
 static void leds_stop(void)
 {
+	k_work_cancel_delayable(&engine_work);
+
 	for (size_t i = 0; i < ARRAY_SIZE(leds); i++) {
-		k_work_cancel_delayable(&leds[i].work);
+		leds_engine_stop(&engine, i);
 
 		set_off(&leds[i]);
 
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <sys/__assert.h>
+#include <sys/util.h>
+
+#include "leds_engine.h"
+
+#define FRAC_BITS 16
+
+/* Limit of substeps done for a single LED in one processing. It is reached
+ * only by effects with zero substep time or after a long processing delay.
+ */
+#define SUBSTEP_LIMIT 16
+
+
+static bool is_due(uint32_t time, uint32_t now)
+{
+	return (int32_t)(time - now) <= 0;
+}
+
+static uint8_t channel_get(const struct leds_engine_led *led, size_t i)
+{
+	return (led->val[i] + BIT(FRAC_BITS - 1)) >> FRAC_BITS;
+}
+
+static void step_start(struct leds_engine_led *led, uint32_t time)
+{
+	const struct led_effect_step *step = &led->effect->steps[led->step];
+
+	__ASSERT_NO_MSG(step->substep_count > 0);
+
+	for (size_t i = 0; i < ARRAY_SIZE(led->val); i++) {
+		int32_t target = (int32_t)step->color.c[i] << FRAC_BITS;
+
+		led->inc[i] = (target - led->val[i]) / step->substep_count;
+	}
+
+	led->substep = 0;
+	led->next_time = time + step->substep_time;
+}
+
+static void substep_do(struct leds_engine_led *led)
+{
+	const struct led_effect_step *step = &led->effect->steps[led->step];
+
+	led->substep++;
+
+	if (led->substep < step->substep_count) {
+		for (size_t i = 0; i < ARRAY_SIZE(led->val); i++) {
+			led->val[i] += led->inc[i];
+		}
+		led->next_time += step->substep_time;
+		return;
+	}
+
+	/* Reach the step color exactly, without rounding errors. */
+	for (size_t i = 0; i < ARRAY_SIZE(led->val); i++) {
+		led->val[i] = (int32_t)step->color.c[i] << FRAC_BITS;
+	}
+
+	led->step++;
+	if (led->step == led->effect->step_count) {
+		if (!led->effect->loop_forever) {
+			led->active = false;
+			led->done = true;
+			return;
+		}
+
+		led->step = 0;
+	}
+
+	step_start(led, led->next_time);
+}
+
+static void led_process(struct leds_engine_led *led, uint32_t now)
+{
+	uint8_t prev[ARRAY_SIZE(led->val)];
+
+	for (size_t i = 0; i < ARRAY_SIZE(prev); i++) {
+		prev[i] = channel_get(led, i);
+	}
+
+	size_t cnt = 0;
+
+	while ((cnt < SUBSTEP_LIMIT) && led->active &&
+	       is_due(led->next_time, now)) {
+		substep_do(led);
+		cnt++;
+	}
+
+	if (cnt == 0) {
+		return;
+	}
+
+	/* The first substep of an effect always sets the color. */
+	if (led->first) {
+		led->first = false;
+		led->changed = true;
+		return;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(prev); i++) {
+		if (prev[i] != channel_get(led, i)) {
+			led->changed = true;
+			break;
+		}
+	}
+}
+
+void leds_engine_start(struct leds_engine *engine, size_t id,
+		       const struct led_effect *effect, uint32_t now)
+{
+	__ASSERT_NO_MSG(id < engine->led_count);
+	__ASSERT_NO_MSG(effect->steps);
+
+	struct leds_engine_led *led = &engine->leds[id];
+
+	led->effect = effect;
+	led->step = 0;
+	led->active = (effect->step_count > 0);
+	led->first = led->active;
+	led->changed = false;
+	led->done = false;
+
+	if (led->active) {
+		step_start(led, now);
+	}
+}
+
+void leds_engine_stop(struct leds_engine *engine, size_t id)
+{
+	__ASSERT_NO_MSG(id < engine->led_count);
+
+	struct leds_engine_led *led = &engine->leds[id];
+
+	led->active = false;
+	led->changed = false;
+	led->done = false;
+	/* The user turns the LED off, the next effect starts from off. */
+	memset(led->val, 0, sizeof(led->val));
+	memset(led->inc, 0, sizeof(led->inc));
+}
+
+bool leds_engine_next_delay(const struct leds_engine *engine, uint32_t now,
+			    uint32_t *delay)
+{
+	bool active = false;
+	uint32_t min_delay = UINT32_MAX;
+
+	for (size_t i = 0; i < engine->led_count; i++) {
+		const struct leds_engine_led *led = &engine->leds[i];
+
+		if (!led->active) {
+			continue;
+		}
+
+		active = true;
+		if (is_due(led->next_time, now)) {
+			min_delay = 0;
+		} else {
+			min_delay = MIN(min_delay, led->next_time - now);
+		}
+	}
+
+	if (active) {
+		*delay = min_delay;
+	}
+
+	return active;
+}
+
+bool leds_engine_process(struct leds_engine *engine, uint32_t now,
+			 uint32_t *delay)
+{
+	for (size_t i = 0; i < engine->led_count; i++) {
+		if (engine->leds[i].active) {
+			led_process(&engine->leds[i], now);
+		}
+	}
+
+	/* Report all updates at once, after the effects are advanced. */
+	for (size_t i = 0; i < engine->led_count; i++) {
+		struct leds_engine_led *led = &engine->leds[i];
+
+		if (led->changed) {
+			struct led_color color;
+
+			for (size_t j = 0; j < ARRAY_SIZE(color.c); j++) {
+				color.c[j] = channel_get(led, j);
+			}
+
+			led->changed = false;
+			engine->cb->color_set(i, &color);
+		}
+
+		if (led->done) {
+			led->done = false;
+			engine->cb->effect_done(i, led->effect);
+		}
+	}
+
+	return leds_engine_next_delay(engine, now, delay);
+}
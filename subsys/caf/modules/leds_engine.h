@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _LEDS_ENGINE_H_
+#define _LEDS_ENGINE_H_
+
+/**
+ * @brief LED effect engine
+ * @defgroup leds_engine LED effect engine
+ * @{
+ *
+ * Plays LED effects on a set of LEDs from a single timer. Every call to
+ * @ref leds_engine_process advances all LEDs whose substep is due. Color
+ * increments are computed in fixed point once per effect step. Only LEDs
+ * whose color has changed are reported to the user.
+ */
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <caf/led_effect.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Callbacks used to report the results of processing. */
+struct leds_engine_cb {
+	/**
+	 * @brief Set a new color of the LED.
+	 *
+	 * Called after all LEDs are processed, for every LED whose color
+	 * has changed and for LEDs that started a new effect.
+	 *
+	 * @param id	LED index.
+	 * @param color	New color.
+	 */
+	void (*color_set)(size_t id, const struct led_color *color);
+
+	/**
+	 * @brief Report that the LED effect has ended.
+	 *
+	 * Not called for effects that loop forever.
+	 *
+	 * @param id	 LED index.
+	 * @param effect Finished effect.
+	 */
+	void (*effect_done)(size_t id, const struct led_effect *effect);
+};
+
+/** State of a single LED. For internal use by the engine. */
+struct leds_engine_led {
+	const struct led_effect *effect;
+	uint16_t step;
+	uint16_t substep;
+	uint32_t next_time;
+
+	/** Color channels in 16.16 fixed point and increments per substep. */
+	int32_t val[_CAF_LED_COLOR_CHANNEL_COUNT];
+	int32_t inc[_CAF_LED_COLOR_CHANNEL_COUNT];
+
+	bool active;
+	bool first;
+	bool changed;
+	bool done;
+};
+
+/** Engine state. */
+struct leds_engine {
+	const struct leds_engine_cb *cb;
+	struct leds_engine_led *leds;
+	size_t led_count;
+};
+
+/**
+ * @brief Define the engine state.
+ *
+ * @param _name		Name of the engine.
+ * @param _cb		Pointer to the callbacks.
+ * @param _led_count	Number of LEDs.
+ */
+#define LEDS_ENGINE_DEFINE(_name, _cb, _led_count)			\
+	static struct leds_engine_led _name##_leds[_led_count];	\
+	static struct leds_engine _name = {				\
+		.cb = _cb,						\
+		.leds = _name##_leds,					\
+		.led_count = _led_count,				\
+	}
+
+/**
+ * @brief Start playing an effect on the LED.
+ *
+ * The effect starts from the current color of the LED. Call
+ * @ref leds_engine_next_delay afterwards to reschedule processing.
+ *
+ * @param engine	Engine.
+ * @param id		LED index.
+ * @param effect	Effect to play.
+ * @param now		Current time in ms.
+ */
+void leds_engine_start(struct leds_engine *engine, size_t id,
+		       const struct led_effect *effect, uint32_t now);
+
+/**
+ * @brief Stop playing the effect on the LED.
+ *
+ * The color of the LED is reset to off, so the next effect starts from off.
+ * The user is expected to turn the LED off.
+ *
+ * @param engine	Engine.
+ * @param id		LED index.
+ */
+void leds_engine_stop(struct leds_engine *engine, size_t id);
+
+/**
+ * @brief Advance all LEDs whose substep is due.
+ *
+ * @param engine	Engine.
+ * @param now		Current time in ms.
+ * @param delay		Time in ms after which the engine must be processed
+ *			again. Set only if the function returns true.
+ *
+ * @return True if any LED plays an effect.
+ */
+bool leds_engine_process(struct leds_engine *engine, uint32_t now,
+			 uint32_t *delay);
+
+/**
+ * @brief Get the time until the next substep of any LED is due.
+ *
+ * @param engine	Engine.
+ * @param now		Current time in ms.
+ * @param delay		Time in ms after which the engine must be processed.
+ *			Set only if the function returns true.
+ *
+ * @return True if any LED plays an effect.
+ */
+bool leds_engine_next_delay(const struct leds_engine *engine, uint32_t now,
+			    uint32_t *delay);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _LEDS_ENGINE_H_ */
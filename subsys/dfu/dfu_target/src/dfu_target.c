@@ -14,6 +14,7 @@ static const struct dfu_target dfu_target_ ## name  = { \
 	.offset_get = dfu_target_## name ##_offset_get, \
 	.write = dfu_target_ ## name ## _write, \
 	.done = dfu_target_ ## name ## _done, \
+	.reset = dfu_target_ ## name ## _reset, \
 }
 
 #ifdef CONFIG_DFU_TARGET_MODEM_DELTA
@@ -141,8 +142,14 @@ int dfu_target_done(bool successful)
 int dfu_target_reset(void)
 {
 	if (current_target != NULL) {
-		int err = current_target->done(false);
+		int err = current_target->reset();
 
+		if (err != 0) {
+			LOG_ERR("Unable to discard the written data");
+			return err;
+		}
+
+		err = current_target->done(false);
 		if (err != 0) {
 			LOG_ERR("Unable to clean up dfu_target");
 			return err;
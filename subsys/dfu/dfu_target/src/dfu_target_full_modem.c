@@ -74,3 +74,8 @@ int dfu_target_full_modem_done(bool successful)
 
 	return dfu_target_stream_done(successful);
 }
+
+int dfu_target_full_modem_reset(void)
+{
+	return dfu_target_stream_reset();
+}
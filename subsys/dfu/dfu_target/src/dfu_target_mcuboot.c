@@ -181,3 +181,8 @@ int dfu_target_mcuboot_done(bool successful)
 
 	return err;
 }
+
+int dfu_target_mcuboot_reset(void)
+{
+	return dfu_target_stream_reset();
+}
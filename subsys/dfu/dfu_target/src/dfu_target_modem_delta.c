@@ -271,3 +271,8 @@ int dfu_target_modem_delta_done(bool successful)
 
 	return 0;
 }
+
+int dfu_target_modem_delta_reset(void)
+{
+	return delete_banked_modem_delta_fw();
+}
@@ -210,3 +210,23 @@ int dfu_target_stream_done(bool successful)
 
 	return err;
 }
+
+int dfu_target_stream_reset(void)
+{
+	int err = 0;
+
+	/* Drop the buffered data as well, it must not be written by 'done'. */
+	stream.bytes_written = 0;
+	stream.buf_bytes = 0;
+
+#ifdef CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS
+	if (current_id != NULL) {
+		err = store_progress();
+		if (err != 0) {
+			LOG_ERR("Unable to reset write progress: %d", err);
+		}
+	}
+#endif
+
+	return err;
+}
@@ -21,6 +21,7 @@ extern "C" {
 
 #include <zephyr.h>
 #include <zephyr/types.h>
+#include <stdbool.h>
 
 /** @brief The max JOB_ID_LEN according to AWS docs
  * https://docs.aws.amazon.com/general/latest/gr/aws_service_limits.html
@@ -37,6 +38,105 @@ extern "C" {
  */
 #define EXECUTION_OBJ_DECODED_BIT 2
 
+/** @brief Size of the buffer for the "protocol" field of the Job Document. */
+#define AWS_FOTA_JSON_PROTOCOL_MAX_LEN 8
+
+/** @brief Maximum nesting depth of objects and arrays in a document. */
+#define AWS_FOTA_JSON_NESTING_MAX 32
+
+/**
+ * @brief Fields extracted from an AWS IoT Jobs JSON document.
+ *
+ * String fields point to buffers provided by the caller. A NULL pointer means
+ * that the field is not stored. Strings longer than the buffer are truncated.
+ */
+struct aws_fota_job_doc {
+	/** "jobId" of the Job Execution, AWS_JOBS_JOB_ID_MAX_LEN bytes. */
+	char *job_id;
+	/** "host" of the Job Document location,
+	 *  CONFIG_AWS_FOTA_HOSTNAME_MAX_LEN bytes.
+	 */
+	char *hostname;
+	/** "path" of the Job Document location,
+	 *  CONFIG_AWS_FOTA_FILE_PATH_MAX_LEN bytes.
+	 */
+	char *file_path;
+	/** "protocol" of the Job Document location,
+	 *  AWS_FOTA_JSON_PROTOCOL_MAX_LEN bytes. Empty if not present.
+	 */
+	char *protocol;
+	/** "status" of an UpdateJobExecution response, STATUS_MAX_LEN bytes. */
+	char *status;
+	/** "versionNumber" of the Job Execution. */
+	int version_number;
+	/** "size" or "fileSize" of the Job Document, 0 if not present. */
+	uint32_t file_size;
+};
+
+/**
+ * @brief Streaming JSON parser state.
+ *
+ * The parser does not allocate memory and does not need the whole document
+ * at once. The members are internal to the parser.
+ */
+struct aws_fota_json_parser {
+	struct aws_fota_job_doc *doc;
+	/* Bit n is set if the container at depth n is an array. */
+	uint32_t arrays;
+	/* Node of the containers that can hold keys of interest. */
+	uint8_t path[4];
+	uint8_t depth;
+	uint8_t state;
+	/* Node of the key or value being parsed. */
+	uint8_t node;
+	bool is_key;
+	uint16_t found;
+	char key[16];
+	char literal[24];
+	uint8_t literal_len;
+	uint8_t hex_digits;
+	uint16_t codepoint;
+	uint16_t surrogate;
+	char *dst;
+	size_t dst_size;
+	size_t dst_len;
+	int err;
+};
+
+/**
+ * @brief Initialize a streaming parser for an AWS IoT DescribeJobExecution
+ *	  response.
+ *
+ * @param[out] parser  Parser to initialize.
+ * @param[in,out] doc  Where the fields are stored while the document is
+ *		       parsed. Must be valid until the parser is finished.
+ */
+void aws_fota_json_parser_init(struct aws_fota_json_parser *parser,
+			       struct aws_fota_job_doc *doc);
+
+/**
+ * @brief Feed the next chunk of the document to the parser.
+ *
+ * @param[in,out] parser  Initialized parser.
+ * @param[in] data  Chunk of the document, does not need to be null-terminated.
+ * @param[in] len  Length of the chunk.
+ *
+ * @return 0 on success, -EBADMSG if the document is malformed. Once an error
+ *	   is returned, all later calls return the same error.
+ */
+int aws_fota_json_parser_feed(struct aws_fota_json_parser *parser,
+			      const char *data, size_t len);
+
+/**
+ * @brief Finish parsing a document after the last chunk has been fed.
+ *
+ * @param[in,out] parser  Initialized parser.
+ *
+ * @return Same as aws_fota_parse_DescribeJobExecution_rsp(). A document that
+ *	   is malformed or incomplete gives -ENODATA.
+ */
+int aws_fota_json_parser_finish(struct aws_fota_json_parser *parser);
+
 /**
  * @brief Parse a given AWS IoT DescribeJobExecution response JSON object.
  *	  More information on this object can be found at https://docs.aws.amazon.com/iot/latest/developerguide/jobs-api.html#mqtt-describejobexecution
@@ -165,6 +165,56 @@ static int get_published_payload(struct mqtt_client *client, uint8_t *write_buf,
 	return 0;
 }
 
+/**
+ * @brief Read the payload out of the published MQTT message in chunks of the
+ *	  size of the payload buffer and parse it as an AWS IoT
+ *	  DescribeJobExecution response. The payload is read out completely
+ *	  even if the parsing fails.
+ *
+ * @param[in] client  Connected MQTT client instance.
+ * @param[in] length  Length of the payload received.
+ * @param[in,out] job_doc  Where the fields of the job document are stored.
+ *
+ * @return Same as aws_fota_parse_DescribeJobExecution_rsp(), or a negative
+ *	   error code if the payload could not be read.
+ */
+static int parse_published_job_execution(struct mqtt_client *client,
+					 size_t length,
+					 struct aws_fota_job_doc *job_doc)
+{
+	struct aws_fota_json_parser parser;
+	int err = 0;
+
+	aws_fota_json_parser_init(&parser, job_doc);
+
+	while (length > 0) {
+		int ret = mqtt_read_publish_payload_blocking(
+			client, payload_buf, MIN(length, sizeof(payload_buf)));
+
+		if (ret < 0) {
+			return ret;
+		} else if (ret == 0) {
+			return -EIO;
+		}
+		length -= ret;
+
+#if IS_ENABLED(CONFIG_AWS_FOTA_LOG_LEVEL_DBG)
+		char chunk[ret + 1];
+
+		memcpy(chunk, payload_buf, ret);
+		chunk[ret] = '\0';
+		LOG_DBG("Job doc: %s", log_strdup(chunk));
+#endif
+
+		if (!err) {
+			err = aws_fota_json_parser_feed(&parser, payload_buf,
+							ret);
+		}
+	}
+
+	return aws_fota_json_parser_finish(&parser);
+}
+
 /**
  * @brief Update an AWS IoT Job Execution with a state and status details
  *
@@ -226,26 +276,19 @@ static int get_job_execution(struct mqtt_client *const client,
 	int err;
 	int execution_version_number_prev = execution_version_number;
 	uint8_t job_id_incoming[AWS_JOBS_JOB_ID_MAX_LEN];
-
-	err = get_published_payload(client, payload_buf, payload_len);
-	if (err) {
-		LOG_ERR("Error when getting the payload: %d", err);
-		return err;
-	}
-
-#if IS_ENABLED(CONFIG_AWS_FOTA_LOG_LEVEL_DBG)
-	char job_doc[payload_len + 1];
-
-	memcpy(job_doc, payload_buf, payload_len);
-	job_doc[payload_len] = '\0';
-	LOG_DBG("Job doc: %s", log_strdup(job_doc));
-#endif
+	char protocol[AWS_FOTA_JSON_PROTOCOL_MAX_LEN];
+	struct aws_fota_job_doc job_doc = {
+		.job_id = job_id_incoming,
+		.hostname = hostname,
+		.file_path = file_path,
+		.protocol = protocol,
+	};
 
 	/* Check if message received is a job. */
-	err = aws_fota_parse_DescribeJobExecution_rsp(payload_buf, payload_len,
-						      job_id_incoming, hostname,
-						      file_path,
-						      &execution_version_number);
+	err = parse_published_job_execution(client, payload_len, &job_doc);
+	if (err == 1) {
+		execution_version_number = job_doc.version_number;
+	}
 
 	if (err < 0) {
 		LOG_ERR("Error when parsing the json: %d", err);
@@ -269,6 +312,8 @@ static int get_job_execution(struct mqtt_client *const client,
 	LOG_DBG("Job ID: %s", log_strdup(job_id_handling));
 	LOG_DBG("hostname: %s", log_strdup(hostname));
 	LOG_DBG("file_path %s", log_strdup(file_path));
+	LOG_DBG("protocol: %s, size: %u", log_strdup(protocol),
+		job_doc.file_size);
 	LOG_DBG("execution_version_number: %d ", execution_version_number);
 
 	/* Subscribe to update topic to receive feedback on whether an
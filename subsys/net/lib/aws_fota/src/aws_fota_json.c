@@ -6,139 +6,648 @@
 
 #include <zephyr.h>
 #include <string.h>
-#include <cJSON.h>
+#include <stdlib.h>
 #include <sys/util.h>
 #include <net/aws_jobs.h>
 
 #include "aws_fota_json.h"
 
-/**@brief Copy max maxlen bytes from src to dst. Insert null-terminator.
+/* The parser is a single pass state machine that is fed one character at a
+ * time, so a document can be delivered in chunks of any size. Only the values
+ * of the keys in the node table below are stored, directly into the buffers
+ * of the caller. Nothing is allocated.
  */
-static void strncpy_nullterm(char *dst, const char *src, size_t maxlen)
+
+enum parser_state {
+	STATE_VALUE,
+	STATE_OBJECT_FIRST,
+	STATE_KEY,
+	STATE_COLON,
+	STATE_ARRAY_FIRST,
+	STATE_COMMA_OR_END,
+	STATE_STRING,
+	STATE_ESCAPE,
+	STATE_UNICODE,
+	STATE_LITERAL,
+	STATE_DONE,
+};
+
+enum field {
+	FIELD_NONE,
+	FIELD_EXECUTION,
+	FIELD_JOB_ID,
+	FIELD_VERSION_NUMBER,
+	FIELD_FILE_SIZE,
+	FIELD_HOST,
+	FIELD_PATH,
+	FIELD_PROTOCOL,
+	FIELD_STATUS,
+};
+
+enum node {
+	NODE_NONE,
+	NODE_ROOT,
+	NODE_EXECUTION,
+	NODE_JOB_ID,
+	NODE_VERSION_NUMBER,
+	NODE_JOB_DOCUMENT,
+	NODE_SIZE,
+	NODE_FILE_SIZE,
+	NODE_LOCATION,
+	NODE_HOST,
+	NODE_PATH,
+	NODE_PROTOCOL,
+	NODE_STATUS,
+};
+
+/* Keys of interest, as a tree. A key only matches if its parent matched. */
+static const struct {
+	uint8_t parent;
+	uint8_t field;
+	const char *key;
+} nodes[] = {
+	[NODE_EXECUTION] = { NODE_ROOT, FIELD_EXECUTION, "execution" },
+	[NODE_JOB_ID] = { NODE_EXECUTION, FIELD_JOB_ID, "jobId" },
+	[NODE_VERSION_NUMBER] = { NODE_EXECUTION, FIELD_VERSION_NUMBER,
+				  "versionNumber" },
+	[NODE_JOB_DOCUMENT] = { NODE_EXECUTION, FIELD_NONE, "jobDocument" },
+	[NODE_SIZE] = { NODE_JOB_DOCUMENT, FIELD_FILE_SIZE, "size" },
+	[NODE_FILE_SIZE] = { NODE_JOB_DOCUMENT, FIELD_FILE_SIZE, "fileSize" },
+	[NODE_LOCATION] = { NODE_JOB_DOCUMENT, FIELD_NONE, "location" },
+	[NODE_HOST] = { NODE_LOCATION, FIELD_HOST, "host" },
+	[NODE_PATH] = { NODE_LOCATION, FIELD_PATH, "path" },
+	[NODE_PROTOCOL] = { NODE_LOCATION, FIELD_PROTOCOL, "protocol" },
+	[NODE_STATUS] = { NODE_ROOT, FIELD_STATUS, "status" },
+};
+
+BUILD_ASSERT(sizeof(((struct aws_fota_json_parser *)0)->found) * 8 >
+	     FIELD_STATUS, "Field bitmask too small");
+
+static uint8_t node_child(uint8_t parent, const char *key)
 {
-	size_t len = strlen(src) + 1;
+	if (parent == NODE_NONE) {
+		return NODE_NONE;
+	}
 
-	memcpy(dst, src, MIN(len, maxlen));
-	if (len > maxlen) {
-		dst[maxlen - 1] = '\0';
+	for (size_t i = 0; i < ARRAY_SIZE(nodes); i++) {
+		if (nodes[i].key != NULL && nodes[i].parent == parent &&
+		    strcmp(nodes[i].key, key) == 0) {
+			return i;
+		}
 	}
+
+	return NODE_NONE;
 }
 
-int aws_fota_parse_UpdateJobExecution_rsp(const char *update_rsp_document,
-					  size_t payload_len, char *status_buf)
+static bool is_space(char c)
 {
-	if (update_rsp_document == NULL || status_buf == NULL) {
-		return -EINVAL;
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool is_literal(char c)
+{
+	return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+	       (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+}
+
+static bool is_number(const char *str)
+{
+	if (*str == '-') {
+		str++;
+	}
+	if (*str == '0') {
+		str++;
+	} else if (*str >= '1' && *str <= '9') {
+		while (*str >= '0' && *str <= '9') {
+			str++;
+		}
+	} else {
+		return false;
 	}
 
-	int ret;
+	if (*str == '.') {
+		str++;
+		if (!(*str >= '0' && *str <= '9')) {
+			return false;
+		}
+		while (*str >= '0' && *str <= '9') {
+			str++;
+		}
+	}
+
+	if (*str == 'e' || *str == 'E') {
+		str++;
+		if (*str == '+' || *str == '-') {
+			str++;
+		}
+		if (!(*str >= '0' && *str <= '9')) {
+			return false;
+		}
+		while (*str >= '0' && *str <= '9') {
+			str++;
+		}
+	}
+
+	return *str == '\0';
+}
 
-	cJSON *update_response = cJSON_Parse(update_rsp_document);
+static int container_push(struct aws_fota_json_parser *parser, bool array)
+{
+	if (parser->depth >= AWS_FOTA_JSON_NESTING_MAX) {
+		return -EBADMSG;
+	}
 
-	if (update_response == NULL) {
-		ret = -ENODATA;
-		goto cleanup;
+	WRITE_BIT(parser->arrays, parser->depth, array);
+	if (parser->depth < ARRAY_SIZE(parser->path)) {
+		parser->path[parser->depth] = array ? NODE_NONE : parser->node;
 	}
+	parser->depth++;
+
+	return 0;
+}
+
+static bool container_is_array(const struct aws_fota_json_parser *parser)
+{
+	return parser->arrays & BIT(parser->depth - 1);
+}
+
+static uint8_t container_node(const struct aws_fota_json_parser *parser)
+{
+	if (parser->depth > ARRAY_SIZE(parser->path)) {
+		return NODE_NONE;
+	}
+
+	return parser->path[parser->depth - 1];
+}
+
+static void value_end(struct aws_fota_json_parser *parser)
+{
+	parser->state = parser->depth == 0 ? STATE_DONE : STATE_COMMA_OR_END;
+}
+
+static void string_begin(struct aws_fota_json_parser *parser, bool key)
+{
+	struct aws_fota_job_doc *doc = parser->doc;
+
+	parser->dst = NULL;
+	parser->dst_size = 0;
+	parser->dst_len = 0;
+	parser->is_key = key;
 
-	cJSON *status = cJSON_GetObjectItemCaseSensitive(update_response,
-							  "status");
-	if (cJSON_IsString(status) && status->valuestring != NULL) {
-		strncpy_nullterm(status_buf, status->valuestring,
-				 STATUS_MAX_LEN);
+	if (key) {
+		parser->dst = parser->key;
+		parser->dst_size = sizeof(parser->key);
 	} else {
-		ret = -ENODATA;
-		goto cleanup;
+		switch (nodes[parser->node].field) {
+		case FIELD_JOB_ID:
+			parser->dst = doc->job_id;
+			parser->dst_size = AWS_JOBS_JOB_ID_MAX_LEN;
+			break;
+		case FIELD_HOST:
+			parser->dst = doc->hostname;
+			parser->dst_size = CONFIG_AWS_FOTA_HOSTNAME_MAX_LEN;
+			break;
+		case FIELD_PATH:
+			parser->dst = doc->file_path;
+			parser->dst_size = CONFIG_AWS_FOTA_FILE_PATH_MAX_LEN;
+			break;
+		case FIELD_PROTOCOL:
+			parser->dst = doc->protocol;
+			parser->dst_size = AWS_FOTA_JSON_PROTOCOL_MAX_LEN;
+			break;
+		case FIELD_STATUS:
+			parser->dst = doc->status;
+			parser->dst_size = STATUS_MAX_LEN;
+			break;
+		default:
+			break;
+		}
 	}
 
-	ret = 0;
-cleanup:
-	cJSON_Delete(update_response);
-	return ret;
+	parser->state = STATE_STRING;
 }
 
-int aws_fota_parse_DescribeJobExecution_rsp(const char *job_document,
-					   uint32_t payload_len,
-					   char *job_id_buf,
-					   char *hostname_buf,
-					   char *file_path_buf,
-					   int *execution_version_number)
+/* Like strncpy_nullterm(), strings longer than the buffer are truncated. */
+static void string_put(struct aws_fota_json_parser *parser, char c)
 {
-	if (job_document == NULL
-	    || job_id_buf == NULL
-	    || hostname_buf == NULL
-	    || file_path_buf == NULL
-	    || execution_version_number == NULL) {
-		return -EINVAL;
+	if (parser->dst != NULL && parser->dst_len + 1 < parser->dst_size) {
+		parser->dst[parser->dst_len] = c;
 	}
+	parser->dst_len++;
+}
 
-	int ret;
+static void string_put_codepoint(struct aws_fota_json_parser *parser,
+				 uint32_t cp)
+{
+	if (cp < 0x80) {
+		string_put(parser, cp);
+	} else if (cp < 0x800) {
+		string_put(parser, 0xC0 | (cp >> 6));
+		string_put(parser, 0x80 | (cp & 0x3F));
+	} else if (cp < 0x10000) {
+		string_put(parser, 0xE0 | (cp >> 12));
+		string_put(parser, 0x80 | ((cp >> 6) & 0x3F));
+		string_put(parser, 0x80 | (cp & 0x3F));
+	} else {
+		string_put(parser, 0xF0 | (cp >> 18));
+		string_put(parser, 0x80 | ((cp >> 12) & 0x3F));
+		string_put(parser, 0x80 | ((cp >> 6) & 0x3F));
+		string_put(parser, 0x80 | (cp & 0x3F));
+	}
+}
+
+static int string_end(struct aws_fota_json_parser *parser)
+{
+	if (parser->surrogate) {
+		return -EBADMSG;
+	}
 
-	cJSON *json_data = cJSON_Parse(job_document);
+	if (parser->dst != NULL && parser->dst_size > 0) {
+		parser->dst[MIN(parser->dst_len, parser->dst_size - 1)] = '\0';
+	}
 
-	if (json_data == NULL) {
-		ret = -ENODATA;
-		goto cleanup;
+	if (parser->is_key) {
+		/* Keys that did not fit cannot match any node */
+		parser->node = parser->dst_len < sizeof(parser->key) ?
+			node_child(container_node(parser), parser->key) :
+			NODE_NONE;
+		parser->state = STATE_COLON;
+		return 0;
 	}
 
-	cJSON *execution = cJSON_GetObjectItemCaseSensitive(json_data,
-							    "execution");
-	if (execution == NULL) {
-		ret = 0;
-		goto cleanup;
+	if (parser->dst != NULL) {
+		parser->found |= BIT(nodes[parser->node].field);
 	}
 
-	cJSON *job_id = cJSON_GetObjectItemCaseSensitive(execution, "jobId");
+	value_end(parser);
+	return 0;
+}
 
-	if (cJSON_GetStringValue(job_id) != NULL) {
-		strncpy_nullterm(job_id_buf, job_id->valuestring,
-				AWS_JOBS_JOB_ID_MAX_LEN);
-	} else {
-		ret = -ENODATA;
-		goto cleanup;
+static int unicode_end(struct aws_fota_json_parser *parser)
+{
+	uint32_t cp = parser->codepoint;
+
+	if (cp >= 0xD800 && cp <= 0xDBFF) {
+		if (parser->surrogate) {
+			return -EBADMSG;
+		}
+		parser->surrogate = cp;
+		return 0;
 	}
 
-	cJSON *job_data = cJSON_GetObjectItemCaseSensitive(execution,
-							   "jobDocument");
+	if (cp >= 0xDC00 && cp <= 0xDFFF) {
+		if (!parser->surrogate) {
+			return -EBADMSG;
+		}
+		cp = 0x10000 + ((parser->surrogate - 0xD800) << 10) +
+		     (cp - 0xDC00);
+		parser->surrogate = 0;
+	} else if (parser->surrogate) {
+		return -EBADMSG;
+	}
+
+	string_put_codepoint(parser, cp);
+	return 0;
+}
 
-	if (!cJSON_IsObject(job_data)) {
-		ret = -ENODATA;
-		goto cleanup;
+static int literal_end(struct aws_fota_json_parser *parser)
+{
+	const char *literal = parser->literal;
+
+	parser->literal[parser->literal_len] = '\0';
+
+	if (strcmp(literal, "true") == 0 || strcmp(literal, "false") == 0 ||
+	    strcmp(literal, "null") == 0) {
+		value_end(parser);
+		return 0;
 	}
 
-	cJSON *location = cJSON_GetObjectItemCaseSensitive(job_data,
-							    "location");
+	if (!is_number(literal)) {
+		return -EBADMSG;
+	}
 
-	if (!cJSON_IsObject(location)) {
-		ret = -ENODATA;
-		goto cleanup;
+	/* Only the integer part is used, like the valueint field of cJSON. */
+	switch (nodes[parser->node].field) {
+	case FIELD_VERSION_NUMBER:
+		parser->doc->version_number = strtol(literal, NULL, 10);
+		parser->found |= BIT(FIELD_VERSION_NUMBER);
+		break;
+	case FIELD_FILE_SIZE:
+		parser->doc->file_size = strtoul(literal, NULL, 10);
+		parser->found |= BIT(FIELD_FILE_SIZE);
+		break;
+	default:
+		break;
 	}
 
-	cJSON *hostname = cJSON_GetObjectItemCaseSensitive(location, "host");
-	cJSON *path = cJSON_GetObjectItemCaseSensitive(location, "path");
+	value_end(parser);
+	return 0;
+}
 
-	if ((cJSON_GetStringValue(hostname) != NULL)
-	   && (cJSON_GetStringValue(path) != NULL)) {
-		strncpy_nullterm(hostname_buf, hostname->valuestring,
-				CONFIG_AWS_FOTA_HOSTNAME_MAX_LEN);
-		strncpy_nullterm(file_path_buf, path->valuestring,
-				CONFIG_AWS_FOTA_FILE_PATH_MAX_LEN);
-	} else {
-		ret = -ENODATA;
-		goto cleanup;
+static int value_begin(struct aws_fota_json_parser *parser, char c)
+{
+	if (c == '{') {
+		parser->state = STATE_OBJECT_FIRST;
+		return container_push(parser, false);
+	} else if (c == '[') {
+		parser->state = STATE_ARRAY_FIRST;
+		return container_push(parser, true);
+	} else if (c == '"') {
+		string_begin(parser, false);
+		return 0;
+	} else if (is_literal(c)) {
+		parser->literal[0] = c;
+		parser->literal_len = 1;
+		parser->state = STATE_LITERAL;
+		return 0;
 	}
 
-	cJSON *version_number = cJSON_GetObjectItemCaseSensitive(
-					execution, "versionNumber");
+	return -EBADMSG;
+}
 
-	if (cJSON_IsNumber(version_number)) {
-		*execution_version_number = version_number->valueint;
-	} else {
-		ret = -ENODATA;
-		goto cleanup;
+static int container_end(struct aws_fota_json_parser *parser)
+{
+	parser->depth--;
+	value_end(parser);
+	return 0;
+}
+
+static int parse_char(struct aws_fota_json_parser *parser, char c)
+{
+	int err;
+
+	switch (parser->state) {
+	case STATE_VALUE:
+		if (is_space(c)) {
+			return 0;
+		}
+		return value_begin(parser, c);
+	case STATE_OBJECT_FIRST:
+		if (is_space(c)) {
+			return 0;
+		} else if (c == '}') {
+			return container_end(parser);
+		}
+		/* Fall through */
+	case STATE_KEY:
+		if (is_space(c)) {
+			return 0;
+		} else if (c == '"') {
+			string_begin(parser, true);
+			return 0;
+		}
+		return -EBADMSG;
+	case STATE_COLON:
+		if (is_space(c)) {
+			return 0;
+		} else if (c == ':') {
+			if (nodes[parser->node].field == FIELD_EXECUTION) {
+				parser->found |= BIT(FIELD_EXECUTION);
+			}
+			parser->state = STATE_VALUE;
+			return 0;
+		}
+		return -EBADMSG;
+	case STATE_ARRAY_FIRST:
+		if (is_space(c)) {
+			return 0;
+		} else if (c == ']') {
+			return container_end(parser);
+		}
+		parser->node = NODE_NONE;
+		return value_begin(parser, c);
+	case STATE_COMMA_OR_END:
+		if (is_space(c)) {
+			return 0;
+		} else if (c == ',') {
+			if (container_is_array(parser)) {
+				parser->node = NODE_NONE;
+				parser->state = STATE_VALUE;
+			} else {
+				parser->state = STATE_KEY;
+			}
+			return 0;
+		} else if (c == (container_is_array(parser) ? ']' : '}')) {
+			return container_end(parser);
+		}
+		return -EBADMSG;
+	case STATE_STRING:
+		if (c == '"') {
+			return string_end(parser);
+		} else if (c == '\\') {
+			parser->state = STATE_ESCAPE;
+			return 0;
+		} else if ((uint8_t)c < 0x20 || parser->surrogate) {
+			return -EBADMSG;
+		}
+		string_put(parser, c);
+		return 0;
+	case STATE_ESCAPE:
+		parser->state = STATE_STRING;
+		if (c == 'u') {
+			parser->codepoint = 0;
+			parser->hex_digits = 0;
+			parser->state = STATE_UNICODE;
+			return 0;
+		} else if (parser->surrogate) {
+			return -EBADMSG;
+		}
+
+		switch (c) {
+		case '"':
+		case '\\':
+		case '/':
+			break;
+		case 'b':
+			c = '\b';
+			break;
+		case 'f':
+			c = '\f';
+			break;
+		case 'n':
+			c = '\n';
+			break;
+		case 'r':
+			c = '\r';
+			break;
+		case 't':
+			c = '\t';
+			break;
+		default:
+			return -EBADMSG;
+		}
+		string_put(parser, c);
+		return 0;
+	case STATE_UNICODE:
+		if (c >= '0' && c <= '9') {
+			c -= '0';
+		} else if (c >= 'a' && c <= 'f') {
+			c -= 'a' - 10;
+		} else if (c >= 'A' && c <= 'F') {
+			c -= 'A' - 10;
+		} else {
+			return -EBADMSG;
+		}
+
+		parser->codepoint = (parser->codepoint << 4) | c;
+		if (++parser->hex_digits < 4) {
+			return 0;
+		}
+		parser->state = STATE_STRING;
+		return unicode_end(parser);
+	case STATE_LITERAL:
+		if (is_literal(c)) {
+			if (parser->literal_len >= sizeof(parser->literal) - 1) {
+				return -EBADMSG;
+			}
+			parser->literal[parser->literal_len++] = c;
+			return 0;
+		}
+
+		err = literal_end(parser);
+		if (err) {
+			return err;
+		}
+		/* The character ends the literal, parse it in the new state */
+		return parse_char(parser, c);
+	case STATE_DONE:
+		if (is_space(c)) {
+			return 0;
+		}
+		return -EBADMSG;
+	default:
+		return -EBADMSG;
+	}
+}
+
+void aws_fota_json_parser_init(struct aws_fota_json_parser *parser,
+			       struct aws_fota_job_doc *doc)
+{
+	memset(parser, 0, sizeof(*parser));
+	parser->doc = doc;
+	parser->node = NODE_ROOT;
+	parser->state = STATE_VALUE;
+
+	doc->file_size = 0;
+	if (doc->protocol != NULL) {
+		doc->protocol[0] = '\0';
+	}
+}
+
+int aws_fota_json_parser_feed(struct aws_fota_json_parser *parser,
+			      const char *data, size_t len)
+{
+	if (parser->err) {
+		return parser->err;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		parser->err = parse_char(parser, data[i]);
+		if (parser->err) {
+			return parser->err;
+		}
+	}
+
+	return 0;
+}
+
+/* Returns 0 if a complete and well formed document has been parsed. */
+static int parser_complete(struct aws_fota_json_parser *parser)
+{
+	if (parser->err) {
+		return -ENODATA;
+	}
+
+	/* A number at the top level has no terminating character */
+	if (parser->state == STATE_LITERAL) {
+		parser->err = literal_end(parser);
+		if (parser->err) {
+			return -ENODATA;
+		}
+	}
+
+	return parser->state == STATE_DONE ? 0 : -ENODATA;
+}
+
+int aws_fota_json_parser_finish(struct aws_fota_json_parser *parser)
+{
+	const uint16_t required = BIT(FIELD_JOB_ID) |
+				  BIT(FIELD_VERSION_NUMBER) |
+				  BIT(FIELD_HOST) |
+				  BIT(FIELD_PATH);
+	int err;
+
+	err = parser_complete(parser);
+	if (err) {
+		return err;
+	}
+
+	if (!(parser->found & BIT(FIELD_EXECUTION))) {
+		return 0;
+	}
+
+	if ((parser->found & required) != required) {
+		return -ENODATA;
+	}
+
+	return 1;
+}
+
+int aws_fota_parse_UpdateJobExecution_rsp(const char *update_rsp_document,
+					  size_t payload_len, char *status_buf)
+{
+	if (update_rsp_document == NULL || status_buf == NULL) {
+		return -EINVAL;
+	}
+
+	struct aws_fota_json_parser parser;
+	struct aws_fota_job_doc doc = {
+		.status = status_buf,
+	};
+	int ret;
+
+	aws_fota_json_parser_init(&parser, &doc);
+	(void)aws_fota_json_parser_feed(&parser, update_rsp_document,
+					payload_len);
+
+	ret = parser_complete(&parser);
+	if (ret) {
+		return ret;
+	}
+
+	return (parser.found & BIT(FIELD_STATUS)) ? 0 : -ENODATA;
+}
+
+int aws_fota_parse_DescribeJobExecution_rsp(const char *job_document,
+					   uint32_t payload_len,
+					   char *job_id_buf,
+					   char *hostname_buf,
+					   char *file_path_buf,
+					   int *execution_version_number)
+{
+	if (job_document == NULL
+	    || job_id_buf == NULL
+	    || hostname_buf == NULL
+	    || file_path_buf == NULL
+	    || execution_version_number == NULL) {
+		return -EINVAL;
+	}
+
+	struct aws_fota_json_parser parser;
+	struct aws_fota_job_doc doc = {
+		.job_id = job_id_buf,
+		.hostname = hostname_buf,
+		.file_path = file_path_buf,
+	};
+	int ret;
+
+	aws_fota_json_parser_init(&parser, &doc);
+	(void)aws_fota_json_parser_feed(&parser, job_document, payload_len);
+
+	ret = aws_fota_json_parser_finish(&parser);
+	if (ret == 1) {
+		*execution_version_number = doc.version_number;
 	}
 
-	ret = 1;
-cleanup:
-	cJSON_Delete(json_data);
 	return ret;
 }
@@ -9,6 +9,9 @@
 #include <net/fota_download.h>
 #include <net/download_client.h>
 #include <pm_config.h>
+#ifdef CONFIG_FOTA_DOWNLOAD_PIPELINE
+#include <sys/ring_buffer.h>
+#endif
 
 #if defined(PM_S1_ADDRESS) || defined(CONFIG_DFU_TARGET_MCUBOOT)
 /* MCUBoot support is required */
@@ -41,6 +44,34 @@ static enum dfu_target_image_type img_type_expected = DFU_TARGET_IMAGE_TYPE_ANY;
 static bool first_fragment;
 static bool downloading;
 
+static struct {
+	int64_t start;
+	uint32_t received;
+	uint32_t written;
+	uint32_t write_ms; /* Time spent in dfu_target_write() */
+	uint32_t stalled_ms; /* Time the download waited for writes */
+} stats;
+
+#ifdef CONFIG_FOTA_DOWNLOAD_PIPELINE
+#define WRITER_STACK_SIZE CONFIG_FOTA_DOWNLOAD_PIPELINE_STACK_SIZE
+#define WRITER_PRIORITY K_LOWEST_APPLICATION_THREAD_PRIO
+/* Wait for the writer in steps, as both the download and a cancel
+ * may be waiting at the same time, and only one of them gets each
+ * wakeup. The waiters re-check the queue and the write error in between.
+ */
+#define FLUSH_POLL_TIME K_MSEC(100)
+
+/* Fragments are queued here by the download client thread and written to
+ * the DFU target by the writer thread, straight from the buffer.
+ */
+RING_BUF_DECLARE(pipe, CONFIG_FOTA_DOWNLOAD_PIPELINE_BUF_SIZE);
+static K_MUTEX_DEFINE(pipe_lock);
+static K_SEM_DEFINE(pipe_data_sem, 0, 1);
+static K_SEM_DEFINE(pipe_space_sem, 0, 1);
+/* First write error, or -ECANCELED. Queued data is discarded when set. */
+static atomic_t pipe_err;
+#endif
+
 static void send_evt(enum fota_download_evt_id id)
 {
 	__ASSERT(id != FOTA_DOWNLOAD_EVT_PROGRESS, "use send_progress");
@@ -71,6 +102,177 @@ static void send_progress(int progress)
 #endif
 }
 
+static void send_throughput(void)
+{
+#ifdef CONFIG_FOTA_DOWNLOAD_THROUGHPUT_EVT
+	uint32_t elapsed = k_uptime_get() - stats.start;
+	uint32_t receiving = elapsed - MIN(stats.stalled_ms, elapsed);
+	const struct fota_download_evt evt = {
+		.id = FOTA_DOWNLOAD_EVT_THROUGHPUT,
+		.throughput = {
+			.download = receiving ? ((uint64_t)stats.received *
+						 MSEC_PER_SEC / receiving) : 0,
+			.write = stats.write_ms ? ((uint64_t)stats.written *
+						   MSEC_PER_SEC / stats.write_ms) : 0,
+			.stalled = stats.stalled_ms,
+		}
+	};
+	callback(&evt);
+#endif
+}
+
+static int target_write(const uint8_t *buf, size_t len)
+{
+	int64_t start = k_uptime_get();
+	int err;
+
+	err = dfu_target_write(buf, len);
+	stats.write_ms += k_uptime_get() - start;
+
+	if (err == 0) {
+		stats.written += len;
+	}
+
+	return err;
+}
+
+#ifdef CONFIG_FOTA_DOWNLOAD_PIPELINE
+static void writer_thread_fn(void *p1, void *p2, void *p3)
+{
+	uint8_t *data;
+	uint32_t len;
+	int err;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (true) {
+		k_sem_take(&pipe_data_sem, K_FOREVER);
+
+		while (true) {
+			k_mutex_lock(&pipe_lock, K_FOREVER);
+			len = ring_buf_get_claim(&pipe, &data,
+						 CONFIG_FOTA_DOWNLOAD_PIPELINE_BUF_SIZE);
+			k_mutex_unlock(&pipe_lock);
+
+			if (len == 0) {
+				break;
+			}
+
+			if (atomic_get(&pipe_err) == 0) {
+				err = target_write(data, len);
+				if (err != 0) {
+					LOG_ERR("dfu_target_write error %d", err);
+					atomic_cas(&pipe_err, 0, err);
+				}
+			}
+
+			k_mutex_lock(&pipe_lock, K_FOREVER);
+			(void)ring_buf_get_finish(&pipe, len);
+			k_mutex_unlock(&pipe_lock);
+
+			k_sem_give(&pipe_space_sem);
+		}
+	}
+}
+
+K_THREAD_DEFINE(fota_download_writer, WRITER_STACK_SIZE, writer_thread_fn,
+		NULL, NULL, NULL, WRITER_PRIORITY, 0, 0);
+
+/* Wait until the queue is empty. Returns the first write error, if any. */
+static int pipe_flush(void)
+{
+	bool empty;
+
+	while (true) {
+		k_mutex_lock(&pipe_lock, K_FOREVER);
+		empty = ring_buf_is_empty(&pipe);
+		k_mutex_unlock(&pipe_lock);
+
+		if (empty) {
+			break;
+		}
+
+		(void)k_sem_take(&pipe_space_sem, FLUSH_POLL_TIME);
+	}
+
+	return atomic_get(&pipe_err);
+}
+
+/* Discard queued data and wait for the writer to let go of the DFU target */
+static void pipe_abort(void)
+{
+	atomic_cas(&pipe_err, 0, -ECANCELED);
+	(void)pipe_flush();
+}
+#endif /* CONFIG_FOTA_DOWNLOAD_PIPELINE */
+
+/* Pass a fragment on to the DFU target. With the pipeline, the fragment
+ * is queued and the download only waits when the queue is full.
+ */
+static int fragment_write(const uint8_t *buf, size_t len)
+{
+#ifdef CONFIG_FOTA_DOWNLOAD_PIPELINE
+	int64_t start;
+	uint32_t put;
+	int err;
+
+	stats.received += len;
+
+	while (len > 0) {
+		err = atomic_get(&pipe_err);
+		if (err != 0) {
+			return err;
+		}
+
+		k_mutex_lock(&pipe_lock, K_FOREVER);
+		put = ring_buf_put(&pipe, buf, len);
+		k_mutex_unlock(&pipe_lock);
+
+		if (put > 0) {
+			buf += put;
+			len -= put;
+			k_sem_give(&pipe_data_sem);
+			continue;
+		}
+
+		/* A cancel may take the wakeup, see FLUSH_POLL_TIME */
+		start = k_uptime_get();
+		(void)k_sem_take(&pipe_space_sem, FLUSH_POLL_TIME);
+		stats.stalled_ms += k_uptime_get() - start;
+	}
+
+	return 0;
+#else
+	uint32_t write_ms = stats.write_ms;
+	int err;
+
+	stats.received += len;
+
+	err = target_write(buf, len);
+	stats.stalled_ms += stats.write_ms - write_ms;
+
+	return err;
+#endif
+}
+
+static int fragments_flush(void)
+{
+#ifdef CONFIG_FOTA_DOWNLOAD_PIPELINE
+	return pipe_flush();
+#else
+	return 0;
+#endif
+}
+
+static void fragments_abort(void)
+{
+#ifdef CONFIG_FOTA_DOWNLOAD_PIPELINE
+	pipe_abort();
+#endif
+}
+
 static void dfu_target_callback_handler(enum dfu_target_evt_id evt)
 {
 	switch (evt) {
@@ -109,6 +311,8 @@ static int download_client_callback(const struct download_client_evt *event)
 				return err;
 			}
 			first_fragment = false;
+			memset(&stats, 0, sizeof(stats));
+			stats.start = k_uptime_get();
 			img_type = dfu_target_img_type(event->fragment.buf,
 							event->fragment.len);
 
@@ -160,10 +364,14 @@ static int download_client_callback(const struct download_client_evt *event)
 			}
 		}
 
-		err = dfu_target_write(event->fragment.buf,
-				       event->fragment.len);
-		if (err != 0) {
+		err = fragment_write(event->fragment.buf,
+				     event->fragment.len);
+		if (err == -ECANCELED) {
+			/* Cancelled, fota_download_cancel() cleans up */
+			return err;
+		} else if (err != 0) {
 			LOG_ERR("dfu_target_write error %d", err);
+			fragments_abort();
 			int res = dfu_target_done(false);
 
 			if (res != 0) {
@@ -177,13 +385,11 @@ static int download_client_callback(const struct download_client_evt *event)
 
 		if (IS_ENABLED(CONFIG_FOTA_DOWNLOAD_PROGRESS_EVT) &&
 		    !first_fragment) {
-			err = dfu_target_offset_get(&offset);
-			if (err != 0) {
-				LOG_DBG("unable to get dfu target "
-						"offset err: %d", err);
-				send_error_evt(FOTA_DOWNLOAD_ERROR_CAUSE_DOWNLOAD_FAILED);
-				return err;
-			}
+			/* Progress of the download, including the offset it
+			 * was resumed from. The DFU target is not queried, as
+			 * the writer thread may be using it.
+			 */
+			offset = dlc.progress;
 
 			if (file_size == 0) {
 				LOG_DBG("invalid file size: %d", file_size);
@@ -192,12 +398,24 @@ static int download_client_callback(const struct download_client_evt *event)
 			}
 
 			send_progress((offset * 100) / file_size);
+			send_throughput();
 			LOG_DBG("Progress: %d/%d bytes", offset, file_size);
 		}
 	break;
 	}
 
 	case DOWNLOAD_CLIENT_EVT_DONE:
+		err = fragments_flush();
+		if (err != 0) {
+			LOG_ERR("dfu_target_write error %d", err);
+			fragments_abort();
+			(void)dfu_target_done(false);
+			first_fragment = true;
+			(void)download_client_disconnect(&dlc);
+			send_error_evt(FOTA_DOWNLOAD_ERROR_CAUSE_INVALID_UPDATE);
+			return err;
+		}
+
 		err = dfu_target_done(true);
 		if (err != 0) {
 			LOG_ERR("dfu_target_done error: %d", err);
@@ -210,6 +428,7 @@ static int download_client_callback(const struct download_client_evt *event)
 			send_error_evt(FOTA_DOWNLOAD_ERROR_CAUSE_DOWNLOAD_FAILED);
 			return err;
 		}
+		send_throughput();
 		send_evt(FOTA_DOWNLOAD_EVT_FINISHED);
 		first_fragment = true;
 		downloading = false;
@@ -230,6 +449,7 @@ static int download_client_callback(const struct download_client_evt *event)
 		} else {
 			download_client_disconnect(&dlc);
 			LOG_ERR("Download client error");
+			fragments_abort();
 			err = dfu_target_done(false);
 			if (err == -EACCES) {
 				LOG_DBG("No DFU target was initialized");
@@ -312,6 +532,9 @@ int fota_download_start_with_image_type(const char *host, const char *file,
 	}
 
 	socket_retries_left = CONFIG_FOTA_SOCKET_RETRIES;
+#ifdef CONFIG_FOTA_DOWNLOAD_PIPELINE
+	atomic_clear(&pipe_err);
+#endif
 
 	strncpy(file_buf, file, sizeof(file_buf));
 
@@ -426,6 +649,8 @@ int fota_download_cancel(void)
 		return err;
 	}
 
+	fragments_abort();
+
 	err = dfu_target_done(false);
 	if (err && err != -EACCES) {
 		LOG_ERR("%s failed to clean up: %d", __func__, err);
@@ -29,6 +29,12 @@ LOG_MODULE_REGISTER(ftp_client, CONFIG_FTP_CLIENT_LOG_LEVEL);
 #define FTP_PRIORITY		K_LOWEST_APPLICATION_THREAD_PRIO
 static K_THREAD_STACK_DEFINE(ftp_stack_area, FTP_STACK_SIZE);
 
+enum stream_state {
+	STREAM_IDLE,
+	STREAM_PUT,
+	STREAM_GET
+};
+
 static struct ftp_client {
 	int cmd_sock;
 	int data_sock;
@@ -37,6 +43,8 @@ static struct ftp_client {
 	int sec_tag;
 	ftp_client_callback_t ctrl_callback;
 	ftp_client_callback_t data_callback;
+	enum stream_state stream;	/* Streaming transfer in progress */
+	uint32_t stream_offset;		/* File offset of streaming transfer */
 } client;
 
 static struct k_work_q ftp_work_q;
@@ -171,6 +179,7 @@ static void close_connection(int code, int error)
 	client.data_sock = INVALID_SOCKET;
 	client.connected = false;
 	client.sec_tag = INVALID_SEC_TAG;
+	client.stream = STREAM_IDLE;
 }
 
 /**@brief Send FTP message via socket
@@ -390,6 +399,234 @@ static void keepalive_timeout(struct k_timer *dummy)
 	}
 }
 
+static int stream_open(const char *cmd, uint32_t offset)
+{
+	int ret;
+
+	/* Always set Passive mode to act as TCP client */
+	ret = do_ftp_send_ctrl(CMD_PASV, sizeof(CMD_PASV) - 1);
+	if (ret) {
+		return -EIO;
+	}
+	ret = do_ftp_recv_ctrl(true, FTP_CODE_227);
+	if (ret != FTP_CODE_227) {
+		return ret;
+	}
+
+	/* Data channel stays open until the stream is closed */
+	ret = establish_data_channel(ctrl_buf);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (offset > 0) {
+		sprintf(ctrl_buf, CMD_REST, offset);
+		ret = do_ftp_send_ctrl(ctrl_buf, strlen(ctrl_buf));
+		if (ret == 0) {
+			ret = do_ftp_recv_ctrl(true, FTP_CODE_350);
+		}
+		if (ret != FTP_CODE_350) {
+			goto error;
+		}
+	}
+
+	ret = do_ftp_send_ctrl(cmd, strlen(cmd));
+	if (ret) {
+		goto error;
+	}
+	ret = do_ftp_recv_ctrl(true, FTP_CODE_150);
+	if (ret != FTP_CODE_150 && parse_return_code(ctrl_buf, FTP_CODE_125) != FTP_CODE_125) {
+		goto error;
+	}
+
+	/* Keep-alive would interleave NOOP replies with the transfer result */
+	k_timer_stop(&keepalive_timer);
+	client.stream_offset = offset;
+
+	return FTP_CODE_150;
+
+error:
+	close(client.data_sock);
+	client.data_sock = INVALID_SOCKET;
+	return ret;
+}
+
+static int stream_close(void)
+{
+	int ret;
+	int keepalive_time = CONFIG_FTP_CLIENT_KEEPALIVE_TIME;
+
+	/* Closing data channel marks the end of file for uploads */
+	close(client.data_sock);
+	client.data_sock = INVALID_SOCKET;
+	client.stream = STREAM_IDLE;
+
+	ret = poll_data_task_done();
+
+	if (keepalive_time > 0 && client.connected) {
+		k_timer_start(&keepalive_timer, K_SECONDS(keepalive_time),
+			      K_SECONDS(keepalive_time));
+	}
+
+	return ret;
+}
+
+int ftp_put_stream_open(const char *file, int type, uint32_t offset)
+{
+	int ret;
+	char put_cmd[128];
+
+	if (client.stream != STREAM_IDLE) {
+		return -EBUSY;
+	}
+	if (type == FTP_PUT_NORMAL) {
+		if (file == NULL) {
+			return -EINVAL;
+		}
+		sprintf(put_cmd, CMD_STOR, file);
+	} else if (type == FTP_PUT_UNIQUE) {
+		sprintf(put_cmd, CMD_STOU);
+	} else if (type == FTP_PUT_APPEND) {
+		if (file == NULL) {
+			return -EINVAL;
+		}
+		sprintf(put_cmd, CMD_APPE, file);
+	} else {
+		return -EINVAL;
+	}
+
+	ret = stream_open(put_cmd, offset);
+	if (ret == FTP_CODE_150) {
+		client.stream = STREAM_PUT;
+	}
+
+	return ret;
+}
+
+int ftp_put_stream_write(const uint8_t *data, size_t length)
+{
+	int ret;
+	size_t offset = 0;
+
+	if (client.stream != STREAM_PUT) {
+		return -ENOTCONN;
+	}
+	if (data == NULL) {
+		return -EINVAL;
+	}
+
+	LOG_HEXDUMP_DBG(data, length, "TXD");
+
+	/* Blocking send applies backpressure from the TCP window */
+	while (offset < length) {
+		ret = send(client.data_sock, data + offset, length - offset, 0);
+		if (ret < 0) {
+			LOG_ERR("send data failed: %d", -errno);
+			return -errno;
+		}
+		offset += ret;
+		client.stream_offset += ret;
+	}
+
+	return 0;
+}
+
+int ftp_put_stream_close(void)
+{
+	if (client.stream != STREAM_PUT) {
+		return -ENOTCONN;
+	}
+
+	return stream_close();
+}
+
+int ftp_get_stream_open(const char *file, uint32_t offset)
+{
+	int ret;
+	char get_cmd[128];
+
+	if (client.stream != STREAM_IDLE) {
+		return -EBUSY;
+	}
+	if (file == NULL) {
+		return -EINVAL;
+	}
+
+	sprintf(get_cmd, CMD_RETR, file);
+	ret = stream_open(get_cmd, offset);
+	if (ret == FTP_CODE_150) {
+		client.stream = STREAM_GET;
+	}
+
+	return ret;
+}
+
+int ftp_get_stream_read(uint8_t *buf, size_t length)
+{
+	int ret;
+	struct pollfd fds[1];
+
+	if (client.stream != STREAM_GET) {
+		return -ENOTCONN;
+	}
+	if (buf == NULL) {
+		return -EINVAL;
+	}
+
+	fds[0].fd = client.data_sock;
+	fds[0].events = POLLIN;
+	ret = poll(fds, 1, MSEC_PER_SEC * CONFIG_FTP_CLIENT_LISTEN_TIME);
+	if (ret < 0) {
+		LOG_ERR("poll(data) failed: (%d)", -errno);
+		return -errno;
+	}
+	if (ret == 0) {
+		return -ETIMEDOUT;
+	}
+	if ((fds[0].revents & (POLLERR | POLLNVAL)) != 0) {
+		LOG_ERR("Data connection error (0x%08x)", fds[0].revents);
+		return -EIO;
+	}
+	if ((fds[0].revents & POLLIN) != POLLIN) {
+		/* An orderly close is readable, recv() then returns 0 */
+		LOG_ERR("Data connection lost (0x%08x)", fds[0].revents);
+		return -ECONNRESET;
+	}
+
+	/* Data is only read when the caller asks for it, so the TCP window
+	 * throttles the server while the caller is busy.
+	 */
+	ret = recv(client.data_sock, buf, length, 0);
+	if (ret < 0) {
+		LOG_ERR("recv(data) failed: (%d)", -errno);
+		return -errno;
+	}
+
+	if (ret == 0) {
+		/* Server closed data channel after the last byte */
+		return 0;
+	}
+
+	LOG_HEXDUMP_DBG(buf, ret, "RXD");
+	client.stream_offset += ret;
+
+	return ret;
+}
+
+int ftp_get_stream_close(void)
+{
+	if (client.stream != STREAM_GET) {
+		return -ENOTCONN;
+	}
+
+	return stream_close();
+}
+
+uint32_t ftp_stream_offset(void)
+{
+	return client.stream_offset;
+}
+
 int ftp_open(const char *hostname, uint16_t port, int sec_tag)
 {
 	int ret;
@@ -578,6 +815,10 @@ int ftp_list(const char *options, const char *target)
 	int ret;
 	char list_cmd[128];
 
+	if (client.stream != STREAM_IDLE) {
+		return -EBUSY;
+	}
+
 	/* Always set Passive mode to act as TCP client */
 	ret = do_ftp_send_ctrl(CMD_PASV, sizeof(CMD_PASV) - 1);
 	if (ret) {
@@ -695,6 +936,10 @@ int ftp_get(const char *file)
 	int ret;
 	char get_cmd[128];
 
+	if (client.stream != STREAM_IDLE) {
+		return -EBUSY;
+	}
+
 	/* Always set Passive mode to act as TCP client */
 	ret = do_ftp_send_ctrl(CMD_PASV, sizeof(CMD_PASV) - 1);
 	if (ret) {
@@ -730,6 +975,9 @@ int ftp_put(const char *file, const uint8_t *data, uint16_t length, int type)
 	int ret;
 	char put_cmd[128];
 
+	if (client.stream != STREAM_IDLE) {
+		return -EBUSY;
+	}
 	if (type != FTP_PUT_NORMAL && type != FTP_PUT_UNIQUE && type != FTP_PUT_APPEND) {
 		return -EINVAL;
 	}
@@ -800,6 +1048,8 @@ int ftp_init(ftp_client_callback_t ctrl_callback, ftp_client_callback_t data_cal
 	client.data_sock = INVALID_SOCKET;
 	client.connected = false;
 	client.sec_tag = INVALID_SEC_TAG;
+	client.stream = STREAM_IDLE;
+	client.stream_offset = 0;
 	client.ctrl_callback = ctrl_callback;
 	client.data_callback = data_callback;
 
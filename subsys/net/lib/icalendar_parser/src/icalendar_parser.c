@@ -14,63 +14,67 @@
 
 LOG_MODULE_REGISTER(icalendar_parser, CONFIG_ICAL_PARSER_LOG_LEVEL);
 
-static size_t unfold_contentline(const char *buf, char *prop_buf)
+/* Content line states. Reference: RFC 5545 3.1 Content Lines */
+enum {
+	/* Receiving content line data */
+	LINE_DATA,
+	/* CR received, waiting for LF */
+	LINE_CR,
+	/* CRLF received, the next character tells if the line is folded */
+	LINE_CRLF,
+};
+
+struct ical_component_name {
+	const char *name;
+	enum ical_parser_evt_id id;
+};
+
+static const struct ical_component_name components[] = {
+	{ "VEVENT", ICAL_EVT_VEVENT },
+	{ "VTODO", ICAL_EVT_VTODO },
+	{ "VJOURNAL", ICAL_EVT_VJOURNAL },
+	{ "VFREEBUSY", ICAL_EVT_VFREEBUSY },
+	{ "VTIMEZONE", ICAL_EVT_VTIMEZONE },
+};
+
+static const struct ical_component_name *find_component(const char *name)
 {
-	const char *sol = buf;
-	char *eol;
-	uint16_t total_line_len = 0, single_line_len = 0;
-
-	while (1) {
-		eol = strstr(sol, "\r\n");
-		if (!eol) {
-			return 0;
-		}
-		single_line_len = eol - sol;
-		if ((total_line_len + single_line_len) <= CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE) {
-			memcpy(prop_buf + total_line_len, sol, single_line_len);
-			total_line_len += single_line_len;
-		} else {
-			LOG_WRN("Property value overflow."
-				"Increase CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE.");
-			return 0;
-		}
-		if (!strncmp(eol, "\r\n ", strlen("\r\n "))) {
-			/* Long content line is split into multiple lines.
-			 * Copy the folded part to unfolded buffer.
-			 */
-			sol = eol + strlen("\r\n ");
-		} else {
-			/* Content line is delimited. */
-			break;
+	for (size_t i = 0; i < ARRAY_SIZE(components); i++) {
+		if (!strcasecmp(name, components[i].name)) {
+			return &components[i];
 		}
 	}
-	prop_buf[total_line_len] = '\0';
 
-	return total_line_len;
+	return NULL;
+}
+
+/* Return the length of the property name, which is delimited by the
+ * parameters (';') or the value (':').
+ */
+static size_t prop_name_len(const char *line)
+{
+	return strcspn(line, ";:");
+}
+
+static bool prop_name_is(const char *line, size_t name_len, const char *name)
+{
+	return (name_len == strlen(name)) && !strncasecmp(line, name, name_len);
 }
 
-static bool parse_desc_props(const char *buf,
+static bool parse_desc_props(const char *line,
+			     size_t line_len,
 			     const char *name,
 			     size_t name_size,
 			     char *value,
 			     size_t max_value_len)
 {
 	bool ret;
-	size_t unfold_size;
-	char ical_prop_buf[CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE + 1];
-
-	unfold_size = unfold_contentline(buf, ical_prop_buf);
-	if (unfold_size <= 0) {
-		/* Property wrong format - no parameter or value. */
-		LOG_ERR("%s no value/param.", name);
-		return false;
-	}
 
-	if (ical_prop_buf[name_size] == ':') {
-		size_t value_len = unfold_size - name_size - 1;
+	if (line[name_size] == ':') {
+		size_t value_len = line_len - name_size - 1;
 
 		if (value_len <= max_value_len) {
-			memcpy(value, ical_prop_buf + name_size + 1, value_len);
+			memcpy(value, line + name_size + 1, value_len);
 			value[value_len] = '\0';
 			ret = true;
 		} else {
@@ -78,7 +82,7 @@ static bool parse_desc_props(const char *buf,
 			LOG_ERR("%s value overflow.", name);
 			ret = false;
 		}
-	} else if (ical_prop_buf[name_size] == ';') {
+	} else if (line[name_size] == ';') {
 		/* Does not support property parameter. */
 		LOG_ERR("%s param not supported.", name);
 		ret = false;
@@ -91,311 +95,253 @@ static bool parse_desc_props(const char *buf,
 	return ret;
 }
 
-static bool parse_datetime_props(const char *buf,
+static bool parse_datetime_props(const char *line,
+				 size_t line_len,
 				 const char *name,
 				 size_t name_size,
 				 char *value,
 				 size_t max_value_len)
 {
-	bool ret;
-	size_t unfold_size;
-	char ical_prop_buf[CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE + 1];
+	const char *dtvalue;
+	size_t value_len;
 
-	unfold_size = unfold_contentline(buf, ical_prop_buf);
-	if (unfold_size <= 0) {
-		/* Property wrong format - fail to unfold property. */
-		LOG_ERR("%s wrong format. Fail to unfold property", name);
+	if (line[name_size] != ':' && line[name_size] != ';') {
+		/* Property wrong format - no parameter or value. */
+		LOG_ERR("%s wrong format.", name);
 		return false;
 	}
 
-	if (ical_prop_buf[name_size] == ':') {
-		size_t value_len = unfold_size - name_size - 1;
+	/* Skip the parameters, if any */
+	dtvalue = strchr(line + name_size, ':');
+	if (dtvalue == NULL) {
+		/* Property wrong format - no value. */
+		LOG_ERR("%s wrong format - no value.", name);
+		return false;
+	}
+	dtvalue = dtvalue + 1;
 
-		if (value_len <= max_value_len) {
-			memcpy(value, ical_prop_buf + name_size + 1, value_len);
-			value[value_len] = '\0';
-			ret = true;
-		} else {
-			/* Property value overflow. */
-			LOG_ERR("%s value overflow.", name);
-			ret = false;
-		}
-	} else if (ical_prop_buf[name_size] == ';') {
-		char *dtvalue;
-
-		dtvalue = strchr(ical_prop_buf, ':');
-		if (dtvalue) {
-			dtvalue = dtvalue + 1;
-			size_t value_len;
-
-			value_len = unfold_size - (dtvalue - ical_prop_buf);
-			if (value_len <= max_value_len) {
-				memcpy(value, dtvalue, value_len);
-				value[value_len] = '\0';
-				ret = true;
-			} else {
-				/* Property value overflow. */
-				LOG_ERR("%s value overflow.", name);
-				ret = false;
-			}
-		} else {
-			/* Property wrong format - no value. */
-			LOG_ERR("%s wrong format - no value.", name);
-			ret = false;
-		}
-	} else {
-		/* Property wrong format - no parameter or value. */
-		LOG_ERR("%s wrong format.", name);
-		ret = false;
+	value_len = line_len - (dtvalue - line);
+	if (value_len > max_value_len) {
+		/* Property value overflow. */
+		LOG_ERR("%s value overflow.", name);
+		return false;
 	}
 
-	return ret;
+	memcpy(value, dtvalue, value_len);
+	value[value_len] = '\0';
+
+	return true;
 }
 
-static size_t parse_calprops(const char *buf)
+static void parse_eventprop(struct icalendar_parser *ical, const char *line,
+			    size_t line_len, size_t name_len)
 {
-	const char *parsed = buf;
-	char *end = NULL;
-	char prop_value[CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE + 1];
+	struct ical_parser_evt *evt = &ical->evt;
+	struct ical_component *com = &evt->ical_com;
 
-	parsed = strstr(parsed, "BEGIN:VCALENDAR\r\n");
-	if (parsed == NULL) {
-		return 0;
+	/* Properties after an erroneous one are ignored. */
+	if (evt->error != ICAL_ERROR_NONE) {
+		return;
 	}
-	parsed += strlen("BEGIN:VCALENDAR\r\n");
 
-	end = strstr(parsed, "\r\nBEGIN:");
-	if (end == NULL) {
-		return 0;
-	}
-	end += strlen("\r\n");
-
-	while (parsed < end) {
-		memset(prop_value, 0, sizeof(prop_value));
-		if (!strncmp(parsed, "PRODID", 6)) {
-			if (!parse_desc_props(parsed, "PRODID", 6,
-					prop_value, sizeof(prop_value))) {
-				LOG_ERR("Wrong PRODID");
-			}
-		} else if (!strncmp(parsed, "VERSION", 7)) {
-			if (!parse_desc_props(parsed, "VERSION", 7,
-					prop_value, sizeof(prop_value))) {
-				LOG_ERR("Wrong VERSION");
-			}
+	if (prop_name_is(line, name_len, "SUMMARY")) {
+		if (ical->line_overflow ||
+		    !parse_desc_props(line, line_len, "SUMMARY", name_len,
+				      com->summary, CONFIG_ICAL_PARSER_SUMMARY_SIZE)) {
+			evt->error = ICAL_ERROR_SUMMARY;
+		}
+	} else if (prop_name_is(line, name_len, "LOCATION")) {
+		if (ical->line_overflow ||
+		    !parse_desc_props(line, line_len, "LOCATION", name_len,
+				      com->location, CONFIG_ICAL_PARSER_LOCATION_SIZE)) {
+			evt->error = ICAL_ERROR_LOCATION;
+		}
+	} else if (prop_name_is(line, name_len, "DESCRIPTION")) {
+		if (ical->line_overflow ||
+		    !parse_desc_props(line, line_len, "DESCRIPTION", name_len,
+				      com->description, CONFIG_ICAL_PARSER_DESCRIPTION_SIZE)) {
+			evt->error = ICAL_ERROR_DESCRIPTION;
+		}
+	} else if (prop_name_is(line, name_len, "DTSTART")) {
+		if (ical->line_overflow ||
+		    !parse_datetime_props(line, line_len, "DTSTART", name_len,
+					  com->dtstart, CONFIG_ICAL_PARSER_DTSTART_SIZE)) {
+			evt->error = ICAL_ERROR_DTSTART;
+		}
+	} else if (prop_name_is(line, name_len, "DTEND")) {
+		if (ical->line_overflow ||
+		    !parse_datetime_props(line, line_len, "DTEND", name_len,
+					  com->dtend, CONFIG_ICAL_PARSER_DTEND_SIZE)) {
+			evt->error = ICAL_ERROR_DTEND;
 		}
-		parsed = strstr(parsed, "\r\n");
-		parsed += strlen("\r\n");
 	}
-
-	return (parsed - buf);
 }
 
-static size_t parse_eventprop(const char *buf, struct ical_parser_evt *evt)
+static void parse_begin(struct icalendar_parser *ical, const char *value)
 {
-	const char *parsed = buf;
-	char *com_end;
+	const struct ical_component_name *com;
 
-	if (strncmp(buf, "BEGIN:VEVENT\r\n", strlen("BEGIN:VEVENT\r\n"))) {
-		return 0;
+	if (!ical->icalobject_begin) {
+		/* Reference: RFC 5545 3.4 iCalendar Object */
+		if (!strcasecmp(value, "VCALENDAR")) {
+			LOG_DBG("Found a calendar stream");
+			ical->icalobject_begin = true;
+		}
+		return;
 	}
 
-	com_end = strstr(buf, "END:VEVENT\r\n");
-	if (com_end == NULL) {
-		return 0;
+	if (ical->com_active) {
+		/* Nested component, e.g. VALARM in VEVENT */
+		ical->com_depth++;
+		return;
 	}
 
-	evt->id = ICAL_EVT_VEVENT;
-	evt->error = ICAL_ERROR_NONE;
-	com_end += strlen("END:VEVENT\r\n");
-	while (parsed < com_end) {
-		if (!strncasecmp(parsed, "SUMMARY", 7)) {
-			if (!parse_desc_props(
-				parsed, "SUMMARY", 7,
-				evt->ical_com.summary,
-				CONFIG_ICAL_PARSER_SUMMARY_SIZE)) {
-				evt->error = ICAL_ERROR_SUMMARY;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed, "LOCATION", 8)) {
-			if (!parse_desc_props(
-				parsed, "LOCATION", 8,
-				evt->ical_com.location,
-				CONFIG_ICAL_PARSER_LOCATION_SIZE)) {
-				evt->error = ICAL_ERROR_LOCATION;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed, "DESCRIPTION", 11)) {
-			if (!parse_desc_props(
-				parsed, "DESCRIPTION", 11,
-				evt->ical_com.description,
-				CONFIG_ICAL_PARSER_DESCRIPTION_SIZE)) {
-				evt->error = ICAL_ERROR_DESCRIPTION;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed, "DTSTART", 7)) {
-			if (!parse_datetime_props(
-				parsed, "DTSTART", 7,
-				evt->ical_com.dtstart,
-				CONFIG_ICAL_PARSER_DTSTART_SIZE)) {
-				evt->error = ICAL_ERROR_DTSTART;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed,
-					"DTEND", 5)) {
-			if (!parse_datetime_props(
-				parsed, "DTEND", 5,
-				evt->ical_com.dtend,
-				CONFIG_ICAL_PARSER_DTEND_SIZE)) {
-				evt->error = ICAL_ERROR_DTEND;
-				parsed = com_end;
-			}
-		}
-
-		/* Move parsed pointer to end of line break */
-		parsed = strstr(parsed, "\r\n") + 2;
+	com = find_component(value);
+	if (com == NULL) {
+		LOG_WRN("Unknown component %s", log_strdup(value));
+		return;
 	}
 
-	return parsed - buf;
+	memset(&ical->evt, 0, sizeof(ical->evt));
+	ical->evt.id = com->id;
+	ical->evt.error = (com->id == ICAL_EVT_VEVENT) ?
+			  ICAL_ERROR_NONE : ICAL_ERROR_COM_NOT_SUPPORTED;
+	ical->com_active = true;
+	ical->com_depth = 0;
 }
 
-static size_t parse_todoprop(const char *buf, struct ical_parser_evt *evt)
+/* Return non-zero if the application wants to stop parsing. */
+static int parse_end(struct icalendar_parser *ical, const char *value)
 {
-	const char *parsed = buf;
-	char *com_end;
-
-	com_end = strstr(buf, "END:VTODO\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VTODO\r\n");
+	if (!ical->icalobject_begin) {
+		return 0;
 	}
-	evt->id = ICAL_EVT_VTODO;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
-
-	return parsed - buf;
-}
 
-static size_t parse_jourprop(const char *buf,
-				struct ical_parser_evt *evt)
-{
-	const char *parsed = buf;
-	char *com_end;
+	if (!ical->com_active) {
+		if (!strcasecmp(value, "VCALENDAR")) {
+			ical->icalobject_begin = false;
+		}
+		return 0;
+	}
 
-	com_end = strstr(buf, "END:VJOURNAL\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VJOURNAL\r\n");
+	if (ical->com_depth > 0) {
+		ical->com_depth--;
+		return 0;
 	}
-	evt->id = ICAL_EVT_VJOURNAL;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
 
-	return parsed - buf;
+	/* Component closed, deliver it right away. */
+	ical->com_active = false;
+
+	return ical->callback(&ical->evt);
 }
 
-static size_t parse_fbprop(const char *buf, struct ical_parser_evt *evt)
+/* Process one unfolded content line. */
+static int parse_contentline(struct icalendar_parser *ical)
 {
-	const char *parsed = buf;
-	char *com_end;
-
-	com_end = strstr(buf, "END:VFREEBUSY\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VFREEBUSY\r\n");
+	const char *line = ical->line;
+	size_t line_len = ical->line_len;
+	size_t name_len;
+
+	ical->line[line_len] = '\0';
+	name_len = prop_name_len(line);
+
+	if (prop_name_is(line, name_len, "BEGIN") && line[name_len] == ':') {
+		parse_begin(ical, line + name_len + 1);
+	} else if (prop_name_is(line, name_len, "END") && line[name_len] == ':') {
+		return parse_end(ical, line + name_len + 1);
+	} else if (ical->com_active && ical->com_depth == 0 &&
+		   ical->evt.id == ICAL_EVT_VEVENT) {
+		parse_eventprop(ical, line, line_len, name_len);
+	} else if (ical->icalobject_begin && !ical->com_active) {
+		/* Calendar properties, e.g. PRODID and VERSION */
+		LOG_DBG("Calendar property %s", log_strdup(line));
 	}
-	evt->id = ICAL_EVT_VFREEBUSY;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
 
-	return parsed - buf;
+	return 0;
 }
 
-static size_t parse_tzprop(const char *buf, struct ical_parser_evt *evt)
+/* A component delimiter cannot be meaningfully folded, so it is processed as
+ * soon as its CRLF is received instead of waiting for the next character.
+ */
+static bool is_component_end(struct icalendar_parser *ical)
 {
-	const char *parsed = buf;
-	char *com_end;
+	static const char end[] = "END:";
 
-	com_end = strstr(buf, "END:VTIMEZONE\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VTIMEZONE\r\n");
-	}
-	evt->id = ICAL_EVT_VTIMEZONE;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
+	ical->line[ical->line_len] = '\0';
 
-	return parsed - buf;
+	return ical->line_len > sizeof(end) - 1 &&
+	       !strncasecmp(ical->line, end, sizeof(end) - 1) &&
+	       (find_component(ical->line + sizeof(end) - 1) != NULL ||
+		!strcasecmp(ical->line + sizeof(end) - 1, "VCALENDAR"));
 }
 
-static size_t parse_component(char *buf, struct ical_parser_evt *evt)
+static void line_append(struct icalendar_parser *ical, char c)
 {
-	char *com_begin = buf;
-	size_t ret = 0;
-
-	/* Search begin of component */
-	if (!strncmp(com_begin, "BEGIN:VEVENT\r\n", 14)) {
-		ret += parse_eventprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VTODO\r\n", 13)) {
-		ret += parse_todoprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VJOURNAL\r\n", 16)) {
-		ret += parse_jourprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VFREEBUSY\r\n", 17)) {
-		ret += parse_fbprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VTIMEZONE\r\n", 17)) {
-		ret += parse_tzprop(com_begin, evt);
+	if (ical->line_len < CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE) {
+		ical->line[ical->line_len++] = c;
+	} else if (!ical->line_overflow) {
+		LOG_WRN("Property value overflow. "
+			"Increase CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE.");
+		ical->line_overflow = true;
 	}
-
-	return ret;
 }
 
-static size_t parse_icalbody(char *buf,	icalendar_parser_callback_t callback)
+static int line_end(struct icalendar_parser *ical)
 {
-	size_t parsed_bytes = 0, parsed_offset = 0;
-
-	do {
-		struct ical_parser_evt evt;
+	int ret = 0;
 
-		parsed_bytes = parse_component(buf + parsed_offset, &evt);
-		parsed_offset += parsed_bytes;
-		if (parsed_bytes > 0) {
-			callback(&evt);
-		}
-	} while (parsed_bytes > 0);
+	if (ical->line_len > 0) {
+		ret = parse_contentline(ical);
+	}
+	ical->line_len = 0;
+	ical->line_overflow = false;
 
-	return parsed_offset;
+	return ret;
 }
 
 size_t ical_parser_parse(struct icalendar_parser *ical, const char *data, size_t len)
 {
-	size_t parsed_offset = 0;
-
-	if (CONFIG_ICAL_PARSER_BUFFER_SIZE < (ical->offset + len)) {
-		return -ENOBUFS;
-	}
+	size_t i;
 
-	memcpy(ical->buf + ical->offset, data, len);
-	ical->buf[ical->offset + len] = '\0';
+	for (i = 0; i < len; i++) {
+		char c = data[i];
 
-	/* Check begin of iCalendar object delimiter
-	 * Reference: RFC 5545 3.4 iCalendar Object
-	 */
-	if (!ical->icalobject_begin) {
-		/* The body of the iCalendar object consists of
-		 * a sequence of calendar properties and
-		 * one or more calendar components.
-		 *
-		 * Reference: RFC 5545 3.6 Calendar Components
-		 */
-		parsed_offset += parse_calprops(ical->buf);
-		if (parsed_offset > 0) {
-			LOG_DBG("Found a calendar stream");
-			ical->icalobject_begin = true;
+		if (ical->line_state == LINE_CRLF) {
+			if (c == ' ' || c == '\t') {
+				/* Long content line is folded. Reference: RFC 5545 3.1 */
+				ical->line_state = LINE_DATA;
+				continue;
+			}
+			ical->line_state = LINE_DATA;
+			if (line_end(ical)) {
+				return i;
+			}
 		}
-	}
 
-	/* If we got a calendar property, start parsing calendar body. */
-	if (ical->icalobject_begin) {
-		parsed_offset += parse_icalbody(ical->buf + parsed_offset, ical->callback);
-	}
+		if (ical->line_state == LINE_CR) {
+			if (c == '\n') {
+				ical->line_state = LINE_CRLF;
+				if (is_component_end(ical)) {
+					ical->line_state = LINE_DATA;
+					if (line_end(ical)) {
+						return i + 1;
+					}
+				}
+				continue;
+			}
+			/* Lone CR is part of the line */
+			line_append(ical, '\r');
+			ical->line_state = LINE_DATA;
+		}
 
-	if (parsed_offset) {
-		ical->offset = ical->offset + len - parsed_offset;
-		memcpy(ical->buf, ical->buf + parsed_offset, ical->offset);
+		if (c == '\r') {
+			ical->line_state = LINE_CR;
+		} else {
+			line_append(ical, c);
+		}
 	}
 
-	return parsed_offset;
+	return i;
 }
 
 int ical_parser_init(struct icalendar_parser *ical, icalendar_parser_callback_t callback)
@@ -406,7 +352,11 @@ int ical_parser_init(struct icalendar_parser *ical, icalendar_parser_callback_t
 
 	ical->callback = callback;
 	ical->icalobject_begin = false;
-	ical->offset = 0;
+	ical->com_active = false;
+	ical->com_depth = 0;
+	ical->line_state = LINE_DATA;
+	ical->line_len = 0;
+	ical->line_overflow = false;
 
 	return 0;
 }
@@ -14,6 +14,8 @@
 LOG_MODULE_REGISTER(lwm2m_fota_settings, CONFIG_LWM2M_CLIENT_UTILS_LOG_LEVEL);
 
 static struct update_counter uc;
+static struct lwm2m_client_utils_download_state download_state;
+static bool download_state_valid;
 
 int fota_update_counter_read(struct update_counter *update_counter)
 {
@@ -32,6 +34,38 @@ int fota_update_counter_update(enum counter_type type, uint32_t new_value)
 	return settings_save_one("fota/counter", &uc, sizeof(uc));
 }
 
+int lwm2m_client_utils_download_state_read(
+	struct lwm2m_client_utils_download_state *state)
+{
+	if (!download_state_valid) {
+		return -ENOENT;
+	}
+
+	memcpy(state, &download_state, sizeof(download_state));
+	return 0;
+}
+
+int lwm2m_client_utils_download_state_save(
+	const struct lwm2m_client_utils_download_state *state)
+{
+	memcpy(&download_state, state, sizeof(download_state));
+	download_state_valid = true;
+
+	return settings_save_one("fota/download", &download_state,
+				 sizeof(download_state));
+}
+
+int lwm2m_client_utils_download_state_clear(void)
+{
+	if (!download_state_valid) {
+		return 0;
+	}
+
+	download_state_valid = false;
+
+	return settings_delete("fota/download");
+}
+
 static int set(const char *key, size_t len_rd, settings_read_cb read_cb,
 	       void *cb_arg)
 {
@@ -55,6 +89,22 @@ static int set(const char *key, size_t len_rd, settings_read_cb read_cb,
 		return 0;
 	}
 
+	if (!strncmp(key, "download", key_len)) {
+		/* Deleted */
+		if (len_rd == 0) {
+			download_state_valid = false;
+			return 0;
+		}
+
+		len = read_cb(cb_arg, &download_state, sizeof(download_state));
+		download_state_valid = (len == sizeof(download_state));
+		if (!download_state_valid) {
+			LOG_WRN("Unable to read download state, ignoring it.");
+		}
+
+		return 0;
+	}
+
 	return -ENOENT;
 }
 
@@ -15,6 +15,10 @@
 #include <net/lwm2m.h>
 #include <modem/nrf_modem_lib.h>
 #include <sys/reboot.h>
+#ifdef CONFIG_LWM2M_CLIENT_UTILS_FIRMWARE_WRITE_BEHIND
+#include <sys/atomic.h>
+#include <sys/ring_buffer.h>
+#endif
 
 #include <net/lwm2m_client_utils.h>
 #include <net/lwm2m_client_utils_fota.h>
@@ -33,8 +37,33 @@ static uint8_t mcuboot_buf[CONFIG_APP_MCUBOOT_FLASH_BUF_SZ] __aligned(4);
 
 static int image_type;
 
+/* Progress of the current download. It is stored so that a download that is
+ * restarted after an interruption can be told apart from a new one.
+ */
+static struct lwm2m_client_utils_download_state download_state;
+
 static struct k_work_delayable reboot_work;
 
+#ifdef CONFIG_LWM2M_CLIENT_UTILS_FIRMWARE_WRITE_BEHIND
+#define WRITER_STACK_SIZE CONFIG_LWM2M_CLIENT_UTILS_FIRMWARE_WRITE_STACK_SIZE
+#define WRITER_PRIORITY K_LOWEST_APPLICATION_THREAD_PRIO
+#define QUEUE_SIZE (CONFIG_LWM2M_CLIENT_UTILS_FIRMWARE_WRITE_WINDOW * \
+		    CONFIG_LWM2M_COAP_BLOCK_SIZE)
+/* Wait for the writer in steps, the writer only signals freed space. */
+#define FLUSH_POLL_TIME K_MSEC(100)
+
+/* Blocks are queued here by the LwM2M engine thread and written to the DFU
+ * target by the writer thread, straight from the buffer. A block is
+ * acknowledged as soon as it is queued.
+ */
+RING_BUF_DECLARE(block_queue, QUEUE_SIZE);
+static K_MUTEX_DEFINE(queue_lock);
+static K_SEM_DEFINE(queue_data_sem, 0, 1);
+static K_SEM_DEFINE(queue_space_sem, 0, 1);
+/* First write error, or -ECANCELED. Queued data is discarded when set. */
+static atomic_t queue_err;
+#endif
+
 void client_acknowledge(void);
 
 static void reboot_work_handler(struct k_work *work)
@@ -100,6 +129,202 @@ static void dfu_target_cb(enum dfu_target_evt_id evt)
 	ARG_UNUSED(evt);
 }
 
+/* Resume the download only if the DFU target holds the start of the same
+ * image. Otherwise the data in the target is discarded and the download
+ * starts from offset 0.
+ */
+static int download_state_init(size_t *offset, size_t total_size)
+{
+	struct lwm2m_client_utils_download_state saved;
+	int ret;
+
+	if (*offset == 0) {
+		LOG_DBG("Nothing written to the DFU target");
+	} else if (lwm2m_client_utils_download_state_read(&saved) == 0 &&
+		   saved.image_type == image_type &&
+		   saved.total_size == total_size) {
+		LOG_INF("Resuming firmware download, %d bytes written.",
+			*offset);
+	} else {
+		LOG_WRN("DFU target holds %d bytes of another download.",
+			*offset);
+
+		ret = dfu_target_reset();
+		if (ret < 0) {
+			LOG_ERR("Failed to reset DFU target, err: %d", ret);
+			return ret;
+		}
+
+		ret = dfu_target_init(image_type, total_size, dfu_target_cb);
+		if (ret < 0) {
+			LOG_ERR("Failed to init DFU target, err: %d", ret);
+			return ret;
+		}
+
+		*offset = 0;
+	}
+
+	download_state.image_type = image_type;
+	download_state.total_size = total_size;
+	download_state.offset = *offset;
+
+	return 0;
+}
+
+static int target_write(const uint8_t *data, size_t len)
+{
+	uint32_t prev = download_state.offset;
+	int ret;
+
+	ret = dfu_target_write(data, len);
+	if (ret < 0) {
+		LOG_ERR("dfu_target_write error, err %d", ret);
+		return ret;
+	}
+
+	download_state.offset += len;
+
+	/* Settings are written to flash too, so do not store every block */
+	if (download_state.offset / BYTE_PROGRESS_STEP >
+	    prev / BYTE_PROGRESS_STEP) {
+		ret = lwm2m_client_utils_download_state_save(
+			&download_state);
+		if (ret) {
+			LOG_WRN("Unable to store download state, err %d", ret);
+		}
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_LWM2M_CLIENT_UTILS_FIRMWARE_WRITE_BEHIND
+static void writer_thread_fn(void *p1, void *p2, void *p3)
+{
+	uint8_t *data;
+	uint32_t len;
+	int ret;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (true) {
+		k_sem_take(&queue_data_sem, K_FOREVER);
+
+		while (true) {
+			k_mutex_lock(&queue_lock, K_FOREVER);
+			len = ring_buf_get_claim(&block_queue, &data,
+						 QUEUE_SIZE);
+			k_mutex_unlock(&queue_lock);
+
+			if (len == 0) {
+				break;
+			}
+
+			if (atomic_get(&queue_err) == 0) {
+				ret = target_write(data, len);
+				if (ret < 0) {
+					atomic_cas(&queue_err, 0, ret);
+				}
+			}
+
+			k_mutex_lock(&queue_lock, K_FOREVER);
+			(void)ring_buf_get_finish(&block_queue, len);
+			k_mutex_unlock(&queue_lock);
+
+			k_sem_give(&queue_space_sem);
+		}
+	}
+}
+
+K_THREAD_DEFINE(lwm2m_firmware_writer, WRITER_STACK_SIZE, writer_thread_fn,
+		NULL, NULL, NULL, WRITER_PRIORITY, 0, 0);
+
+/* Wait until the queue is empty. Returns the first write error, if any. */
+static int queue_flush(void)
+{
+	bool empty;
+
+	while (true) {
+		k_mutex_lock(&queue_lock, K_FOREVER);
+		empty = ring_buf_is_empty(&block_queue);
+		k_mutex_unlock(&queue_lock);
+
+		if (empty) {
+			break;
+		}
+
+		(void)k_sem_take(&queue_space_sem, FLUSH_POLL_TIME);
+	}
+
+	return atomic_get(&queue_err);
+}
+#endif /* CONFIG_LWM2M_CLIENT_UTILS_FIRMWARE_WRITE_BEHIND */
+
+/* Pass a block on to the DFU target. With write-behind, the block is queued
+ * and the LwM2M engine only waits when the write window is full. A write
+ * error is then returned for a later block.
+ */
+static int block_write(const uint8_t *data, size_t len)
+{
+#ifdef CONFIG_LWM2M_CLIENT_UTILS_FIRMWARE_WRITE_BEHIND
+	uint32_t put;
+	int ret;
+
+	while (len > 0) {
+		ret = atomic_get(&queue_err);
+		if (ret != 0) {
+			return ret;
+		}
+
+		k_mutex_lock(&queue_lock, K_FOREVER);
+		put = ring_buf_put(&block_queue, data, len);
+		k_mutex_unlock(&queue_lock);
+
+		if (put > 0) {
+			data += put;
+			len -= put;
+			k_sem_give(&queue_data_sem);
+			continue;
+		}
+
+		(void)k_sem_take(&queue_space_sem, K_FOREVER);
+	}
+
+	return 0;
+#else
+	return target_write(data, len);
+#endif
+}
+
+/* Wait for the queued blocks to be written. */
+static int blocks_flush(void)
+{
+#ifdef CONFIG_LWM2M_CLIENT_UTILS_FIRMWARE_WRITE_BEHIND
+	return queue_flush();
+#else
+	return 0;
+#endif
+}
+
+/* Discard the queued blocks and wait for the writer to let go of the
+ * DFU target.
+ */
+static void blocks_abort(void)
+{
+#ifdef CONFIG_LWM2M_CLIENT_UTILS_FIRMWARE_WRITE_BEHIND
+	atomic_cas(&queue_err, 0, -ECANCELED);
+	(void)queue_flush();
+#endif
+}
+
+static void blocks_start(void)
+{
+#ifdef CONFIG_LWM2M_CLIENT_UTILS_FIRMWARE_WRITE_BEHIND
+	atomic_set(&queue_err, 0);
+#endif
+}
+
 static int firmware_block_received_cb(uint16_t obj_inst_id,
 				      uint16_t res_id, uint16_t res_inst_id,
 				      uint8_t *data, uint16_t data_len,
@@ -107,9 +332,9 @@ static int firmware_block_received_cb(uint16_t obj_inst_id,
 {
 	static uint8_t percent_downloaded;
 	static uint32_t bytes_downloaded;
+	static size_t offset;
 	uint8_t curent_percent;
 	uint32_t current_bytes;
-	size_t offset;
 	size_t skip = 0;
 	int ret = 0;
 
@@ -133,12 +358,23 @@ static int firmware_block_received_cb(uint16_t obj_inst_id,
 			image_type == DFU_TARGET_IMAGE_TYPE_MODEM_DELTA ?
 				"Modem" :
 				"Application");
-	}
 
-	ret = dfu_target_offset_get(&offset);
-	if (ret < 0) {
-		LOG_ERR("Failed to obtain current offset, err: %d", ret);
-		goto cleanup;
+		/* The blocks up to here were written before an interruption.
+		 * Later blocks may still be queued, so this is only read once.
+		 */
+		ret = dfu_target_offset_get(&offset);
+		if (ret < 0) {
+			LOG_ERR("Failed to obtain current offset, err: %d",
+				ret);
+			goto cleanup;
+		}
+
+		ret = download_state_init(&offset, total_size);
+		if (ret < 0) {
+			goto cleanup;
+		}
+
+		blocks_start();
 	}
 
 	/* Display a % downloaded or byte progress, if no total size was
@@ -167,40 +403,53 @@ static int firmware_block_received_cb(uint16_t obj_inst_id,
 
 	bytes_downloaded += data_len;
 
-	if (skip == data_len) {
+	if (skip == data_len && !last_block) {
 		/* Nothing to do. */
 		return 0;
 	}
 
-	ret = dfu_target_write(data + skip, data_len - skip);
-	if (ret < 0) {
-		LOG_ERR("dfu_target_write error, err %d", ret);
-		goto cleanup;
+	if (skip < data_len) {
+		ret = block_write(data + skip, data_len - skip);
+		if (ret < 0) {
+			goto cleanup;
+		}
 	}
 
 	if (!last_block) {
 		/* Keep going */
 		return 0;
-	} else {
-		LOG_INF("Firmware downloaded, %d bytes in total",
-			bytes_downloaded);
 	}
 
+	ret = blocks_flush();
+	if (ret < 0) {
+		goto cleanup;
+	}
+
+	LOG_INF("Firmware downloaded, %d bytes in total", bytes_downloaded);
+
 	if (total_size && (bytes_downloaded != total_size)) {
 		LOG_ERR("Early last block, downloaded %d, expecting %d",
 			bytes_downloaded, total_size);
 		ret = -EIO;
+	} else {
+		(void)lwm2m_client_utils_download_state_clear();
 	}
 
 cleanup:
 	if (ret < 0) {
-		if (dfu_target_reset() < 0) {
-			LOG_ERR("Failed to reset DFU target");
+		blocks_abort();
+		/* Keep the written data, so that the download can be resumed.
+		 * It is discarded by download_state_init if the server sends
+		 * another image.
+		 */
+		if (dfu_target_done(false) < 0) {
+			LOG_ERR("Failed to abort DFU target");
 		}
 	}
 
 	bytes_downloaded = 0;
 	percent_downloaded = 0;
+	offset = 0;
 
 	return ret;
 }
@@ -266,6 +515,7 @@ int lwm2m_init_image(void)
 {
 	int ret = 0;
 	struct update_counter counter;
+	struct lwm2m_client_utils_download_state download;
 	bool image_ok;
 
 	/* Update boot status and update counter */
@@ -318,6 +568,12 @@ int lwm2m_init_image(void)
 		lwm2m_engine_set_u8("5/0/5", RESULT_UPDATE_FAILED);
 	}
 
+	if (lwm2m_client_utils_download_state_read(&download) == 0) {
+		LOG_INF("Firmware download interrupted after %d bytes, "
+			"it resumes when the transfer is restarted",
+			download.offset);
+	}
+
 #ifdef CONFIG_DFU_TARGET_MCUBOOT
 	/* Set the required buffer for MCUboot targets */
 	ret = dfu_target_mcuboot_set_buf(mcuboot_buf, sizeof(mcuboot_buf));
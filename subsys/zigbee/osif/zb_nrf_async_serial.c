@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <kernel.h>
+#include <drivers/uart.h>
+#include <zboss_api.h>
+#include "zb_nrf_platform.h"
+#include <sys/ring_buffer.h>
+#include <logging/log.h>
+
+LOG_MODULE_DECLARE(zboss_osif, CONFIG_ZBOSS_OSIF_LOG_LEVEL);
+
+static K_SEM_DEFINE(tx_done_sem, 1, 1);
+static K_SEM_DEFINE(rx_done_sem, 1, 1);
+static const struct device *uart_dev;
+static bool is_sleeping;
+
+static zb_callback_t char_handler;
+static serial_recv_data_cb_t rx_data_cb;
+static serial_send_data_cb_t tx_data_cb;
+static serial_send_data_cb_t tx_trx_data_cb;
+
+static uint8_t uart_tx_buf_mem[CONFIG_ZIGBEE_UART_TX_BUF_LEN];
+static size_t uart_tx_buf_size;
+
+static uint8_t *uart_tx_buf;
+static uint8_t *uart_tx_buf_bak;
+
+static uint8_t uart_rx_buf_mem[CONFIG_ZIGBEE_UART_RX_BUF_LEN];
+static struct ring_buf rx_ringbuf;
+static struct k_spinlock rx_lock;
+
+static uint8_t *uart_rx_buf;
+static volatile size_t uart_rx_buf_offset;
+static volatile size_t uart_rx_buf_len;
+
+/* Two DMA buffers, so that the UARTE receives continuously while
+ * the data from the other buffer is handed over.
+ */
+static uint8_t uart_rx_dma_buf[2][CONFIG_ZIGBEE_UART_RX_DMA_BUF_LEN];
+static uint8_t uart_rx_dma_buf_idx;
+
+/**
+ * Inform user about received data and unlock for the next reception.
+ */
+static void uart_rx_notify(zb_bufid_t bufid)
+{
+	uint8_t *rx_buf = uart_rx_buf;
+	size_t rx_buf_len = uart_rx_buf_offset;
+
+	ARG_UNUSED(bufid);
+
+	uart_rx_buf_len = 0;
+	uart_rx_buf_offset = 0;
+	uart_rx_buf = NULL;
+	k_sem_give(&rx_done_sem);
+
+	if (rx_data_cb) {
+		rx_data_cb(rx_buf, rx_buf_len);
+	}
+}
+
+static void uart_rx_bytes(const uint8_t *buf, size_t len)
+{
+	if (char_handler) {
+		for (size_t i = 0; i < len; i++) {
+			char_handler(buf[i]);
+		}
+	}
+}
+
+static void uart_rx_buf_complete(void)
+{
+	uart_rx_buf_len = 0;
+
+	if (zigbee_schedule_callback(uart_rx_notify, 0)) {
+		uart_rx_buf_offset = 0;
+		uart_rx_buf = NULL;
+		k_sem_give(&rx_done_sem);
+	}
+}
+
+/**
+ * Hand over data received by DMA.
+ *
+ * @param data  Received data.
+ * @param len   Length of received data.
+ * @param idle  True if the reception stopped because of the line being idle.
+ */
+static void handle_rx_ready_evt(const uint8_t *data, size_t len, bool idle)
+{
+	k_spinlock_key_t key = k_spin_lock(&rx_lock);
+
+	uart_rx_bytes(data, len);
+
+	/* Copy data directly to the user's buffer. */
+	if (uart_rx_buf && (uart_rx_buf_offset < uart_rx_buf_len)) {
+		size_t copy_len;
+
+		uart_rx_buf_offset += ring_buf_get(
+			&rx_ringbuf,
+			&uart_rx_buf[uart_rx_buf_offset],
+			uart_rx_buf_len - uart_rx_buf_offset);
+
+		copy_len = MIN(len, uart_rx_buf_len - uart_rx_buf_offset);
+		memcpy(&uart_rx_buf[uart_rx_buf_offset], data, copy_len);
+		uart_rx_buf_offset += copy_len;
+		data += copy_len;
+		len -= copy_len;
+
+		/* Idle line ends a partial reception, replacing the software
+		 * partial reception timer.
+		 */
+		if ((uart_rx_buf_offset == uart_rx_buf_len) || idle) {
+			uart_rx_buf_complete();
+		}
+	}
+
+	/* Store remaining bytes inside the ring buffer. */
+	if (len > ring_buf_space_get(&rx_ringbuf)) {
+		(void)ring_buf_get(&rx_ringbuf, NULL,
+				   len - ring_buf_space_get(&rx_ringbuf));
+	}
+	(void)ring_buf_put(&rx_ringbuf, data, len);
+
+	k_spin_unlock(&rx_lock, key);
+}
+
+static void handle_tx_done_evt(int result)
+{
+	uart_tx_buf = uart_tx_buf_bak;
+	k_sem_give(&tx_done_sem);
+
+	if (tx_trx_data_cb) {
+		zigbee_schedule_callback(tx_trx_data_cb, result);
+		tx_trx_data_cb = NULL;
+	}
+}
+
+static int uart_rx_start(void)
+{
+	uart_rx_dma_buf_idx = 0;
+
+	return uart_rx_enable(uart_dev,
+			      uart_rx_dma_buf[0],
+			      sizeof(uart_rx_dma_buf[0]),
+			      CONFIG_ZIGBEE_UART_PARTIAL_RX_TIMEOUT);
+}
+
+static void uart_callback(const struct device *dev,
+			  struct uart_event *evt,
+			  void *user_data)
+{
+	ARG_UNUSED(dev);
+	ARG_UNUSED(user_data);
+
+	switch (evt->type) {
+	case UART_RX_RDY:
+		handle_rx_ready_evt(
+			&evt->data.rx.buf[evt->data.rx.offset],
+			evt->data.rx.len,
+			(evt->data.rx.offset + evt->data.rx.len) <
+				sizeof(uart_rx_dma_buf[0]));
+		break;
+
+	case UART_RX_BUF_REQUEST:
+		uart_rx_dma_buf_idx ^= 1;
+		(void)uart_rx_buf_rsp(uart_dev,
+				      uart_rx_dma_buf[uart_rx_dma_buf_idx],
+				      sizeof(uart_rx_dma_buf[0]));
+		break;
+
+	case UART_RX_DISABLED:
+		/* Reception is stopped on errors and before sleep. */
+		if (!is_sleeping) {
+			(void)uart_rx_start();
+		}
+		break;
+
+	case UART_RX_STOPPED:
+		LOG_WRN("UART RX stopped, reason: %d", evt->data.rx_stop.reason);
+		break;
+
+	case UART_TX_DONE:
+		handle_tx_done_evt(SERIAL_SEND_SUCCESS);
+		break;
+
+	case UART_TX_ABORTED:
+		handle_tx_done_evt(SERIAL_SEND_TIMEOUT_EXPIRED);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void zb_osif_serial_init(void)
+{
+	if (uart_dev != NULL) {
+		return;
+	}
+
+	/*
+	 * Reset all static variables in case of runtime init/uninit sequence.
+	 */
+	char_handler = NULL;
+	rx_data_cb = NULL;
+	tx_data_cb = NULL;
+	tx_trx_data_cb = NULL;
+	uart_tx_buf = uart_tx_buf_mem;
+	uart_tx_buf_bak = uart_tx_buf_mem;
+	uart_tx_buf_size = sizeof(uart_tx_buf_mem);
+	uart_rx_buf = NULL;
+	uart_rx_buf_len = 0;
+	uart_rx_buf_offset = 0;
+
+	uart_dev = device_get_binding(CONFIG_ZIGBEE_UART_DEVICE_NAME);
+	if (uart_dev == NULL) {
+		return;
+	}
+
+	ring_buf_init(&rx_ringbuf, sizeof(uart_rx_buf_mem), uart_rx_buf_mem);
+
+	if (uart_callback_set(uart_dev, uart_callback, NULL)) {
+		LOG_ERR("UART async API is not supported by %s",
+			CONFIG_ZIGBEE_UART_DEVICE_NAME);
+		uart_dev = NULL;
+		return;
+	}
+
+	if (uart_rx_start()) {
+		LOG_ERR("Unable to start UART reception");
+	}
+}
+
+void zb_osif_set_uart_byte_received_cb(zb_callback_t hnd)
+{
+	char_handler = hnd;
+}
+
+void zb_osif_set_user_io_buffer(zb_byte_array_t *buf_ptr, zb_ushort_t capacity)
+{
+	(void)k_sem_take(&tx_done_sem, K_FOREVER);
+
+	uart_tx_buf = buf_ptr->ring_buf;
+	uart_tx_buf_size = capacity;
+
+	k_sem_give(&tx_done_sem);
+}
+
+void zb_osif_uart_sleep(void)
+{
+	if (uart_dev == NULL) {
+		return;
+	}
+
+	is_sleeping = true;
+	(void)uart_tx_abort(uart_dev);
+	(void)uart_rx_disable(uart_dev);
+}
+
+void zb_osif_uart_wake_up(void)
+{
+	if (uart_dev == NULL) {
+		return;
+	}
+
+	is_sleeping = false;
+	(void)uart_rx_start();
+}
+
+void zb_osif_serial_put_bytes(const zb_uint8_t *buf, zb_short_t len)
+{
+#if !(defined(ZB_HAVE_ASYNC_SERIAL) && \
+	defined(CONFIG_ZBOSS_TRACE_LOG_LEVEL_OFF))
+
+	if ((uart_dev == NULL) || is_sleeping) {
+		return;
+	}
+
+	if (len > uart_tx_buf_size) {
+		return;
+	}
+
+	/*
+	 * Wait forever since there is no way to inform higher layer
+	 * about TX busy state.
+	 */
+	(void)k_sem_take(&tx_done_sem, K_FOREVER);
+	memcpy(uart_tx_buf, buf, len);
+
+	if (uart_tx(uart_dev, uart_tx_buf, len, SYS_FOREVER_MS)) {
+		k_sem_give(&tx_done_sem);
+	}
+
+#endif /* !(ZB_HAVE_ASYNC_SERIAL && CONFIG_ZBOSS_TRACE_LOG_LEVEL_OFF) */
+}
+
+void zb_osif_serial_recv_data(zb_uint8_t *buf, zb_ushort_t len)
+{
+	k_spinlock_key_t key;
+
+	if (!rx_data_cb) {
+		return;
+	}
+
+	if ((uart_dev == NULL) || (len == 0) || is_sleeping) {
+		if (rx_data_cb) {
+			rx_data_cb(NULL, 0);
+		}
+		return;
+	}
+
+	if (k_sem_take(&rx_done_sem,
+		       K_MSEC(CONFIG_ZIGBEE_UART_RX_TIMEOUT))) {
+		/* Ongoing asynchronous reception. */
+		if (rx_data_cb) {
+			rx_data_cb(NULL, 0);
+		}
+		return;
+	}
+
+	/* Flush already received data. */
+	key = k_spin_lock(&rx_lock);
+	uart_rx_buf_offset = ring_buf_get(&rx_ringbuf, buf, len);
+
+	if (uart_rx_buf_offset == len) {
+		uart_rx_buf_offset = 0;
+		k_spin_unlock(&rx_lock, key);
+		k_sem_give(&rx_done_sem);
+		rx_data_cb(buf, len);
+		return;
+	}
+
+	/*
+	 * Since the driver is kept in a continuous reception, it is enough to
+	 * pass the buffer through a variable.
+	 */
+	uart_rx_buf_len = len;
+	uart_rx_buf = buf;
+	k_spin_unlock(&rx_lock, key);
+}
+
+void zb_osif_serial_set_cb_recv_data(serial_recv_data_cb_t cb)
+{
+	rx_data_cb = cb;
+}
+
+void zb_osif_serial_send_data(zb_uint8_t *buf, zb_ushort_t len)
+{
+	if ((uart_dev == NULL) || is_sleeping) {
+		if (tx_data_cb) {
+			tx_data_cb(SERIAL_SEND_ERROR);
+		}
+		return;
+	}
+
+	if (k_sem_take(&tx_done_sem, K_MSEC(CONFIG_ZIGBEE_UART_TX_TIMEOUT))) {
+		/* Ongoing synchronous transmission. */
+		if (tx_data_cb) {
+			tx_data_cb(SERIAL_SEND_BUSY);
+		}
+		return;
+	}
+
+	/* Transmit directly from the ZBOSS buffer. */
+	uart_tx_buf_bak = uart_tx_buf;
+	uart_tx_buf = buf;
+
+	/* Pass the TX callback for a single (ongoing) tranmission. */
+	tx_trx_data_cb = tx_data_cb;
+
+	if (uart_tx(uart_dev, buf, len, SYS_FOREVER_MS)) {
+		tx_trx_data_cb = NULL;
+		uart_tx_buf = uart_tx_buf_bak;
+		k_sem_give(&tx_done_sem);
+		if (tx_data_cb) {
+			tx_data_cb(SERIAL_SEND_ERROR);
+		}
+	}
+}
+
+void zb_osif_serial_set_cb_send_data(serial_send_data_cb_t cb)
+{
+	tx_data_cb = cb;
+}
+
+void zb_osif_serial_flush(void)
+{
+	(void)k_sem_take(&tx_done_sem, K_FOREVER);
+	k_sem_give(&tx_done_sem);
+}
@@ -9,6 +9,7 @@
 #include <logging/log.h>
 
 #include <zboss_api.h>
+#include "zb_nrf_platform.h"
 
 #ifdef ZB_USE_NVRAM
 
@@ -33,6 +34,42 @@ static const struct flash_area *fa; /* ZBOSS nvram */
 static const struct flash_area *fa_pc; /* production config */
 #endif
 
+static struct {
+	atomic_t writes;
+	atomic_t flash_writes;
+	atomic_t errors;
+} nvram_stats;
+
+#ifdef CONFIG_ZIGBEE_NVRAM_WRITE_BUFFER
+
+#define NVRAM_WQ_PRIORITY (CONFIG_ZBOSS_DEFAULT_THREAD_PRIORITY + 1)
+
+/* Continuous range of NVRAM data not yet written to flash. */
+struct nvram_write_buf {
+	uint8_t page;
+	uint32_t pos;
+	uint16_t len;
+	uint8_t data[CONFIG_ZIGBEE_NVRAM_WRITE_BUFFER_SIZE] __aligned(4);
+};
+
+static K_THREAD_STACK_DEFINE(nvram_wq_stack,
+			     CONFIG_ZIGBEE_NVRAM_THREAD_STACK_SIZE);
+static struct k_work_q nvram_wq;
+static struct k_work nvram_write_work;
+
+static struct nvram_write_buf write_bufs[2];
+/* Buffer collecting writes, only accessed from the ZBOSS thread. */
+static struct nvram_write_buf *active_buf = &write_bufs[0];
+/* Buffer being written to flash by the NVRAM work queue. */
+static struct nvram_write_buf *pending_buf;
+/* Available when no buffer is being written to flash. */
+static K_SEM_DEFINE(nvram_idle_sem, 1, 1);
+/* Set if writing a buffer failed, until reported to ZBOSS. */
+static atomic_t nvram_write_failed;
+
+static void nvram_write_work_handler(struct k_work *work);
+#endif /* CONFIG_ZIGBEE_NVRAM_WRITE_BUFFER */
+
 void zb_osif_nvram_init(const zb_char_t *name)
 {
 	ARG_UNUSED(name);
@@ -49,6 +86,13 @@ void zb_osif_nvram_init(const zb_char_t *name)
 		LOG_ERR("Can't open product config flash area");
 	}
 #endif
+
+#ifdef CONFIG_ZIGBEE_NVRAM_WRITE_BUFFER
+	k_work_queue_start(&nvram_wq, nvram_wq_stack,
+			   K_THREAD_STACK_SIZEOF(nvram_wq_stack),
+			   NVRAM_WQ_PRIORITY, NULL);
+	k_work_init(&nvram_write_work, nvram_write_work_handler);
+#endif
 }
 
 zb_uint32_t zb_get_nvram_page_length(void)
@@ -66,6 +110,102 @@ static zb_uint32_t get_page_base_offset(int page_num)
 	return (page_num * zb_get_nvram_page_length());
 }
 
+static int nvram_flash_write(uint8_t page, uint32_t pos, const void *buf,
+			     uint16_t len)
+{
+	int err = flash_area_write(fa, get_page_base_offset(page) + pos,
+				   buf, len);
+
+	atomic_inc(&nvram_stats.flash_writes);
+	if (err) {
+		atomic_inc(&nvram_stats.errors);
+		LOG_ERR("Write error: %d", err);
+	}
+
+	return err;
+}
+
+#ifdef CONFIG_ZIGBEE_NVRAM_WRITE_BUFFER
+static void nvram_write_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	if (nvram_flash_write(pending_buf->page, pending_buf->pos,
+			      pending_buf->data, pending_buf->len)) {
+		atomic_set(&nvram_write_failed, 1);
+	}
+	pending_buf->len = 0;
+	k_sem_give(&nvram_idle_sem);
+}
+
+/* Hand the collected writes over to the NVRAM work queue. Blocks while
+ * the previous buffer is still being written.
+ */
+static void nvram_buf_submit(void)
+{
+	if (active_buf->len == 0) {
+		return;
+	}
+
+	k_sem_take(&nvram_idle_sem, K_FOREVER);
+	pending_buf = active_buf;
+	active_buf = (active_buf == &write_bufs[0]) ?
+		     &write_bufs[1] : &write_bufs[0];
+	k_work_submit_to_queue(&nvram_wq, &nvram_write_work);
+}
+
+/* Write all collected data and wait until it is in flash. */
+static void nvram_buf_sync(void)
+{
+	nvram_buf_submit();
+	k_sem_take(&nvram_idle_sem, K_FOREVER);
+	k_sem_give(&nvram_idle_sem);
+}
+
+/* Return the failure of a buffered write once, as ZBOSS learns about
+ * it only from the next NVRAM operation.
+ */
+static bool nvram_buf_failed(void)
+{
+	return atomic_clear(&nvram_write_failed) != 0;
+}
+
+static zb_ret_t nvram_buf_write(zb_uint8_t page, zb_uint32_t pos,
+				const void *buf, zb_uint16_t len)
+{
+	if (nvram_buf_failed()) {
+		return RET_ERROR;
+	}
+
+	if (len > sizeof(active_buf->data)) {
+		/* Keep the order of writes and bypass the buffer. */
+		nvram_buf_sync();
+		if (nvram_buf_failed()) {
+			return RET_ERROR;
+		}
+		return nvram_flash_write(page, pos, buf, len) ?
+		       RET_ERROR : RET_OK;
+	}
+
+	if ((active_buf->len > 0) &&
+	    ((active_buf->page != page) ||
+	     (active_buf->pos + active_buf->len != pos) ||
+	     (active_buf->len + len > sizeof(active_buf->data)))) {
+		nvram_buf_submit();
+	}
+
+	if (active_buf->len == 0) {
+		active_buf->page = page;
+		active_buf->pos = pos;
+	}
+
+	memcpy(&active_buf->data[active_buf->len], buf, len);
+	active_buf->len += len;
+
+	return RET_OK;
+}
+#endif /* CONFIG_ZIGBEE_NVRAM_WRITE_BUFFER */
+
 zb_ret_t zb_osif_nvram_read(zb_uint8_t page, zb_uint32_t pos, zb_uint8_t *buf,
 			    zb_uint16_t len)
 {
@@ -87,6 +227,13 @@ zb_ret_t zb_osif_nvram_read(zb_uint8_t page, zb_uint32_t pos, zb_uint8_t *buf,
 	LOG_DBG("Function: %s, page: %d, pos: %d, len: %d",
 		__func__, page, pos, len);
 
+#ifdef CONFIG_ZIGBEE_NVRAM_WRITE_BUFFER
+	nvram_buf_sync();
+	if (nvram_buf_failed()) {
+		return RET_ERROR;
+	}
+#endif
+
 	uint32_t flash_addr = get_page_base_offset(page) + pos;
 
 	int err = flash_area_read(fa, flash_addr, buf, len);
@@ -101,8 +248,6 @@ zb_ret_t zb_osif_nvram_read(zb_uint8_t page, zb_uint32_t pos, zb_uint8_t *buf,
 zb_ret_t zb_osif_nvram_write(zb_uint8_t page, zb_uint32_t pos, void *buf,
 			     zb_uint16_t len)
 {
-	uint32_t flash_addr = get_page_base_offset(page) + pos;
-
 	if (page >= zb_get_nvram_page_count()) {
 		return RET_PAGE_NOT_FOUND;
 	}
@@ -126,20 +271,23 @@ zb_ret_t zb_osif_nvram_write(zb_uint8_t page, zb_uint32_t pos, void *buf,
 	LOG_DBG("Function: %s, page: %d, pos: %d, len: %d",
 		__func__, page, pos, len);
 
-	int err = flash_area_write(fa, flash_addr, buf, len);
-
-	if (err) {
-		LOG_ERR("Write error: %d", err);
-		return RET_ERROR;
-	}
+	atomic_inc(&nvram_stats.writes);
 
-	return RET_OK;
+#ifdef CONFIG_ZIGBEE_NVRAM_WRITE_BUFFER
+	return nvram_buf_write(page, pos, buf, len);
+#else
+	return nvram_flash_write(page, pos, buf, len) ? RET_ERROR : RET_OK;
+#endif
 }
 
 zb_ret_t zb_osif_nvram_erase_async(zb_uint8_t page)
 {
 	zb_ret_t ret = RET_OK;
 
+	if (IS_ENABLED(CONFIG_ZIGBEE_NVRAM_WRITE_BUFFER)) {
+		zb_osif_nvram_wait_for_last_op();
+	}
+
 	if (page < zb_get_nvram_page_count()) {
 		int err = flash_area_erase(fa, get_page_base_offset(page),
 					   zb_get_nvram_page_length());
@@ -154,12 +302,24 @@ zb_ret_t zb_osif_nvram_erase_async(zb_uint8_t page)
 
 void zb_osif_nvram_wait_for_last_op(void)
 {
-	/* empty for synchronous erase and write */
+#ifdef CONFIG_ZIGBEE_NVRAM_WRITE_BUFFER
+	nvram_buf_sync();
+#endif
+	/* Erase is synchronous. */
 }
 
 void zb_osif_nvram_flush(void)
 {
-	/* empty for synchronous erase and write */
+#ifdef CONFIG_ZIGBEE_NVRAM_WRITE_BUFFER
+	nvram_buf_submit();
+#endif
+}
+
+void zigbee_nvram_stats_get(struct zigbee_nvram_stats *stats)
+{
+	stats->writes = atomic_get(&nvram_stats.writes);
+	stats->flash_writes = atomic_get(&nvram_stats.flash_writes);
+	stats->errors = atomic_get(&nvram_stats.errors);
 }
 
 
@@ -34,7 +34,6 @@
 typedef enum {
 	ZB_CALLBACK_TYPE_SINGLE_PARAM,
 	ZB_CALLBACK_TYPE_TWO_PARAMS,
-	ZB_CALLBACK_TYPE_ALARM_SET,
 	ZB_CALLBACK_TYPE_ALARM_CANCEL,
 	ZB_GET_OUT_BUF_DELAYED,
 	ZB_GET_IN_BUF_DELAYED,
@@ -51,9 +50,33 @@ typedef struct {
 	zb_callback2_t func2;
 	zb_uint16_t param;
 	zb_uint16_t user_param;
-	int64_t alarm_timestamp;
 } zb_app_cb_t;
 
+/**
+ * Type definition of application alarm, kept in the alarm timer wheel.
+ */
+typedef struct {
+	/* Node in the timer wheel slot or in the list of expired alarms. */
+	sys_dnode_t node;
+	/* Node in the hash table used to find alarms to cancel. */
+	sys_dnode_t hash_node;
+	zb_callback_t func;
+	zb_uint8_t param;
+	/* Timer wheel tick at which the alarm expires. */
+	int64_t tick;
+	/* Uptime in milliseconds at which the alarm expires. */
+	int64_t deadline;
+	/* Alarm moved from the wheel to the list of expired alarms. */
+	bool expired;
+} zb_app_alarm_t;
+
+#define ALARM_WHEEL_SLOTS CONFIG_ZIGBEE_ALARM_WHEEL_SLOTS
+#define ALARM_WHEEL_MASK  (ALARM_WHEEL_SLOTS - 1)
+#define ALARM_TICK_MS     CONFIG_ZIGBEE_ALARM_TICK_MS
+
+BUILD_ASSERT((ALARM_WHEEL_SLOTS & ALARM_WHEEL_MASK) == 0,
+	     "The number of alarm wheel slots must be a power of two.");
+
 
 LOG_MODULE_REGISTER(zboss_osif, CONFIG_ZBOSS_OSIF_LOG_LEVEL);
 
@@ -85,6 +108,28 @@ static struct k_work zb_app_cb_work;
  */
 volatile atomic_t zb_app_cb_process_scheduled = ATOMIC_INIT(0);
 
+/**
+ * Hashed timer wheel of application alarms. An alarm is kept in the slot
+ * selected by its expiry tick and in the hash table bucket selected by its
+ * callback and parameter, so both scheduling and cancelling take constant
+ * time. Expired alarms are moved to a separate list and executed in a batch
+ * from the ZBOSS thread.
+ */
+static zb_app_alarm_t alarm_pool[CONFIG_ZIGBEE_ALARM_MAX_COUNT];
+static sys_dlist_t alarm_free;
+static sys_dlist_t alarm_wheel[ALARM_WHEEL_SLOTS];
+static sys_dlist_t alarm_hash[ALARM_WHEEL_SLOTS];
+static sys_dlist_t alarm_expired;
+/* Next timer wheel tick to process. */
+static int64_t alarm_wheel_tick;
+/* Tick at which the alarm timer expires, or -1 if the timer is stopped. */
+static int64_t alarm_timer_tick = -1;
+static uint32_t alarm_wheel_count;
+static struct k_timer alarm_timer;
+static struct k_spinlock alarm_lock;
+static struct zigbee_alarm_stats alarm_stats;
+static uint64_t alarm_latency_sum;
+
 K_THREAD_STACK_DEFINE(zboss_stack_area, CONFIG_ZBOSS_DEFAULT_THREAD_STACK_SIZE);
 static struct k_thread zboss_thread_data;
 static k_tid_t zboss_tid;
@@ -129,6 +174,158 @@ bool zigbee_is_stack_started(void)
 	return stack_is_started;
 }
 
+static inline sys_dlist_t *alarm_hash_bucket(zb_callback_t func,
+					     zb_uint8_t param)
+{
+	return &alarm_hash[(((uintptr_t)func >> 2) ^ param) & ALARM_WHEEL_MASK];
+}
+
+static void alarm_free_locked(zb_app_alarm_t *alarm)
+{
+	sys_dlist_remove(&alarm->hash_node);
+	sys_dlist_append(&alarm_free, &alarm->node);
+	alarm_stats.pending--;
+}
+
+/* Find the tick of the earliest alarm in the timer wheel. */
+static int64_t alarm_next_tick_get(void)
+{
+	zb_app_alarm_t *alarm;
+	int64_t next = INT64_MAX;
+
+	/* Check the slots of the current wheel revolution first. */
+	for (int64_t tick = alarm_wheel_tick;
+	     tick < alarm_wheel_tick + ALARM_WHEEL_SLOTS; tick++) {
+		SYS_DLIST_FOR_EACH_CONTAINER(&alarm_wheel[tick & ALARM_WHEEL_MASK],
+					     alarm, node) {
+			if (alarm->tick == tick) {
+				return tick;
+			}
+		}
+	}
+
+	/* All alarms expire in one of the next revolutions. */
+	for (int i = 0; i < ALARM_WHEEL_SLOTS; i++) {
+		SYS_DLIST_FOR_EACH_CONTAINER(&alarm_wheel[i], alarm, node) {
+			next = MIN(next, alarm->tick);
+		}
+	}
+
+	return next;
+}
+
+static void alarm_timer_start_locked(int64_t tick)
+{
+	int64_t delay = tick * ALARM_TICK_MS - k_uptime_get();
+
+	alarm_timer_tick = tick;
+	k_timer_start(&alarm_timer, K_MSEC(MAX(delay, 0)), K_NO_WAIT);
+}
+
+static void alarm_timer_handler(struct k_timer *timer)
+{
+	k_spinlock_key_t key = k_spin_lock(&alarm_lock);
+	int64_t now_tick = k_uptime_get() / ALARM_TICK_MS;
+	bool expired = false;
+	zb_app_alarm_t *alarm;
+	zb_app_alarm_t *tmp;
+
+	ARG_UNUSED(timer);
+
+	/* Move expired alarms out of the wheel. After a full revolution
+	 * all slots are checked, so the loop can stop there.
+	 */
+	for (int i = 0;
+	     (alarm_wheel_tick <= now_tick) && (i < ALARM_WHEEL_SLOTS);
+	     i++, alarm_wheel_tick++) {
+		sys_dlist_t *slot =
+			&alarm_wheel[alarm_wheel_tick & ALARM_WHEEL_MASK];
+
+		SYS_DLIST_FOR_EACH_CONTAINER_SAFE(slot, alarm, tmp, node) {
+			if (alarm->tick <= now_tick) {
+				sys_dlist_remove(&alarm->node);
+				sys_dlist_append(&alarm_expired, &alarm->node);
+				alarm->expired = true;
+				alarm_wheel_count--;
+				expired = true;
+			}
+		}
+	}
+	alarm_wheel_tick = now_tick + 1;
+
+	if (alarm_wheel_count) {
+		alarm_timer_start_locked(alarm_next_tick_get());
+	} else {
+		alarm_timer_tick = -1;
+	}
+
+	k_spin_unlock(&alarm_lock, key);
+
+	if (expired) {
+		k_work_submit(&zb_app_cb_work);
+	}
+}
+
+static void alarm_init(void)
+{
+	sys_dlist_init(&alarm_free);
+	sys_dlist_init(&alarm_expired);
+	for (int i = 0; i < ALARM_WHEEL_SLOTS; i++) {
+		sys_dlist_init(&alarm_wheel[i]);
+		sys_dlist_init(&alarm_hash[i]);
+	}
+	for (int i = 0; i < ARRAY_SIZE(alarm_pool); i++) {
+		sys_dnode_init(&alarm_pool[i].hash_node);
+		sys_dlist_append(&alarm_free, &alarm_pool[i].node);
+	}
+
+	k_timer_init(&alarm_timer, alarm_timer_handler, NULL);
+}
+
+/* From ZBOSS main loop context: execute all expired alarms. */
+static void alarm_expired_process(void)
+{
+	while (true) {
+		k_spinlock_key_t key = k_spin_lock(&alarm_lock);
+		sys_dnode_t *node = sys_dlist_get(&alarm_expired);
+		zb_app_alarm_t *alarm;
+		zb_callback_t func;
+		zb_uint8_t param;
+		uint32_t latency;
+
+		if (!node) {
+			k_spin_unlock(&alarm_lock, key);
+			break;
+		}
+
+		alarm = CONTAINER_OF(node, zb_app_alarm_t, node);
+		func = alarm->func;
+		param = alarm->param;
+		latency = (uint32_t)MAX(k_uptime_get() - alarm->deadline, 0);
+
+		alarm_free_locked(alarm);
+		alarm_stats.fired++;
+		alarm_stats.latency_max_ms =
+			MAX(alarm_stats.latency_max_ms, latency);
+		alarm_latency_sum += latency;
+
+		k_spin_unlock(&alarm_lock, key);
+
+		/* The alarm may be scheduled again from its callback. */
+		func(param);
+	}
+}
+
+static bool alarm_expired_pending(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&alarm_lock);
+	bool pending = !sys_dlist_is_empty(&alarm_expired);
+
+	k_spin_unlock(&alarm_lock, key);
+
+	return pending;
+}
+
 static void zb_app_cb_process(zb_bufid_t bufid)
 {
 	zb_ret_t ret_code = RET_OK;
@@ -137,6 +334,8 @@ static void zb_app_cb_process(zb_bufid_t bufid)
 	/* Mark te processing callback as non-scheduled. */
 	(void)atomic_set((atomic_t *)&zb_app_cb_process_scheduled, 0);
 
+	alarm_expired_process();
+
 	/**
 	 * From ZBOSS main loop context: process all requests.
 	 *
@@ -155,26 +354,6 @@ static void zb_app_cb_process(zb_bufid_t bufid)
 					(zb_uint8_t)new_app_cb.param,
 					new_app_cb.user_param);
 			break;
-		case ZB_CALLBACK_TYPE_ALARM_SET:
-		{
-			/**
-			 * Check if the timeout already passed. If so, use the
-			 * lowest value that schedules an alarm, so the user
-			 * is still able to cancel the alarm.
-			 */
-			zb_time_t delay =
-				(k_uptime_get() > new_app_cb.alarm_timestamp ?
-					1 :
-					ZB_MILLISECONDS_TO_BEACON_INTERVAL(
-						new_app_cb.alarm_timestamp -
-						k_uptime_get())
-				);
-			ret_code = zb_schedule_app_alarm(
-					new_app_cb.func,
-					(zb_uint8_t)new_app_cb.param,
-					delay);
-			break;
-		}
 		case ZB_CALLBACK_TYPE_ALARM_CANCEL:
 			ret_code = zb_schedule_alarm_cancel(
 					new_app_cb.func,
@@ -227,7 +406,8 @@ static void zb_app_cb_process_schedule(struct k_work *item)
 {
 	zb_app_cb_t new_app_cb;
 
-	if (k_msgq_peek(&zb_app_cb_msgq, &new_app_cb)) {
+	if (k_msgq_peek(&zb_app_cb_msgq, &new_app_cb) &&
+	    !alarm_expired_pending()) {
 		return;
 	}
 
@@ -255,6 +435,7 @@ int zigbee_init(void)
 {
 	/* Initialise work queue for processing app callback and alarms. */
 	k_work_init(&zb_app_cb_work, zb_app_cb_process_schedule);
+	alarm_init();
 
 #if ZB_TRACE_LEVEL
 	/* Set Zigbee stack logging level and traffic dump subsystem. */
@@ -369,24 +550,98 @@ zb_ret_t zigbee_schedule_alarm(zb_callback_t func,
 			       zb_uint8_t param,
 			       zb_time_t run_after)
 {
-	zb_app_cb_t new_app_cb = {
-		.type = ZB_CALLBACK_TYPE_ALARM_SET,
-		.func = func,
-		.param = param,
-		.alarm_timestamp = k_uptime_get() +
-				   ZB_TIME_BEACON_INTERVAL_TO_MSEC(run_after),
-	};
+	int64_t deadline = k_uptime_get() +
+			   ZB_TIME_BEACON_INTERVAL_TO_MSEC(run_after);
+	k_spinlock_key_t key = k_spin_lock(&alarm_lock);
+	sys_dnode_t *node = sys_dlist_get(&alarm_free);
+	zb_app_alarm_t *alarm;
 
-	if (k_msgq_put(&zb_app_cb_msgq, &new_app_cb, K_NO_WAIT)) {
+	if (!node) {
+		k_spin_unlock(&alarm_lock, key);
 		return RET_OVERFLOW;
 	}
 
-	k_work_submit(&zb_app_cb_work);
+	if (!alarm_wheel_count) {
+		/* The wheel was not turning, move it to the current time. */
+		alarm_wheel_tick = k_uptime_get() / ALARM_TICK_MS;
+	}
+
+	alarm = CONTAINER_OF(node, zb_app_alarm_t, node);
+	alarm->func = func;
+	alarm->param = param;
+	alarm->deadline = deadline;
+	alarm->expired = false;
+	alarm->tick = MAX(ceiling_fraction(deadline, ALARM_TICK_MS),
+			  alarm_wheel_tick);
+
+	sys_dlist_append(&alarm_wheel[alarm->tick & ALARM_WHEEL_MASK],
+			 &alarm->node);
+	sys_dlist_append(alarm_hash_bucket(func, param), &alarm->hash_node);
+	alarm_wheel_count++;
+
+	alarm_stats.scheduled++;
+	alarm_stats.pending++;
+	alarm_stats.pending_max = MAX(alarm_stats.pending_max,
+				      alarm_stats.pending);
+
+	if ((alarm_timer_tick < 0) || (alarm->tick < alarm_timer_tick)) {
+		alarm_timer_start_locked(alarm->tick);
+	}
+
+	k_spin_unlock(&alarm_lock, key);
 	return RET_OK;
 }
 
+static uint32_t alarm_cancel_list(sys_dlist_t *list, zb_callback_t func,
+				  zb_uint8_t param)
+{
+	zb_app_alarm_t *alarm;
+	zb_app_alarm_t *tmp;
+	uint32_t cancelled = 0;
+
+	SYS_DLIST_FOR_EACH_CONTAINER_SAFE(list, alarm, tmp, hash_node) {
+		if ((alarm->func != func) ||
+		    ((param != ZB_ALARM_ANY_PARAM) && (alarm->param != param))) {
+			continue;
+		}
+
+		if (!alarm->expired) {
+			alarm_wheel_count--;
+		}
+		sys_dlist_remove(&alarm->node);
+		alarm_free_locked(alarm);
+		cancelled++;
+	}
+
+	return cancelled;
+}
+
 zb_ret_t zigbee_schedule_alarm_cancel(zb_callback_t func, zb_uint8_t param)
 {
+	k_spinlock_key_t key = k_spin_lock(&alarm_lock);
+	uint32_t cancelled = 0;
+
+	if (param == ZB_ALARM_ANY_PARAM) {
+		for (int i = 0; i < ALARM_WHEEL_SLOTS; i++) {
+			cancelled += alarm_cancel_list(&alarm_hash[i], func,
+						       param);
+		}
+	} else {
+		cancelled = alarm_cancel_list(alarm_hash_bucket(func, param),
+					      func, param);
+	}
+	alarm_stats.cancelled += cancelled;
+
+	k_spin_unlock(&alarm_lock, key);
+
+	/* Alarms with any parameter may also have been scheduled
+	 * directly in ZBOSS.
+	 */
+	if (cancelled && (param != ZB_ALARM_ANY_PARAM)) {
+		return RET_OK;
+	}
+
+	/* The alarm may have been scheduled directly in ZBOSS. */
 	zb_app_cb_t new_app_cb = {
 		.type = ZB_CALLBACK_TYPE_ALARM_CANCEL,
 		.func = func,
@@ -401,6 +656,21 @@ zb_ret_t zigbee_schedule_alarm_cancel(zb_callback_t func, zb_uint8_t param)
 	return RET_OK;
 }
 
+void zigbee_alarm_stats_get(struct zigbee_alarm_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&alarm_lock);
+
+	*stats = alarm_stats;
+	if (alarm_stats.fired) {
+		stats->latency_avg_ms =
+			(uint32_t)(alarm_latency_sum / alarm_stats.fired);
+	}
+
+	k_spin_unlock(&alarm_lock, key);
+
+	stats->app_cb_queue_len = k_msgq_num_used_get(&zb_app_cb_msgq);
+}
+
 zb_ret_t zigbee_get_out_buf_delayed(zb_callback_t func)
 {
 	zb_app_cb_t new_app_cb = {
@@ -17,6 +17,36 @@ typedef enum {
 	ZIGBEE_EVENT_APP,
 } zigbee_event_t;
 
+/**@brief Statistics of the application alarms. */
+struct zigbee_alarm_stats {
+	/** Number of alarms scheduled. */
+	uint32_t scheduled;
+	/** Number of alarms executed. */
+	uint32_t fired;
+	/** Number of alarms cancelled before execution. */
+	uint32_t cancelled;
+	/** Number of alarms waiting for execution. */
+	uint32_t pending;
+	/** Highest number of alarms waiting for execution. */
+	uint32_t pending_max;
+	/** Highest delay between alarm expiry and its execution. */
+	uint32_t latency_max_ms;
+	/** Average delay between alarm expiry and its execution. */
+	uint32_t latency_avg_ms;
+	/** Number of requests waiting in the application callback queue. */
+	uint32_t app_cb_queue_len;
+};
+
+/**@brief Statistics of the ZBOSS NVRAM writes. */
+struct zigbee_nvram_stats {
+	/** Number of writes requested by ZBOSS. */
+	uint32_t writes;
+	/** Number of flash write operations performed for these writes. */
+	uint32_t flash_writes;
+	/** Number of failed flash write operations. */
+	uint32_t errors;
+};
+
 #ifdef CONFIG_ZIGBEE_DEBUG_FUNCTIONS
 /**@brief Function for suspending zboss thread.
  */
@@ -69,4 +99,28 @@ void zigbee_event_notify(zigbee_event_t event);
  */
 uint32_t zigbee_event_poll(uint32_t timeout_us);
 
+/**@brief Function for reading the application alarm statistics.
+ *
+ * Alarms scheduled with zigbee_schedule_alarm() are kept in a timer wheel
+ * in this layer and are not visible to the ZBOSS scheduler. Cancel them
+ * with zigbee_schedule_alarm_cancel(), as ZB_SCHEDULE_APP_ALARM_CANCEL()
+ * and zb_schedule_get_alarm_time() see only alarms scheduled directly
+ * with ZB_SCHEDULE_APP_ALARM(). zigbee_schedule_alarm_cancel() forwards
+ * the request to ZBOSS if no matching alarm is found in the timer wheel,
+ * and always if called with ZB_ALARM_ANY_PARAM.
+ *
+ * @param[out] stats  Current statistics.
+ */
+void zigbee_alarm_stats_get(struct zigbee_alarm_stats *stats);
+
+/**@brief Function for reading the ZBOSS NVRAM write statistics.
+ *
+ * The difference between the number of requested writes and the number
+ * of flash write operations is the number of flash operations saved
+ * by combining writes.
+ *
+ * @param[out] stats  Current statistics.
+ */
+void zigbee_nvram_stats_get(struct zigbee_nvram_stats *stats);
+
 #endif /* ZB_NRF_PLATFORM_H__ */
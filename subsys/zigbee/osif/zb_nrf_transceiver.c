@@ -12,6 +12,7 @@
 #include <zboss_api.h>
 #include <zb_macll.h>
 #include <zb_transceiver.h>
+#include <zigbee/zigbee_rx_stats.h>
 #include "zb_nrf_platform.h"
 
 #define PHR_LENGTH                1
@@ -48,6 +49,14 @@ static struct ieee802154_state_cache state_cache = {
 /* RX fifo queue. */
 static struct k_fifo rx_fifo;
 
+/* RX fifo queue statistics. */
+static struct {
+	atomic_t received;
+	atomic_t dropped;
+	atomic_t queue_len;
+	atomic_t queue_max;
+} rx_stats;
+
 static uint8_t ack_frame_buf[ACK_PKT_LENGTH + PHR_LENGTH];
 static uint8_t *ack_frame;
 
@@ -455,12 +464,13 @@ zb_uint8_t zb_trans_get_next_packet(zb_bufid_t buf)
 		return 0;
 	}
 
+	atomic_dec(&rx_stats.queue_len);
+
 	length = net_pkt_get_len(pkt);
 	data_ptr = zb_buf_initial_alloc(buf, length);
 
-	/* Copy received data */
-	net_pkt_cursor_init(pkt);
-	net_pkt_read(pkt, data_ptr, length);
+	/* Copy received data straight from the fragments */
+	(void)net_buf_linearize(data_ptr, length, pkt->buffer, 0, length);
 
 	/* Put LQI, RSSI */
 	zb_macll_metadata_t *metadata = ZB_MACLL_GET_METADATA(buf);
@@ -566,8 +576,26 @@ enum net_verdict ieee802154_radio_handle_ack(struct net_if *iface,
 static enum net_verdict zigbee_l2_recv(struct net_if *iface,
 					struct net_pkt *pkt)
 {
+	atomic_val_t queue_len;
+
 	ARG_UNUSED(iface);
 
+	/* The radio has already acknowledged the frame, so the sender does
+	 * not know that it is dropped.
+	 */
+	if ((CONFIG_ZIGBEE_RX_QUEUE_MAX_LEN > 0) &&
+	    (atomic_get(&rx_stats.queue_len) >=
+	     CONFIG_ZIGBEE_RX_QUEUE_MAX_LEN)) {
+		atomic_inc(&rx_stats.dropped);
+		return NET_DROP;
+	}
+
+	queue_len = atomic_inc(&rx_stats.queue_len) + 1;
+	if (queue_len > atomic_get(&rx_stats.queue_max)) {
+		atomic_set(&rx_stats.queue_max, queue_len);
+	}
+	atomic_inc(&rx_stats.received);
+
 	k_fifo_put(&rx_fifo, pkt);
 
 	zb_macll_set_rx_flag();
@@ -579,6 +607,14 @@ static enum net_verdict zigbee_l2_recv(struct net_if *iface,
 	return NET_OK;
 }
 
+void zigbee_rx_stats_get(struct zigbee_rx_stats *stats)
+{
+	stats->received = atomic_get(&rx_stats.received);
+	stats->dropped = atomic_get(&rx_stats.dropped);
+	stats->queue_len = atomic_get(&rx_stats.queue_len);
+	stats->queue_max = atomic_get(&rx_stats.queue_max);
+}
+
 static enum net_l2_flags zigbee_l2_flags(struct net_if *iface)
 {
 	ARG_UNUSED(iface);
@@ -0,0 +1,498 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <string.h>
+
+#include <cell_db.c>
+#include <http_response.c>
+#include <location_cache.c>
+
+#define MCC 242
+#define MNC 1
+#define TAC 100
+
+#define SERVING_ECI 1000
+#define NEIGHBOR_ECI 1001
+#define FAR_ECI 1002
+#define NEW_ECI 2000
+#define NEIGHBOR_PCI 2
+
+#define BASE_SEQ 1
+
+/* Serving cell, its neighbor and a cell with the same physical cell ID that
+ * is too far away to be the neighbor. Sorted by key.
+ */
+static const struct cell_db_record base_recs[] = {
+	{ MCC, MNC, TAC, 1000, SERVING_ECI, 600000000, 100000000, 1 },
+	{ MCC, MNC, TAC, 1000, NEIGHBOR_ECI, 600100000, 100100000, NEIGHBOR_PCI },
+	{ MCC, MNC, TAC, 1000, FAR_ECI, 610000000, 110000000, NEIGHBOR_PCI },
+};
+
+/* Removes the neighbor and adds a cell in another tracking area. */
+static const struct cell_db_record delta_recs[] = {
+	{ MCC, MNC, TAC, 0, NEIGHBOR_ECI, 0, 0, NEIGHBOR_PCI },
+	{ MCC, MNC, TAC + 1, 500, NEW_ECI, 590000000, 90000000, 3 },
+};
+
+static uint8_t flash[PM_CELL_DB_SIZE];
+static const struct flash_area cell_db_area = {
+	.fa_id = PM_CELL_DB_ID,
+	.fa_size = PM_CELL_DB_SIZE,
+};
+static int read_fail;
+
+static struct lte_lc_ncell ncells[1];
+static struct lte_lc_cells_info cells;
+
+
+int flash_area_open(uint8_t id, const struct flash_area **area)
+{
+	zassert_equal(id, PM_CELL_DB_ID, "Wrong partition");
+	*area = &cell_db_area;
+
+	return 0;
+}
+
+int flash_area_read(const struct flash_area *area, off_t off, void *dst,
+		    size_t len)
+{
+	zassert_true(off + len <= sizeof(flash), "Read out of partition");
+
+	if (read_fail > 0) {
+		read_fail--;
+		return -EIO;
+	}
+
+	memcpy(dst, &flash[off], len);
+
+	return 0;
+}
+
+int flash_area_write(const struct flash_area *area, off_t off,
+		     const void *src, size_t len)
+{
+	const uint8_t *bytes = src;
+
+	zassert_true(off + len <= sizeof(flash), "Write out of partition");
+
+	/* Writes can only clear bits, as on the real flash. */
+	for (size_t i = 0; i < len; i++) {
+		flash[off + i] &= bytes[i];
+	}
+
+	return 0;
+}
+
+int flash_area_erase(const struct flash_area *area, off_t off, size_t len)
+{
+	zassert_true(off + len <= sizeof(flash), "Erase out of partition");
+	memset(&flash[off], 0xff, len);
+
+	return 0;
+}
+
+/* Build an image of the records, as scripts/cell_db/cell_db.py does. */
+static size_t image_build(uint8_t *buf, const struct cell_db_record *recs,
+			  size_t count, uint32_t seq, uint32_t base_seq,
+			  uint8_t flags)
+{
+	struct cell_db_header hdr = {
+		.magic = CELL_DB_MAGIC,
+		.version = CELL_DB_VERSION,
+		.flags = flags,
+		.record_size = sizeof(struct cell_db_record),
+		.count = count,
+		.seq = seq,
+		.base_seq = base_seq,
+		.crc = crc32_ieee((const uint8_t *)recs, count * sizeof(*recs)),
+	};
+
+	memcpy(buf, &hdr, sizeof(hdr));
+	memcpy(&buf[sizeof(hdr)], recs, count * sizeof(*recs));
+
+	return sizeof(hdr) + count * sizeof(*recs);
+}
+
+static void delta_write(uint32_t base_seq)
+{
+	uint8_t buf[sizeof(struct cell_db_header) + sizeof(delta_recs)];
+	size_t len = image_build(buf, delta_recs, ARRAY_SIZE(delta_recs),
+				 BASE_SEQ + 1, base_seq, CELL_DB_FLAG_DELTA);
+	size_t half = len / 2;
+
+	/* Written in two parts, as received from a server. */
+	zassert_equal(multicell_location_db_delta_write(0, buf, half), 0,
+		      "Delta write failed");
+	zassert_equal(multicell_location_db_delta_write(half, &buf[half],
+							len - half),
+		      0, "Delta write failed");
+}
+
+static int location_get(uint16_t tac, uint32_t eci, uint16_t neighbor_pci,
+			struct multicell_location *location)
+{
+	cells.current_cell.mcc = MCC;
+	cells.current_cell.mnc = MNC;
+	cells.current_cell.tac = tac;
+	cells.current_cell.id = eci;
+	cells.current_cell.rsrp = 50;
+	cells.ncells_count = (neighbor_pci != 0) ? 1 : 0;
+	cells.neighbor_cells = ncells;
+	ncells[0].phys_cell_id = neighbor_pci;
+	ncells[0].rsrp = 50;
+
+	return cell_db_location_get(&cells, location);
+}
+
+static void check_location(const struct multicell_location *location,
+			   float lat, float lon, float accuracy)
+{
+	zassert_within(location->latitude, lat, 0.0001f, "Wrong latitude");
+	zassert_within(location->longitude, lon, 0.0001f, "Wrong longitude");
+	zassert_within(location->accuracy, accuracy, 1.0f, "Wrong accuracy");
+}
+
+static void setup(void)
+{
+	memset(flash, 0xff, sizeof(flash));
+	(void)image_build(flash, base_recs, ARRAY_SIZE(base_recs), BASE_SEQ, 0,
+			  0);
+
+	fa = NULL;
+	loaded = false;
+	base.count = 0;
+	base.seq = 0;
+	delta.count = 0;
+	read_fail = 0;
+
+	memset(cache, 0, sizeof(cache));
+}
+
+static void teardown(void)
+{
+}
+
+static void test_lookup(void)
+{
+	struct multicell_location location;
+
+	zassert_equal(location_get(TAC, SERVING_ECI, 0, &location), 0,
+		      "Serving cell not found");
+	check_location(&location, 60.0f, 10.0f, 1000.0f);
+
+	/* Equally strong cells of the same range have the same weight. */
+	zassert_equal(location_get(TAC, SERVING_ECI, NEIGHBOR_PCI, &location),
+		      0, "Serving cell not found");
+	check_location(&location, 60.005f, 10.005f, 1000.0f);
+}
+
+static void test_lookup_missing(void)
+{
+	struct multicell_location location;
+
+	zassert_equal(location_get(TAC, SERVING_ECI + 10, 0, &location),
+		      -ENOENT, "Unknown cell found");
+	zassert_equal(location_get(TAC + 1, SERVING_ECI, 0, &location),
+		      -ENOENT, "Cell found in wrong tracking area");
+	zassert_equal(location_get(TAC, 0, 0, &location), -ENOENT,
+		      "Invalid cell found");
+}
+
+static void test_delta_insert(void)
+{
+	struct multicell_location location;
+
+	zassert_equal(location_get(TAC + 1, NEW_ECI, 0, &location), -ENOENT,
+		      "Cell found before delta");
+
+	delta_write(BASE_SEQ);
+	zassert_equal(multicell_location_db_delta_apply(), 0,
+		      "Delta not applied");
+
+	zassert_equal(location_get(TAC + 1, NEW_ECI, 0, &location), 0,
+		      "Inserted cell not found");
+	check_location(&location, 59.0f, 9.0f, 500.0f);
+
+	/* The removed neighbor is not used, and the cell with the same
+	 * physical cell ID is too far away.
+	 */
+	zassert_equal(location_get(TAC, SERVING_ECI, NEIGHBOR_PCI, &location),
+		      0, "Serving cell not found");
+	check_location(&location, 60.0f, 10.0f, 1000.0f);
+	zassert_equal(location_get(TAC, NEIGHBOR_ECI, 0, &location), -ENOENT,
+		      "Removed cell found");
+}
+
+static void test_delta_stale(void)
+{
+	struct multicell_location location;
+
+	delta_write(BASE_SEQ + 1);
+	zassert_equal(multicell_location_db_delta_apply(), -ESTALE,
+		      "Delta for another database applied");
+	zassert_equal(location_get(TAC + 1, NEW_ECI, 0, &location), -ENOENT,
+		      "Cell of stale delta found");
+}
+
+static void test_delta_replaced(void)
+{
+	static const uint8_t part[8];
+	struct multicell_location location;
+
+	delta_write(BASE_SEQ);
+	zassert_equal(multicell_location_db_delta_apply(), 0,
+		      "Delta not applied");
+
+	/* The applied delta is not used while a new one is written. */
+	zassert_equal(multicell_location_db_delta_write(0, part, sizeof(part)),
+		      0, "Delta write failed");
+	zassert_equal(location_get(TAC + 1, NEW_ECI, 0, &location), -ENOENT,
+		      "Cell of replaced delta found");
+}
+
+static void test_read_retry(void)
+{
+	struct multicell_location location;
+
+	/* A failed read is not taken to mean that there is no database. */
+	read_fail = 1;
+	zassert_equal(location_get(TAC, SERVING_ECI, 0, &location), -EIO,
+		      "Read error not reported");
+
+	zassert_equal(location_get(TAC, SERVING_ECI, 0, &location), 0,
+		      "Database not loaded again");
+	check_location(&location, 60.0f, 10.0f, 1000.0f);
+}
+
+static void test_no_database(void)
+{
+	struct multicell_location location;
+
+	memset(flash, 0xff, sizeof(flash));
+
+	zassert_equal(location_get(TAC, SERVING_ECI, 0, &location), -ENOENT,
+		      "Cell found without database");
+}
+
+static char response_buf[256];
+
+/* Pass the first len bytes of a response, as received so far. */
+static bool response_complete(const char *response, size_t len, bool *keep)
+{
+	zassert_true(len < sizeof(response_buf), "Response too long");
+	memcpy(response_buf, response, len);
+	response_buf[len] = '\0';
+
+	return http_response_complete(response_buf, len, keep);
+}
+
+static void test_response_content_length(void)
+{
+	const char *response = "HTTP/1.1 200 OK\r\n"
+			       "Content-Length: 5\r\n"
+			       "\r\n"
+			       "hello";
+	bool keep = false;
+
+	zassert_false(response_complete(response, strlen(response) - 1, &keep),
+		      "Incomplete body accepted");
+	zassert_true(response_complete(response, strlen(response), &keep),
+		     "Complete response not detected");
+	zassert_true(keep, "Connection not kept");
+}
+
+static void test_response_close(void)
+{
+	const char *response = "HTTP/1.1 200 OK\r\n"
+			       "content-length: 2\r\n"
+			       "Connection: close\r\n"
+			       "\r\n"
+			       "{}";
+	bool keep = true;
+
+	zassert_true(response_complete(response, strlen(response), &keep),
+		     "Complete response not detected");
+	zassert_false(keep, "Closed connection kept");
+}
+
+static void test_response_chunked(void)
+{
+	const char *response = "HTTP/1.1 200 OK\r\n"
+			       "Transfer-Encoding: chunked\r\n"
+			       "\r\n"
+			       "5\r\nhello\r\n"
+			       "6;ext=1\r\n world\r\n"
+			       "0\r\n"
+			       "\r\n";
+	size_t len = strlen(response);
+	size_t head_len = strstr(response, "\r\n\r\n") + 4 - response;
+	bool keep = false;
+
+	zassert_false(response_complete(response, len - 2, &keep),
+		      "Response without the end of the trailer accepted");
+
+	/* The body is left untouched until the last chunk is received. */
+	zassert_false(response_complete(response, len - 12, &keep),
+		      "Incomplete chunk accepted");
+	zassert_mem_equal(&response_buf[head_len], &response[head_len],
+			  len - 12 - head_len, "Body modified");
+
+	zassert_true(response_complete(response, len, &keep),
+		     "Complete response not detected");
+	zassert_true(keep, "Connection not kept");
+	zassert_equal(strcmp(&response_buf[head_len], "hello world"), 0,
+		      "Body not decoded");
+}
+
+static void test_response_unframed(void)
+{
+	const char *response = "HTTP/1.1 200 OK\r\n"
+			       "\r\n"
+			       "{}";
+	const char *malformed = "HTTP/1.1 200 OK\r\n"
+				"Transfer-Encoding: chunked\r\n"
+				"\r\n"
+				"xyz\r\n";
+	bool keep = false;
+
+	/* Only the server closing the connection ends these responses. */
+	zassert_false(response_complete(response, strlen(response), &keep),
+		      "Unframed response accepted");
+	zassert_false(response_complete(malformed, strlen(malformed), &keep),
+		      "Malformed chunk accepted");
+}
+
+static void cells_set(struct lte_lc_ncell *neighbors, size_t count)
+{
+	cells.current_cell.mcc = MCC;
+	cells.current_cell.mnc = MNC;
+	cells.current_cell.tac = TAC;
+	cells.current_cell.id = SERVING_ECI;
+	cells.ncells_count = count;
+	cells.neighbor_cells = neighbors;
+}
+
+static void test_cache_key(void)
+{
+	struct lte_lc_ncell neighbors[] = {
+		{ .earfcn = 6300, .phys_cell_id = 10, .rsrp = 40 },
+		{ .earfcn = 6300, .phys_cell_id = 11, .rsrp = 30 },
+		{ .earfcn = 6300, .phys_cell_id = 12, .rsrp = 10 },
+	};
+	uint32_t key;
+
+	cells_set(neighbors, ARRAY_SIZE(neighbors));
+	key = location_cache_key(&cells);
+
+	/* A change in the ranking of the strongest neighbors alone */
+	neighbors[0].rsrp = 20;
+	zassert_equal(location_cache_key(&cells), key,
+		      "Key depends on the neighbor ranking");
+
+	/* The weakest neighbor is not part of the key */
+	neighbors[2].phys_cell_id = 13;
+	neighbors[2].rsrp = 0;
+	zassert_equal(location_cache_key(&cells), key,
+		      "Key depends on a weak neighbor");
+
+	neighbors[1].phys_cell_id = 14;
+	zassert_not_equal(location_cache_key(&cells), key,
+			  "Key does not depend on a strong neighbor");
+
+	neighbors[1].phys_cell_id = 11;
+	cells.current_cell.id = NEIGHBOR_ECI;
+	zassert_not_equal(location_cache_key(&cells), key,
+			  "Key does not depend on the serving cell");
+}
+
+static void test_cache_get_put(void)
+{
+	struct multicell_location stored = { 60.0f, 10.0f, 1000.0f };
+	struct multicell_location location;
+
+	zassert_false(location_cache_get(1, &location), "Empty cache hit");
+
+	location_cache_put(1, &stored);
+	zassert_true(location_cache_get(1, &location), "Stored location missed");
+	check_location(&location, 60.0f, 10.0f, 1000.0f);
+	zassert_false(location_cache_get(2, &location), "Wrong key hit");
+
+	/* Storing the same key again replaces the location */
+	stored.latitude = 61.0f;
+	location_cache_put(1, &stored);
+	zassert_true(location_cache_get(1, &location), "Stored location missed");
+	check_location(&location, 61.0f, 10.0f, 1000.0f);
+}
+
+static void test_cache_lru(void)
+{
+	struct multicell_location stored = { 60.0f, 10.0f, 1000.0f };
+	struct multicell_location location;
+
+	BUILD_ASSERT(CONFIG_MULTICELL_LOCATION_CACHE_SIZE == 2);
+
+	location_cache_put(1, &stored);
+	k_sleep(K_MSEC(10));
+	location_cache_put(2, &stored);
+	k_sleep(K_MSEC(10));
+
+	/* Key 2 becomes the least recently used one */
+	zassert_true(location_cache_get(1, &location), "Stored location missed");
+	k_sleep(K_MSEC(10));
+
+	location_cache_put(3, &stored);
+	zassert_true(location_cache_get(1, &location), "Recent location evicted");
+	zassert_true(location_cache_get(3, &location), "New location missed");
+	zassert_false(location_cache_get(2, &location),
+		      "Least recently used location kept");
+}
+
+static void test_cache_ttl(void)
+{
+	struct multicell_location stored = { 60.0f, 10.0f, 1000.0f };
+	struct multicell_location location;
+
+	location_cache_put(1, &stored);
+	k_sleep(K_SECONDS(CONFIG_MULTICELL_LOCATION_CACHE_TTL));
+
+	zassert_false(location_cache_get(1, &location),
+		      "Expired location returned");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(cell_db_test,
+			 ztest_unit_test_setup_teardown(test_lookup,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_lookup_missing,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_delta_insert,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_delta_stale,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_delta_replaced,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_read_retry,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_no_database,
+							setup, teardown),
+			 ztest_unit_test(test_response_content_length),
+			 ztest_unit_test(test_response_close),
+			 ztest_unit_test(test_response_chunked),
+			 ztest_unit_test(test_response_unframed),
+			 ztest_unit_test_setup_teardown(test_cache_key,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_cache_get_put,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_cache_lru,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_cache_ttl,
+							setup, teardown)
+			 );
+
+	ztest_run_test_suite(cell_db_test);
+}
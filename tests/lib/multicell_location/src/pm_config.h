@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef PM_CONFIG_H__
+#define PM_CONFIG_H__
+
+/* Simulated cell_db partition */
+#define PM_CELL_DB_ID 0
+#define PM_CELL_DB_SIZE 0x2000
+
+#endif /* PM_CONFIG_H__ */
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <unity.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <kernel.h>
+#include <modem/sms.h>
+#include <mock_at_cmd.h>
+
+#define MSG_A_PART1 "+CMT: \"+1234567890\",22\r\n" \
+	"0791534874894310440A912143658709000012201232054480A00500037E020162B219AD66BBE172B0986C46ABD96EB81C2C269BD16AB61B2E078BC966B49AED86CBC162B219AD66BBE172B0986C46ABD96EB81C2C269BD16AB61B2E078BC966B49AED86CBC162B219AD66BBE172B0986C46ABD96EB81C2C269BD16AB61B2E078BC966B49AED86CBC162B219AD66BBE172B0986C46ABD96EB81C2C269BD16AB61B2E078BC966\r\n"
+#define MSG_A_PART2 "+CMT: \"+1234567890\",22\r\n" \
+	"0791534874894320440A912143658709000012201232054480910500037E02026835DB0D9783C564335ACD76C3E56031D98C56B3DD7039584C36A3D56C375C0E1693CD6835DB0D9783C564335ACD76C3E56031D98C56B3DD7039584C36A3D56C375C0E1693CD6835DB0D9783C564335ACD76C3E56031D98C56B3DD7039584C36A3D56C375C0E1693CD6835DB0D9783C564335ACD76C3E56031\r\n"
+#define MSG_A_TEXT \
+	"123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123" \
+	"456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901"
+
+#define MSG_B_PART1 "+CMT: \"1234567890\",159\r\n" \
+	"0791534874894370440A912143658709000012202280655080A005000351020162B219AD66BBE172B0986C46ABD96EB81C2C269BD16AB61B2E078BC966B49AED86CBC162B219AD66BBE172B0986C46ABD96EB81C2C269BD16AB61B2E078BC966B49AED86CBC162B219AD66BBE172B0986C46ABD96EB81C2C269BD16AB61B2E078BC966B49AED86CBC162B219AD66BBE172B0986C46ABD96EB81C2C269BD16AB61B2E078BC936\r\n"
+#define MSG_B_PART2 "+CMT: \"1234567890\",159\r\n" \
+	"0791534874894370440A9121436587090000122022806550801305000351020236E5986C46ABD96EB81C0C\r\n"
+
+static struct sms_data test_sms_data = {0};
+static struct sms_deliver_header test_sms_header = {0};
+static int test_handle;
+static int sms_callback_count;
+
+/* sms_at_handler() is implemented in the library and we'll call it directly
+ * to fake received SMS message
+ */
+extern void sms_at_handler(void *context, const char *at_notif);
+
+/** Callback that SMS library will call when a message is received. */
+static void sms_callback(struct sms_data *const data, void *context)
+{
+	struct sms_deliver_header *sms_header = &data->header.deliver;
+
+	sms_callback_count++;
+
+	TEST_ASSERT_EQUAL(SMS_TYPE_DELIVER, data->type);
+	TEST_ASSERT_EQUAL(test_sms_data.payload_len, data->payload_len);
+	TEST_ASSERT_EQUAL_STRING(test_sms_data.payload, data->payload);
+
+	TEST_ASSERT_EQUAL_STRING(test_sms_header.originating_address.address_str,
+		sms_header->originating_address.address_str);
+	TEST_ASSERT_EQUAL(test_sms_header.time.day, sms_header->time.day);
+	TEST_ASSERT_EQUAL(test_sms_header.time.hour, sms_header->time.hour);
+	TEST_ASSERT_EQUAL(test_sms_header.time.minute, sms_header->time.minute);
+	TEST_ASSERT_EQUAL(test_sms_header.time.second, sms_header->time.second);
+
+	TEST_ASSERT_EQUAL(test_sms_header.concatenated.present, sms_header->concatenated.present);
+	TEST_ASSERT_EQUAL(test_sms_header.concatenated.ref_number,
+		sms_header->concatenated.ref_number);
+	TEST_ASSERT_EQUAL(test_sms_header.concatenated.seq_number,
+		sms_header->concatenated.seq_number);
+	TEST_ASSERT_EQUAL(test_sms_header.concatenated.total_msgs,
+		sms_header->concatenated.total_msgs);
+}
+
+void setUp(void)
+{
+	char resp[] = "+CNMI: 0,0,0,0,1\r\n";
+
+	memset(&test_sms_data, 0, sizeof(test_sms_data));
+	memset(&test_sms_header, 0, sizeof(test_sms_header));
+	sms_callback_count = 0;
+
+	__wrap_at_cmd_write_ExpectAndReturn("AT+CNMI?", NULL, 0, NULL, 0);
+	__wrap_at_cmd_write_IgnoreArg_buf();
+	__wrap_at_cmd_write_IgnoreArg_buf_len();
+	__wrap_at_cmd_write_ReturnArrayThruPtr_buf(resp, sizeof(resp));
+
+	__wrap_at_cmd_write_ExpectAndReturn("AT+CNMI=3,2,0,1", NULL, 0, NULL, 0);
+
+	test_handle = sms_register_listener(sms_callback, NULL);
+	TEST_ASSERT_EQUAL(0, test_handle);
+}
+
+void tearDown(void)
+{
+	__wrap_at_cmd_write_ExpectAndReturn("AT+CNMI=0,0,0,0", NULL, 0, NULL, 0);
+	__wrap_at_cmd_write_IgnoreArg_buf();
+	__wrap_at_cmd_write_IgnoreArg_buf_len();
+
+	sms_unregister_listener(test_handle);
+}
+
+/** Receive a part of concatenated message. */
+static void helper_recv(const char *at_notif)
+{
+	__wrap_at_cmd_write_ExpectAndReturn("AT+CNMA=1", NULL, 0, NULL, 0);
+	sms_at_handler(NULL, at_notif);
+}
+
+static void helper_expect_msg_a(void)
+{
+	strcpy(test_sms_header.originating_address.address_str, "1234567890");
+	test_sms_header.time.day = 21;
+	test_sms_header.time.hour = 23;
+	test_sms_header.time.minute = 50;
+	test_sms_header.time.second = 44;
+	test_sms_header.concatenated.present = true;
+	test_sms_header.concatenated.total_msgs = 2;
+	test_sms_header.concatenated.ref_number = 126;
+	test_sms_header.concatenated.seq_number = 0;
+
+	strcpy(test_sms_data.payload, MSG_A_TEXT);
+	test_sms_data.payload_len = strlen(MSG_A_TEXT);
+}
+
+static void helper_expect_msg_b(void)
+{
+	strcpy(test_sms_header.originating_address.address_str, "1234567890");
+	test_sms_header.time.day = 22;
+	test_sms_header.time.hour = 8;
+	test_sms_header.time.minute = 56;
+	test_sms_header.time.second = 5;
+	test_sms_header.concatenated.present = true;
+	test_sms_header.concatenated.total_msgs = 2;
+	test_sms_header.concatenated.ref_number = 81;
+	test_sms_header.concatenated.seq_number = 0;
+
+	test_sms_data.payload_len = 163;
+	sprintf(test_sms_data.payload,
+		"12345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012"
+		"%c1234567890", 0xA4);
+}
+
+/** Both parts received in order are delivered once as a single message. */
+void test_reassembly_in_order(void)
+{
+	helper_expect_msg_a();
+
+	helper_recv(MSG_A_PART1);
+	TEST_ASSERT_EQUAL(0, sms_callback_count);
+
+	helper_recv(MSG_A_PART2);
+	TEST_ASSERT_EQUAL(1, sms_callback_count);
+}
+
+/** Parts received in reverse order are put into sequence order. */
+void test_reassembly_out_of_order(void)
+{
+	helper_expect_msg_b();
+
+	helper_recv(MSG_B_PART2);
+	TEST_ASSERT_EQUAL(0, sms_callback_count);
+
+	helper_recv(MSG_B_PART1);
+	TEST_ASSERT_EQUAL(1, sms_callback_count);
+}
+
+/** Duplicate part is ignored and doesn't complete the message. */
+void test_reassembly_duplicate_part(void)
+{
+	helper_expect_msg_a();
+
+	helper_recv(MSG_A_PART1);
+	helper_recv(MSG_A_PART1);
+	TEST_ASSERT_EQUAL(0, sms_callback_count);
+
+	helper_recv(MSG_A_PART2);
+	TEST_ASSERT_EQUAL(1, sms_callback_count);
+}
+
+/** Least recently updated message is evicted when all slots are in use. */
+void test_reassembly_eviction(void)
+{
+	helper_expect_msg_b();
+
+	helper_recv(MSG_A_PART1);
+	helper_recv(MSG_B_PART1);
+	helper_recv(MSG_B_PART2);
+	TEST_ASSERT_EQUAL(1, sms_callback_count);
+
+	/* First part of message A was evicted */
+	helper_recv(MSG_A_PART2);
+	TEST_ASSERT_EQUAL(1, sms_callback_count);
+}
+
+/** Incomplete message is dropped after the timeout. */
+void test_reassembly_timeout(void)
+{
+	helper_expect_msg_a();
+
+	helper_recv(MSG_A_PART1);
+	k_sleep(K_MSEC(CONFIG_SMS_REASSEMBLY_TIMEOUT * MSEC_PER_SEC + 100));
+
+	helper_recv(MSG_A_PART2);
+	TEST_ASSERT_EQUAL(0, sms_callback_count);
+}
+
+/** Messages with more parts than can be reassembled are delivered part by part. */
+void test_reassembly_too_many_parts(void)
+{
+	strcpy(test_sms_header.originating_address.address_str, "1234567890");
+	test_sms_header.time.day = 22;
+	test_sms_header.time.hour = 8;
+	test_sms_header.time.minute = 56;
+	test_sms_header.time.second = 5;
+	test_sms_header.concatenated.present = true;
+	test_sms_header.concatenated.total_msgs = 5;
+	test_sms_header.concatenated.ref_number = 128;
+	test_sms_header.concatenated.seq_number = 1;
+
+	test_sms_data.payload_len = 153;
+	strcpy(test_sms_data.payload,
+		"abcdefghijklmnopqrstuvwxyz "
+		"abcdefghijklmnopqrstuvwxyz "
+		"abcdefghijklmnopqrstuvwxyz "
+		"abcdefghijklmnopqrstuvwxyz "
+		"abcdefghijklmnopqrstuvwxyz "
+		"abcdefghijklmnopqr");
+
+	helper_recv("+CMT: \"1234567890\",159\r\n"
+		"0791534874894310440A912143658709000012202280655080A0050003800501C2E231B96C3EA3D3EA35BBED7EC3E3F239BD6EBFE3F37A50583C2697CD67745ABD66B7DD6F785C3EA7D7ED777C5E0F0A8BC7E4B2F98C4EABD7ECB6FB0D8FCBE7F4BAFD8ECFEB4161F1985C369FD169F59ADD76BFE171F99C5EB7DFF1793D282C1E93CBE6333AAD5EB3DBEE373C2E9FD3EBF63B3EAF0785C56372D97C46A7D56B76DBFD86C7E5\r\n");
+	TEST_ASSERT_EQUAL(1, sms_callback_count);
+}
+
+/* It is required to be added to each test. That is because unity is using
+ * different main signature (returns int) and zephyr expects main which does
+ * not return value.
+ */
+extern int unity_main(void);
+
+void main(void)
+{
+	(void)unity_main();
+}
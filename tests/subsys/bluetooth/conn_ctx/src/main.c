@@ -0,0 +1,396 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <bluetooth/conn_ctx.h>
+
+#define CONN_COUNT CONFIG_BT_MAX_CONN
+#define DATA_MAGIC 0xC0DEFACE
+
+#define THREAD_COUNT CONN_COUNT
+#define THREAD_STACK_SIZE 1024
+#define THREAD_ITERATIONS 20
+
+struct test_data {
+	uint32_t magic;
+	uint32_t conn_idx;
+};
+
+BT_CONN_CTX_DEF(test, CONN_COUNT, sizeof(struct test_data));
+BT_CONN_CTX_DEF(small, 2, sizeof(struct test_data));
+
+static struct bt_conn_ctx_lib *ctx_lib = &test_ctx_lib;
+
+/** Mocks ******************************************/
+
+static char dummy_conns[CONN_COUNT];
+static bool subscribed[CONN_COUNT];
+
+static struct bt_conn *conn_get(size_t idx)
+{
+	return (struct bt_conn *)&dummy_conns[idx];
+}
+
+uint8_t bt_conn_index(struct bt_conn *conn)
+{
+	size_t idx = (char *)conn - dummy_conns;
+
+	zassert_true(idx < CONN_COUNT, "Unexpected connection");
+	return idx;
+}
+
+bool bt_gatt_is_subscribed(struct bt_conn *conn,
+			   const struct bt_gatt_attr *attr, uint16_t ccc_value)
+{
+	return subscribed[bt_conn_index(conn)];
+}
+
+/** Test setup ******************************************/
+
+static struct test_data *data_alloc(struct bt_conn_ctx_lib *lib, size_t idx)
+{
+	struct test_data *data = bt_conn_ctx_alloc(lib, conn_get(idx));
+
+	if (data) {
+		data->magic = DATA_MAGIC;
+		data->conn_idx = idx;
+		bt_conn_ctx_release(lib, data);
+	}
+
+	return data;
+}
+
+static void data_check(const struct test_data *data, size_t idx)
+{
+	zassert_not_null(data, NULL);
+	zassert_equal(data->magic, DATA_MAGIC, "Context data overwritten");
+	zassert_equal(data->conn_idx, idx, NULL);
+}
+
+static void setup(void)
+{
+	memset(subscribed, 0, sizeof(subscribed));
+}
+
+static void teardown(void)
+{
+	bt_conn_ctx_free_all(&test_ctx_lib);
+	bt_conn_ctx_free_all(&small_ctx_lib);
+	zassert_equal(k_mem_slab_num_used_get(test_ctx_lib.mem_slab), 0,
+		      "Context memory leaked");
+	zassert_equal(k_mem_slab_num_used_get(small_ctx_lib.mem_slab), 0,
+		      "Context memory leaked");
+}
+
+/** Test cases ******************************************/
+
+static void test_get_release(void)
+{
+	struct test_data *data[CONN_COUNT];
+
+	for (size_t i = 0; i < CONN_COUNT; i++) {
+		data[i] = data_alloc(ctx_lib, i);
+		zassert_not_null(data[i], NULL);
+	}
+
+	for (size_t i = 0; i < CONN_COUNT; i++) {
+		struct test_data *ctx_data =
+			bt_conn_ctx_get(ctx_lib, conn_get(i));
+		const struct bt_conn_ctx *ctx =
+			bt_conn_ctx_get_by_id(ctx_lib, i);
+
+		zassert_equal_ptr(ctx_data, data[i], NULL);
+		data_check(ctx_data, i);
+		zassert_not_null(ctx, NULL);
+		zassert_equal_ptr(ctx->conn, conn_get(i), NULL);
+		zassert_equal_ptr(ctx->data, data[i], NULL);
+
+		bt_conn_ctx_release(ctx_lib, ctx->data);
+		bt_conn_ctx_release(ctx_lib, ctx_data);
+	}
+
+	/* The context of a connection is allocated only once. */
+	zassert_is_null(bt_conn_ctx_alloc(ctx_lib, conn_get(0)), NULL);
+
+	zassert_ok(bt_conn_ctx_free(ctx_lib, conn_get(0)), NULL);
+	zassert_is_null(bt_conn_ctx_get(ctx_lib, conn_get(0)), NULL);
+	zassert_is_null(bt_conn_ctx_get_by_id(ctx_lib, 0), NULL);
+	zassert_equal(bt_conn_ctx_free(ctx_lib, conn_get(0)), -EINVAL, NULL);
+	zassert_equal(k_mem_slab_num_used_get(ctx_lib->mem_slab),
+		      CONN_COUNT - 1, NULL);
+}
+
+static void test_memory_shared(void)
+{
+	struct test_data *data;
+
+	zassert_not_null(data_alloc(&small_ctx_lib, 3), NULL);
+	zassert_not_null(data_alloc(&small_ctx_lib, 1), NULL);
+	zassert_is_null(data_alloc(&small_ctx_lib, 0), "No memory expected");
+
+	/* The freed memory block is used by another connection. */
+	zassert_ok(bt_conn_ctx_free(&small_ctx_lib, conn_get(3)), NULL);
+	zassert_not_null(data_alloc(&small_ctx_lib, 0), NULL);
+
+	for (size_t i = 0; i < 2; i++) {
+		data = bt_conn_ctx_get(&small_ctx_lib, conn_get(i));
+		data_check(data, i);
+		bt_conn_ctx_release(&small_ctx_lib, data);
+	}
+
+	zassert_is_null(bt_conn_ctx_get(&small_ctx_lib, conn_get(3)), NULL);
+}
+
+static void test_free_while_used(void)
+{
+	struct test_data *data;
+
+	zassert_not_null(data_alloc(ctx_lib, 1), NULL);
+
+	data = bt_conn_ctx_get(ctx_lib, conn_get(1));
+	zassert_ok(bt_conn_ctx_free(ctx_lib, conn_get(1)), NULL);
+
+	/* No new reference can be taken, but the data is kept until
+	 * the last reference is released.
+	 */
+	zassert_is_null(bt_conn_ctx_get(ctx_lib, conn_get(1)), NULL);
+	zassert_is_null(bt_conn_ctx_alloc(ctx_lib, conn_get(1)), NULL);
+	zassert_equal(k_mem_slab_num_used_get(ctx_lib->mem_slab), 1, NULL);
+	data_check(data, 1);
+
+	bt_conn_ctx_release(ctx_lib, data);
+	zassert_equal(k_mem_slab_num_used_get(ctx_lib->mem_slab), 0, NULL);
+	zassert_not_null(data_alloc(ctx_lib, 1), NULL);
+}
+
+static void foreach_cb(const struct bt_conn_ctx *ctx, void *user_data)
+{
+	uint32_t *visited = user_data;
+	size_t idx = bt_conn_index(ctx->conn);
+
+	data_check(ctx->data, idx);
+	*visited |= BIT(idx);
+}
+
+static void test_foreach(void)
+{
+	static const struct bt_gatt_attr attr;
+	uint32_t visited = 0;
+
+	zassert_equal(bt_conn_ctx_foreach(ctx_lib, foreach_cb, &visited), 0,
+		      NULL);
+
+	for (size_t i = 0; i < CONN_COUNT; i++) {
+		zassert_not_null(data_alloc(ctx_lib, i), NULL);
+	}
+	zassert_ok(bt_conn_ctx_free(ctx_lib, conn_get(2)), NULL);
+
+	zassert_equal(bt_conn_ctx_foreach(ctx_lib, foreach_cb, &visited),
+		      CONN_COUNT - 1, NULL);
+	zassert_equal(visited, BIT_MASK(CONN_COUNT) & ~BIT(2), NULL);
+
+	subscribed[1] = true;
+	subscribed[2] = true;
+	subscribed[3] = true;
+	visited = 0;
+
+	zassert_equal(bt_conn_ctx_foreach_subscribed(ctx_lib, &attr,
+						     BT_GATT_CCC_NOTIFY,
+						     foreach_cb, &visited),
+		      2, NULL);
+	zassert_equal(visited, BIT(1) | BIT(3), NULL);
+
+	/* All the references are released by the iterator. */
+	zassert_ok(bt_conn_ctx_free(ctx_lib, conn_get(1)), NULL);
+	zassert_equal(k_mem_slab_num_used_get(ctx_lib->mem_slab),
+		      CONN_COUNT - 2, NULL);
+}
+
+/** Contention ******************************************/
+
+K_THREAD_STACK_ARRAY_DEFINE(thread_stacks, THREAD_COUNT, THREAD_STACK_SIZE);
+static struct k_thread threads[THREAD_COUNT];
+static K_MUTEX_DEFINE(baseline_mutex);
+
+/* Lookup as it was done before the contexts were indexed by
+ * the connection: linear search, with a mutex that is held until
+ * the context is released.
+ */
+static void *baseline_get(struct bt_conn *conn)
+{
+	k_mutex_lock(&baseline_mutex, K_FOREVER);
+
+	for (size_t i = 0; i < CONN_COUNT; i++) {
+		if (ctx_lib->ctx[i].conn == conn) {
+			return ctx_lib->ctx[i].data;
+		}
+	}
+
+	k_mutex_unlock(&baseline_mutex);
+	return NULL;
+}
+
+static void baseline_release(void *data)
+{
+	k_mutex_unlock(&baseline_mutex);
+}
+
+static void *lib_get(struct bt_conn *conn)
+{
+	return bt_conn_ctx_get(ctx_lib, conn);
+}
+
+static void lib_release(void *data)
+{
+	bt_conn_ctx_release(ctx_lib, data);
+}
+
+struct access_ops {
+	void *(*get)(struct bt_conn *conn);
+	void (*release)(void *data);
+};
+
+static void user_thread(void *p1, void *p2, void *p3)
+{
+	const struct access_ops *ops = p1;
+	size_t idx = POINTER_TO_UINT(p2);
+
+	for (size_t i = 0; i < THREAD_ITERATIONS; i++) {
+		struct test_data *data = ops->get(conn_get(idx));
+
+		data_check(data, idx);
+		/* Work done on the context, like sending a notification. */
+		k_sleep(K_TICKS(1));
+		data_check(data, idx);
+
+		ops->release(data);
+	}
+}
+
+static int64_t threads_run(const struct access_ops *ops)
+{
+	int64_t start = k_uptime_ticks();
+
+	for (size_t i = 0; i < THREAD_COUNT; i++) {
+		k_thread_create(&threads[i], thread_stacks[i],
+				K_THREAD_STACK_SIZEOF(thread_stacks[i]),
+				user_thread, (void *)ops, UINT_TO_POINTER(i),
+				NULL, K_PRIO_PREEMPT(1), 0, K_NO_WAIT);
+	}
+
+	for (size_t i = 0; i < THREAD_COUNT; i++) {
+		zassert_ok(k_thread_join(&threads[i], K_FOREVER), NULL);
+	}
+
+	return k_uptime_ticks() - start;
+}
+
+static void test_contention(void)
+{
+	static const struct access_ops baseline_ops = {
+		.get = baseline_get,
+		.release = baseline_release,
+	};
+	static const struct access_ops lib_ops = {
+		.get = lib_get,
+		.release = lib_release,
+	};
+	int64_t baseline_ticks;
+	int64_t lib_ticks;
+
+	for (size_t i = 0; i < CONN_COUNT; i++) {
+		zassert_not_null(data_alloc(ctx_lib, i), NULL);
+	}
+
+	baseline_ticks = threads_run(&baseline_ops);
+	lib_ticks = threads_run(&lib_ops);
+
+	TC_PRINT("%u threads, %u accesses each: "
+		 "global mutex %u ticks, reference counting %u ticks\n",
+		 THREAD_COUNT, THREAD_ITERATIONS,
+		 (uint32_t)baseline_ticks, (uint32_t)lib_ticks);
+
+	/* Threads using different connections do not wait for each other. */
+	zassert_true(2 * lib_ticks <= baseline_ticks, "Accesses serialized");
+}
+
+static void churn_thread(void *p1, void *p2, void *p3)
+{
+	for (size_t i = 0; i < THREAD_ITERATIONS; i++) {
+		k_sleep(K_TICKS(1));
+		zassert_ok(bt_conn_ctx_free(ctx_lib, conn_get(0)), NULL);
+		k_sleep(K_TICKS(1));
+
+		/* Readers may still hold the context freed before. */
+		while (!data_alloc(ctx_lib, 0)) {
+			k_sleep(K_TICKS(1));
+		}
+	}
+}
+
+static void reader_thread(void *p1, void *p2, void *p3)
+{
+	size_t *found = p1;
+
+	for (size_t i = 0; i < 2 * THREAD_ITERATIONS; i++) {
+		struct test_data *data = bt_conn_ctx_get(ctx_lib, conn_get(0));
+
+		k_sleep(K_TICKS(1));
+
+		if (data) {
+			(*found)++;
+			data_check(data, 0);
+			bt_conn_ctx_release(ctx_lib, data);
+		}
+	}
+}
+
+static void test_free_concurrent(void)
+{
+	size_t found[THREAD_COUNT - 1] = {0};
+
+	zassert_not_null(data_alloc(ctx_lib, 0), NULL);
+
+	k_thread_create(&threads[0], thread_stacks[0],
+			K_THREAD_STACK_SIZEOF(thread_stacks[0]),
+			churn_thread, NULL, NULL, NULL,
+			K_PRIO_PREEMPT(1), 0, K_NO_WAIT);
+	for (size_t i = 1; i < THREAD_COUNT; i++) {
+		k_thread_create(&threads[i], thread_stacks[i],
+				K_THREAD_STACK_SIZEOF(thread_stacks[i]),
+				reader_thread, &found[i - 1], NULL, NULL,
+				K_PRIO_PREEMPT(1), 0, K_NO_WAIT);
+	}
+
+	for (size_t i = 0; i < THREAD_COUNT; i++) {
+		zassert_ok(k_thread_join(&threads[i], K_FOREVER), NULL);
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(found); i++) {
+		zassert_true(found[i] > 0, "Context never found");
+	}
+	zassert_equal(k_mem_slab_num_used_get(ctx_lib->mem_slab), 1, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(bt_conn_ctx_test,
+			 ztest_unit_test_setup_teardown(test_get_release,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_memory_shared,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_free_while_used,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_foreach,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_contention,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_free_concurrent,
+							setup, teardown)
+			 );
+
+	ztest_run_test_suite(bt_conn_ctx_test);
+}
@@ -0,0 +1,449 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <bluetooth/gatt.h>
+#include <bluetooth/services/hids.h>
+
+#define CONN_COUNT CONFIG_BT_MAX_CONN
+#define INPUT_REP_COUNT 2
+#define INPUT_REP_SIZE 4
+#define ATT_IND_MOUSE INPUT_REP_COUNT
+#define ATT_IND_KB (INPUT_REP_COUNT + 1)
+#define ATT_COUNT (INPUT_REP_COUNT + 2)
+#define FRAME_COUNT 1000
+
+BT_HIDS_DEF(hids_obj, INPUT_REP_SIZE, INPUT_REP_SIZE);
+
+/** Mocks ******************************************/
+
+static char dummy_conns[CONN_COUNT];
+
+static struct {
+	bool subscribed[CONN_COUNT][ATT_COUNT];
+	/* Calls into the Bluetooth stack. */
+	size_t stack_calls;
+	/* Notifications sent, and the PDUs that carried them. */
+	size_t notifications;
+	size_t pdus;
+	size_t notifications_per_conn[CONN_COUNT];
+	size_t complete_cbs;
+	uint8_t last_data[CONN_COUNT][ATT_COUNT][BT_HIDS_BOOT_KB_INPUT_REP_LEN];
+} mock;
+
+static struct bt_conn *conn_get(size_t idx)
+{
+	return (struct bt_conn *)&dummy_conns[idx];
+}
+
+static size_t conn_idx(struct bt_conn *conn)
+{
+	size_t idx = (char *)conn - dummy_conns;
+
+	zassert_true(idx < CONN_COUNT, "Unexpected connection");
+	return idx;
+}
+
+uint8_t bt_conn_index(struct bt_conn *conn)
+{
+	return conn_idx(conn);
+}
+
+static size_t att_ind(const struct bt_gatt_attr *attr)
+{
+	size_t idx = attr - hids_obj.gp.svc.attrs;
+
+	zassert_true(idx < ATT_COUNT, "Unexpected attribute");
+	return idx;
+}
+
+static void notification_record(struct bt_conn *conn,
+				struct bt_gatt_notify_params *params)
+{
+	size_t idx = conn_idx(conn);
+
+	zassert_true(mock.subscribed[idx][att_ind(params->attr)],
+		     "Notification to a connection that is not subscribed");
+	zassert_true(params->len <= BT_HIDS_BOOT_KB_INPUT_REP_LEN, NULL);
+
+	memcpy(mock.last_data[idx][att_ind(params->attr)], params->data,
+	       params->len);
+	mock.notifications++;
+	mock.notifications_per_conn[idx]++;
+
+	if (params->func) {
+		mock.complete_cbs++;
+		params->func(conn, params->user_data);
+	}
+}
+
+bool bt_gatt_is_subscribed(struct bt_conn *conn,
+			   const struct bt_gatt_attr *attr, uint16_t ccc_value)
+{
+	zassert_equal(ccc_value, BT_GATT_CCC_NOTIFY, NULL);
+	return mock.subscribed[conn_idx(conn)][att_ind(attr)];
+}
+
+int bt_gatt_notify_cb(struct bt_conn *conn,
+		      struct bt_gatt_notify_params *params)
+{
+	mock.stack_calls++;
+
+	if (conn) {
+		mock.pdus++;
+		notification_record(conn, params);
+		return 0;
+	}
+
+	/* The stack notifies every subscribed connection. */
+	for (size_t i = 0; i < CONN_COUNT; i++) {
+		if (mock.subscribed[i][att_ind(params->attr)]) {
+			mock.pdus++;
+			notification_record(conn_get(i), params);
+		}
+	}
+
+	return 0;
+}
+
+int bt_gatt_notify_multiple(struct bt_conn *conn, uint16_t num_params,
+			    struct bt_gatt_notify_params *params)
+{
+	zassert_not_null(conn, NULL);
+	zassert_true(num_params > 0, NULL);
+
+	mock.stack_calls++;
+	/* As with CONFIG_BT_GATT_NOTIFY_MULTIPLE. */
+	mock.pdus++;
+
+	for (size_t i = 0; i < num_params; i++) {
+		notification_record(conn, &params[i]);
+	}
+
+	return 0;
+}
+
+ssize_t bt_gatt_attr_read(struct bt_conn *conn,
+			  const struct bt_gatt_attr *attr,
+			  void *buf, uint16_t buf_len, uint16_t offset,
+			  const void *value, uint16_t value_len)
+{
+	return 0;
+}
+
+int bt_gatt_service_register(struct bt_gatt_service *svc)
+{
+	return 0;
+}
+
+int bt_gatt_service_unregister(struct bt_gatt_service *svc)
+{
+	return 0;
+}
+
+int bt_gatt_pool_svc_alloc(struct bt_gatt_pool *gp,
+			   struct bt_uuid const *svc_uuid)
+{
+	return 0;
+}
+
+int bt_gatt_pool_chrc_alloc(struct bt_gatt_pool *gp, uint8_t props,
+			    struct bt_gatt_attr const *attr)
+{
+	return 0;
+}
+
+int bt_gatt_pool_desc_alloc(struct bt_gatt_pool *gp,
+			    struct bt_gatt_attr const *descriptor)
+{
+	return 0;
+}
+
+int bt_gatt_pool_ccc_alloc(struct bt_gatt_pool *gp,
+			   struct _bt_gatt_ccc *ccc,
+			   uint8_t perm)
+{
+	return 0;
+}
+
+void bt_gatt_pool_free(struct bt_gatt_pool *gp)
+{
+}
+
+/** Test setup ******************************************/
+
+static const uint8_t inp_rep_data[INPUT_REP_COUNT][INPUT_REP_SIZE] = {
+	{0x01, 0x02, 0x03, 0x04},
+	{0x11, 0x12, 0x13, 0x14},
+};
+static const uint8_t mouse_rep_data[] = {0x01, 0x10, 0xf0};
+static const uint8_t kb_rep_data[] = {0x02, 0x00, 0x04, 0x05};
+
+static const struct bt_hids_batch_rep frame[] = {
+	{
+		.type = BT_HIDS_BATCH_REP_INPUT,
+		.rep_index = 0,
+		.data = inp_rep_data[0],
+		.len = INPUT_REP_SIZE,
+	},
+	{
+		.type = BT_HIDS_BATCH_REP_INPUT,
+		.rep_index = 1,
+		.data = inp_rep_data[1],
+		.len = INPUT_REP_SIZE,
+	},
+	{
+		.type = BT_HIDS_BATCH_REP_BOOT_MOUSE,
+		.data = mouse_rep_data,
+		.len = sizeof(mouse_rep_data),
+	},
+	{
+		.type = BT_HIDS_BATCH_REP_BOOT_KB,
+		.data = kb_rep_data,
+		.len = sizeof(kb_rep_data),
+	},
+};
+
+static void complete_cb(struct bt_conn *conn, void *user_data)
+{
+}
+
+static void mock_reset(void)
+{
+	bool subscribed[CONN_COUNT][ATT_COUNT];
+
+	memcpy(subscribed, mock.subscribed, sizeof(subscribed));
+	memset(&mock, 0, sizeof(mock));
+	memcpy(mock.subscribed, subscribed, sizeof(subscribed));
+}
+
+static void subscribe_all(void)
+{
+	for (size_t i = 0; i < CONN_COUNT; i++) {
+		for (size_t j = 0; j < ATT_COUNT; j++) {
+			mock.subscribed[i][j] = true;
+		}
+	}
+}
+
+static void setup(void)
+{
+	memset(&mock, 0, sizeof(mock));
+
+	hids_obj.inp_rep_group.cnt = INPUT_REP_COUNT;
+	for (size_t i = 0; i < INPUT_REP_COUNT; i++) {
+		struct bt_hids_inp_rep *rep = &hids_obj.inp_rep_group.reports[i];
+
+		rep->idx = i;
+		rep->att_ind = i;
+		rep->size = INPUT_REP_SIZE;
+		rep->offset = i * INPUT_REP_SIZE;
+		rep->rep_mask = NULL;
+	}
+	hids_obj.outp_rep_group.cnt = 0;
+	hids_obj.feat_rep_group.cnt = 0;
+
+	hids_obj.is_mouse = true;
+	hids_obj.boot_mouse_inp_rep.att_ind = ATT_IND_MOUSE;
+	hids_obj.is_kb = true;
+	hids_obj.boot_kb_inp_rep.att_ind = ATT_IND_KB;
+
+	for (size_t i = 0; i < CONN_COUNT; i++) {
+		zassert_ok(bt_hids_connected(&hids_obj, conn_get(i)), NULL);
+	}
+}
+
+static void teardown(void)
+{
+	for (size_t i = 0; i < CONN_COUNT; i++) {
+		zassert_ok(bt_hids_disconnected(&hids_obj, conn_get(i)), NULL);
+	}
+}
+
+static void frame_send_legacy(void)
+{
+	for (size_t i = 0; i < INPUT_REP_COUNT; i++) {
+		zassert_ok(bt_hids_inp_rep_send(&hids_obj, NULL, i,
+						inp_rep_data[i],
+						INPUT_REP_SIZE, NULL), NULL);
+	}
+	zassert_ok(bt_hids_boot_mouse_inp_rep_send(&hids_obj, NULL,
+						   &mouse_rep_data[0],
+						   mouse_rep_data[1],
+						   mouse_rep_data[2], NULL),
+		   NULL);
+	zassert_ok(bt_hids_boot_kb_inp_rep_send(&hids_obj, NULL, kb_rep_data,
+						sizeof(kb_rep_data), NULL),
+		   NULL);
+}
+
+/** Test cases ******************************************/
+
+static void test_batch_all_conns(void)
+{
+	size_t legacy_pdus;
+
+	subscribe_all();
+
+	/* Host timing is meaningless on native_posix, the cost of sending
+	 * a frame is measured in calls into the stack and PDUs sent.
+	 */
+	for (size_t i = 0; i < FRAME_COUNT; i++) {
+		frame_send_legacy();
+	}
+
+	zassert_equal(mock.stack_calls, FRAME_COUNT * ARRAY_SIZE(frame), NULL);
+	zassert_equal(mock.pdus, FRAME_COUNT * CONN_COUNT * ARRAY_SIZE(frame),
+		      NULL);
+	zassert_equal(mock.notifications,
+		      FRAME_COUNT * CONN_COUNT * ARRAY_SIZE(frame), NULL);
+	TC_PRINT("Separate reports: %zu stack calls, %zu PDUs per frame\n",
+		 mock.stack_calls / FRAME_COUNT, mock.pdus / FRAME_COUNT);
+	legacy_pdus = mock.pdus;
+
+	mock_reset();
+
+	for (size_t i = 0; i < FRAME_COUNT; i++) {
+		zassert_ok(bt_hids_inp_rep_send_batch(&hids_obj, NULL, 0,
+						      frame,
+						      ARRAY_SIZE(frame),
+						      complete_cb),
+			   NULL);
+	}
+
+	TC_PRINT("Batched reports: %zu stack calls, %zu PDUs per frame\n",
+		 mock.stack_calls / FRAME_COUNT, mock.pdus / FRAME_COUNT);
+
+	zassert_true(mock.pdus < legacy_pdus, "Batching sent more PDUs");
+	zassert_equal(mock.stack_calls, FRAME_COUNT * CONN_COUNT, NULL);
+	zassert_equal(mock.pdus, FRAME_COUNT * CONN_COUNT, NULL);
+	zassert_equal(mock.notifications,
+		      FRAME_COUNT * CONN_COUNT * ARRAY_SIZE(frame), NULL);
+	zassert_equal(mock.complete_cbs, FRAME_COUNT * CONN_COUNT,
+		      "Expected one callback per connection and frame");
+
+	for (size_t i = 0; i < CONN_COUNT; i++) {
+		zassert_mem_equal(mock.last_data[i][0], inp_rep_data[0],
+				  INPUT_REP_SIZE, NULL);
+		zassert_mem_equal(mock.last_data[i][1], inp_rep_data[1],
+				  INPUT_REP_SIZE, NULL);
+		zassert_mem_equal(mock.last_data[i][ATT_IND_MOUSE],
+				  mouse_rep_data, sizeof(mouse_rep_data),
+				  NULL);
+		zassert_mem_equal(mock.last_data[i][ATT_IND_KB], kb_rep_data,
+				  sizeof(kb_rep_data), NULL);
+	}
+}
+
+static void test_batch_subscriptions(void)
+{
+	mock.subscribed[0][0] = true;
+	for (size_t j = 0; j < ATT_COUNT; j++) {
+		mock.subscribed[2][j] = true;
+	}
+
+	zassert_ok(bt_hids_inp_rep_send_batch(&hids_obj, NULL, 0, frame,
+					      ARRAY_SIZE(frame), NULL),
+		   NULL);
+
+	zassert_equal(mock.stack_calls, 2, NULL);
+	zassert_equal(mock.notifications_per_conn[0], 1, NULL);
+	zassert_equal(mock.notifications_per_conn[1], 0, NULL);
+	zassert_equal(mock.notifications_per_conn[2], ARRAY_SIZE(frame), NULL);
+}
+
+static void test_batch_conn_list(void)
+{
+	struct bt_conn *conns[] = {conn_get(1)};
+	struct bt_hids_conn_data *conn_data;
+
+	subscribe_all();
+
+	zassert_ok(bt_hids_inp_rep_send_batch(&hids_obj, conns,
+					      ARRAY_SIZE(conns), frame,
+					      ARRAY_SIZE(frame), complete_cb),
+		   NULL);
+
+	zassert_equal(mock.stack_calls, 1, NULL);
+	zassert_equal(mock.notifications_per_conn[1], ARRAY_SIZE(frame), NULL);
+	zassert_equal(mock.complete_cbs, 1, NULL);
+
+	/* Reports are stored in the context of the connection, and only
+	 * the buttons of the boot mouse report are kept.
+	 */
+	conn_data = bt_conn_ctx_get(hids_obj.conn_ctx, conn_get(1));
+	zassert_not_null(conn_data, NULL);
+	zassert_mem_equal(conn_data->inp_rep_ctx + INPUT_REP_SIZE,
+			  inp_rep_data[1], INPUT_REP_SIZE, NULL);
+	zassert_equal(conn_data->hids_boot_mouse_inp_rep_ctx[0],
+		      mouse_rep_data[0], NULL);
+	zassert_equal(conn_data->hids_boot_mouse_inp_rep_ctx[1], 0, NULL);
+	zassert_equal(conn_data->hids_boot_mouse_inp_rep_ctx[2], 0, NULL);
+	zassert_equal(conn_data->hids_boot_kb_inp_rep_ctx[
+			      BT_HIDS_BOOT_KB_INPUT_REP_LEN - 1], 0, NULL);
+	bt_conn_ctx_release(hids_obj.conn_ctx, conn_data);
+}
+
+static void test_batch_no_subscribers(void)
+{
+	zassert_equal(bt_hids_inp_rep_send_batch(&hids_obj, NULL, 0, frame,
+						 ARRAY_SIZE(frame), NULL),
+		      -ENODATA, NULL);
+	zassert_equal(mock.stack_calls, 0, NULL);
+}
+
+static void test_batch_invalid(void)
+{
+	struct bt_hids_batch_rep reps[BT_HIDS_BATCH_REP_MAX + 1];
+
+	subscribe_all();
+
+	memcpy(reps, frame, sizeof(frame));
+	reps[0].rep_index = INPUT_REP_COUNT;
+	zassert_equal(bt_hids_inp_rep_send_batch(&hids_obj, NULL, 0, reps,
+						 ARRAY_SIZE(frame), NULL),
+		      -EINVAL, "Invalid report index accepted");
+
+	memcpy(reps, frame, sizeof(frame));
+	reps[1].len = INPUT_REP_SIZE - 1;
+	zassert_equal(bt_hids_inp_rep_send_batch(&hids_obj, NULL, 0, reps,
+						 ARRAY_SIZE(frame), NULL),
+		      -EINVAL, "Invalid report length accepted");
+
+	memcpy(reps, frame, sizeof(frame));
+	reps[1] = reps[2];
+	zassert_equal(bt_hids_inp_rep_send_batch(&hids_obj, NULL, 0, reps,
+						 ARRAY_SIZE(frame), NULL),
+		      -EINVAL, "Duplicate boot report accepted");
+
+	for (size_t i = 0; i < ARRAY_SIZE(reps); i++) {
+		reps[i] = frame[0];
+	}
+	zassert_equal(bt_hids_inp_rep_send_batch(&hids_obj, NULL, 0, reps,
+						 ARRAY_SIZE(reps), NULL),
+		      -EINVAL, "Too many reports accepted");
+
+	zassert_equal(mock.stack_calls, 0, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(hids_test,
+			 ztest_unit_test_setup_teardown(test_batch_all_conns,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_batch_subscriptions,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_batch_conn_list,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_batch_no_subscribers,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_batch_invalid,
+							setup, teardown)
+			 );
+
+	ztest_run_test_suite(hids_test);
+}
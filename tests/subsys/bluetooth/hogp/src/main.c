@@ -0,0 +1,674 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <sys/byteorder.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/att.h>
+#include <bluetooth/gatt.h>
+#include <bluetooth/gatt_dm.h>
+#include <bluetooth/services/hogp.h>
+
+#define REPORT_COUNT 12
+#define ATTR_MAX (16 + 4 * REPORT_COUNT)
+#define MAP_SIZE 100
+#define DEFAULT_MTU 23
+/* Time the simulated server takes to respond to a request */
+#define CONN_INTERVAL_MS 10
+#define TIMEOUT K_SECONDS(2)
+
+/** Simulated GATT server ******************************************/
+
+struct sim_attr {
+	struct bt_gatt_dm_attr attr;
+	struct bt_uuid_16 uuid;
+	/* Characteristic declaration value */
+	struct bt_gatt_chrc chrc;
+	/* Attribute value, if it can be read */
+	const uint8_t *value;
+	uint16_t value_len;
+};
+
+struct bt_gatt_dm {
+	struct sim_attr attrs[ATTR_MAX];
+	size_t cnt;
+	struct bt_uuid_16 service_uuid;
+	struct bt_gatt_service_val service_val;
+};
+
+static struct bt_gatt_dm db;
+static char dummy_conn;
+static const bt_addr_le_t peer_addr = {
+	.type = BT_ADDR_LE_RANDOM,
+	.a = {
+		.val = {0x01, 0x23, 0x45, 0x67, 0x89, 0xCA}
+	}
+};
+
+static const uint8_t info_value[] = {0x11, 0x01, 0x00, 0x02};
+static const uint8_t pm_value[] = {BT_HIDS_PM_REPORT};
+static const uint8_t cp_value[] = {0};
+static uint8_t map_value[MAP_SIZE];
+static uint8_t boot_value[3];
+static uint8_t rep_value[4];
+static uint8_t ref_values[REPORT_COUNT][2];
+static uint8_t db_hash_value[BT_HOGP_DB_HASH_SIZE];
+
+static struct {
+	bool read_multiple;
+	bool bonded;
+	bool db_hash;
+	uint16_t mtu;
+	/* Requests received */
+	size_t requests;
+	struct bt_gatt_read_params *params;
+	struct k_work_delayable work;
+} server;
+
+static struct bt_conn *conn_get(void)
+{
+	return (struct bt_conn *)&dummy_conn;
+}
+
+static enum bt_hids_report_type rep_type(size_t idx)
+{
+	static const enum bt_hids_report_type types[] = {
+		BT_HIDS_REPORT_TYPE_INPUT,
+		BT_HIDS_REPORT_TYPE_OUTPUT,
+		BT_HIDS_REPORT_TYPE_FEATURE,
+	};
+
+	return types[idx % ARRAY_SIZE(types)];
+}
+
+static struct sim_attr *attr_add(uint16_t uuid, uint16_t handle)
+{
+	struct sim_attr *attr = &db.attrs[db.cnt++];
+
+	zassert_true(db.cnt <= ARRAY_SIZE(db.attrs), "Too many attributes");
+	memset(attr, 0, sizeof(*attr));
+	attr->uuid.uuid.type = BT_UUID_TYPE_16;
+	attr->uuid.val = uuid;
+	attr->attr.uuid = &attr->uuid.uuid;
+	attr->attr.handle = handle;
+	return attr;
+}
+
+static uint16_t chrc_add(uint16_t handle, uint16_t uuid, uint8_t props,
+			 const uint8_t *value, uint16_t value_len)
+{
+	struct sim_attr *chrc = attr_add(BT_UUID_GATT_CHRC_VAL, handle);
+	struct sim_attr *attr = attr_add(uuid, handle + 1);
+
+	chrc->chrc.uuid = &attr->uuid.uuid;
+	chrc->chrc.value_handle = handle + 1;
+	chrc->chrc.properties = props;
+
+	attr->value = value;
+	attr->value_len = value_len;
+
+	return handle + 2;
+}
+
+/* Build the database, with the reports moved by handle_shift */
+static void db_build(uint16_t handle_shift)
+{
+	uint16_t handle = 2;
+	struct sim_attr *attr;
+
+	/* Any change of the database changes its hash */
+	memset(db_hash_value, 0xa0 + handle_shift, sizeof(db_hash_value));
+
+	db.cnt = 0;
+	attr_add(BT_UUID_GATT_PRIMARY_VAL, 1);
+	db.service_uuid.uuid.type = BT_UUID_TYPE_16;
+	db.service_uuid.val = BT_UUID_HIDS_VAL;
+	db.service_val.uuid = &db.service_uuid.uuid;
+
+	handle = chrc_add(handle, BT_UUID_HIDS_INFO_VAL, BT_GATT_CHRC_READ,
+			  info_value, sizeof(info_value));
+	handle = chrc_add(handle, BT_UUID_HIDS_REPORT_MAP_VAL,
+			  BT_GATT_CHRC_READ, map_value, sizeof(map_value));
+	handle = chrc_add(handle, BT_UUID_HIDS_CTRL_POINT_VAL,
+			  BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+			  cp_value, sizeof(cp_value));
+	handle = chrc_add(handle, BT_UUID_HIDS_PROTOCOL_MODE_VAL,
+			  BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+			  pm_value, sizeof(pm_value));
+	handle = chrc_add(handle, BT_UUID_HIDS_BOOT_MOUSE_IN_REPORT_VAL,
+			  BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+			  boot_value, sizeof(boot_value));
+	attr_add(BT_UUID_GATT_CCC_VAL, handle++);
+
+	handle += handle_shift;
+
+	for (size_t i = 0; i < REPORT_COUNT; i++) {
+		enum bt_hids_report_type type = rep_type(i);
+		uint8_t props = BT_GATT_CHRC_READ;
+
+		if (type == BT_HIDS_REPORT_TYPE_INPUT) {
+			props |= BT_GATT_CHRC_NOTIFY;
+		} else if (type == BT_HIDS_REPORT_TYPE_OUTPUT) {
+			props |= BT_GATT_CHRC_WRITE_WITHOUT_RESP;
+		} else {
+			props |= BT_GATT_CHRC_WRITE;
+		}
+
+		handle = chrc_add(handle, BT_UUID_HIDS_REPORT_VAL, props,
+				  rep_value, sizeof(rep_value));
+		if (type == BT_HIDS_REPORT_TYPE_INPUT) {
+			attr_add(BT_UUID_GATT_CCC_VAL, handle++);
+		}
+
+		ref_values[i][0] = i + 1;
+		ref_values[i][1] = type;
+		attr = attr_add(BT_UUID_HIDS_REPORT_REF_VAL, handle++);
+		attr->value = ref_values[i];
+		attr->value_len = sizeof(ref_values[i]);
+	}
+
+	db.service_val.end_handle = handle - 1;
+}
+
+static const struct sim_attr *server_attr(uint16_t handle)
+{
+	for (size_t i = 0; i < db.cnt; i++) {
+		if (db.attrs[i].attr.handle == handle) {
+			zassert_not_null(db.attrs[i].value,
+					 "Read of attribute without value");
+			return &db.attrs[i];
+		}
+	}
+
+	zassert_unreachable("Unknown handle: %u", handle);
+	return NULL;
+}
+
+/* Responds to the pending request like the Bluetooth stack does */
+static void server_respond(struct k_work *work)
+{
+	struct bt_gatt_read_params *params = server.params;
+	struct bt_conn *conn = conn_get();
+	uint8_t rsp[DEFAULT_MTU * 4];
+	uint16_t len = 0;
+
+	server.params = NULL;
+
+	if (params->handle_count == 0) {
+		zassert_equal(bt_uuid_cmp(params->by_uuid.uuid,
+					  BT_UUID_GATT_DB_HASH), 0,
+			      "Unexpected read by UUID");
+		if (!server.db_hash) {
+			params->func(conn, BT_ATT_ERR_ATTRIBUTE_NOT_FOUND,
+				     params, NULL, 0);
+			return;
+		}
+		if (params->func(conn, 0, params, db_hash_value,
+				 sizeof(db_hash_value)) != BT_GATT_ITER_STOP) {
+			params->func(conn, 0, params, NULL, 0);
+		}
+		return;
+	}
+
+	if (params->handle_count == 1) {
+		const struct sim_attr *attr =
+			server_attr(params->single.handle);
+		uint16_t offset = params->single.offset;
+
+		zassert_true(offset <= attr->value_len, NULL);
+		len = MIN(attr->value_len - offset, server.mtu - 1);
+		if (len == 0) {
+			params->func(conn, 0, params, NULL, 0);
+			return;
+		}
+		memcpy(rsp, &attr->value[offset], len);
+		if ((params->func(conn, 0, params, rsp, len) !=
+		     BT_GATT_ITER_STOP) && (len < server.mtu - 1)) {
+			params->func(conn, 0, params, NULL, 0);
+		}
+		return;
+	}
+
+	if (!server.read_multiple) {
+		params->func(conn, BT_ATT_ERR_NOT_SUPPORTED, params, NULL, 0);
+		return;
+	}
+
+	zassert_true(1 + 2 * params->handle_count <= server.mtu,
+		     "Read Multiple request too long");
+	for (size_t i = 0; i < params->handle_count; i++) {
+		const struct sim_attr *attr =
+			server_attr(params->multiple.handles[i]);
+
+		zassert_true(len + attr->value_len <= sizeof(rsp), NULL);
+		memcpy(&rsp[len], attr->value, attr->value_len);
+		len += attr->value_len;
+	}
+	zassert_true(len <= server.mtu - 1, "Read Multiple response truncated");
+
+	params->func(conn, 0, params, rsp, len);
+	params->func(conn, 0, params, NULL, 0);
+}
+
+/** Mocks ******************************************/
+
+int bt_gatt_read(struct bt_conn *conn, struct bt_gatt_read_params *params)
+{
+	zassert_equal(conn, conn_get(), NULL);
+	zassert_is_null(server.params, "Request already pending");
+
+	server.requests++;
+	server.params = params;
+	k_work_reschedule(&server.work, K_MSEC(CONN_INTERVAL_MS));
+	return 0;
+}
+
+uint16_t bt_gatt_get_mtu(struct bt_conn *conn)
+{
+	return server.mtu;
+}
+
+int bt_gatt_write(struct bt_conn *conn, struct bt_gatt_write_params *params)
+{
+	return -ENOTSUP;
+}
+
+int bt_gatt_write_without_response_cb(struct bt_conn *conn, uint16_t handle,
+				      const void *data, uint16_t length,
+				      bool sign, bt_gatt_complete_func_t func,
+				      void *user_data)
+{
+	return -ENOTSUP;
+}
+
+int bt_gatt_subscribe(struct bt_conn *conn,
+		      struct bt_gatt_subscribe_params *params)
+{
+	return -ENOTSUP;
+}
+
+int bt_gatt_unsubscribe(struct bt_conn *conn,
+			struct bt_gatt_subscribe_params *params)
+{
+	return -ENOTSUP;
+}
+
+int bt_conn_get_info(const struct bt_conn *conn, struct bt_conn_info *info)
+{
+	memset(info, 0, sizeof(*info));
+	return 0;
+}
+
+const bt_addr_le_t *bt_conn_get_dst(const struct bt_conn *conn)
+{
+	return &peer_addr;
+}
+
+bool bt_addr_le_is_bonded(uint8_t id, const bt_addr_le_t *addr)
+{
+	return server.bonded && !bt_addr_le_cmp(addr, &peer_addr);
+}
+
+int bt_uuid_cmp(const struct bt_uuid *u1, const struct bt_uuid *u2)
+{
+	zassert_equal(u1->type, BT_UUID_TYPE_16, NULL);
+	zassert_equal(u2->type, BT_UUID_TYPE_16, NULL);
+
+	return (int)BT_UUID_16(u1)->val - (int)BT_UUID_16(u2)->val;
+}
+
+struct bt_conn *bt_gatt_dm_conn_get(struct bt_gatt_dm *dm)
+{
+	return conn_get();
+}
+
+const struct bt_gatt_dm_attr *bt_gatt_dm_service_get(
+	const struct bt_gatt_dm *dm)
+{
+	return &dm->attrs[0].attr;
+}
+
+struct bt_gatt_service_val *bt_gatt_dm_attr_service_val(
+	const struct bt_gatt_dm_attr *attr)
+{
+	return &db.service_val;
+}
+
+struct bt_gatt_chrc *bt_gatt_dm_attr_chrc_val(
+	const struct bt_gatt_dm_attr *attr)
+{
+	struct sim_attr *sim = CONTAINER_OF(attr, struct sim_attr, attr);
+
+	if (bt_uuid_cmp(attr->uuid, BT_UUID_GATT_CHRC)) {
+		return NULL;
+	}
+	return &sim->chrc;
+}
+
+const struct bt_gatt_dm_attr *bt_gatt_dm_char_next(
+	const struct bt_gatt_dm *dm,
+	const struct bt_gatt_dm_attr *prev)
+{
+	size_t i = 0;
+
+	if (prev) {
+		i = CONTAINER_OF(prev, struct sim_attr, attr) - dm->attrs + 1;
+	}
+
+	for (; i < dm->cnt; i++) {
+		if (!bt_uuid_cmp(dm->attrs[i].attr.uuid, BT_UUID_GATT_CHRC)) {
+			return &dm->attrs[i].attr;
+		}
+	}
+
+	return NULL;
+}
+
+const struct bt_gatt_dm_attr *bt_gatt_dm_char_by_uuid(
+	const struct bt_gatt_dm *dm,
+	const struct bt_uuid *uuid)
+{
+	const struct bt_gatt_dm_attr *attr = NULL;
+
+	while ((attr = bt_gatt_dm_char_next(dm, attr)) != NULL) {
+		if (!bt_uuid_cmp(bt_gatt_dm_attr_chrc_val(attr)->uuid, uuid)) {
+			return attr;
+		}
+	}
+
+	return NULL;
+}
+
+const struct bt_gatt_dm_attr *bt_gatt_dm_desc_by_uuid(
+	const struct bt_gatt_dm *dm,
+	const struct bt_gatt_dm_attr *attr_chrc,
+	const struct bt_uuid *uuid)
+{
+	size_t i = CONTAINER_OF(attr_chrc, struct sim_attr, attr) -
+		   dm->attrs + 1;
+
+	for (; i < dm->cnt; i++) {
+		const struct bt_gatt_dm_attr *attr = &dm->attrs[i].attr;
+
+		if (!bt_uuid_cmp(attr->uuid, BT_UUID_GATT_CHRC)) {
+			break;
+		}
+		if (!bt_uuid_cmp(attr->uuid, uuid)) {
+			return attr;
+		}
+	}
+
+	return NULL;
+}
+
+/** Test setup ******************************************/
+
+static struct bt_hogp hogp;
+static K_SEM_DEFINE(ready_sem, 0, 1);
+static K_SEM_DEFINE(map_sem, 0, 1);
+static int prep_err;
+static uint8_t map_buf[MAP_SIZE];
+static size_t map_len;
+
+static void hogp_ready_cb(struct bt_hogp *hogp)
+{
+	k_sem_give(&ready_sem);
+}
+
+static void hogp_prep_fail_cb(struct bt_hogp *hogp, int err)
+{
+	prep_err = err;
+	k_sem_give(&ready_sem);
+}
+
+static const struct bt_hogp_init_params hogp_init_params = {
+	.ready_cb      = hogp_ready_cb,
+	.prep_error_cb = hogp_prep_fail_cb,
+};
+
+static void map_cb(struct bt_hogp *hogp, uint8_t err, const uint8_t *data,
+		   size_t size, size_t offset)
+{
+	zassert_equal(err, 0, NULL);
+	zassert_equal(offset, map_len, NULL);
+
+	if (data) {
+		zassert_true(offset + size <= sizeof(map_buf), NULL);
+		memcpy(&map_buf[offset], data, size);
+		map_len += size;
+	}
+
+	if (data && (size == server.mtu - 1)) {
+		zassert_ok(bt_hogp_map_read(hogp, map_cb, map_len, K_NO_WAIT),
+			   NULL);
+	} else {
+		k_sem_give(&map_sem);
+	}
+}
+
+static void map_read(void)
+{
+	map_len = 0;
+	memset(map_buf, 0, sizeof(map_buf));
+	zassert_ok(bt_hogp_map_read(&hogp, map_cb, 0, K_NO_WAIT), NULL);
+	zassert_ok(k_sem_take(&map_sem, TIMEOUT), "Map read timed out");
+	zassert_equal(map_len, sizeof(map_value), NULL);
+	zassert_mem_equal(map_buf, map_value, sizeof(map_value), NULL);
+}
+
+static const struct bt_hogp_prep_stats *hogp_prepare(void)
+{
+	const struct bt_hogp_prep_stats *stats;
+
+	prep_err = 0;
+	server.requests = 0;
+	zassert_ok(bt_hogp_handles_assign(&db, &hogp), NULL);
+	zassert_ok(k_sem_take(&ready_sem, TIMEOUT), "Preparation timed out");
+	zassert_ok(prep_err, "Preparation failed");
+	zassert_true(bt_hogp_ready_check(&hogp), NULL);
+
+	stats = bt_hogp_prep_stats_get(&hogp);
+	zassert_equal(stats->reads, server.requests, NULL);
+	TC_PRINT("Ready after %u read(s) in %u ms%s\n", stats->reads,
+		 stats->latency_ms, stats->cached ? " (cached)" : "");
+
+	return stats;
+}
+
+static void hogp_check(void)
+{
+	const struct bt_hids_info *info = bt_hogp_conn_info_val(&hogp);
+
+	zassert_equal(info->bcd_hid, sys_get_le16(info_value), NULL);
+	zassert_equal(info->b_country_code, info_value[2], NULL);
+	zassert_equal(info->flags, info_value[3], NULL);
+	zassert_equal(bt_hogp_pm_get(&hogp), BT_HIDS_PM_REPORT, NULL);
+	zassert_not_null(bt_hogp_rep_boot_mouse_in(&hogp), NULL);
+	zassert_equal(bt_hogp_rep_count(&hogp), REPORT_COUNT, NULL);
+
+	for (size_t i = 0; i < REPORT_COUNT; i++) {
+		zassert_not_null(bt_hogp_rep_find(&hogp, rep_type(i), i + 1),
+				 "Report %zu not found", i);
+	}
+}
+
+static void setup(void)
+{
+	memset(&server, 0, sizeof(server));
+	k_work_init_delayable(&server.work, server_respond);
+	server.mtu = DEFAULT_MTU;
+	server.read_multiple = true;
+	server.db_hash = true;
+
+	for (size_t i = 0; i < sizeof(map_value); i++) {
+		map_value[i] = i;
+	}
+	db_build(0);
+
+	bt_hogp_init(&hogp, &hogp_init_params);
+}
+
+static void teardown(void)
+{
+	bt_hogp_release(&hogp);
+}
+
+/** Test cases ******************************************/
+
+static void test_read_multiple(void)
+{
+	const struct bt_hogp_prep_stats *stats = hogp_prepare();
+
+	hogp_check();
+
+	/* HID Information and 9 report references fit into the first
+	 * response, the rest of the references and the protocol mode
+	 * into the second.
+	 */
+	zassert_equal(stats->reads, 2, NULL);
+	zassert_false(stats->cached, NULL);
+	zassert_true(stats->latency_ms >= 2 * CONN_INTERVAL_MS, NULL);
+}
+
+static void test_read_multiple_not_supported(void)
+{
+	const struct bt_hogp_prep_stats *stats;
+
+	server.read_multiple = false;
+	stats = hogp_prepare();
+
+	hogp_check();
+
+	/* The rejected request and then each value one by one */
+	zassert_equal(stats->reads, 1 + 1 + REPORT_COUNT + 1, NULL);
+}
+
+static void test_not_bonded(void)
+{
+	const struct bt_hogp_prep_stats *stats;
+
+	hogp_prepare();
+	map_read();
+	bt_hogp_release(&hogp);
+
+	stats = hogp_prepare();
+	hogp_check();
+	zassert_false(stats->cached, NULL);
+	zassert_equal(stats->reads, 2, NULL);
+}
+
+static void test_cache(void)
+{
+	const struct bt_hogp_prep_stats *stats;
+	size_t requests;
+
+	server.bonded = true;
+
+	hogp_prepare();
+	map_read();
+	bt_hogp_release(&hogp);
+
+	/* Reconnection: only the Database Hash and the protocol mode
+	 * are read
+	 */
+	stats = hogp_prepare();
+	hogp_check();
+	zassert_true(stats->cached, NULL);
+	zassert_equal(stats->reads, 2, NULL);
+
+	requests = server.requests;
+	map_read();
+	zassert_equal(server.requests, requests,
+		      "Report map read from the server");
+}
+
+static void test_cache_outdated(void)
+{
+	const struct bt_hogp_prep_stats *stats;
+
+	server.bonded = true;
+
+	hogp_prepare();
+	map_read();
+	bt_hogp_release(&hogp);
+
+	/* The server database changed */
+	db_build(4);
+
+	stats = hogp_prepare();
+	hogp_check();
+	zassert_false(stats->cached, NULL);
+	zassert_equal(stats->reads, 3, NULL);
+
+	server.requests = 0;
+	map_read();
+	zassert_true(server.requests > 0, "Outdated report map used");
+}
+
+static void test_cache_hash_changed(void)
+{
+	const struct bt_hogp_prep_stats *stats;
+
+	server.bonded = true;
+
+	hogp_prepare();
+	map_read();
+	bt_hogp_release(&hogp);
+
+	/* The database changed without moving the HIDS attributes */
+	db_hash_value[0] ^= 0xff;
+
+	stats = hogp_prepare();
+	hogp_check();
+	zassert_false(stats->cached, NULL);
+	zassert_equal(stats->reads, 3, NULL);
+
+	server.requests = 0;
+	map_read();
+	zassert_true(server.requests > 0, "Outdated report map used");
+}
+
+static void test_cache_no_hash(void)
+{
+	const struct bt_hogp_prep_stats *stats;
+
+	server.bonded = true;
+	server.db_hash = false;
+
+	hogp_prepare();
+	map_read();
+	bt_hogp_release(&hogp);
+
+	/* The data cannot be validated, so it is not cached */
+	stats = hogp_prepare();
+	hogp_check();
+	zassert_false(stats->cached, NULL);
+	zassert_equal(stats->reads, 3, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(hogp_test,
+			 ztest_unit_test_setup_teardown(test_read_multiple,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(
+				test_read_multiple_not_supported,
+				setup, teardown),
+			 ztest_unit_test_setup_teardown(test_not_bonded,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_cache,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_cache_outdated,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_cache_hash_changed,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_cache_no_hash,
+							setup, teardown)
+			 );
+
+	ztest_run_test_suite(hogp_test);
+}
@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+
+#include "buttons_debounce.h"
+
+#define COLS 3
+#define ROWS 4
+
+#define PRESS_MS 2
+#define RELEASE_MS 4
+#define EVENT_LIMIT 4
+
+#define EVENTS_MAX 16
+
+/* Raw matrix state recorded at a given time. */
+struct sample {
+	uint32_t time;
+	uint32_t raw[COLS];
+};
+
+struct key_evt {
+	uint32_t time;
+	size_t col;
+	size_t row;
+	bool pressed;
+};
+
+static struct buttons_debounce_config config;
+
+BUTTONS_DEBOUNCE_DEFINE(db, &config, COLS, ROWS);
+
+static struct key_evt events[EVENTS_MAX];
+static size_t event_cnt;
+static uint32_t cur_time;
+static uint32_t last_time;
+
+
+static void key_changed(size_t col, size_t row, bool pressed, void *user_data)
+{
+	zassert_true(event_cnt < ARRAY_SIZE(events), "Too many events");
+
+	events[event_cnt].time = cur_time;
+	events[event_cnt].col = col;
+	events[event_cnt].row = row;
+	events[event_cnt].pressed = pressed;
+	event_cnt++;
+}
+
+static uint32_t process(uint32_t time, const uint32_t *raw)
+{
+	cur_time = time;
+
+	uint32_t next_ms = buttons_debounce_process(&db, raw,
+						    cur_time - last_time,
+						    key_changed, NULL);
+
+	last_time = cur_time;
+
+	return next_ms;
+}
+
+static void play(const struct sample *trace, size_t cnt)
+{
+	for (size_t i = 0; i < cnt; i++) {
+		(void)process(trace[i].time, trace[i].raw);
+	}
+}
+
+static void check_event(size_t idx, uint32_t time, size_t col, size_t row,
+			bool pressed)
+{
+	zassert_true(idx < event_cnt, "Missing event %zu", idx);
+	zassert_equal(events[idx].time, time, "Wrong time of event %zu", idx);
+	zassert_equal(events[idx].col, col, "Wrong column of event %zu", idx);
+	zassert_equal(events[idx].row, row, "Wrong row of event %zu", idx);
+	zassert_equal(events[idx].pressed, pressed,
+		      "Wrong state of event %zu", idx);
+}
+
+static void setup(void)
+{
+	config.press_ms = PRESS_MS;
+	config.release_ms = RELEASE_MS;
+	config.event_limit = EVENT_LIMIT;
+
+	buttons_debounce_reset(&db);
+	event_cnt = 0;
+	cur_time = 0;
+	last_time = 0;
+}
+
+static void teardown(void)
+{
+}
+
+static void test_press_bounce(void)
+{
+	static const struct sample trace[] = {
+		{ 0,  { 0x0, 0x0, 0x0 } },
+		{ 1,  { 0x0, 0x2, 0x0 } },
+		{ 2,  { 0x0, 0x0, 0x0 } },
+		{ 3,  { 0x0, 0x2, 0x0 } },
+		{ 4,  { 0x0, 0x0, 0x0 } },
+		{ 5,  { 0x0, 0x2, 0x0 } },
+		{ 6,  { 0x0, 0x2, 0x0 } },
+		{ 7,  { 0x0, 0x2, 0x0 } },
+		{ 8,  { 0x0, 0x2, 0x0 } },
+	};
+
+	play(trace, ARRAY_SIZE(trace));
+
+	zassert_equal(event_cnt, 1, "Wrong number of events");
+	check_event(0, 5 + PRESS_MS, 1, 1, true);
+	zassert_true(buttons_debounce_any_pressed(&db), "Key not pressed");
+}
+
+static void test_release_bounce(void)
+{
+	static const struct sample trace[] = {
+		{ 0,  { 0x8, 0x0, 0x0 } },
+		{ 2,  { 0x8, 0x0, 0x0 } },
+		{ 3,  { 0x0, 0x0, 0x0 } },
+		{ 4,  { 0x8, 0x0, 0x0 } },
+		{ 5,  { 0x0, 0x0, 0x0 } },
+		{ 6,  { 0x0, 0x0, 0x0 } },
+		{ 7,  { 0x0, 0x0, 0x0 } },
+		{ 8,  { 0x8, 0x0, 0x0 } },
+		{ 9,  { 0x0, 0x0, 0x0 } },
+		{ 10, { 0x0, 0x0, 0x0 } },
+		{ 11, { 0x0, 0x0, 0x0 } },
+		{ 12, { 0x0, 0x0, 0x0 } },
+		{ 13, { 0x0, 0x0, 0x0 } },
+		{ 14, { 0x0, 0x0, 0x0 } },
+	};
+
+	play(trace, ARRAY_SIZE(trace));
+
+	zassert_equal(event_cnt, 2, "Wrong number of events");
+	check_event(0, 0 + PRESS_MS, 0, 3, true);
+	check_event(1, 9 + RELEASE_MS, 0, 3, false);
+	zassert_false(buttons_debounce_any_pressed(&db), "Key pressed");
+}
+
+static void test_glitch(void)
+{
+	/* Glitches shorter than the debounce time are not reported. */
+	static const struct sample trace[] = {
+		{ 0,  { 0x0, 0x0, 0x0 } },
+		{ 1,  { 0x0, 0x0, 0x1 } },
+		{ 2,  { 0x0, 0x0, 0x0 } },
+		{ 3,  { 0x4, 0x0, 0x0 } },
+		{ 4,  { 0x0, 0x0, 0x0 } },
+		{ 5,  { 0x0, 0x0, 0x0 } },
+		{ 10, { 0x0, 0x0, 0x0 } },
+	};
+
+	play(trace, ARRAY_SIZE(trace));
+
+	zassert_equal(event_cnt, 0, "Glitch reported");
+	zassert_false(buttons_debounce_any_pressed(&db), "Key pressed");
+}
+
+static void test_asymmetric(void)
+{
+	/* A press shorter than the release debounce time is reported. */
+	static const struct sample trace[] = {
+		{ 0,  { 0x1, 0x0, 0x0 } },
+		{ 1,  { 0x1, 0x0, 0x0 } },
+		{ 2,  { 0x1, 0x0, 0x0 } },
+		{ 3,  { 0x0, 0x0, 0x0 } },
+		{ 5,  { 0x0, 0x0, 0x0 } },
+		{ 7,  { 0x0, 0x0, 0x0 } },
+	};
+
+	play(trace, ARRAY_SIZE(trace));
+
+	zassert_equal(event_cnt, 2, "Wrong number of events");
+	check_event(0, 0 + PRESS_MS, 0, 0, true);
+	check_event(1, 3 + RELEASE_MS, 0, 0, false);
+}
+
+static void test_ghosting(void)
+{
+	/* Keys (0, 0), (0, 1) and (1, 0) are pressed. Key (1, 1) is seen
+	 * as pressed too, so the state of keys in both columns is ambiguous.
+	 */
+	static const struct sample trace[] = {
+		{ 0,  { 0x1, 0x0, 0x0 } },
+		{ 2,  { 0x3, 0x0, 0x0 } },
+		{ 4,  { 0x3, 0x0, 0x0 } },
+		{ 6,  { 0x3, 0x3, 0x0 } },
+		{ 8,  { 0x3, 0x3, 0x0 } },
+		{ 16, { 0x3, 0x3, 0x0 } },
+		{ 20, { 0x1, 0x1, 0x0 } },
+		{ 22, { 0x1, 0x1, 0x0 } },
+		{ 24, { 0x1, 0x1, 0x0 } },
+	};
+
+	play(trace, ARRAY_SIZE(trace));
+
+	zassert_equal(event_cnt, 4, "Wrong number of events");
+	check_event(0, 0 + PRESS_MS, 0, 0, true);
+	check_event(1, 2 + PRESS_MS, 0, 1, true);
+	check_event(2, 20 + PRESS_MS, 1, 0, true);
+	check_event(3, 20 + RELEASE_MS, 0, 1, false);
+}
+
+static void test_event_limit(void)
+{
+	static const uint32_t all_pressed[COLS] = { 0x1, 0x1, 0x1 };
+	static const uint32_t none_pressed[COLS];
+
+	config.event_limit = 2;
+
+	zassert_equal(process(0, all_pressed), PRESS_MS, "Wrong delay");
+	zassert_equal(process(PRESS_MS, all_pressed), 1, "Wrong delay");
+	zassert_equal(event_cnt, 2, "Event limit exceeded");
+
+	zassert_equal(process(PRESS_MS + 1, all_pressed), 0, "Wrong delay");
+	zassert_equal(event_cnt, 3, "Delayed event not reported");
+
+	/* Releasing the keys starts their release debounce. */
+	zassert_equal(process(PRESS_MS + 2, none_pressed), RELEASE_MS,
+		      "Wrong delay");
+	zassert_equal(event_cnt, 3, "Unexpected event");
+
+	check_event(0, PRESS_MS, 0, 0, true);
+	check_event(1, PRESS_MS, 1, 0, true);
+	check_event(2, PRESS_MS + 1, 2, 0, true);
+}
+
+static void test_scan_delay(void)
+{
+	static const uint32_t pressed[COLS] = { 0x0, 0x4, 0x0 };
+	static const uint32_t released[COLS];
+
+	/* The next scan is needed only when the debounce time ends. */
+	zassert_equal(process(0, released), 0, "Wrong delay");
+	zassert_equal(process(10, pressed), PRESS_MS, "Wrong delay");
+	zassert_equal(process(11, pressed), PRESS_MS - 1, "Wrong delay");
+	zassert_equal(process(11 + PRESS_MS, pressed), 0, "Wrong delay");
+	zassert_equal(process(100, released), RELEASE_MS, "Wrong delay");
+	zassert_equal(process(100 + RELEASE_MS + 5, released), 0,
+		      "Wrong delay");
+
+	zassert_equal(event_cnt, 2, "Wrong number of events");
+	check_event(0, 11 + PRESS_MS, 1, 2, true);
+	check_event(1, 100 + RELEASE_MS + 5, 1, 2, false);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(caf_buttons_debounce_test,
+			 ztest_unit_test_setup_teardown(test_press_bounce,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_release_bounce,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_glitch,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_asymmetric,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_ghosting,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_event_limit,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_scan_delay,
+							setup, teardown)
+			 );
+
+	ztest_run_test_suite(caf_buttons_debounce_test);
+}
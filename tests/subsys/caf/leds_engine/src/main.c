@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <ztest.h>
+
+#include "leds_engine.h"
+
+#define LED_COUNT 4
+#define UPDATES_MAX 256
+
+#define BREATH_PERIOD 150
+/* Substeps of both color changes and both holds of the breath effect. */
+#define BREATH_WAKEUPS (2 * _BREATH_SUBSTEPS + 2)
+#define BREATH_DURATION (4 * BREATH_PERIOD)
+
+struct color_update {
+	uint32_t time;
+	size_t id;
+	struct led_color color;
+};
+
+static void color_set(size_t id, const struct led_color *color);
+static void effect_done(size_t id, const struct led_effect *effect);
+
+static const struct leds_engine_cb engine_cb = {
+	.color_set = color_set,
+	.effect_done = effect_done,
+};
+
+LEDS_ENGINE_DEFINE(engine, &engine_cb, LED_COUNT);
+
+static const struct led_effect effect_fade = {
+	.steps = ((const struct led_effect_step[]) {
+		{
+			.color = { .c = {100, 0, 200} },
+			.substep_count = 4,
+			.substep_time = 10,
+		},
+	}),
+	.step_count = 1,
+	.loop_forever = false,
+};
+
+static const struct led_effect effect_hold = {
+	.steps = ((const struct led_effect_step[]) {
+		{
+			.color = { .c = {50, 50, 50} },
+			.substep_count = 1,
+			.substep_time = 10,
+		},
+		{
+			.color = { .c = {50, 50, 50} },
+			.substep_count = 1,
+			.substep_time = 50,
+		},
+		{
+			.color = LED_NOCOLOR(),
+			.substep_count = 1,
+			.substep_time = 10,
+		},
+	}),
+	.step_count = 3,
+	.loop_forever = false,
+};
+
+static const struct led_effect effect_blink =
+	LED_EFFECT_LED_BLINK(20, LED_COLOR(255, 255, 255));
+
+static const struct led_effect effect_breath =
+	LED_EFFECT_LED_BREATH(BREATH_PERIOD, LED_COLOR(255, 0, 0));
+
+static struct color_update updates[UPDATES_MAX];
+static size_t update_cnt;
+static size_t done_cnt[LED_COUNT];
+static uint32_t cur_time;
+
+
+static void color_set(size_t id, const struct led_color *color)
+{
+	zassert_true(id < LED_COUNT, "Invalid LED");
+	zassert_true(update_cnt < ARRAY_SIZE(updates), "Too many updates");
+
+	updates[update_cnt].time = cur_time;
+	updates[update_cnt].id = id;
+	updates[update_cnt].color = *color;
+	update_cnt++;
+}
+
+static void effect_done(size_t id, const struct led_effect *effect)
+{
+	zassert_true(id < LED_COUNT, "Invalid LED");
+
+	done_cnt[id]++;
+}
+
+/* Process the engine at the requested moments until the end time.
+ * Returns the number of wakeups.
+ */
+static size_t run(uint32_t end_time)
+{
+	size_t wakeups = 0;
+	uint32_t delay;
+	bool active = leds_engine_next_delay(&engine, cur_time, &delay);
+
+	while (active && (cur_time + delay <= end_time)) {
+		cur_time += delay;
+		wakeups++;
+		active = leds_engine_process(&engine, cur_time, &delay);
+	}
+
+	cur_time = end_time;
+
+	return wakeups;
+}
+
+static void check_update(size_t idx, uint32_t time, size_t id, uint8_t r,
+			 uint8_t g, uint8_t b)
+{
+	zassert_true(idx < update_cnt, "Missing update %zu", idx);
+	zassert_equal(updates[idx].time, time, "Wrong time of update %zu", idx);
+	zassert_equal(updates[idx].id, id, "Wrong LED of update %zu", idx);
+	zassert_equal(updates[idx].color.c[0], r, "Wrong red of update %zu",
+		      idx);
+	zassert_equal(updates[idx].color.c[1], g, "Wrong green of update %zu",
+		      idx);
+	zassert_equal(updates[idx].color.c[2], b, "Wrong blue of update %zu",
+		      idx);
+}
+
+static void setup(void)
+{
+	memset(engine_leds, 0, sizeof(engine_leds));
+	memset(done_cnt, 0, sizeof(done_cnt));
+	update_cnt = 0;
+	cur_time = 1000;
+}
+
+static void teardown(void)
+{
+}
+
+static void test_trajectory(void)
+{
+	leds_engine_start(&engine, 1, &effect_fade, cur_time);
+
+	zassert_equal(run(cur_time + 100), 4, "Wrong number of wakeups");
+	zassert_equal(update_cnt, 4, "Wrong number of updates");
+
+	check_update(0, 1010, 1, 25, 0, 50);
+	check_update(1, 1020, 1, 50, 0, 100);
+	check_update(2, 1030, 1, 75, 0, 150);
+	check_update(3, 1040, 1, 100, 0, 200);
+	zassert_equal(done_cnt[1], 1, "Effect not done");
+}
+
+static void test_restart(void)
+{
+	leds_engine_start(&engine, 0, &effect_fade, cur_time);
+	run(cur_time + 25);
+
+	/* The new effect starts from the current color. */
+	leds_engine_start(&engine, 0, &effect_hold, cur_time);
+	run(cur_time + 100);
+
+	zassert_equal(update_cnt, 4, "Wrong number of updates");
+	check_update(0, 1010, 0, 25, 0, 50);
+	check_update(1, 1020, 0, 50, 0, 100);
+	check_update(2, 1035, 0, 50, 50, 50);
+	/* The hold step does not change the color. */
+	check_update(3, 1095, 0, 0, 0, 0);
+	zassert_equal(done_cnt[0], 1, "Wrong number of done effects");
+}
+
+static void test_stop(void)
+{
+	leds_engine_start(&engine, 0, &effect_fade, cur_time);
+	run(cur_time + 25);
+	leds_engine_stop(&engine, 0);
+
+	/* The stopped LED is off, so the effect starts from off again. */
+	update_cnt = 0;
+	leds_engine_start(&engine, 0, &effect_fade, cur_time);
+	run(cur_time + 100);
+
+	zassert_equal(update_cnt, 4, "Wrong number of updates");
+	check_update(0, 1035, 0, 25, 0, 50);
+	check_update(3, 1065, 0, 100, 0, 200);
+	zassert_equal(done_cnt[0], 1, "Wrong number of done effects");
+}
+
+static void test_unchanged_skipped(void)
+{
+	static const struct led_effect_step steps[] = {
+		{
+			.color = { .c = {1, 1, 1} },
+			.substep_count = 8,
+			.substep_time = 10,
+		},
+	};
+	static const struct led_effect effect_slow = {
+		.steps = steps,
+		.step_count = ARRAY_SIZE(steps),
+		.loop_forever = false,
+	};
+
+	/* A color change smaller than the number of substeps is reported
+	 * only when the rounded color changes.
+	 */
+	leds_engine_start(&engine, 2, &effect_slow, cur_time);
+
+	zassert_equal(run(cur_time + 100), 8, "Wrong number of wakeups");
+	zassert_equal(update_cnt, 2, "Wrong number of updates");
+	check_update(0, 1010, 2, 0, 0, 0);
+	check_update(1, 1040, 2, 1, 1, 1);
+}
+
+static void test_late_processing(void)
+{
+	uint32_t delay;
+
+	leds_engine_start(&engine, 3, &effect_fade, cur_time);
+
+	/* Substeps missed due to a processing delay are caught up. */
+	cur_time += 35;
+	zassert_true(leds_engine_process(&engine, cur_time, &delay),
+		     "Effect not active");
+	zassert_equal(delay, 5, "Wrong delay");
+	zassert_equal(update_cnt, 1, "Wrong number of updates");
+	check_update(0, 1035, 3, 75, 0, 150);
+
+	run(cur_time + 100);
+	zassert_equal(update_cnt, 2, "Wrong number of updates");
+	check_update(1, 1040, 3, 100, 0, 200);
+}
+
+static void test_loop(void)
+{
+	leds_engine_start(&engine, 0, &effect_blink, cur_time);
+
+	zassert_equal(run(cur_time + 80), 4, "Wrong number of wakeups");
+	zassert_equal(update_cnt, 4, "Wrong number of updates");
+
+	check_update(0, 1020, 0, 100, 100, 100);
+	check_update(1, 1040, 0, 0, 0, 0);
+	check_update(2, 1060, 0, 100, 100, 100);
+	check_update(3, 1080, 0, 0, 0, 0);
+	zassert_equal(done_cnt[0], 0, "Looped effect done");
+}
+
+static void test_shared_tick(void)
+{
+	for (size_t i = 0; i < LED_COUNT; i++) {
+		leds_engine_start(&engine, i, &effect_breath, cur_time);
+	}
+
+	/* One wakeup advances all LEDs. Separate timers would need
+	 * LED_COUNT times more wakeups.
+	 */
+	size_t wakeups = run(cur_time + 2 * BREATH_DURATION);
+
+	zassert_equal(wakeups, 2 * BREATH_WAKEUPS, "Wrong number of wakeups");
+
+	/* All LEDs follow the same trajectory, updated in the same wakeup. */
+	zassert_equal(update_cnt % LED_COUNT, 0, "Wrong number of updates");
+	for (size_t i = 0; i < update_cnt; i += LED_COUNT) {
+		for (size_t j = 1; j < LED_COUNT; j++) {
+			zassert_equal(updates[i + j].time, updates[i].time,
+				      "LEDs updated separately");
+			zassert_equal(updates[i + j].id, j, "Wrong LED");
+			zassert_equal(updates[i + j].color.c[0],
+				      updates[i].color.c[0], "Wrong color");
+		}
+	}
+
+	/* Brightness rises monotonically to the full color. */
+	uint8_t prev = 0;
+
+	for (size_t i = 0; i < _BREATH_SUBSTEPS * LED_COUNT; i += LED_COUNT) {
+		zassert_true(updates[i].color.c[0] > prev, "Wrong trajectory");
+		prev = updates[i].color.c[0];
+	}
+	zassert_equal(prev, 100, "Full color not reached");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(caf_leds_engine_test,
+			 ztest_unit_test_setup_teardown(test_trajectory,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_restart,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_stop,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_unchanged_skipped,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_late_processing,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_loop,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_shared_tick,
+							setup, teardown)
+			 );
+
+	ztest_run_test_suite(caf_leds_engine_test);
+}
@@ -48,6 +48,11 @@ int dfu_target_mcuboot_done(bool successful)
 	return done_retval;
 }
 
+int dfu_target_mcuboot_reset(void)
+{
+	return 0;
+}
+
 static void init(void)
 {
 	int err;
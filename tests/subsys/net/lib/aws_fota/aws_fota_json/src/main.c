@@ -7,6 +7,7 @@
 #include <zephyr/types.h>
 #include <stdbool.h>
 #include <ztest.h>
+#include <net/aws_jobs.h>
 #include <aws_fota_json.h>
 
 static void test_parse_job_execution(void)
@@ -182,10 +183,70 @@ static void test_update_job_exec_rsp(void)
 }
 
 
+static void test_parse_job_execution_chunked(void)
+{
+	int ret;
+	char job_id[AWS_JOBS_JOB_ID_MAX_LEN];
+	char hostname[100];
+	char file_path[100];
+	char protocol[AWS_FOTA_JSON_PROTOCOL_MAX_LEN];
+	struct aws_fota_json_parser parser;
+	struct aws_fota_job_doc doc = {
+		.job_id = job_id,
+		.hostname = hostname,
+		.file_path = file_path,
+		.protocol = protocol,
+	};
+	char encoded[] = "{\"timestamp\":1559808907,\"execution\":{\"jobId\":\"job\\u00e9\",\"status\":\"QUEUED\",\"statusDetails\":{\"list\":[1,{\"host\":\"x\"},[]]},\"versionNumber\":7,\"jobDocument\":{\"operation\":\"app_fw_update\",\"fileSize\":181124,\"location\":{\"protocol\":\"https:\",\"host\":\"fota.example.com\",\"path\":\"/update.bin\"}}}}";
+
+	/* The result must not depend on how the document is split up */
+	for (size_t chunk = 1; chunk < sizeof(encoded); chunk++) {
+		aws_fota_json_parser_init(&parser, &doc);
+
+		for (size_t i = 0; i < sizeof(encoded) - 1; i += chunk) {
+			ret = aws_fota_json_parser_feed(&parser, &encoded[i],
+				MIN(chunk, sizeof(encoded) - 1 - i));
+			zassert_equal(ret, 0, NULL);
+		}
+
+		ret = aws_fota_json_parser_finish(&parser);
+		zassert_equal(ret, 1, NULL);
+		zassert_true(!strcmp(job_id, "job\xc3\xa9"), NULL);
+		zassert_true(!strcmp(hostname, "fota.example.com"), NULL);
+		zassert_true(!strcmp(file_path, "/update.bin"), NULL);
+		zassert_true(!strcmp(protocol, "https:"), NULL);
+		zassert_equal(doc.version_number, 7, NULL);
+		zassert_equal(doc.file_size, 181124, NULL);
+	}
+}
+
+static void test_parse_job_execution_incomplete(void)
+{
+	int ret;
+	char job_id[AWS_JOBS_JOB_ID_MAX_LEN];
+	char hostname[100];
+	char file_path[100];
+	struct aws_fota_json_parser parser;
+	struct aws_fota_job_doc doc = {
+		.job_id = job_id,
+		.hostname = hostname,
+		.file_path = file_path,
+	};
+	char encoded[] = "{\"execution\":{\"jobId\":\"job\",\"versionNumber\":1,\"jobDocument\":{\"location\":{\"host\":\"fota.example.com\",\"path\":\"/update.bin\"}}}";
+
+	aws_fota_json_parser_init(&parser, &doc);
+	ret = aws_fota_json_parser_feed(&parser, encoded, sizeof(encoded) - 1);
+	zassert_equal(ret, 0, NULL);
+	ret = aws_fota_json_parser_finish(&parser);
+	zassert_equal(ret, -ENODATA, "Missing closing brace not detected");
+}
+
 void test_main(void)
 {
 	ztest_test_suite(lib_json_test,
 			 ztest_unit_test(test_parse_job_execution),
+			 ztest_unit_test(test_parse_job_execution_chunked),
+			 ztest_unit_test(test_parse_job_execution_incomplete),
 			 ztest_unit_test(test_parse_job_execution_missing_job_id_field),
 			 ztest_unit_test(test_parse_job_execution_missing_location_obj),
 			 ztest_unit_test(test_parse_job_execution_missing_path_field),
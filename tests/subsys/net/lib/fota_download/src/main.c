@@ -26,12 +26,28 @@ char buf[1024];
 #define NO_TLS -1
 #define DEFAULT_APN NULL
 
+#define IMAGE_SIZE 1000
+#define FRAGMENT_SIZE 48
+
 /* Stubs and mocks */
 bool dfu_ctx_mcuboot_set_b1_file__s0_active;
 const char *download_client_start_file;
 char *dfu_ctx_mcuboot_set_b1_file__update;
 static bool spm_s0_active_retval;
 
+static struct download_client *dl;
+static download_client_callback_t dl_callback;
+static uint8_t image[IMAGE_SIZE];
+static uint8_t written[IMAGE_SIZE];
+static size_t written_len;
+static bool write_fail;
+static int done_cnt;
+static bool done_successful;
+
+static enum fota_download_evt_id last_evt;
+static enum fota_download_error_cause last_cause;
+static int last_progress;
+
 int dfu_target_init(int img_type, size_t file_size, dfu_target_callback_t cb)
 {
 	return 0;
@@ -44,16 +60,33 @@ int dfu_target_img_type(const void *const buf, size_t len)
 
 int dfu_target_offset_get(size_t *offset)
 {
+	*offset = 0;
 	return 0;
 }
 
 int dfu_target_write(const void *const buf, size_t len)
 {
+	if (write_fail) {
+		return -EIO;
+	}
+
+	zassert_true(written_len + len <= sizeof(written), "Too much data");
+	memcpy(&written[written_len], buf, len);
+	written_len += len;
+
 	return 0;
 }
 
 int dfu_target_done(bool successful)
 {
+	/* All data is written before the target is done */
+	if (successful) {
+		zassert_equal(written_len, IMAGE_SIZE, "Data not written");
+	}
+
+	done_cnt++;
+	done_successful = successful;
+
 	return 0;
 }
 
@@ -76,12 +109,15 @@ int download_client_start(struct download_client *client, const char *file,
 
 int download_client_file_size_get(struct download_client *client, size_t *size)
 {
+	*size = IMAGE_SIZE;
 	return 0;
 }
 
 int download_client_init(struct download_client *client,
 			 download_client_callback_t callback)
 {
+	dl = client;
+	dl_callback = callback;
 	return 0;
 }
 
@@ -167,6 +203,13 @@ void set_s0_active(bool s0_active)
 
 void client_callback(const struct fota_download_evt *evt)
 {
+	if (evt->id == FOTA_DOWNLOAD_EVT_PROGRESS) {
+		last_progress = evt->progress;
+		return;
+	}
+
+	last_evt = evt->id;
+	last_cause = evt->cause;
 }
 
 static void init(void)
@@ -226,10 +269,91 @@ static void test_fota_download_start(void)
 	zassert_equal(err, -EALREADY, "No failure for double call");
 }
 
+/* Start a download, and feed the image to the library as the download
+ * client does. Returns the first non-zero return value of the callback.
+ */
+static int download(void)
+{
+	struct download_client_evt evt;
+	size_t len;
+	int err;
+
+	(void)fota_download_cancel();
+
+	dfu_ctx_mcuboot_set_b1_file__update = NULL;
+	strcpy(buf, S0);
+	err = fota_download_start("something.com", buf, NO_TLS, DEFAULT_APN, 0);
+	zassert_equal(err, 0, "Download not started");
+
+	for (size_t i = 0; i < sizeof(image); i++) {
+		image[i] = i;
+	}
+
+	written_len = 0;
+	done_cnt = 0;
+	done_successful = false;
+	last_evt = FOTA_DOWNLOAD_EVT_CANCELLED;
+	last_progress = 0;
+
+	for (size_t offset = 0; offset < sizeof(image); offset += len) {
+		len = MIN(FRAGMENT_SIZE, sizeof(image) - offset);
+
+		evt.id = DOWNLOAD_CLIENT_EVT_FRAGMENT;
+		evt.fragment.buf = &image[offset];
+		evt.fragment.len = len;
+		dl->progress = offset + len;
+
+		err = dl_callback(&evt);
+		if (err != 0) {
+			return err;
+		}
+	}
+
+	evt.id = DOWNLOAD_CLIENT_EVT_DONE;
+
+	return dl_callback(&evt);
+}
+
+static void test_fota_download_write(void)
+{
+	write_fail = false;
+
+	/* With CONFIG_FOTA_DOWNLOAD_PIPELINE, fragments are written by the
+	 * writer thread. They are written in order, before the target is
+	 * done.
+	 */
+	zassert_equal(download(), 0, "Download failed");
+	zassert_equal(written_len, sizeof(image), "Wrong amount written");
+	zassert_mem_equal(written, image, sizeof(image), "Wrong data written");
+	zassert_equal(done_cnt, 1, "Target not done");
+	zassert_true(done_successful, "Target not done successfully");
+	zassert_equal(last_evt, FOTA_DOWNLOAD_EVT_FINISHED, "Not finished");
+	zassert_equal(last_progress, 100, "Wrong progress");
+}
+
+static void test_fota_download_write_error(void)
+{
+	write_fail = true;
+
+	/* With CONFIG_FOTA_DOWNLOAD_PIPELINE, the error is reported on a later
+	 * fragment or when the download is done.
+	 */
+	zassert_not_equal(download(), 0, "Write error not reported");
+	zassert_equal(done_cnt, 1, "Target not released");
+	zassert_false(done_successful, "Target done successfully");
+	zassert_equal(last_evt, FOTA_DOWNLOAD_EVT_ERROR, "No error event");
+	zassert_equal(last_cause, FOTA_DOWNLOAD_ERROR_CAUSE_INVALID_UPDATE,
+		      "Wrong error cause");
+
+	write_fail = false;
+}
+
 void test_main(void)
 {
 	ztest_test_suite(lib_fota_download_test,
-			 ztest_unit_test(test_fota_download_start));
+			 ztest_unit_test(test_fota_download_start),
+			 ztest_unit_test(test_fota_download_write),
+			 ztest_unit_test(test_fota_download_write_error));
 
 	ztest_run_test_suite(lib_fota_download_test);
 }
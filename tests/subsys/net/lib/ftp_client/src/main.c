@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <net/socket.h>
+
+/* Route the socket calls of the client to a simulated FTP server. */
+#define socket mock_socket
+#define connect mock_connect
+#define setsockopt mock_setsockopt
+#define send mock_send
+#define recv mock_recv
+#define poll mock_poll
+#define close mock_close
+#define getaddrinfo mock_getaddrinfo
+#define freeaddrinfo mock_freeaddrinfo
+#define addrinfo zsock_addrinfo
+#define pollfd zsock_pollfd
+#define POLLIN ZSOCK_POLLIN
+#define POLLHUP ZSOCK_POLLHUP
+#define POLLERR ZSOCK_POLLERR
+#define POLLNVAL ZSOCK_POLLNVAL
+
+int mock_socket(int family, int type, int proto);
+int mock_connect(int sock, const struct sockaddr *addr, socklen_t addrlen);
+int mock_setsockopt(int sock, int level, int optname, const void *optval,
+		    socklen_t optlen);
+ssize_t mock_send(int sock, const void *buf, size_t len, int flags);
+ssize_t mock_recv(int sock, void *buf, size_t max_len, int flags);
+int mock_poll(struct zsock_pollfd *fds, int nfds, int timeout);
+int mock_close(int sock);
+int mock_getaddrinfo(const char *host, const char *service,
+		     const struct zsock_addrinfo *hints,
+		     struct zsock_addrinfo **res);
+void mock_freeaddrinfo(struct zsock_addrinfo *ai);
+
+#include <ftp_client.c>
+
+#define CMD_FD 1
+#define DATA_FD 2
+
+/* Largest chunk accepted or returned by a single data socket call. */
+#define DATA_CHUNK 100
+#define FILE_SIZE 1000
+
+static char cmd_log[256];
+static char reply[64];
+static bool data_open;
+
+static uint8_t file_data[FILE_SIZE];
+static uint8_t uploaded[FILE_SIZE];
+static size_t uploaded_len;
+static size_t download_len;
+static size_t download_pos;
+/* Poll events of the data socket after the downloaded data, or 0 for
+ * an orderly close.
+ */
+static short download_end_events;
+
+
+int mock_socket(int family, int type, int proto)
+{
+	zassert_false(data_open, "Data socket already open");
+	data_open = true;
+
+	return DATA_FD;
+}
+
+int mock_connect(int sock, const struct sockaddr *addr, socklen_t addrlen)
+{
+	return 0;
+}
+
+int mock_setsockopt(int sock, int level, int optname, const void *optval,
+		    socklen_t optlen)
+{
+	return 0;
+}
+
+static void cmd_handle(const char *cmd, size_t len)
+{
+	zassert_true(strlen(cmd_log) + len < sizeof(cmd_log), "Command log full");
+	strncat(cmd_log, cmd, len);
+
+	if (!strncmp(cmd, "PASV", 4)) {
+		strcpy(reply, "227 Entering Passive Mode (127,0,0,1,4,1)\r\n");
+	} else if (!strncmp(cmd, "REST", 4)) {
+		strcpy(reply, "350 Restarting\r\n");
+	} else if (!strncmp(cmd, "STOR", 4) || !strncmp(cmd, "APPE", 4) ||
+		   !strncmp(cmd, "RETR", 4)) {
+		strcpy(reply, "150 Ok to send data\r\n");
+	} else {
+		strcpy(reply, "500 Unknown command\r\n");
+	}
+}
+
+ssize_t mock_send(int sock, const void *buf, size_t len, int flags)
+{
+	if (sock == CMD_FD) {
+		cmd_handle(buf, len);
+		return len;
+	}
+
+	zassert_equal(sock, DATA_FD, "Invalid socket");
+	zassert_true(data_open, "Data socket closed");
+
+	/* Partial sends, as with a full TCP window. */
+	len = MIN(len, DATA_CHUNK);
+	zassert_true(uploaded_len + len <= sizeof(uploaded), "Upload too long");
+	memcpy(&uploaded[uploaded_len], buf, len);
+	uploaded_len += len;
+
+	return len;
+}
+
+ssize_t mock_recv(int sock, void *buf, size_t max_len, int flags)
+{
+	size_t len;
+
+	if (sock == CMD_FD) {
+		len = strlen(reply);
+		zassert_true(len < max_len, "Reply too long");
+		memcpy(buf, reply, len);
+		reply[0] = '\0';
+		return len;
+	}
+
+	zassert_equal(sock, DATA_FD, "Invalid socket");
+	len = MIN(MIN(max_len, DATA_CHUNK), download_len - download_pos);
+	memcpy(buf, &file_data[download_pos], len);
+	download_pos += len;
+
+	return len;
+}
+
+int mock_poll(struct zsock_pollfd *fds, int nfds, int timeout)
+{
+	zassert_equal(nfds, 1, "Unexpected poll");
+
+	if (fds[0].fd == CMD_FD) {
+		fds[0].revents = (reply[0] != '\0') ? POLLIN : 0;
+	} else if ((download_pos < download_len) ||
+		   (download_end_events == 0)) {
+		/* An orderly close is readable, recv() returns 0 */
+		fds[0].revents = POLLIN;
+	} else {
+		fds[0].revents = download_end_events;
+	}
+
+	return (fds[0].revents != 0) ? 1 : 0;
+}
+
+int mock_close(int sock)
+{
+	if ((sock == DATA_FD) && data_open) {
+		data_open = false;
+		strcpy(reply, "226 Transfer complete\r\n");
+	}
+
+	return 0;
+}
+
+int mock_getaddrinfo(const char *host, const char *service,
+		     const struct zsock_addrinfo *hints,
+		     struct zsock_addrinfo **res)
+{
+	return -EINVAL;
+}
+
+void mock_freeaddrinfo(struct zsock_addrinfo *ai)
+{
+}
+
+static void ftp_ctrl_callback(const uint8_t *msg, uint16_t len)
+{
+}
+
+static void ftp_data_callback(const uint8_t *msg, uint16_t len)
+{
+}
+
+static void setup(void)
+{
+	memset(cmd_log, 0, sizeof(cmd_log));
+	reply[0] = '\0';
+	data_open = false;
+	uploaded_len = 0;
+	download_len = 0;
+	download_pos = 0;
+	download_end_events = 0;
+
+	for (size_t i = 0; i < sizeof(file_data); i++) {
+		file_data[i] = i;
+	}
+
+	client.cmd_sock = CMD_FD;
+	client.data_sock = INVALID_SOCKET;
+	client.connected = true;
+	client.stream = STREAM_IDLE;
+	client.stream_offset = 0;
+}
+
+static void teardown(void)
+{
+}
+
+static void test_put_stream(void)
+{
+	static const size_t chunks[] = { 1, 299, 450, 250 };
+	size_t pos = 0;
+
+	zassert_equal(ftp_put_stream_open("f.bin", FTP_PUT_NORMAL, 0),
+		      FTP_CODE_150, "Stream not opened");
+	zassert_true(data_open, "No data connection");
+	zassert_equal(strcmp(cmd_log, "PASV\r\nSTOR f.bin\r\n"), 0,
+		      "Wrong commands");
+
+	/* All chunks go through the same data connection. */
+	for (size_t i = 0; i < ARRAY_SIZE(chunks); i++) {
+		zassert_equal(ftp_put_stream_write(&file_data[pos], chunks[i]),
+			      0, "Write failed");
+		pos += chunks[i];
+		zassert_equal(ftp_stream_offset(), pos, "Wrong offset");
+	}
+
+	zassert_equal(ftp_put_stream_close(), FTP_CODE_226,
+		      "Transfer not complete");
+	zassert_false(data_open, "Data connection not closed");
+	zassert_equal(uploaded_len, sizeof(file_data), "Wrong upload size");
+	zassert_mem_equal(uploaded, file_data, sizeof(file_data),
+			  "Wrong upload data");
+}
+
+static void test_put_stream_resume(void)
+{
+	zassert_equal(ftp_put_stream_open("f.bin", FTP_PUT_APPEND, 500),
+		      FTP_CODE_150, "Stream not opened");
+	zassert_equal(strcmp(cmd_log, "PASV\r\nREST 500\r\nAPPE f.bin\r\n"),
+		      0, "Wrong commands");
+
+	zassert_equal(ftp_put_stream_write(&file_data[500], 100), 0,
+		      "Write failed");
+	zassert_equal(ftp_stream_offset(), 600, "Wrong offset");
+
+	zassert_equal(ftp_put_stream_close(), FTP_CODE_226,
+		      "Transfer not complete");
+	zassert_mem_equal(uploaded, &file_data[500], 100, "Wrong upload data");
+}
+
+static void test_get_stream(void)
+{
+	uint8_t buf[64];
+	uint8_t received[FILE_SIZE];
+	size_t received_len = 0;
+	int ret;
+
+	download_len = sizeof(file_data);
+
+	zassert_equal(ftp_get_stream_open("f.bin", 0), FTP_CODE_150,
+		      "Stream not opened");
+	zassert_equal(strcmp(cmd_log, "PASV\r\nRETR f.bin\r\n"), 0,
+		      "Wrong commands");
+
+	/* Data is read only when requested. */
+	while ((ret = ftp_get_stream_read(buf, sizeof(buf))) > 0) {
+		zassert_true(received_len + ret <= sizeof(received),
+			     "Too much data");
+		memcpy(&received[received_len], buf, ret);
+		received_len += ret;
+		zassert_equal(download_pos, received_len, "Data read ahead");
+	}
+
+	zassert_equal(ret, 0, "Read failed");
+	zassert_equal(received_len, sizeof(file_data), "Wrong download size");
+	zassert_mem_equal(received, file_data, sizeof(file_data),
+			  "Wrong download data");
+	zassert_equal(ftp_stream_offset(), sizeof(file_data), "Wrong offset");
+
+	zassert_equal(ftp_get_stream_close(), FTP_CODE_226,
+		      "Transfer not complete");
+}
+
+static void download_lost(short events, int err)
+{
+	uint8_t buf[64];
+	int ret;
+
+	download_len = 200;
+	download_end_events = events;
+
+	zassert_equal(ftp_get_stream_open("f.bin", 0), FTP_CODE_150,
+		      "Stream not opened");
+
+	while ((ret = ftp_get_stream_read(buf, sizeof(buf))) > 0) {
+	}
+
+	/* A broken transfer is not reported as the end of file. */
+	zassert_equal(ret, err, "Wrong error");
+	zassert_equal(ftp_stream_offset(), download_len, "Wrong offset");
+
+	(void)ftp_get_stream_close();
+}
+
+static void test_get_stream_reset(void)
+{
+	download_lost(POLLHUP, -ECONNRESET);
+}
+
+static void test_get_stream_error(void)
+{
+	download_lost(POLLERR | POLLHUP, -EIO);
+}
+
+static void test_busy(void)
+{
+	uint8_t buf[8];
+
+	zassert_equal(ftp_put_stream_open("f.bin", FTP_PUT_NORMAL, 0),
+		      FTP_CODE_150, "Stream not opened");
+	memset(cmd_log, 0, sizeof(cmd_log));
+
+	/* No other transfer can start while the stream is open. */
+	zassert_equal(ftp_put("g.bin", file_data, 10, FTP_PUT_NORMAL), -EBUSY,
+		      "Put not rejected");
+	zassert_equal(ftp_get("g.bin"), -EBUSY, "Get not rejected");
+	zassert_equal(ftp_list("", ""), -EBUSY, "List not rejected");
+	zassert_equal(ftp_put_stream_open("g.bin", FTP_PUT_NORMAL, 0), -EBUSY,
+		      "Stream not rejected");
+	zassert_equal(ftp_get_stream_open("g.bin", 0), -EBUSY,
+		      "Stream not rejected");
+	zassert_equal(ftp_get_stream_read(buf, sizeof(buf)), -ENOTCONN,
+		      "Read from upload stream");
+	zassert_equal(cmd_log[0], '\0', "Command sent during stream");
+
+	zassert_equal(ftp_put_stream_close(), FTP_CODE_226,
+		      "Transfer not complete");
+}
+
+static void test_not_open(void)
+{
+	uint8_t buf[8];
+
+	zassert_equal(ftp_put_stream_write(file_data, 10), -ENOTCONN,
+		      "Write without stream");
+	zassert_equal(ftp_get_stream_read(buf, sizeof(buf)), -ENOTCONN,
+		      "Read without stream");
+	zassert_equal(ftp_put_stream_close(), -ENOTCONN,
+		      "Close without stream");
+	zassert_equal(ftp_get_stream_close(), -ENOTCONN,
+		      "Close without stream");
+	zassert_equal(cmd_log[0], '\0', "Command sent");
+}
+
+void test_main(void)
+{
+	zassert_equal(ftp_init(ftp_ctrl_callback, ftp_data_callback), 0,
+		      "Init failed");
+
+	ztest_test_suite(ftp_client_test,
+			 ztest_unit_test_setup_teardown(test_put_stream,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_put_stream_resume,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_get_stream,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_get_stream_reset,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_get_stream_error,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_busy,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_not_open,
+							setup, teardown)
+			 );
+
+	ztest_run_test_suite(ftp_client_test);
+}
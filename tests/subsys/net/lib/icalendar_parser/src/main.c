@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <net/icalendar_parser.h>
+
+#define EVENTS_MAX 8
+
+/* Contains folded lines, a nested component and an unsupported component. */
+static const char calendar[] =
+	"BEGIN:VCALENDAR\r\n"
+	"VERSION:2.0\r\n"
+	"PRODID:-//Nordic Semiconductor//Test//EN\r\n"
+	"BEGIN:VEVENT\r\n"
+	"DTSTART:20210601T100000Z\r\n"
+	"DTEND:20210601T110000Z\r\n"
+	"SUMMARY:Team\r\n"
+	"  meeting\r\n"
+	"LOCATION:Room 1\r\n"
+	"DESCRIPTION:Weekly \r\n"
+	"\tsync\r\n"
+	"BEGIN:VALARM\r\n"
+	"TRIGGER:-PT15M\r\n"
+	"END:VALARM\r\n"
+	"END:VEVENT\r\n"
+	"BEGIN:VTODO\r\n"
+	"SUMMARY:Todo\r\n"
+	"END:VTODO\r\n"
+	"BEGIN:VEVENT\r\n"
+	"DTSTART;TZID=Europe/Oslo:20210602T090000\r\n"
+	"SUMMARY:Review\r\n"
+	"END:VEVENT\r\n"
+	"END:VCALENDAR\r\n";
+
+/* End of the first component, where the parser stops if asked to. */
+static const char first_end[] = "END:VEVENT\r\n";
+
+static struct icalendar_parser ical;
+static struct ical_parser_evt events[EVENTS_MAX];
+static size_t event_cnt;
+static size_t stop_at;
+static bool stopped;
+
+
+static int ical_callback(const struct ical_parser_evt *evt)
+{
+	zassert_true(event_cnt < ARRAY_SIZE(events), "Too many events");
+
+	events[event_cnt++] = *evt;
+	stopped = (event_cnt == stop_at);
+
+	return stopped ? 1 : 0;
+}
+
+/* Feed the calendar in two fragments split at the position, unless
+ * the callback stopped the parsing. Returns the number of parsed bytes.
+ */
+static size_t parse_split(size_t split)
+{
+	size_t len = sizeof(calendar) - 1;
+	size_t parsed;
+
+	parsed = ical_parser_parse(&ical, calendar, split);
+	if (stopped) {
+		return parsed;
+	}
+
+	return parsed + ical_parser_parse(&ical, &calendar[split], len - split);
+}
+
+static void check_events(void)
+{
+	zassert_equal(events[0].id, ICAL_EVT_VEVENT, "Wrong component");
+	zassert_equal(events[0].error, ICAL_ERROR_NONE, "Wrong error");
+	zassert_equal(strcmp(events[0].ical_com.summary, "Team meeting"), 0,
+		      "Wrong summary");
+	zassert_equal(strcmp(events[0].ical_com.location, "Room 1"), 0,
+		      "Wrong location");
+	zassert_equal(strcmp(events[0].ical_com.description, "Weekly sync"), 0,
+		      "Wrong description");
+	zassert_equal(strcmp(events[0].ical_com.dtstart, "20210601T100000Z"), 0,
+		      "Wrong start");
+	zassert_equal(strcmp(events[0].ical_com.dtend, "20210601T110000Z"), 0,
+		      "Wrong end");
+
+	zassert_equal(events[1].id, ICAL_EVT_VTODO, "Wrong component");
+	zassert_equal(events[1].error, ICAL_ERROR_COM_NOT_SUPPORTED,
+		      "Wrong error");
+
+	zassert_equal(events[2].id, ICAL_EVT_VEVENT, "Wrong component");
+	zassert_equal(events[2].error, ICAL_ERROR_NONE, "Wrong error");
+	zassert_equal(strcmp(events[2].ical_com.summary, "Review"), 0,
+		      "Wrong summary");
+	zassert_equal(strcmp(events[2].ical_com.dtstart, "20210602T090000"), 0,
+		      "Wrong start");
+	zassert_equal(events[2].ical_com.dtend[0], '\0', "Unexpected end");
+}
+
+static void setup(void)
+{
+	memset(events, 0, sizeof(events));
+	event_cnt = 0;
+	stop_at = 0;
+	stopped = false;
+
+	zassert_equal(ical_parser_init(&ical, ical_callback), 0,
+		      "Init failed");
+}
+
+static void teardown(void)
+{
+}
+
+static void test_init_invalid(void)
+{
+	zassert_equal(ical_parser_init(NULL, ical_callback), -EINVAL,
+		      "NULL parser accepted");
+	zassert_equal(ical_parser_init(&ical, NULL), -EINVAL,
+		      "NULL callback accepted");
+}
+
+static void test_split_anywhere(void)
+{
+	size_t len = sizeof(calendar) - 1;
+
+	/* Every split position, including inside CRLF and folded lines,
+	 * gives the same components.
+	 */
+	for (size_t split = 0; split <= len; split++) {
+		setup();
+
+		zassert_equal(parse_split(split), len,
+			      "Not all data parsed, split %zu", split);
+		zassert_equal(event_cnt, 3, "Wrong number of events, split %zu",
+			      split);
+		check_events();
+	}
+}
+
+static void test_byte_by_byte(void)
+{
+	size_t len = sizeof(calendar) - 1;
+
+	for (size_t i = 0; i < len; i++) {
+		zassert_equal(ical_parser_parse(&ical, &calendar[i], 1), 1,
+			      "Byte %zu not parsed", i);
+	}
+
+	zassert_equal(event_cnt, 3, "Wrong number of events");
+	check_events();
+}
+
+static void test_callback_stop(void)
+{
+	size_t len = sizeof(calendar) - 1;
+	size_t stop_offset = strstr(calendar, first_end) - calendar +
+			     strlen(first_end);
+
+	for (size_t split = 0; split <= len; split++) {
+		setup();
+		stop_at = 1;
+
+		/* Parsing stops right after the component, wherever
+		 * the data is split.
+		 */
+		zassert_equal(parse_split(split), stop_offset,
+			      "Wrong stop offset, split %zu", split);
+		zassert_equal(event_cnt, 1, "Parsing not stopped, split %zu",
+			      split);
+
+		/* The rest of the data can still be parsed. */
+		stopped = false;
+		zassert_equal(ical_parser_parse(&ical, &calendar[stop_offset],
+						len - stop_offset),
+			      len - stop_offset, "Rest not parsed");
+		zassert_equal(event_cnt, 3, "Wrong number of events, split %zu",
+			      split);
+		check_events();
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(icalendar_parser_test,
+			 ztest_unit_test(test_init_invalid),
+			 ztest_unit_test_setup_teardown(test_split_anywhere,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_byte_by_byte,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_callback_stop,
+							setup, teardown)
+			 );
+
+	ztest_run_test_suite(icalendar_parser_test);
+}
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <string.h>
+
+#include <lwm2m_firmware.c>
+
+#define BLOCK_SIZE CONFIG_LWM2M_COAP_BLOCK_SIZE
+#define IMAGE_SIZE (4 * BLOCK_SIZE)
+/* Written before the interruption, in the middle of the second block. */
+#define WRITTEN (BLOCK_SIZE + 36)
+
+static uint8_t image[IMAGE_SIZE];
+static uint8_t target[IMAGE_SIZE];
+static size_t target_offset;
+static size_t write_cnt;
+static int init_cnt;
+static int reset_cnt;
+
+static struct lwm2m_client_utils_download_state saved_state;
+static bool saved_valid;
+
+
+void client_acknowledge(void)
+{
+}
+
+int dfu_target_img_type(const void *const buf, size_t len)
+{
+	return DFU_TARGET_IMAGE_TYPE_MCUBOOT;
+}
+
+int dfu_target_init(int img_type, size_t file_size, dfu_target_callback_t cb)
+{
+	init_cnt++;
+
+	return 0;
+}
+
+int dfu_target_offset_get(size_t *offset)
+{
+	*offset = target_offset;
+
+	return 0;
+}
+
+int dfu_target_write(const void *const buf, size_t len)
+{
+	zassert_true(target_offset + len <= sizeof(target), "Write too long");
+	memcpy(&target[target_offset], buf, len);
+	target_offset += len;
+	write_cnt += len;
+
+	return 0;
+}
+
+int dfu_target_done(bool successful)
+{
+	return 0;
+}
+
+int dfu_target_reset(void)
+{
+	reset_cnt++;
+	target_offset = 0;
+	memset(target, 0xff, sizeof(target));
+
+	return 0;
+}
+
+int lwm2m_client_utils_download_state_read(
+	struct lwm2m_client_utils_download_state *state)
+{
+	if (!saved_valid) {
+		return -ENOENT;
+	}
+
+	*state = saved_state;
+
+	return 0;
+}
+
+int lwm2m_client_utils_download_state_save(
+	const struct lwm2m_client_utils_download_state *state)
+{
+	saved_state = *state;
+	saved_valid = true;
+
+	return 0;
+}
+
+int lwm2m_client_utils_download_state_clear(void)
+{
+	saved_valid = false;
+
+	return 0;
+}
+
+int fota_update_counter_read(struct update_counter *update_counter)
+{
+	return 0;
+}
+
+int fota_update_counter_update(enum counter_type type, uint32_t new_value)
+{
+	return 0;
+}
+
+void lwm2m_firmware_set_update_cb(lwm2m_engine_execute_cb_t cb)
+{
+}
+
+void lwm2m_firmware_set_write_cb(lwm2m_engine_set_data_cb_t cb)
+{
+}
+
+int lwm2m_engine_register_pre_write_callback(char *pathstr,
+					     lwm2m_engine_get_data_cb_t cb)
+{
+	return 0;
+}
+
+int lwm2m_engine_set_u8(char *pathstr, uint8_t value)
+{
+	return 0;
+}
+
+int nrf_modem_lib_get_init_ret(void)
+{
+	return 0;
+}
+
+bool boot_is_img_confirmed(void)
+{
+	return true;
+}
+
+int boot_write_img_confirmed(void)
+{
+	return 0;
+}
+
+void sys_reboot(int type)
+{
+	zassert_unreachable("Unexpected reboot");
+	CODE_UNREACHABLE;
+}
+
+/* Feed the whole image to the firmware object, as the LwM2M engine does. */
+static void download(void)
+{
+	for (size_t pos = 0; pos < IMAGE_SIZE; pos += BLOCK_SIZE) {
+		zassert_equal(firmware_block_received_cb(0, 0, 0, &image[pos],
+							 BLOCK_SIZE,
+							 pos + BLOCK_SIZE ==
+								IMAGE_SIZE,
+							 IMAGE_SIZE),
+			      0, "Block at %zu not accepted", pos);
+	}
+}
+
+/* Simulate a download interrupted after WRITTEN bytes. */
+static void interrupted(int img_type, uint32_t total_size)
+{
+	memcpy(target, image, WRITTEN);
+	target_offset = WRITTEN;
+
+	saved_state.image_type = img_type;
+	saved_state.total_size = total_size;
+	saved_state.offset = WRITTEN;
+	saved_valid = true;
+}
+
+static void setup(void)
+{
+	for (size_t i = 0; i < sizeof(image); i++) {
+		image[i] = i;
+	}
+
+	memset(target, 0xff, sizeof(target));
+	target_offset = 0;
+	write_cnt = 0;
+	init_cnt = 0;
+	reset_cnt = 0;
+	saved_valid = false;
+}
+
+static void teardown(void)
+{
+}
+
+static void test_download(void)
+{
+	download();
+
+	zassert_equal(reset_cnt, 0, "Target reset");
+	zassert_equal(write_cnt, IMAGE_SIZE, "Wrong number of bytes written");
+	zassert_mem_equal(target, image, IMAGE_SIZE, "Wrong image");
+	zassert_false(saved_valid, "Download state not cleared");
+}
+
+static void test_resume(void)
+{
+	interrupted(DFU_TARGET_IMAGE_TYPE_MCUBOOT, IMAGE_SIZE);
+
+	download();
+
+	/* Only the bytes missing from the target are written. */
+	zassert_equal(reset_cnt, 0, "Target reset");
+	zassert_equal(write_cnt, IMAGE_SIZE - WRITTEN,
+		      "Wrong number of bytes written");
+	zassert_mem_equal(target, image, IMAGE_SIZE, "Wrong image");
+	zassert_false(saved_valid, "Download state not cleared");
+}
+
+static void test_resume_other_size(void)
+{
+	interrupted(DFU_TARGET_IMAGE_TYPE_MCUBOOT, IMAGE_SIZE + BLOCK_SIZE);
+
+	download();
+
+	/* The data of the other image is discarded. */
+	zassert_equal(reset_cnt, 1, "Target not reset");
+	zassert_equal(init_cnt, 2, "Target not initialized again");
+	zassert_equal(write_cnt, IMAGE_SIZE, "Wrong number of bytes written");
+	zassert_mem_equal(target, image, IMAGE_SIZE, "Wrong image");
+}
+
+static void test_resume_other_type(void)
+{
+	interrupted(DFU_TARGET_IMAGE_TYPE_MODEM_DELTA, IMAGE_SIZE);
+
+	download();
+
+	zassert_equal(reset_cnt, 1, "Target not reset");
+	zassert_equal(init_cnt, 2, "Target not initialized again");
+	zassert_equal(write_cnt, IMAGE_SIZE, "Wrong number of bytes written");
+	zassert_mem_equal(target, image, IMAGE_SIZE, "Wrong image");
+}
+
+static void test_resume_unknown(void)
+{
+	interrupted(DFU_TARGET_IMAGE_TYPE_MCUBOOT, IMAGE_SIZE);
+	saved_valid = false;
+
+	/* Without a stored state, the data in the target cannot be trusted. */
+	download();
+
+	zassert_equal(reset_cnt, 1, "Target not reset");
+	zassert_equal(write_cnt, IMAGE_SIZE, "Wrong number of bytes written");
+	zassert_mem_equal(target, image, IMAGE_SIZE, "Wrong image");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lwm2m_firmware_test,
+			 ztest_unit_test_setup_teardown(test_download,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_resume,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_resume_other_size,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_resume_other_type,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_resume_unknown,
+							setup, teardown)
+			 );
+
+	ztest_run_test_suite(lwm2m_firmware_test);
+}
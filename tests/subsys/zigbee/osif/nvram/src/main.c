@@ -9,6 +9,7 @@
 #include <zboss_api.h>
 #include <zb_errors.h>
 #include <zb_osif.h>
+#include <zb_nrf_platform.h>
 
 #define PAGE_SIZE 0x400         /* Size for testing purpose */
 #define VIRTUAL_PAGE_COUNT 2    /* ZBOSS uses two virtual pages */
@@ -97,13 +98,52 @@ static void test_zb_nvram_write(void)
 	}
 }
 
+static void test_zb_nvram_write_combine(void)
+{
+	const uint8_t MEM_PATTERN = 0x55;
+	const uint16_t CHUNK_SIZE = 16;
+	struct zigbee_nvram_stats before;
+	struct zigbee_nvram_stats after;
+	int ret;
+
+	ret = zb_osif_nvram_erase_async(0);
+	zassert_true(ret == RET_OK, "Erasing failed");
+
+	memset(zb_nvram_buf, MEM_PATTERN, sizeof(zb_nvram_buf));
+	zigbee_nvram_stats_get(&before);
+
+	/* Write adjacent chunks, as ZBOSS does when storing a dataset. */
+	for (uint32_t offset = 0; offset < 4 * CHUNK_SIZE;
+	     offset += CHUNK_SIZE) {
+		ret = zb_osif_nvram_write(0, offset, zb_nvram_buf, CHUNK_SIZE);
+		zassert_true(ret == RET_OK, "writing failed");
+	}
+	zb_osif_nvram_flush();
+	zb_osif_nvram_wait_for_last_op();
+
+	zigbee_nvram_stats_get(&after);
+	zassert_equal(after.writes - before.writes, 4,
+		      "Incorrect number of writes");
+	zassert_equal(after.errors, before.errors, "Flash write failed");
+	if (IS_ENABLED(CONFIG_ZIGBEE_NVRAM_WRITE_BUFFER)) {
+		zassert_equal(after.flash_writes - before.flash_writes, 1,
+			      "Writes were not combined");
+	}
+
+	memset(zb_nvram_buf, 0, sizeof(zb_nvram_buf));
+	zb_osif_nvram_read(0, 0, zb_nvram_buf, 4 * CHUNK_SIZE);
+	for (int i = 0; i < 4 * CHUNK_SIZE; i++) {
+		zassert_true(zb_nvram_buf[i] == MEM_PATTERN, "writing failed");
+	}
+}
 
 void test_main(void)
 {
 	ztest_test_suite(osif_test,
 			 ztest_unit_test(test_zb_nvram_memory_size),
 			 ztest_unit_test(test_zb_nvram_erase),
-			 ztest_unit_test(test_zb_nvram_write)
+			 ztest_unit_test(test_zb_nvram_write),
+			 ztest_unit_test(test_zb_nvram_write_combine)
 			 );
 
 	ztest_run_test_suite(osif_test);
@@ -7,7 +7,11 @@
 #include <ztest.h>
 #include <zboss_api.h>
 
+#ifdef CONFIG_ZIGBEE_UART_ASYNC_API
+#include <zb_nrf_async_serial.c>
+#else
 #include <zb_nrf_serial.c>
+#endif
 
 
 #define TEST_UART_BUF_LEN 256
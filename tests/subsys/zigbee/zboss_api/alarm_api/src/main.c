@@ -180,6 +180,47 @@ void test_zboss_app_alarm(void)
 	}
 }
 
+static void cancelled_alarm_callback(uint8_t param)
+{
+	ARG_UNUSED(param);
+
+	zassert_unreachable("Cancelled alarm has fired.");
+}
+
+void test_zboss_app_alarm_cancel(void)
+{
+	struct zigbee_alarm_stats before;
+	struct zigbee_alarm_stats after;
+	zb_ret_t ret;
+
+	zigbee_alarm_stats_get(&before);
+
+	for (uint8_t i = 0; i < N_THREADS; i++) {
+		ret = zigbee_schedule_alarm(
+			cancelled_alarm_callback, i,
+			ZB_MILLISECONDS_TO_BEACON_INTERVAL(100 * (i + 1)));
+		zassert_equal(ret, RET_OK, "Unable to schedule an alarm.");
+	}
+
+	ret = zigbee_schedule_alarm_cancel(cancelled_alarm_callback, 0);
+	zassert_equal(ret, RET_OK, "Unable to cancel an alarm.");
+	ret = zigbee_schedule_alarm_cancel(cancelled_alarm_callback,
+					   ZB_ALARM_ANY_PARAM);
+	zassert_equal(ret, RET_OK, "Unable to cancel alarms.");
+
+	/* Wait past the expiry of all cancelled alarms. */
+	k_sleep(K_MSEC(100 * (N_THREADS + 1) + ZB_TIMER_PRECISION));
+
+	zigbee_alarm_stats_get(&after);
+	zassert_equal(after.scheduled - before.scheduled, N_THREADS,
+		      "Incorrect number of scheduled alarms.");
+	zassert_equal(after.cancelled - before.cancelled, N_THREADS,
+		      "Incorrect number of cancelled alarms.");
+	zassert_equal(after.fired, before.fired,
+		      "Cancelled alarms have fired.");
+	zassert_equal(after.pending, 0, "Alarms are still pending.");
+}
+
 void test_main(void)
 {
 	/* Erase NVRAM to have repeatability of test runs. */
@@ -190,7 +231,8 @@ void test_main(void)
 
 	ztest_test_suite(zboss_api_alarm,
 			 ztest_unit_test(test_zboss_startup_signals),
-			 ztest_unit_test(test_zboss_app_alarm));
+			 ztest_unit_test(test_zboss_app_alarm),
+			 ztest_unit_test(test_zboss_app_alarm_cancel));
 
 	ztest_run_test_suite(zboss_api_alarm);
 }